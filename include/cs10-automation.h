@@ -0,0 +1,54 @@
+/* cs10-automation.h
+ *
+ * moves of the surface's faders and knobs recorded against time code.
+ * each control has its own stream of frame and value events, delta
+ * encoded as a varint step in frames followed by the value byte, with a
+ * key every CS10_AUTOMATION_KEY_EVENTS events so that a locate finds its
+ * place with a binary search and a short scan.
+ * the streams live in a sparse memory mapped file, a long take costs
+ * page cache rather than heap.
+ * none of this is locked, one thread does all the recording and playing.
+ */
+
+#ifndef CS10_AUTOMATION_H_INCLUDED
+#define CS10_AUTOMATION_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CS10_AUTOMATION_KEY_EVENTS   64
+#define CS10_AUTOMATION_STREAM_BYTES (128 * 1024)
+
+bool
+cs10_automation_open(
+  const char *pFilename,
+  unsigned int uiStreams) ;
+
+void
+cs10_automation_close(void) ;
+
+bool
+cs10_automation_is_open(void) ;
+
+void
+cs10_automation_truncate(
+  unsigned int uiStream,
+  uint32_t ulFrame) ;
+
+bool
+cs10_automation_record(
+  unsigned int uiStream,
+  uint32_t ulFrame,
+  unsigned int uiValue) ;
+
+int
+cs10_automation_seek(
+  unsigned int uiStream,
+  uint32_t ulFrame) ;
+
+int
+cs10_automation_play(
+  unsigned int uiStream,
+  uint32_t ulFrame) ;
+
+#endif /* CS10_AUTOMATION_H_INCLUDED */
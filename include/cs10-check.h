@@ -0,0 +1,21 @@
+/* cs10-check.h
+ *
+ * self checks of the parts of cs10-linux that need neither a sequencer
+ * nor a surface: journal record and replay, the undo ring, automation
+ * streams, control socket batches and the macro and target files.
+ * cs10-daw --check runs them, and so does make check. every file they
+ * make goes in the directory they are given, and is removed again.
+ */
+
+#ifndef CS10_CHECK_H_INCLUDED
+#define CS10_CHECK_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdio.h>
+
+bool
+cs10_check(
+  const char *pDirectory,
+  FILE *pReport) ;
+
+#endif /* CS10_CHECK_H_INCLUDED */
@@ -0,0 +1,51 @@
+/* cs10-control.h
+ *
+ * a unix domain socket for local scripts to drive and query cs10-linux.
+ * each line a client sends is a batch of commands separated by ';',
+ * run in order until one fails. whatever the commands print comes back
+ * followed by a single "ok" line, or by "error N message" for the
+ * first command that failed, so there is exactly one reply per batch.
+ * a line longer than CS10_CONTROL_LINE, or a reply longer than half of
+ * CS10_CONTROL_REPLY, is answered with an error instead.
+ * the sockets are non-blocking and served from the caller's poll loop,
+ * the caller hands over CS10_CONTROL_FDS pollfd slots for them.
+ */
+
+#ifndef CS10_CONTROL_H_INCLUDED
+#define CS10_CONTROL_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <poll.h>
+
+#define CS10_CONTROL_CLIENTS   4
+#define CS10_CONTROL_FDS       (1 + CS10_CONTROL_CLIENTS)
+#define CS10_CONTROL_LINE      1024
+#define CS10_CONTROL_REPLY     16384
+#define CS10_CONTROL_MAX_ARGS  8
+
+/* run one command, printing any result to pReply
+ * return NULL or why it failed
+ */
+typedef const char *(*cs10_control_command_fn)(
+  unsigned int uiArgs,
+  char **ppArgs,
+  FILE *pReply) ;
+
+bool
+cs10_control_open(
+  const char *pPath,
+  cs10_control_command_fn pfnCommand) ;
+
+void
+cs10_control_close(void) ;
+
+void
+cs10_control_poll_fds(
+  struct pollfd *pFDs) ;
+
+void
+cs10_control_handle(
+  const struct pollfd *pFDs) ;
+
+#endif /* CS10_CONTROL_H_INCLUDED */
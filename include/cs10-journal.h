@@ -0,0 +1,59 @@
+/* cs10-journal.h
+ *
+ * an append-only journal of live state, so a restart picks up exactly
+ * where the last run left off.
+ * the journal file is mapped into memory and holds two snapshot slots
+ * followed by a ring of fixed size records. each change is one record,
+ * and once half the ring has been used a fresh snapshot is written over
+ * the older slot. a crash at any point leaves either slot plus the
+ * records after it to replay.
+ * a small scratch area is kept in the same file for state that changes
+ * too often to journal but should still survive a restart.
+ * appends are not locked, callers keep them in order.
+ */
+
+#ifndef CS10_JOURNAL_H_INCLUDED
+#define CS10_JOURNAL_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CS10_JOURNAL_RECORDS 4096
+
+/* fill pSnapshot with the current state */
+typedef void (*cs10_journal_snapshot_fn)(
+  void *pSnapshot) ;
+
+/* apply one journalled change to pSnapshot */
+typedef void (*cs10_journal_record_fn)(
+  void *pSnapshot,
+  unsigned int uiKey,
+  unsigned int uiValue) ;
+
+bool
+cs10_journal_open(
+  const char *pFilename,
+  size_t uiSnapshotSize,
+  size_t uiScratchSize,
+  cs10_journal_snapshot_fn pfnSnapshot) ;
+
+void
+cs10_journal_close(void) ;
+
+bool
+cs10_journal_replay(
+  void *pSnapshot,
+  cs10_journal_record_fn pfnRecord) ;
+
+void *
+cs10_journal_scratch(void) ;
+
+void
+cs10_journal_append(
+  unsigned int uiKey,
+  unsigned int uiValue) ;
+
+void
+cs10_journal_checkpoint(void) ;
+
+#endif /* CS10_JOURNAL_H_INCLUDED */
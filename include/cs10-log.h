@@ -0,0 +1,40 @@
+/* cs10-log.h
+ *
+ * verbose output without the cost of formatting it where it happens.
+ * CS10_LOG copies a timestamp, the calling function, the format and up
+ * to four int arguments into a fixed size record on a ring of the
+ * calling thread's own, with no lock and no system call. a writer
+ * thread empties every ring a few times a second and formats the
+ * records to a file.
+ * the format must be a string constant, it is only read when the
+ * record is written out. a full ring drops records, and the writer says
+ * how many.
+ */
+
+#ifndef CS10_LOG_H_INCLUDED
+#define CS10_LOG_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define CS10_LOG_RECORDS  1024 /* per thread, a power of two */
+#define CS10_LOG_THREADS  4
+#define CS10_LOG_FLUSH_MS 100
+
+/* the padding makes sure there are always four arguments to take */
+#define CS10_LOG(...) cs10_log_put(__FUNCTION__, __VA_ARGS__, 0, 0, 0, 0)
+
+void
+cs10_log_put(
+  const char *pFunction,
+  const char *pFormat,
+  ...) ;
+
+bool
+cs10_log_start(
+  FILE *pFile) ;
+
+void
+cs10_log_stop(void) ;
+
+#endif /* CS10_LOG_H_INCLUDED */
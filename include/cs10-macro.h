@@ -0,0 +1,109 @@
+/* cs10-macro.h
+ *
+ * button macros, short timelines of transport commands, locates and
+ * track controls, one to each track button. a macro is recorded from
+ * the surface or loaded from a file of one step to a line:
+ *
+ *   macro N                  the steps after it are macro N
+ *   wait ms                  before the next step
+ *   play, stop, record, ff, rew
+ *   locate fN                to saved position N
+ *   locate hh:mm:ss:ff
+ *   set track control value
+ *
+ * a macro is run by handing cs10_macro_schedule every event it makes,
+ * each with the time it is due and the port it goes out of. they go
+ * on a sequencer queue of our own in one go, so the kernel sends them
+ * out on time and nothing here sleeps in between. running a macro
+ * drops whatever is left of the one before.
+ * only the surface thread may use it.
+ */
+
+#ifndef CS10_MACRO_H_INCLUDED
+#define CS10_MACRO_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <alsa/asoundlib.h>
+
+#include "cs10-map.h"
+
+#define CS10_MACRO_SLOTS       8
+#define CS10_MACRO_STEPS       64
+#define CS10_MACRO_POSITIONS   9
+#define CS10_MACRO_MAX_WAIT_MS 60000
+#define CS10_MACRO_QUEUE_NAME  "cs10 macros"
+
+typedef enum CS10_MACRO_ACTION_E {
+  MACRO_PLAY,
+  MACRO_STOP,
+  MACRO_RECORD,
+  MACRO_FF,
+  MACRO_REW,
+  MACRO_LOCATE_SAVED,  /* ucArg[0] is the saved position */
+  MACRO_LOCATE,        /* ucArg[] is hours, minutes, seconds, frames */
+  MACRO_SET,           /* ucArg[] is track, control, value */
+  NUM_MACRO_ACTIONS
+} cs10_macro_action_t ;
+
+typedef struct CS10_MACRO_STEP_S {
+  uint32_t ulWaitMs ;  /* after the step before */
+  uint8_t  ucAction ;
+  uint8_t  ucArg[4] ;
+} cs10_macro_step_t ;
+
+typedef struct CS10_MACRO_S {
+  unsigned int      uiSteps ;
+  cs10_macro_step_t step[CS10_MACRO_STEPS] ;
+} cs10_macro_t ;
+
+bool
+cs10_macro_load(
+  const char *pFilename,
+  const char * const *ppControlNames) ;
+
+bool
+cs10_macro_save(
+  const char *pFilename,
+  const char * const *ppControlNames) ;
+
+const cs10_macro_t *
+cs10_macro_get(
+  unsigned int uiSlot) ;
+
+void
+cs10_macro_record_start(void) ;
+
+bool
+cs10_macro_is_recording(void) ;
+
+void
+cs10_macro_record_step(
+  cs10_macro_action_t action,
+  unsigned int uiArg0,
+  unsigned int uiArg1,
+  unsigned int uiArg2,
+  unsigned int uiArg3) ;
+
+bool
+cs10_macro_record_keep(
+  unsigned int uiSlot) ;
+
+void
+cs10_macro_record_abandon(void) ;
+
+bool
+cs10_macro_queue_open(
+  snd_seq_t *pSeq,
+  unsigned int uiEvents) ;
+
+void
+cs10_macro_queue_close(void) ;
+
+bool
+cs10_macro_schedule(
+  snd_seq_event_t *pEvents,
+  const uint32_t *pulDueMs,
+  unsigned int uiEvents) ;
+
+#endif /* CS10_MACRO_H_INCLUDED */
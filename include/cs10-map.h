@@ -0,0 +1,109 @@
+/* cs10-map.h
+ *
+ * which midi channel and cc carries each control of each mixer strip.
+ * a map is loaded from an ardour generic midi map, or from a plain text
+ * file of the same bindings, and compiled into flat tables so that a
+ * lookup in either direction is a couple of array reads.
+ */
+
+#ifndef CS10_MAP_H_INCLUDED
+#define CS10_MAP_H_INCLUDED
+
+#include <stdbool.h>
+
+typedef enum VIRTUAL_TRACK_CONTROL_E {
+  ARMED_CONTROL,
+  MUTE_CONTROL,
+  SOLO_CONTROL,
+  FADER_CONTROL,
+  BOOST_CUT_CONTROL,
+  FREQUENCY_CONTROL,
+  BANDWDITH_CONTROL,
+  SEND_ONE_CONTROL,
+  SEND_TWO_CONTROL,
+  PAN_CONTROL,
+  NUM_VIRTUAL_TRACK_CONTROLS
+} virtual_track_control_t ;
+
+#define CS10_MAP_MAX_STRIPS   32
+#define CS10_MAP_NUM_CHANNELS 16
+#define CS10_MAP_NUM_CCS      128
+#define CS10_MAP_UNMAPPED     0xff
+
+typedef struct CS10_MAP_S {
+  /* strip and control to the channel and cc that carry them */
+  unsigned char ucChannel[CS10_MAP_MAX_STRIPS][NUM_VIRTUAL_TRACK_CONTROLS] ;
+  unsigned char ucCC[CS10_MAP_MAX_STRIPS][NUM_VIRTUAL_TRACK_CONTROLS] ;
+
+  /* channel and cc back to strip and control */
+  unsigned char ucStrip[CS10_MAP_NUM_CHANNELS][CS10_MAP_NUM_CCS] ;
+  unsigned char ucControl[CS10_MAP_NUM_CHANNELS][CS10_MAP_NUM_CCS] ;
+
+  unsigned int  uiBindings ;
+} cs10_map_t ;
+
+void
+cs10_map_default(
+  cs10_map_t *pMap,
+  unsigned int uiFirstChannel,
+  unsigned int uiStripsPerChannel,
+  unsigned int uiStrips) ;
+
+bool
+cs10_map_load(
+  cs10_map_t *pMap,
+  const char *pFilename) ;
+
+bool
+cs10_map_parse_uri(
+  const char *pURI,
+  unsigned int *puiStrip,
+  virtual_track_control_t *pControl) ;
+
+/*
+ * cs10_map_to_cc
+ *
+ * find the channel and cc for uiStrip's tcControl
+ */
+static inline bool
+cs10_map_to_cc(
+  const cs10_map_t *pMap,
+  unsigned int uiStrip,
+  virtual_track_control_t tcControl,
+  unsigned int *puiChannel,
+  unsigned int *puiCC) {
+
+  if ((CS10_MAP_MAX_STRIPS <= uiStrip) ||
+      (CS10_MAP_UNMAPPED == pMap->ucChannel[uiStrip][tcControl]))
+    return false ;
+
+  *puiChannel = pMap->ucChannel[uiStrip][tcControl] ;
+  *puiCC = pMap->ucCC[uiStrip][tcControl] ;
+
+  return true ;
+} /* cs10_map_to_cc */
+
+/*
+ * cs10_map_from_cc
+ *
+ * find the strip and control carried on uiChannel's uiCC
+ */
+static inline bool
+cs10_map_from_cc(
+  const cs10_map_t *pMap,
+  unsigned int uiChannel,
+  unsigned int uiCC,
+  unsigned int *puiStrip,
+  virtual_track_control_t *pControl) {
+
+  if ((CS10_MAP_NUM_CHANNELS <= uiChannel) || (CS10_MAP_NUM_CCS <= uiCC) ||
+      (CS10_MAP_UNMAPPED == pMap->ucStrip[uiChannel][uiCC]))
+    return false ;
+
+  *puiStrip = pMap->ucStrip[uiChannel][uiCC] ;
+  *pControl = pMap->ucControl[uiChannel][uiCC] ;
+
+  return true ;
+} /* cs10_map_from_cc */
+
+#endif /* CS10_MAP_H_INCLUDED */
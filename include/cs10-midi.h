@@ -0,0 +1,57 @@
+/* cs10-midi.h
+ *
+ * a byte at a time midi parser for talking to hardware without the
+ * sequencer in the way. handles running status, real time bytes
+ * interleaved anywhere, and reassembles sysex.
+ */
+
+#ifndef CS10_MIDI_H_INCLUDED
+#define CS10_MIDI_H_INCLUDED
+
+#include <stdbool.h>
+
+#define CS10_MIDI_MAX_SYSEX  256
+
+#define MIDI_NOTE_OFF        0x80
+#define MIDI_NOTE_ON         0x90
+#define MIDI_KEY_PRESSURE    0xA0
+#define MIDI_CONTROLLER      0xB0
+#define MIDI_PROGRAM_CHANGE  0xC0
+#define MIDI_CHAN_PRESSURE   0xD0
+#define MIDI_PITCH_BEND      0xE0
+#define MIDI_SYSEX_START     0xF0
+#define MIDI_SYSEX_END       0xF7
+#define MIDI_REAL_TIME_FIRST 0xF8
+
+#define MIDI_STATUS_TYPE(status)    ((status) & 0xF0)
+#define MIDI_STATUS_CHANNEL(status) ((status) & 0x0F)
+
+typedef struct CS10_MIDI_MESSAGE_S {
+  unsigned char        ucStatus ;
+  unsigned char        ucData1 ;
+  unsigned char        ucData2 ;
+  const unsigned char *pSysex ;        /* whole packet, f0 to f7 */
+  unsigned int         uiSysexLength ;
+} cs10_midi_message_t ;
+
+typedef struct CS10_MIDI_PARSER_S {
+  unsigned char ucRunningStatus ;
+  unsigned char ucData[2] ;
+  unsigned int  uiDataCount ;
+  bool          bInSysex ;
+  bool          bSysexOverflow ;
+  unsigned int  uiSysexLength ;
+  unsigned char ucSysex[CS10_MIDI_MAX_SYSEX] ;
+} cs10_midi_parser_t ;
+
+void
+cs10_midi_parser_init(
+  cs10_midi_parser_t *pParser) ;
+
+bool
+cs10_midi_parse_byte(
+  cs10_midi_parser_t *pParser,
+  unsigned char ucByte,
+  cs10_midi_message_t *pMessage) ;
+
+#endif /* CS10_MIDI_H_INCLUDED */
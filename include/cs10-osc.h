@@ -0,0 +1,54 @@
+/* cs10-osc.h
+ *
+ * a minimal open sound control sender, for talking to ardour over udp.
+ * packets are built in place, either as a single message or as a
+ * bundle of messages that goes out in one datagram.
+ * only the surface thread may build or send packets.
+ */
+
+#ifndef CS10_OSC_H_INCLUDED
+#define CS10_OSC_H_INCLUDED
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/* room for a full snapshot recall as one bundle */
+#define CS10_OSC_MAX_PACKET 16384
+
+typedef struct CS10_OSC_PACKET_S {
+  bool          bBundle ;
+  unsigned int  uiLength ;
+  unsigned char ucData[CS10_OSC_MAX_PACKET] ;
+} cs10_osc_packet_t ;
+
+bool
+cs10_osc_open(
+  const char *pHostPort) ;
+
+void
+cs10_osc_close(void) ;
+
+bool
+cs10_osc_is_open(void) ;
+
+void
+cs10_osc_packet_init(
+  cs10_osc_packet_t *pPacket,
+  bool bBundle) ;
+
+bool
+cs10_osc_add_message(
+  cs10_osc_packet_t *pPacket,
+  const char *pPath,
+  const char *pTypes,
+  ...) ;
+
+bool
+cs10_osc_send(
+  cs10_osc_packet_t *pPacket) ;
+
+void
+cs10_osc_dump_stats(
+  FILE *fp) ;
+
+#endif /* CS10_OSC_H_INCLUDED */
@@ -0,0 +1,112 @@
+/* cs10-output.h
+ *
+ * prioritized output lanes for everything cs10-linux sends.
+ * events are queued per lane and written out highest lane first,
+ * so a transport command never waits behind LED or restore traffic.
+ * when the sequencer pushes back, events wait on their lane and
+ * each lane decides what may be thrown away. a full lane holds a
+ * bounded backlog for the poll loop to retry, queueing never waits.
+ * a lane writes out of its own port unless an event is queued to
+ * another port of the same sequencer client, a lane sent straight to
+ * rawmidi has no ports and writes everything to the device.
+ * only the surface thread may queue or flush.
+ */
+
+#ifndef CS10_OUTPUT_H_INCLUDED
+#define CS10_OUTPUT_H_INCLUDED
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <alsa/asoundlib.h>
+
+/* lanes in the order they are drained */
+typedef enum CS10_OUTPUT_LANE_E {
+  TRANSPORT_LANE,    /* mmc commands, locates and jog steps to the daw */
+  INTERACTIVE_LANE,  /* fader, knob and button moves to the daw */
+  FEEDBACK_LANE,     /* LED and seven segment sysex to the surface */
+  BULK_LANE,         /* snapshot restore traffic to the daw */
+  NUM_OUTPUT_LANES
+} cs10_output_lane_t ;
+
+#define CS10_OUTPUT_LANE_DEPTH   64
+
+/* events a full lane holds over for the poll loop to retry, rather
+ * than wait for the sequencer. past that the transport lane waits,
+ * and the others drop
+ */
+#define CS10_OUTPUT_BACKLOG_DEPTH 192
+
+/* longer sysex is dropped rather than held up for */
+#define CS10_OUTPUT_MAX_SYSEX    32
+
+/* bytes a rawmidi lane packs up before writing them in one go */
+#define CS10_OUTPUT_RAW_BUFFER   512
+
+/* how long to wait before trying a stalled sequencer again */
+#define CS10_OUTPUT_RETRY_MS     1
+
+/* how long transport waits for a stalled sequencer before giving up */
+#define CS10_OUTPUT_WAIT_MS      1000
+
+typedef struct CS10_OUTPUT_STATS_S {
+  unsigned long ulQueued ;
+  unsigned long ulSent ;
+  unsigned long ulDelayed ;   /* had to wait for room in the sequencer */
+  unsigned long ulReplaced ;  /* stale values overtaken before going out */
+  unsigned long ulDropped ;   /* discarded on a full lane or by the sequencer */
+} cs10_output_stats_t ;
+
+bool
+cs10_output_init(
+  snd_seq_t *pDAWSeq,
+  int iDAWPortID,
+  snd_seq_t *pSurfaceSeq,
+  int iSurfacePortID) ;
+
+void
+cs10_output_use_rawmidi(
+  cs10_output_lane_t lane,
+  snd_rawmidi_t *pRawMidi) ;
+
+bool
+cs10_output_queue(
+  cs10_output_lane_t lane,
+  const snd_seq_event_t *pEvent) ;
+
+bool
+cs10_output_queue_to(
+  cs10_output_lane_t lane,
+  int iPortID,
+  const snd_seq_event_t *pEvent) ;
+
+bool
+cs10_output_queue_latest(
+  cs10_output_lane_t lane,
+  const snd_seq_event_t *pEvent) ;
+
+bool
+cs10_output_queue_latest_to(
+  cs10_output_lane_t lane,
+  int iPortID,
+  const snd_seq_event_t *pEvent) ;
+
+unsigned int
+cs10_output_room(
+  cs10_output_lane_t lane) ;
+
+bool
+cs10_output_pending(void) ;
+
+void
+cs10_output_flush(void) ;
+
+void
+cs10_output_get_stats(
+  cs10_output_lane_t lane,
+  cs10_output_stats_t *pStats) ;
+
+void
+cs10_output_dump_stats(
+  FILE *fp) ;
+
+#endif /* CS10_OUTPUT_H_INCLUDED */
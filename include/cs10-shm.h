@@ -0,0 +1,100 @@
+/* cs10-shm.h
+ *
+ * the live mixer state mirrored into posix shared memory for anything
+ * on the same machine to watch, a control room display say.
+ * cs10-linux rewrites the tracks or time a change to its live state
+ * touched, under a sequence count of its own in the segment: odd
+ * while a write is under way, bumped again when it is done. a reader
+ * copies the whole segment and tries again if the count moved, so it
+ * takes no lock and makes no system call, and the daemon never waits
+ * for it. cs10_shm_snapshot below does just that.
+ * values are as they go over midi, 0 to 127, the flags 0 or 1.
+ */
+
+#ifndef CS10_SHM_H_INCLUDED
+#define CS10_SHM_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CS10_SHM_DEFAULT_NAME "/cs10-state"
+#define CS10_SHM_MAGIC        0x30317363 /* "cs10" */
+#define CS10_SHM_VERSION      1
+#define CS10_SHM_TRACKS       32
+#define CS10_SHM_KNOBS        6
+#define CS10_SHM_TRIES        1000
+
+typedef struct CS10_SHM_TRACK_S {
+  uint8_t ucFader ;
+  uint8_t ucKnob[CS10_SHM_KNOBS] ; /* boost, frequency, bandwidth,
+                                    * send 1, send 2, pan
+                                    */
+  uint8_t ucArmed ;
+  uint8_t ucMute ;
+  uint8_t ucSolo ;
+} cs10_shm_track_t ;
+
+typedef struct CS10_SHM_STATE_S {
+  uint32_t         ulMagic ;
+  uint32_t         ulVersion ;
+  uint32_t         ulSequence ;     /* odd while being written */
+  uint32_t         ulPid ;          /* of the cs10-linux writing it */
+
+  uint8_t          ucBank ;
+  uint8_t          ucMode ;         /* select, locate, mute, solo, nullify */
+  uint8_t          ucSelectedTrack ;
+  uint8_t          ucHours ;
+  uint8_t          ucMinutes ;
+  uint8_t          ucSeconds ;
+  uint8_t          ucFrames ;
+  uint8_t          ucRate ;         /* mtc rate code, 24, 25, 29.97, 30 */
+
+  cs10_shm_track_t track[CS10_SHM_TRACKS] ;
+} cs10_shm_state_t ;
+
+/*
+ * cs10_shm_snapshot
+ *
+ * copy a consistent pShared to pCopy
+ * return false if a writer kept getting in the way
+ */
+static inline bool
+cs10_shm_snapshot(
+  const cs10_shm_state_t *pShared,
+  cs10_shm_state_t *pCopy) {
+
+  unsigned int uiTry ;
+
+  for (uiTry = 0 ; uiTry < CS10_SHM_TRIES ; uiTry++) {
+    uint32_t ulSequence = __atomic_load_n(&pShared->ulSequence,
+                                          __ATOMIC_ACQUIRE) ;
+
+    if (ulSequence & 1)
+      continue ;
+
+    memcpy(pCopy, pShared, sizeof(cs10_shm_state_t)) ;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE) ;
+
+    if (ulSequence == __atomic_load_n(&pShared->ulSequence,
+                                      __ATOMIC_RELAXED))
+      return true ;
+  } /* for */
+
+  return false ;
+} /* cs10_shm_snapshot */
+
+bool
+cs10_shm_open(
+  const char *pName) ;
+
+void
+cs10_shm_close(void) ;
+
+cs10_shm_state_t *
+cs10_shm_write_begin(void) ;
+
+void
+cs10_shm_write_end(void) ;
+
+#endif /* CS10_SHM_H_INCLUDED */
@@ -0,0 +1,60 @@
+/* cs10-stats.h
+ *
+ * counters that are always kept, and a file they are written to every
+ * CS10_STATS_INTERVAL_S in the prometheus text format, for the node
+ * exporter's textfile collector to pick up.
+ * counting is a relaxed atomic add, from whichever thread.
+ * the file is written next to itself and renamed into place, so a
+ * scrape never sees half of it. threads that name themselves with
+ * cs10_stats_thread have their cpu time written too.
+ */
+
+#ifndef CS10_STATS_H_INCLUDED
+#define CS10_STATS_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CS10_STATS_INTERVAL_S 10
+#define CS10_STATS_THREADS    4
+
+typedef enum CS10_COUNTER_E {
+  SURFACE_CONTROL_IN_COUNTER,  /* controllers from the surface */
+  SURFACE_OTHER_IN_COUNTER,    /* anything else, passed on to the daw */
+  DAW_CONTROL_IN_COUNTER,      /* feedback from the daw */
+  DAW_SYSEX_IN_COUNTER,        /* mtc full frames and mmc */
+  DAW_QFRAME_IN_COUNTER,
+  DAW_OTHER_IN_COUNTER,
+  CONTROL_OUT_COUNTER,         /* controllers sent to the daw */
+  LED_SYSEX_OUT_COUNTER,       /* LED and seven segment sysex */
+  MMC_OUT_COUNTER,             /* transport lane sysex */
+  OTHER_OUT_COUNTER,
+  SURFACE_BYTES_OUT_COUNTER,
+  OUTPUT_DRAIN_COUNTER,
+  RESTORE_STEP_COUNTER,
+  RESTORE_ABORTED_COUNTER,     /* retargeted before it was done */
+  SAVE_COUNTER,                /* settings file written */
+  QFRAME_TIME_COUNTER,         /* times put together from quarter frames */
+  FULL_FRAME_TIME_COUNTER,
+  LOCATE_TIME_COUNTER,
+  NUM_COUNTERS
+} cs10_counter_t ;
+
+extern uint64_t cs10_counters[NUM_COUNTERS] ;
+
+#define CS10_COUNT_ADD(counter, n) \
+  __atomic_fetch_add(&cs10_counters[counter], (n), __ATOMIC_RELAXED)
+#define CS10_COUNT(counter) CS10_COUNT_ADD(counter, 1)
+
+void
+cs10_stats_thread(
+  const char *pName) ;
+
+bool
+cs10_stats_start(
+  const char *pFilename) ;
+
+void
+cs10_stats_stop(void) ;
+
+#endif /* CS10_STATS_H_INCLUDED */
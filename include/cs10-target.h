@@ -0,0 +1,94 @@
+/* cs10-target.h
+ *
+ * extra sequencer ports for whatever else should follow the surface
+ * besides the daw, a video player slaved over mmc say. each target is
+ * a port of its own, named in a targets file of one setting to a line:
+ *
+ *   target NAME              the settings after it are for port NAME
+ *   map PATH                 its own map, otherwise it shares the daw's
+ *   transport                it follows mmc commands and locates
+ *   tracks N or N-M          it follows these virtual tracks, 1 to 32
+ *   controls NAME ...        only these controls of them
+ *
+ * a target with tracks and no controls follows every control of them,
+ * one with controls and no tracks follows them on every track.
+ * the event going to the daw is made once and handed on to each target
+ * that follows it, with only the channel and cc swapped for its own.
+ * targets only listen, nothing is read back from them.
+ * only the surface thread may use it.
+ */
+
+#ifndef CS10_TARGET_H_INCLUDED
+#define CS10_TARGET_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <alsa/asoundlib.h>
+
+#include "cs10-map.h"
+
+#define CS10_MAX_TARGETS        4
+#define CS10_TARGET_NAME_LENGTH 32
+
+typedef struct CS10_TARGET_S {
+  char          cName[CS10_TARGET_NAME_LENGTH] ;
+  int           iPortID ;
+  bool          bTransport ;
+  uint32_t      ulTrackMask ;    /* virtual tracks it follows */
+  unsigned int  uiControlMask ;  /* and which of their controls */
+  cs10_map_t   *pMap ;           /* NULL to share the daw's */
+} cs10_target_t ;
+
+bool
+cs10_target_load(
+  const char *pFilename,
+  const char * const *ppControlNames) ;
+
+bool
+cs10_target_open(
+  snd_seq_t *pSeq) ;
+
+void
+cs10_target_close(void) ;
+
+unsigned int
+cs10_target_count(void) ;
+
+const cs10_target_t *
+cs10_target_get(
+  unsigned int uiTarget) ;
+
+/*
+ * cs10_target_remap
+ *
+ * make pEvent, the controller for uiStrip's tcControl as it goes to the
+ * daw, into the one pTarget takes
+ * return false if pTarget doesn't follow it
+ */
+static inline bool
+cs10_target_remap(
+  const cs10_target_t *pTarget,
+  const cs10_map_t *pDAWMap,
+  unsigned int uiStrip,
+  virtual_track_control_t tcControl,
+  snd_seq_event_t *pEvent) {
+
+  unsigned int uiChannel ;
+  unsigned int uiCC ;
+
+  if ((CS10_MAP_MAX_STRIPS <= uiStrip) ||
+      (0 == (pTarget->ulTrackMask & (1U << uiStrip))) ||
+      (0 == (pTarget->uiControlMask & (1U << tcControl))))
+    return false ;
+
+  if (!cs10_map_to_cc((pTarget->pMap ? pTarget->pMap : pDAWMap),
+                      uiStrip, tcControl, &uiChannel, &uiCC))
+    return false ;
+
+  pEvent->data.control.channel = uiChannel ;
+  pEvent->data.control.param = uiCC ;
+
+  return true ;
+} /* cs10_target_remap */
+
+#endif /* CS10_TARGET_H_INCLUDED */
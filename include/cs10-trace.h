@@ -0,0 +1,64 @@
+/* cs10-trace.h
+ *
+ * a timeline of where the time goes, for chrome://tracing or perfetto.
+ * spans are opened and closed around event dispatch, mode changes,
+ * restore steps, output drains and the waits in poll, and every event
+ * sent out is marked as an instant on its lane.
+ * the trace points are only built in with CS10_TRACE defined (make
+ * TRACE=1), and then cost a single branch until cs10_trace_open is
+ * called. each thread keeps the latest CS10_TRACE_EVENTS on a ring of
+ * its own, the rings are written out as json by cs10_trace_close.
+ * names must be string constants, only pointers to them are kept.
+ */
+
+#ifndef CS10_TRACE_H_INCLUDED
+#define CS10_TRACE_H_INCLUDED
+
+#include <stdbool.h>
+
+#define CS10_TRACE_EVENTS  65536 /* per thread, a power of two */
+#define CS10_TRACE_THREADS 4
+
+#ifdef CS10_TRACE
+
+extern bool cs10_trace_enabled ;
+
+#define CS10_TRACE_IF(call) \
+  do { if (__builtin_expect(cs10_trace_enabled, 0)) call ; } while (0)
+
+#define CS10_TRACE_BEGIN(name) \
+  CS10_TRACE_IF(cs10_trace_put((name), 'B', 0))
+#define CS10_TRACE_END(name) \
+  CS10_TRACE_IF(cs10_trace_put((name), 'E', 0))
+#define CS10_TRACE_INSTANT(name, arg) \
+  CS10_TRACE_IF(cs10_trace_put((name), 'i', (arg)))
+#define CS10_TRACE_THREAD(name) \
+  CS10_TRACE_IF(cs10_trace_thread(name))
+
+void
+cs10_trace_put(
+  const char *pName,
+  char cPhase,
+  int iArg) ;
+
+void
+cs10_trace_thread(
+  const char *pName) ;
+
+#else
+
+#define CS10_TRACE_BEGIN(name)        do { } while (0)
+#define CS10_TRACE_END(name)          do { } while (0)
+#define CS10_TRACE_INSTANT(name, arg) do { } while (0)
+#define CS10_TRACE_THREAD(name)       do { } while (0)
+
+#endif /* CS10_TRACE */
+
+bool
+cs10_trace_open(
+  const char *pFilename) ;
+
+void
+cs10_trace_close(void) ;
+
+#endif /* CS10_TRACE_H_INCLUDED */
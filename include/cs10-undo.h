@@ -0,0 +1,45 @@
+/* cs10-undo.h
+ *
+ * a ring of changes that can be undone and redone. each change is a
+ * step of one or more deltas, a key with the value it had before and
+ * after, so undoing a step only ever touches what the step changed.
+ * the ring is a fixed array, a step that doesn't fit pushes the oldest
+ * steps out, and a new step forgets anything that could have been
+ * redone.
+ * not locked, only one thread may use it.
+ */
+
+#ifndef CS10_UNDO_H_INCLUDED
+#define CS10_UNDO_H_INCLUDED
+
+#include <stdbool.h>
+
+#define CS10_UNDO_ENTRIES   4096    /* a power of two */
+#define CS10_UNDO_MAX_KEY   0x7fff
+
+/* set whatever uiKey stands for to uiValue */
+typedef void (*cs10_undo_apply_fn)(
+  void *pArg,
+  unsigned int uiKey,
+  unsigned int uiValue) ;
+
+void
+cs10_undo_begin(void) ;
+
+bool
+cs10_undo_note(
+  unsigned int uiKey,
+  unsigned int uiFrom,
+  unsigned int uiTo) ;
+
+bool
+cs10_undo(
+  cs10_undo_apply_fn pfnApply,
+  void *pArg) ;
+
+bool
+cs10_redo(
+  cs10_undo_apply_fn pfnApply,
+  void *pArg) ;
+
+#endif /* CS10_UNDO_H_INCLUDED */
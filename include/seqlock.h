@@ -0,0 +1,71 @@
+/* seqlock.h
+ *
+ * a tiny sequence lock for state shared between the surface and daw threads.
+ * writers serialize on a mutex and bump the sequence around their update,
+ * readers never block: they copy what they need and retry if a writer
+ * got in the way.
+ */
+
+#ifndef SEQLOCK_H_INCLUDED
+#define SEQLOCK_H_INCLUDED
+
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef struct SEQLOCK_S {
+  volatile unsigned int uiSequence ;
+  pthread_mutex_t       writeLock ;
+} seqlock_t ;
+
+static inline void
+seqlock_init(
+  seqlock_t *pLock) {
+
+  pLock->uiSequence = 0 ;
+  pthread_mutex_init(&pLock->writeLock, NULL) ;
+} /* seqlock_init */
+
+static inline void
+seqlock_write_begin(
+  seqlock_t *pLock) {
+
+  pthread_mutex_lock(&pLock->writeLock) ;
+  __atomic_store_n(&pLock->uiSequence, pLock->uiSequence + 1,
+                   __ATOMIC_RELAXED) ;
+  __atomic_thread_fence(__ATOMIC_RELEASE) ;
+} /* seqlock_write_begin */
+
+static inline void
+seqlock_write_end(
+  seqlock_t *pLock) {
+
+  __atomic_store_n(&pLock->uiSequence, pLock->uiSequence + 1,
+                   __ATOMIC_RELEASE) ;
+  pthread_mutex_unlock(&pLock->writeLock) ;
+} /* seqlock_write_end */
+
+static inline unsigned int
+seqlock_read_begin(
+  const seqlock_t *pLock) {
+
+  unsigned int uiSequence ;
+
+  while ((uiSequence = __atomic_load_n(&pLock->uiSequence,
+                                       __ATOMIC_ACQUIRE)) & 1)
+    ;
+
+  return uiSequence ;
+} /* seqlock_read_begin */
+
+static inline bool
+seqlock_read_retry(
+  const seqlock_t *pLock,
+  unsigned int uiSequence) {
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE) ;
+
+  return (__atomic_load_n(&pLock->uiSequence, __ATOMIC_RELAXED) !=
+          uiSequence) ;
+} /* seqlock_read_retry */
+
+#endif /* SEQLOCK_H_INCLUDED */
@@ -0,0 +1,422 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "cs10-automation.h"
+
+/*****************************************************************************/
+
+#define AUTOMATION_MAGIC   "cs10aut"
+#define AUTOMATION_VERSION 1
+#define AUTOMATION_HEADER_BYTES 4096   /* keeps the streams page aligned */
+
+/* every event takes at least two bytes, so this many keys always do */
+#define AUTOMATION_MAX_KEYS \
+  (CS10_AUTOMATION_STREAM_BYTES / (2 * CS10_AUTOMATION_KEY_EVENTS) + 1)
+
+typedef struct CS10_AUTOMATION_HEADER_S {
+  char     cMagic[8] ;
+  uint32_t ulVersion ;
+  uint32_t ulStreams ;
+  uint32_t ulStreamBytes ;
+  uint32_t ulKeyEvents ;
+} cs10_automation_header_t ;
+
+typedef struct CS10_AUTOMATION_KEY_S {
+  uint32_t ulFrame ;
+  uint32_t ulOffset ;
+} cs10_automation_key_t ;
+
+typedef struct CS10_AUTOMATION_STREAM_S {
+  uint32_t              ulBytes ;
+  uint32_t              ulEvents ;
+  uint32_t              ulLastFrame ;
+  uint32_t              ulLastValue ;
+  cs10_automation_key_t keys[AUTOMATION_MAX_KEYS] ;
+  unsigned char         ucData[] ;
+} cs10_automation_stream_t ;
+
+#define AUTOMATION_DATA_BYTES \
+  (CS10_AUTOMATION_STREAM_BYTES - sizeof(cs10_automation_stream_t))
+
+/* where playback of a stream has got to */
+typedef struct CS10_AUTOMATION_CURSOR_S {
+  uint32_t ulOffset ;   /* of the next event */
+  uint32_t ulEvent ;    /* and its index */
+  uint32_t ulFrame ;    /* frame of the event before it */
+} cs10_automation_cursor_t ;
+
+static struct CS10_AUTOMATION_S {
+  unsigned char            *pBase ;
+  size_t                    uiLength ;
+  unsigned int              uiStreams ;
+  cs10_automation_cursor_t *pCursor ;
+} automation ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_automation_stream
+ *
+ * the stream for uiStream
+ */
+static cs10_automation_stream_t *
+cs10_automation_stream(
+  unsigned int uiStream) {
+
+  return (cs10_automation_stream_t *)(automation.pBase +
+    AUTOMATION_HEADER_BYTES + (size_t)uiStream * CS10_AUTOMATION_STREAM_BYTES) ;
+} /* cs10_automation_stream */
+
+/*
+ * cs10_automation_open
+ *
+ * map pFilename with room for uiStreams streams, starting it over if it
+ * was written with some other layout
+ */
+bool
+cs10_automation_open(
+  const char *pFilename,
+  unsigned int uiStreams) {
+
+  cs10_automation_header_t theHeader ;
+  int                      iFD ;
+  bool                     bFresh ;
+
+  automation.uiStreams = uiStreams ;
+  automation.uiLength = AUTOMATION_HEADER_BYTES +
+                        (size_t)uiStreams * CS10_AUTOMATION_STREAM_BYTES ;
+
+  automation.pCursor = calloc(uiStreams, sizeof(cs10_automation_cursor_t)) ;
+
+  if (NULL == automation.pCursor)
+    return false ;
+
+  iFD = open(pFilename, O_RDWR | O_CREAT | O_CLOEXEC, 0600) ;
+
+  if (0 > iFD) {
+    free(automation.pCursor) ;
+    automation.pCursor = NULL ;
+    return false ;
+  } /* if */
+
+  bFresh = ((sizeof(theHeader) != pread(iFD, &theHeader, sizeof(theHeader), 0)) ||
+            (0 != memcmp(theHeader.cMagic, AUTOMATION_MAGIC,
+                         sizeof(AUTOMATION_MAGIC))) ||
+            (AUTOMATION_VERSION != theHeader.ulVersion) ||
+            (uiStreams != theHeader.ulStreams) ||
+            (CS10_AUTOMATION_STREAM_BYTES != theHeader.ulStreamBytes) ||
+            (CS10_AUTOMATION_KEY_EVENTS != theHeader.ulKeyEvents)) ;
+
+  /* truncating to nothing first leaves the whole file as holes */
+  if ((bFresh && (0 != ftruncate(iFD, 0))) ||
+      (0 != ftruncate(iFD, automation.uiLength))) {
+    close(iFD) ;
+    free(automation.pCursor) ;
+    automation.pCursor = NULL ;
+    return false ;
+  } /* if */
+
+  automation.pBase = mmap(NULL, automation.uiLength, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, iFD, 0) ;
+  close(iFD) ;
+
+  if (MAP_FAILED == automation.pBase) {
+    automation.pBase = NULL ;
+    free(automation.pCursor) ;
+    automation.pCursor = NULL ;
+    return false ;
+  } /* if */
+
+  if (bFresh) {
+    memset(&theHeader, 0, sizeof(theHeader)) ;
+    memcpy(theHeader.cMagic, AUTOMATION_MAGIC, sizeof(AUTOMATION_MAGIC)) ;
+    theHeader.ulVersion = AUTOMATION_VERSION ;
+    theHeader.ulStreams = uiStreams ;
+    theHeader.ulStreamBytes = CS10_AUTOMATION_STREAM_BYTES ;
+    theHeader.ulKeyEvents = CS10_AUTOMATION_KEY_EVENTS ;
+    memcpy(automation.pBase, &theHeader, sizeof(theHeader)) ;
+  } /* if */
+
+  return true ;
+} /* cs10_automation_open */
+
+/*
+ * cs10_automation_close
+ *
+ * write everything out and unmap
+ */
+void
+cs10_automation_close(void) {
+
+  if (NULL == automation.pBase)
+    return ;
+
+  msync(automation.pBase, automation.uiLength, MS_SYNC) ;
+  munmap(automation.pBase, automation.uiLength) ;
+  automation.pBase = NULL ;
+
+  free(automation.pCursor) ;
+  automation.pCursor = NULL ;
+} /* cs10_automation_close */
+
+/*
+ * cs10_automation_is_open
+ *
+ * is there anywhere to record to or play from
+ */
+bool
+cs10_automation_is_open(void) {
+
+  return (NULL != automation.pBase) ;
+} /* cs10_automation_is_open */
+
+/*
+ * cs10_automation_decode
+ *
+ * read the event at pCursor, moving it on to the next
+ * return the value
+ */
+static unsigned int
+cs10_automation_decode(
+  cs10_automation_stream_t *pStream,
+  cs10_automation_cursor_t *pCursor) {
+
+  uint32_t     ulStep = 0 ;
+  unsigned int uiShift = 0 ;
+  unsigned char ucByte ;
+
+  do {
+    ucByte = pStream->ucData[pCursor->ulOffset++] ;
+    ulStep |= (uint32_t)(ucByte & 0x7f) << uiShift ;
+    uiShift += 7 ;
+  } while (ucByte & 0x80) ;
+
+  /* a key holds the frame outright, so a scan can start there */
+  if (0 == pCursor->ulEvent % CS10_AUTOMATION_KEY_EVENTS)
+    pCursor->ulFrame =
+      pStream->keys[pCursor->ulEvent / CS10_AUTOMATION_KEY_EVENTS].ulFrame ;
+  else
+    pCursor->ulFrame += ulStep ;
+
+  pCursor->ulEvent++ ;
+
+  return pStream->ucData[pCursor->ulOffset++] ;
+} /* cs10_automation_decode */
+
+/*
+ * cs10_automation_peek_frame
+ *
+ * the frame of the event at pCursor, which must exist
+ */
+static uint32_t
+cs10_automation_peek_frame(
+  cs10_automation_stream_t *pStream,
+  const cs10_automation_cursor_t *pCursor) {
+
+  cs10_automation_cursor_t theCursor = *pCursor ;
+
+  cs10_automation_decode(pStream, &theCursor) ;
+
+  return theCursor.ulFrame ;
+} /* cs10_automation_peek_frame */
+
+/*
+ * cs10_automation_find
+ *
+ * point pCursor at the first event of uiStream after ulFrame
+ * return the value of the last event at or before it, -1 if none is
+ */
+static int
+cs10_automation_find(
+  cs10_automation_stream_t *pStream,
+  cs10_automation_cursor_t *pCursor,
+  uint32_t ulFrame) {
+
+  uint32_t ulKeys = (pStream->ulEvents + CS10_AUTOMATION_KEY_EVENTS - 1) /
+                    CS10_AUTOMATION_KEY_EVENTS ;
+  uint32_t ulLow = 0 ;
+  uint32_t ulHigh = ulKeys ;
+  int      iValue = -1 ;
+
+  memset(pCursor, 0, sizeof(*pCursor)) ;
+
+  if ((0 == ulKeys) || (pStream->keys[0].ulFrame > ulFrame))
+    return -1 ;
+
+  /* the last key at or before ulFrame */
+  while (ulHigh - ulLow > 1) {
+    uint32_t ulMiddle = ulLow + (ulHigh - ulLow) / 2 ;
+
+    if (pStream->keys[ulMiddle].ulFrame <= ulFrame)
+      ulLow = ulMiddle ;
+    else
+      ulHigh = ulMiddle ;
+  } /* while */
+
+  pCursor->ulOffset = pStream->keys[ulLow].ulOffset ;
+  pCursor->ulEvent = ulLow * CS10_AUTOMATION_KEY_EVENTS ;
+
+  /* and no more than a key's worth of events on from there */
+  while ((pCursor->ulEvent < pStream->ulEvents) &&
+         (cs10_automation_peek_frame(pStream, pCursor) <= ulFrame))
+    iValue = cs10_automation_decode(pStream, pCursor) ;
+
+  return iValue ;
+} /* cs10_automation_find */
+
+/*
+ * cs10_automation_truncate
+ *
+ * forget every event of uiStream from ulFrame on
+ */
+void
+cs10_automation_truncate(
+  unsigned int uiStream,
+  uint32_t ulFrame) {
+
+  cs10_automation_stream_t *pStream ;
+  cs10_automation_cursor_t *pCursor ;
+  int                       iValue ;
+
+  if ((NULL == automation.pBase) || (uiStream >= automation.uiStreams))
+    return ;
+
+  pStream = cs10_automation_stream(uiStream) ;
+  pCursor = &automation.pCursor[uiStream] ;
+
+  iValue = (ulFrame ? cs10_automation_find(pStream, pCursor, ulFrame - 1) : -1) ;
+
+  if (0 > iValue) {
+    pStream->ulBytes = 0 ;
+    pStream->ulEvents = 0 ;
+    pStream->ulLastFrame = 0 ;
+    pStream->ulLastValue = 0 ;
+    memset(pCursor, 0, sizeof(*pCursor)) ;
+    return ;
+  } /* if */
+
+  pStream->ulBytes = pCursor->ulOffset ;
+  pStream->ulEvents = pCursor->ulEvent ;
+  pStream->ulLastFrame = pCursor->ulFrame ;
+  pStream->ulLastValue = iValue ;
+} /* cs10_automation_truncate */
+
+/*
+ * cs10_automation_record
+ *
+ * add uiValue at ulFrame to the end of uiStream, a frame earlier than the
+ * end replaces everything from there on
+ * return false when the stream is full
+ */
+bool
+cs10_automation_record(
+  unsigned int uiStream,
+  uint32_t ulFrame,
+  unsigned int uiValue) {
+
+  cs10_automation_stream_t *pStream ;
+  unsigned char             ucEvent[6] ;
+  unsigned int              uiLength = 0 ;
+  uint32_t                  ulStep ;
+
+  if ((NULL == automation.pBase) || (uiStream >= automation.uiStreams))
+    return false ;
+
+  pStream = cs10_automation_stream(uiStream) ;
+
+  if (pStream->ulEvents && (ulFrame < pStream->ulLastFrame))
+    cs10_automation_truncate(uiStream, ulFrame) ;
+
+  if (pStream->ulEvents) {
+    if (uiValue == pStream->ulLastValue)
+      return true ;
+
+    /* one value a frame, the latest */
+    if (ulFrame == pStream->ulLastFrame) {
+      pStream->ucData[pStream->ulBytes - 1] = uiValue ;
+      pStream->ulLastValue = uiValue ;
+      return true ;
+    } /* if */
+  } /* if */
+
+  ulStep = ulFrame - pStream->ulLastFrame ;
+
+  do {
+    ucEvent[uiLength++] = (ulStep & 0x7f) | (ulStep > 0x7f ? 0x80 : 0) ;
+    ulStep >>= 7 ;
+  } while (ulStep) ;
+
+  ucEvent[uiLength++] = uiValue & 0x7f ;
+
+  if (pStream->ulBytes + uiLength > AUTOMATION_DATA_BYTES)
+    return false ;
+
+  if (0 == pStream->ulEvents % CS10_AUTOMATION_KEY_EVENTS) {
+    cs10_automation_key_t *pKey =
+      &pStream->keys[pStream->ulEvents / CS10_AUTOMATION_KEY_EVENTS] ;
+
+    pKey->ulFrame = ulFrame ;
+    pKey->ulOffset = pStream->ulBytes ;
+  } /* if */
+
+  memcpy(pStream->ucData + pStream->ulBytes, ucEvent, uiLength) ;
+  pStream->ulBytes += uiLength ;
+  pStream->ulEvents++ ;
+  pStream->ulLastFrame = ulFrame ;
+  pStream->ulLastValue = uiValue ;
+
+  return true ;
+} /* cs10_automation_record */
+
+/*
+ * cs10_automation_seek
+ *
+ * move playback of uiStream to ulFrame
+ * return the value the stream holds there, -1 if it doesn't start yet
+ */
+int
+cs10_automation_seek(
+  unsigned int uiStream,
+  uint32_t ulFrame) {
+
+  if ((NULL == automation.pBase) || (uiStream >= automation.uiStreams))
+    return -1 ;
+
+  return cs10_automation_find(cs10_automation_stream(uiStream),
+                              &automation.pCursor[uiStream], ulFrame) ;
+} /* cs10_automation_seek */
+
+/*
+ * cs10_automation_play
+ *
+ * move playback of uiStream on to ulFrame
+ * return the last value passed on the way, -1 if nothing was due
+ */
+int
+cs10_automation_play(
+  unsigned int uiStream,
+  uint32_t ulFrame) {
+
+  cs10_automation_stream_t *pStream ;
+  cs10_automation_cursor_t *pCursor ;
+  int                       iValue = -1 ;
+
+  if ((NULL == automation.pBase) || (uiStream >= automation.uiStreams))
+    return -1 ;
+
+  pStream = cs10_automation_stream(uiStream) ;
+  pCursor = &automation.pCursor[uiStream] ;
+
+  while ((pCursor->ulEvent < pStream->ulEvents) &&
+         (cs10_automation_peek_frame(pStream, pCursor) <= ulFrame))
+    iValue = cs10_automation_decode(pStream, pCursor) ;
+
+  return iValue ;
+} /* cs10_automation_play */
@@ -0,0 +1,828 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <alsa/asoundlib.h>
+
+#include "cs10-check.h"
+#include "cs10-map.h"
+#include "cs10-journal.h"
+#include "cs10-undo.h"
+#include "cs10-automation.h"
+#include "cs10-control.h"
+#include "cs10-macro.h"
+#include "cs10-target.h"
+
+/*****************************************************************************/
+
+#define CHECK_KEYS           64
+#define CHECK_UNDO_KEYS      8
+#define CHECK_UNDO_STEPS     (CS10_UNDO_ENTRIES + 1000)
+#define CHECK_EVENTS         500
+#define CHECK_STREAMS        2
+#define CHECK_REPLY_TRIES    200
+#define CHECK_REPLY_WAIT_MS  10
+#define CHECK_LONG_LINE      (CS10_CONTROL_LINE + 500)
+
+/* as cs10-linux names the controls in its files */
+static const char *checkControlName[NUM_VIRTUAL_TRACK_CONTROLS] = {
+  "armed",
+  "mute",
+  "solo",
+  "fader",
+  "boost",
+  "frequency",
+  "bandwidth",
+  "send1",
+  "send2",
+  "pan"
+} ;
+
+/* steps between automation events, for one, two, three and four
+ * byte varints
+ */
+static const uint32_t checkStep[] = {
+  1, 3, 127, 128, 300, 16383, 16384, 2000000
+} ;
+
+#define CHECK_NUM_STEPS (sizeof(checkStep) / sizeof(checkStep[0]))
+
+typedef struct CHECK_STATE_S {
+  uint16_t usValue[CHECK_KEYS] ;
+} check_state_t ;
+
+static struct CS10_CHECK_S {
+  FILE         *pReport ;
+  const char   *pDirectory ;
+  unsigned int  uiChecks ;
+  unsigned int  uiFailed ;
+
+  check_state_t csLive ;
+  unsigned int  uiUndoValue[CHECK_UNDO_KEYS] ;
+
+  uint32_t      ulFrame[CHECK_EVENTS + 1] ;
+  unsigned int  uiValue[CHECK_EVENTS + 1] ;
+  unsigned int  uiEvents ;
+} check ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_check_that
+ *
+ * count one check, and report it if it failed
+ */
+static bool
+cs10_check_that(
+  bool bPassed,
+  const char *pWhat) {
+
+  check.uiChecks++ ;
+
+  if (!bPassed) {
+    check.uiFailed++ ;
+    fprintf(check.pReport, "FAILED: %s\n", pWhat) ;
+  } /* if */
+
+  return bPassed ;
+} /* cs10_check_that */
+
+/*
+ * cs10_check_path
+ *
+ * pName in the check directory, in a buffer of its own each call
+ */
+static const char *
+cs10_check_path(
+  const char *pName) {
+
+  static char  cPath[4][256] ;
+  static unsigned int uiNext ;
+  char        *pPath = cPath[uiNext++ % 4] ;
+
+  snprintf(pPath, sizeof(cPath[0]), "%s/%s", check.pDirectory, pName) ;
+
+  return pPath ;
+} /* cs10_check_path */
+
+/*
+ * cs10_check_write_file
+ *
+ * write pText to pName in the check directory
+ */
+static bool
+cs10_check_write_file(
+  const char *pName,
+  const char *pText) {
+
+  FILE *fp = fopen(cs10_check_path(pName), "w") ;
+
+  if (NULL == fp)
+    return false ;
+
+  fputs(pText, fp) ;
+
+  return (0 == fclose(fp)) ;
+} /* cs10_check_write_file */
+
+/*****************************************************************************/
+
+/*
+ * cs10_check_snapshot
+ *
+ * the journal's view of the live state
+ */
+static void
+cs10_check_snapshot(
+  void *pSnapshot) {
+
+  memcpy(pSnapshot, &check.csLive, sizeof(check_state_t)) ;
+} /* cs10_check_snapshot */
+
+/*
+ * cs10_check_record
+ *
+ * replay one journalled change
+ */
+static void
+cs10_check_record(
+  void *pSnapshot,
+  unsigned int uiKey,
+  unsigned int uiValue) {
+
+  if (uiKey < CHECK_KEYS)
+    ((check_state_t *)pSnapshot)->usValue[uiKey] = uiValue ;
+} /* cs10_check_record */
+
+/*
+ * cs10_check_journal
+ *
+ * changes come back from the journal after a clean close and after
+ * a crash, across snapshots and the ring wrapping
+ */
+static void
+cs10_check_journal(void) {
+
+  const char    *pPath = cs10_check_path("journal") ;
+  check_state_t  csReplayed ;
+  unsigned char *pScratch ;
+  unsigned int   uiChange ;
+
+  memset(&check.csLive, 0, sizeof(check.csLive)) ;
+  unlink(pPath) ;
+
+  if (!cs10_check_that(cs10_journal_open(pPath, sizeof(check_state_t), 16,
+                                         cs10_check_snapshot),
+                       "journal opens"))
+    return ;
+
+  cs10_check_that(!cs10_journal_replay(&csReplayed, cs10_check_record),
+                  "a new journal has nothing to replay") ;
+
+  pScratch = cs10_journal_scratch() ;
+  pScratch[0] = 0x5a ;
+
+  /* enough for a few snapshots and the ring to go round twice */
+  for (uiChange = 0 ; uiChange < 2 * CS10_JOURNAL_RECORDS + 17 ; uiChange++) {
+    unsigned int uiKey = (uiChange * 7) % CHECK_KEYS ;
+
+    check.csLive.usValue[uiKey] = uiChange ;
+    cs10_journal_append(uiKey, uiChange) ;
+  } /* for */
+
+  /* open it again without closing, as a crash would leave it */
+  memset(&csReplayed, 0, sizeof(csReplayed)) ;
+
+  if (cs10_check_that(cs10_journal_open(pPath, sizeof(check_state_t), 16,
+                                        cs10_check_snapshot),
+                      "journal opens after a crash"))
+    cs10_check_that(cs10_journal_replay(&csReplayed, cs10_check_record) &&
+                    (0 == memcmp(&csReplayed, &check.csLive,
+                                 sizeof(csReplayed))),
+                    "journal replays every change after a crash") ;
+
+  check.csLive.usValue[3] = 1234 ;
+  cs10_journal_append(3, 1234) ;
+  cs10_journal_close() ;
+
+  memset(&csReplayed, 0, sizeof(csReplayed)) ;
+
+  if (cs10_check_that(cs10_journal_open(pPath, sizeof(check_state_t), 16,
+                                        cs10_check_snapshot),
+                      "journal opens after a close")) {
+    cs10_check_that(cs10_journal_replay(&csReplayed, cs10_check_record) &&
+                    (0 == memcmp(&csReplayed, &check.csLive,
+                                 sizeof(csReplayed))),
+                    "journal replays every change after a close") ;
+
+    pScratch = cs10_journal_scratch() ;
+    cs10_check_that(0x5a == pScratch[0], "journal keeps its scratch area") ;
+    cs10_journal_close() ;
+  } /* if */
+
+  /* a different layout starts over rather than replay nonsense */
+  if (cs10_check_that(cs10_journal_open(pPath, sizeof(check_state_t), 32,
+                                        cs10_check_snapshot),
+                      "journal opens with another layout")) {
+    cs10_check_that(!cs10_journal_replay(&csReplayed, cs10_check_record),
+                    "journal with another layout starts over") ;
+    cs10_journal_close() ;
+  } /* if */
+
+  unlink(pPath) ;
+} /* cs10_check_journal */
+
+/*****************************************************************************/
+
+/*
+ * cs10_check_undo_apply
+ *
+ * set an undo key to a value
+ */
+static void
+cs10_check_undo_apply(
+  void *pArg,
+  unsigned int uiKey,
+  unsigned int uiValue) {
+
+  unsigned int *pValue = pArg ;
+
+  if (uiKey < CHECK_UNDO_KEYS)
+    pValue[uiKey] = uiValue ;
+} /* cs10_check_undo_apply */
+
+/*
+ * cs10_check_undo_set
+ *
+ * change an undo key and note it in the step being made
+ */
+static void
+cs10_check_undo_set(
+  unsigned int uiKey,
+  unsigned int uiValue) {
+
+  cs10_undo_note(uiKey, check.uiUndoValue[uiKey], uiValue) ;
+  check.uiUndoValue[uiKey] = uiValue ;
+} /* cs10_check_undo_set */
+
+/*
+ * cs10_check_undo
+ *
+ * steps undo and redo whole, a new step forgets the redo, and a full
+ * ring lets go of the oldest steps only
+ */
+static void
+cs10_check_undo(void) {
+
+  unsigned int uiKept[CHECK_UNDO_KEYS] ;
+  unsigned int uiStep ;
+  unsigned int uiUndone = 0 ;
+
+  memset(check.uiUndoValue, 0, sizeof(check.uiUndoValue)) ;
+
+  cs10_undo_begin() ;
+  cs10_check_undo_set(0, 10) ;
+  cs10_check_undo_set(1, 20) ;
+  cs10_undo_begin() ;
+  cs10_check_undo_set(0, 30) ;
+
+  cs10_check_that(cs10_undo(cs10_check_undo_apply, check.uiUndoValue) &&
+                  (10 == check.uiUndoValue[0]) &&
+                  (20 == check.uiUndoValue[1]),
+                  "undo takes back the last step") ;
+  cs10_check_that(cs10_undo(cs10_check_undo_apply, check.uiUndoValue) &&
+                  (0 == check.uiUndoValue[0]) &&
+                  (0 == check.uiUndoValue[1]),
+                  "undo takes back a step of two changes together") ;
+  cs10_check_that(!cs10_undo(cs10_check_undo_apply, check.uiUndoValue),
+                  "undo stops at the first step") ;
+  cs10_check_that(cs10_redo(cs10_check_undo_apply, check.uiUndoValue) &&
+                  (10 == check.uiUndoValue[0]) &&
+                  (20 == check.uiUndoValue[1]),
+                  "redo puts a step of two changes back") ;
+
+  /* a new step after an undo leaves nothing to redo */
+  cs10_undo_begin() ;
+  cs10_check_undo_set(2, 40) ;
+  cs10_check_that(!cs10_redo(cs10_check_undo_apply, check.uiUndoValue),
+                  "a new step forgets what could be redone") ;
+  cs10_check_that(cs10_undo(cs10_check_undo_apply, check.uiUndoValue) &&
+                  (0 == check.uiUndoValue[2]) &&
+                  (10 == check.uiUndoValue[0]),
+                  "undo takes back the new step") ;
+
+  /* more steps than the ring holds, the oldest go */
+  for (uiStep = 0 ; uiStep < CHECK_UNDO_STEPS ; uiStep++) {
+    if (CHECK_UNDO_STEPS - CS10_UNDO_ENTRIES == uiStep)
+      memcpy(uiKept, check.uiUndoValue, sizeof(uiKept)) ;
+
+    cs10_undo_begin() ;
+    cs10_check_undo_set(uiStep % CHECK_UNDO_KEYS,
+                        (check.uiUndoValue[uiStep % CHECK_UNDO_KEYS] + 1) &
+                        0xff) ;
+  } /* for */
+
+  while (cs10_undo(cs10_check_undo_apply, check.uiUndoValue))
+    uiUndone++ ;
+
+  cs10_check_that(CS10_UNDO_ENTRIES == uiUndone,
+                  "a full undo ring holds its last steps") ;
+  cs10_check_that(0 == memcmp(uiKept, check.uiUndoValue, sizeof(uiKept)),
+                  "undoing a full ring ends at its oldest step") ;
+} /* cs10_check_undo */
+
+/*****************************************************************************/
+
+/*
+ * cs10_check_expected
+ *
+ * the value the reference events hold at ulFrame, -1 before the first
+ */
+static int
+cs10_check_expected(
+  uint32_t ulFrame) {
+
+  int          iValue = -1 ;
+  unsigned int uiEvent ;
+
+  for (uiEvent = 0 ; uiEvent < check.uiEvents ; uiEvent++) {
+    if (check.ulFrame[uiEvent] > ulFrame)
+      break ;
+
+    iValue = check.uiValue[uiEvent] ;
+  } /* for */
+
+  return iValue ;
+} /* cs10_check_expected */
+
+/*
+ * cs10_check_seeks
+ *
+ * seek stream 0 to, and either side of, every reference event
+ * return false at the first that's wrong
+ */
+static bool
+cs10_check_seeks(void) {
+
+  unsigned int uiEvent ;
+
+  if (-1 != cs10_automation_seek(0, 0))
+    return false ;
+
+  for (uiEvent = 0 ; uiEvent < check.uiEvents ; uiEvent++) {
+    uint32_t ulFrame = check.ulFrame[uiEvent] ;
+
+    if ((cs10_check_expected(ulFrame - 1) !=
+         cs10_automation_seek(0, ulFrame - 1)) ||
+        (cs10_check_expected(ulFrame) != cs10_automation_seek(0, ulFrame)) ||
+        (cs10_check_expected(ulFrame + 1) !=
+         cs10_automation_seek(0, ulFrame + 1)))
+      return false ;
+  } /* for */
+
+  return true ;
+} /* cs10_check_seeks */
+
+/*
+ * cs10_check_automation
+ *
+ * varint steps of every length come back from seeks and from playing
+ * through, a punch in replaces the rest of the take, and it all
+ * survives a close
+ */
+static void
+cs10_check_automation(void) {
+
+  const char  *pPath = cs10_check_path("automation") ;
+  unsigned int uiEvent ;
+  uint32_t     ulFrame = 10 ;
+  bool         bPlayed = true ;
+  bool         bRecorded = true ;
+
+  unlink(pPath) ;
+
+  if (!cs10_check_that(cs10_automation_open(pPath, CHECK_STREAMS),
+                       "automation opens"))
+    return ;
+
+  check.uiEvents = CHECK_EVENTS ;
+
+  for (uiEvent = 0 ; uiEvent < CHECK_EVENTS ; uiEvent++) {
+    check.ulFrame[uiEvent] = ulFrame ;
+    check.uiValue[uiEvent] = (uiEvent * 13) & 0x7f ;
+    bRecorded &= cs10_automation_record(0, ulFrame, check.uiValue[uiEvent]) ;
+    ulFrame += checkStep[uiEvent % CHECK_NUM_STEPS] ;
+  } /* for */
+
+  cs10_check_that(bRecorded, "automation records every event") ;
+  cs10_check_that(cs10_check_seeks(), "automation seeks to every event") ;
+
+  /* playing through hands over each event as its frame comes */
+  cs10_automation_seek(0, 0) ;
+
+  for (uiEvent = 0 ; uiEvent < CHECK_EVENTS ; uiEvent++) {
+    if ((check.uiValue[uiEvent] !=
+         (unsigned int)cs10_automation_play(0, check.ulFrame[uiEvent])) ||
+        (-1 != cs10_automation_play(0, check.ulFrame[uiEvent])))
+      bPlayed = false ;
+  } /* for */
+
+  cs10_check_that(bPlayed, "automation plays every event on its frame") ;
+  cs10_check_that(-1 == cs10_automation_seek(1, ulFrame),
+                  "automation streams are kept apart") ;
+
+  /* a punch in half way through replaces the rest */
+  uiEvent = CHECK_EVENTS / 2 ;
+  check.uiValue[uiEvent] = (check.uiValue[uiEvent - 1] + 1) & 0x7f ;
+  check.uiEvents = uiEvent + 1 ;
+  cs10_automation_record(0, check.ulFrame[uiEvent], check.uiValue[uiEvent]) ;
+
+  /* and a second value on the same frame replaces the first */
+  check.uiValue[uiEvent] = (check.uiValue[uiEvent] + 1) & 0x7f ;
+  cs10_automation_record(0, check.ulFrame[uiEvent], check.uiValue[uiEvent]) ;
+
+  cs10_check_that(cs10_check_seeks(), "automation punches in") ;
+
+  cs10_automation_close() ;
+
+  if (cs10_check_that(cs10_automation_open(pPath, CHECK_STREAMS),
+                      "automation opens again")) {
+    cs10_check_that(cs10_check_seeks(), "automation survives a close") ;
+    cs10_automation_close() ;
+  } /* if */
+
+  unlink(pPath) ;
+} /* cs10_check_automation */
+
+/*****************************************************************************/
+
+/*
+ * cs10_check_command
+ *
+ * echo the arguments back, or fail when told to
+ */
+static const char *
+cs10_check_command(
+  unsigned int uiArgs,
+  char **ppArgs,
+  FILE *pReply) {
+
+  unsigned int uiArg ;
+
+  if (0 == strcmp("fail", ppArgs[0]))
+    return "failed" ;
+
+  for (uiArg = 1 ; uiArg < uiArgs ; uiArg++)
+    fprintf(pReply, "%s%s", (1 == uiArg) ? "" : " ", ppArgs[uiArg]) ;
+
+  fprintf(pReply, "\n") ;
+
+  return NULL ;
+} /* cs10_check_command */
+
+/*
+ * cs10_check_exchange
+ *
+ * send pLine down iFD and serve the control socket until as much as
+ * pExpected has come back
+ * return true if that's what came back
+ */
+static bool
+cs10_check_exchange(
+  int iFD,
+  const char *pLine,
+  const char *pExpected) {
+
+  struct pollfd theFDs[CS10_CONTROL_FDS] ;
+  char          cReply[256] ;
+  size_t        uiReply = 0 ;
+  size_t        uiExpected = strlen(pExpected) ;
+  unsigned int  uiTry ;
+
+  if (strlen(pLine) != (size_t)send(iFD, pLine, strlen(pLine), MSG_NOSIGNAL))
+    return false ;
+
+  for (uiTry = 0 ;
+       (uiTry < CHECK_REPLY_TRIES) && (uiReply < uiExpected) ;
+       uiTry++) {
+    ssize_t iRead ;
+
+    cs10_control_poll_fds(theFDs) ;
+
+    if (0 < poll(theFDs, CS10_CONTROL_FDS, CHECK_REPLY_WAIT_MS))
+      cs10_control_handle(theFDs) ;
+
+    iRead = recv(iFD, cReply + uiReply, sizeof(cReply) - 1 - uiReply,
+                 MSG_DONTWAIT) ;
+
+    if (0 < iRead)
+      uiReply += iRead ;
+  } /* for */
+
+  cReply[uiReply] = '\0' ;
+
+  if (strcmp(cReply, pExpected))
+    fprintf(check.pReport, "sent %.40s got %s", pLine, cReply) ;
+
+  return (0 == strcmp(cReply, pExpected)) ;
+} /* cs10_check_exchange */
+
+/*
+ * cs10_check_control
+ *
+ * a batch runs its commands in order until one fails and gets a single
+ * reply, too many arguments or too long a line is an error
+ */
+static void
+cs10_check_control(void) {
+
+  const char        *pPath = cs10_check_path("control") ;
+  struct sockaddr_un addr ;
+  char               cLong[CHECK_LONG_LINE + 1] ;
+  int                iFD ;
+
+  if (!cs10_check_that(cs10_control_open(pPath, cs10_check_command),
+                       "control socket opens"))
+    return ;
+
+  iFD = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) ;
+
+  memset(&addr, 0, sizeof(addr)) ;
+  addr.sun_family = AF_UNIX ;
+  strcpy(addr.sun_path, pPath) ;
+
+  if (cs10_check_that((0 <= iFD) &&
+                      (0 == connect(iFD, (struct sockaddr *)&addr,
+                                    sizeof(addr))),
+                      "control socket takes a client")) {
+    cs10_check_that(cs10_check_exchange(iFD, "echo a  b\n", "a b\nok\n"),
+                    "control runs a command") ;
+    cs10_check_that(cs10_check_exchange(iFD,
+                      "echo a;echo b ; ; fail x;echo c\n",
+                      "a\nb\nerror 3 failed\n"),
+                    "control stops a batch at the command that fails") ;
+    cs10_check_that(cs10_check_exchange(iFD, "\n", "ok\n"),
+                    "control answers an empty line") ;
+    cs10_check_that(cs10_check_exchange(iFD, "echo 1 2 3 4 5 6 7\n",
+                                        "1 2 3 4 5 6 7\nok\n"),
+                    "control takes as many arguments as it can") ;
+    cs10_check_that(cs10_check_exchange(iFD, "echo 1 2 3 4 5 6 7 8\n",
+                                        "error 1 too many arguments\n"),
+                    "control refuses too many arguments") ;
+    cs10_check_that(cs10_check_exchange(iFD, "echo a\necho b\n",
+                                        "a\nok\nb\nok\n"),
+                    "control answers each line") ;
+
+    memset(cLong, 'x', CHECK_LONG_LINE - 1) ;
+    cLong[CHECK_LONG_LINE - 1] = '\n' ;
+    cLong[CHECK_LONG_LINE] = '\0' ;
+
+    cs10_check_that(cs10_check_exchange(iFD, cLong,
+                                        "error 0 line too long\n") &&
+                    cs10_check_exchange(iFD, "echo z\n", "z\nok\n"),
+                    "control throws away a long line and carries on") ;
+  } /* if */
+
+  if (0 <= iFD)
+    close(iFD) ;
+
+  cs10_control_close() ;
+} /* cs10_check_control */
+
+/*****************************************************************************/
+
+/*
+ * cs10_check_step
+ *
+ * is step uiStep of pMacro what it should be
+ */
+static bool
+cs10_check_step(
+  const cs10_macro_t *pMacro,
+  unsigned int uiStep,
+  uint32_t ulWaitMs,
+  cs10_macro_action_t action,
+  unsigned int uiArg0,
+  unsigned int uiArg1,
+  unsigned int uiArg2,
+  unsigned int uiArg3) {
+
+  const cs10_macro_step_t *pStep = &pMacro->step[uiStep] ;
+
+  return ((ulWaitMs == pStep->ulWaitMs) &&
+          (action == pStep->ucAction) &&
+          (uiArg0 == pStep->ucArg[0]) &&
+          (uiArg1 == pStep->ucArg[1]) &&
+          (uiArg2 == pStep->ucArg[2]) &&
+          (uiArg3 == pStep->ucArg[3])) ;
+} /* cs10_check_step */
+
+/*
+ * cs10_check_macros
+ *
+ * the macro file is read as written, with waits added up and bad
+ * steps left out, and saving and loading it again changes nothing
+ */
+static void
+cs10_check_macros(void) {
+
+  const cs10_macro_t *pMacro ;
+  cs10_macro_t        theMacro[CS10_MACRO_SLOTS] ;
+  unsigned int        uiSlot ;
+  bool                bSame = true ;
+
+  cs10_check_write_file("macros",
+    "# checks, the bad step and macro 9 are meant to be refused\n"
+    "macro 2\n"
+    "play\n"
+    "wait 250\n"
+    "locate f3\n"
+    "wait 100\n"
+    "  wait 50\n"
+    "locate 01:02:03:04\n"
+    "set 5 pan 64\n"
+    "bad step\n"
+    "stop\n"
+    "\n"
+    "macro 9\n"
+    "play\n"
+    "macro 8\n"
+    "set 32 fader 127\n") ;
+
+  if (!cs10_check_that(cs10_macro_load(cs10_check_path("macros"),
+                                       checkControlName),
+                       "macro file loads"))
+    return ;
+
+  cs10_check_that(NULL == cs10_macro_get(0), "a macro not in the file is empty") ;
+
+  pMacro = cs10_macro_get(1) ;
+
+  cs10_check_that(pMacro && (5 == pMacro->uiSteps) &&
+                  cs10_check_step(pMacro, 0, 0, MACRO_PLAY, 0, 0, 0, 0) &&
+                  cs10_check_step(pMacro, 1, 250, MACRO_LOCATE_SAVED,
+                                  2, 0, 0, 0) &&
+                  cs10_check_step(pMacro, 2, 150, MACRO_LOCATE, 1, 2, 3, 4) &&
+                  cs10_check_step(pMacro, 3, 0, MACRO_SET,
+                                  4, PAN_CONTROL, 64, 0) &&
+                  cs10_check_step(pMacro, 4, 0, MACRO_STOP, 0, 0, 0, 0),
+                  "macro file steps are read as written") ;
+
+  pMacro = cs10_macro_get(7) ;
+
+  cs10_check_that(pMacro && (1 == pMacro->uiSteps) &&
+                  cs10_check_step(pMacro, 0, 0, MACRO_SET,
+                                  31, FADER_CONTROL, 127, 0),
+                  "macro file steps go to the macro above them") ;
+
+  for (uiSlot = 0 ; uiSlot < CS10_MACRO_SLOTS ; uiSlot++) {
+    pMacro = cs10_macro_get(uiSlot) ;
+
+    if (pMacro)
+      theMacro[uiSlot] = *pMacro ;
+    else
+      theMacro[uiSlot].uiSteps = 0 ;
+  } /* for */
+
+  if (cs10_check_that(cs10_macro_save(cs10_check_path("macros-saved"),
+                                      checkControlName) &&
+                      cs10_macro_load(cs10_check_path("macros-saved"),
+                                      checkControlName),
+                      "macro file saves and loads again")) {
+    for (uiSlot = 0 ; uiSlot < CS10_MACRO_SLOTS ; uiSlot++) {
+      pMacro = cs10_macro_get(uiSlot) ;
+
+      if (pMacro ?
+          ((pMacro->uiSteps != theMacro[uiSlot].uiSteps) ||
+           memcmp(pMacro->step, theMacro[uiSlot].step,
+                  pMacro->uiSteps * sizeof(cs10_macro_step_t))) :
+          (0 != theMacro[uiSlot].uiSteps))
+        bSame = false ;
+    } /* for */
+
+    cs10_check_that(bSame, "macro file saved is the macros loaded") ;
+  } /* if */
+
+  unlink(cs10_check_path("macros")) ;
+  unlink(cs10_check_path("macros-saved")) ;
+} /* cs10_check_macros */
+
+/*
+ * cs10_check_targets
+ *
+ * the targets file is read as written, each filter filled in when half
+ * of it is left out, and remapped controls only reach the targets that
+ * follow them
+ */
+static void
+cs10_check_targets(void) {
+
+  const cs10_target_t *pTarget ;
+  cs10_map_t           theMap ;
+  snd_seq_event_t      theEvent ;
+  unsigned int         uiChannel ;
+  unsigned int         uiCC ;
+
+  cs10_check_write_file("targets",
+    "# checks\n"
+    "target video\n"
+    "transport\n"
+    "tracks 1-4\n"
+    "\n"
+    "target lights\n"
+    "controls mute solo\n"
+    "target fx\n"
+    "  tracks 9\n"
+    "controls pan send1\n") ;
+
+  if (!cs10_check_that(cs10_target_load(cs10_check_path("targets"),
+                                        checkControlName),
+                       "targets file loads"))
+    return ;
+
+  cs10_check_that(3 == cs10_target_count(), "targets file has every target") ;
+
+  pTarget = cs10_target_get(0) ;
+
+  cs10_check_that(pTarget && (0 == strcmp("video", pTarget->cName)) &&
+                  pTarget->bTransport && (0x0f == pTarget->ulTrackMask) &&
+                  (((1U << NUM_VIRTUAL_TRACK_CONTROLS) - 1) ==
+                   pTarget->uiControlMask) &&
+                  (NULL == pTarget->pMap),
+                  "a target with only tracks follows all their controls") ;
+
+  pTarget = cs10_target_get(1) ;
+
+  cs10_check_that(pTarget && !pTarget->bTransport &&
+                  (0xffffffffU == pTarget->ulTrackMask) &&
+                  (((1U << MUTE_CONTROL) | (1U << SOLO_CONTROL)) ==
+                   pTarget->uiControlMask),
+                  "a target with only controls follows them on every track") ;
+
+  pTarget = cs10_target_get(2) ;
+
+  cs10_check_that(pTarget && ((1U << 8) == pTarget->ulTrackMask) &&
+                  (((1U << PAN_CONTROL) | (1U << SEND_ONE_CONTROL)) ==
+                   pTarget->uiControlMask),
+                  "a target follows the tracks and controls it names") ;
+
+  cs10_check_that(NULL == cs10_target_get(3), "there are no more targets") ;
+
+  if (pTarget) {
+    cs10_map_default(&theMap, 0, 8, CS10_MAP_MAX_STRIPS) ;
+    memset(&theEvent, 0, sizeof(theEvent)) ;
+
+    cs10_check_that(cs10_target_remap(pTarget, &theMap, 8, PAN_CONTROL,
+                                      &theEvent) &&
+                    cs10_map_to_cc(&theMap, 8, PAN_CONTROL,
+                                   &uiChannel, &uiCC) &&
+                    (uiChannel == theEvent.data.control.channel) &&
+                    (uiCC == theEvent.data.control.param),
+                    "a target takes the controls it follows") ;
+    cs10_check_that(!cs10_target_remap(pTarget, &theMap, 8, FADER_CONTROL,
+                                       &theEvent) &&
+                    !cs10_target_remap(pTarget, &theMap, 0, PAN_CONTROL,
+                                       &theEvent),
+                    "a target is left out of what it doesn't follow") ;
+  } /* if */
+
+  cs10_target_close() ;
+  unlink(cs10_check_path("targets")) ;
+} /* cs10_check_targets */
+
+/*****************************************************************************/
+
+/*
+ * cs10_check
+ *
+ * run every check, with any files they need in pDirectory, and report
+ * failures and a summary to pReport
+ * return true if they all passed
+ */
+bool
+cs10_check(
+  const char *pDirectory,
+  FILE *pReport) {
+
+  memset(&check, 0, sizeof(check)) ;
+
+  check.pDirectory = pDirectory ;
+  check.pReport = pReport ;
+
+  cs10_check_journal() ;
+  cs10_check_undo() ;
+  cs10_check_automation() ;
+  cs10_check_control() ;
+  cs10_check_macros() ;
+  cs10_check_targets() ;
+
+  fprintf(pReport, "%u checks, %u failed\n", check.uiChecks, check.uiFailed) ;
+
+  return (0 == check.uiFailed) ;
+} /* cs10_check */
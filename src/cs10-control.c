@@ -0,0 +1,397 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "cs10-control.h"
+
+/*****************************************************************************/
+
+/* a batch only runs with at least this much reply room to print into */
+#define CONTROL_REPLY_ROOM (CS10_CONTROL_REPLY / 2)
+
+typedef struct CS10_CONTROL_CLIENT_S {
+  int          iFD ;
+  bool         bClosing ;    /* hung up, goes once its replies are out */
+  bool         bSkipping ;   /* throwing away the rest of a long line */
+
+  char         cIn[CS10_CONTROL_LINE] ;
+  size_t       uiInLength ;
+
+  char         cOut[CS10_CONTROL_REPLY] ;
+  size_t       uiOutLength ;
+} cs10_control_client_t ;
+
+static struct CS10_CONTROL_S {
+  int                     iListenFD ;
+  char                   *pPath ;
+  cs10_control_command_fn pfnCommand ;
+
+  cs10_control_client_t   client[CS10_CONTROL_CLIENTS] ;
+} control = {
+  .iListenFD = -1
+} ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_control_drop
+ *
+ * forget pClient and whatever it had buffered
+ */
+static void
+cs10_control_drop(
+  cs10_control_client_t *pClient) {
+
+  if (0 <= pClient->iFD)
+    close(pClient->iFD) ;
+
+  pClient->iFD = -1 ;
+  pClient->bClosing = false ;
+  pClient->bSkipping = false ;
+  pClient->uiInLength = 0 ;
+  pClient->uiOutLength = 0 ;
+} /* cs10_control_drop */
+
+/*
+ * cs10_control_open
+ *
+ * listen on a unix domain socket at pPath, replacing a stale one
+ */
+bool
+cs10_control_open(
+  const char *pPath,
+  cs10_control_command_fn pfnCommand) {
+
+  struct sockaddr_un addr ;
+  struct stat        st ;
+  unsigned int       uiClient ;
+
+  if (strlen(pPath) >= sizeof(addr.sun_path))
+    return false ;
+
+  cs10_control_close() ;
+
+  for (uiClient = 0 ; uiClient < CS10_CONTROL_CLIENTS ; uiClient++)
+    control.client[uiClient].iFD = -1 ;
+
+  /* only ever remove a socket, never a file that happens to be there */
+  if ((0 == stat(pPath, &st)) && S_ISSOCK(st.st_mode))
+    unlink(pPath) ;
+
+  control.iListenFD = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK |
+                                      SOCK_CLOEXEC, 0) ;
+
+  if (control.iListenFD < 0)
+    return false ;
+
+  memset(&addr, 0, sizeof(addr)) ;
+  addr.sun_family = AF_UNIX ;
+  strcpy(addr.sun_path, pPath) ;
+
+  if ((0 != bind(control.iListenFD, (struct sockaddr *)&addr, sizeof(addr))) ||
+      (0 != chmod(pPath, 0600)) ||
+      (0 != listen(control.iListenFD, CS10_CONTROL_CLIENTS))) {
+    close(control.iListenFD) ;
+    control.iListenFD = -1 ;
+    return false ;
+  } /* if */
+
+  control.pPath = strdup(pPath) ;
+  control.pfnCommand = pfnCommand ;
+
+  return true ;
+} /* cs10_control_open */
+
+/*
+ * cs10_control_close
+ *
+ * hang up on every client and take the socket away
+ */
+void
+cs10_control_close(void) {
+
+  unsigned int uiClient ;
+
+  if (control.iListenFD < 0)
+    return ;
+
+  for (uiClient = 0 ; uiClient < CS10_CONTROL_CLIENTS ; uiClient++)
+    cs10_control_drop(&control.client[uiClient]) ;
+
+  close(control.iListenFD) ;
+  control.iListenFD = -1 ;
+
+  if (control.pPath)
+    unlink(control.pPath) ;
+
+  free(control.pPath) ;
+  control.pPath = NULL ;
+} /* cs10_control_close */
+
+/*
+ * cs10_control_batch
+ *
+ * run the commands of one line and queue its reply
+ */
+static void
+cs10_control_batch(
+  cs10_control_client_t *pClient,
+  char *pLine) {
+
+  FILE        *pReply ;
+  size_t       uiRoom = CS10_CONTROL_REPLY - pClient->uiOutLength ;
+  char        *pBatchPos ;
+  char        *pCommand ;
+  const char  *pError = NULL ;
+  unsigned int uiCommand = 0 ;
+  long         lLength ;
+
+  pReply = fmemopen(pClient->cOut + pClient->uiOutLength, uiRoom, "w") ;
+
+  if (NULL == pReply)
+    return ;
+
+  for (pCommand = strtok_r(pLine, ";", &pBatchPos) ;
+       pCommand && (NULL == pError) ;
+       pCommand = strtok_r(NULL, ";", &pBatchPos)) {
+    char        *ppArgs[CS10_CONTROL_MAX_ARGS + 1] ;
+    char        *pArgPos ;
+    unsigned int uiArgs = 0 ;
+
+    for (ppArgs[0] = strtok_r(pCommand, " \t\r", &pArgPos) ;
+         ppArgs[uiArgs] && (uiArgs < CS10_CONTROL_MAX_ARGS) ;
+         ppArgs[uiArgs] = strtok_r(NULL, " \t\r", &pArgPos))
+      uiArgs++ ;
+
+    if (0 == uiArgs)
+      continue ;
+
+    uiCommand++ ;
+
+    if ((CS10_CONTROL_MAX_ARGS == uiArgs) && ppArgs[uiArgs])
+      pError = "too many arguments" ;
+    else
+      pError = control.pfnCommand(uiArgs, ppArgs, pReply) ;
+  } /* for */
+
+  if (pError)
+    fprintf(pReply, "error %u %s\n", uiCommand, pError) ;
+  else
+    fprintf(pReply, "ok\n") ;
+
+  fflush(pReply) ;
+  lLength = ftell(pReply) ;
+  fclose(pReply) ;
+
+  /* a reply cut short would have no end, it is replaced by an error */
+  if ((lLength < 0) || ((size_t)lLength >= uiRoom))
+    lLength = snprintf(pClient->cOut + pClient->uiOutLength, uiRoom,
+                       "error %u reply too long\n", uiCommand) ;
+
+  pClient->uiOutLength += lLength ;
+} /* cs10_control_batch */
+
+/*
+ * cs10_control_run
+ *
+ * run every whole line pClient has sent, while there's room to reply
+ */
+static void
+cs10_control_run(
+  cs10_control_client_t *pClient) {
+
+  char *pEnd ;
+
+  while ((CS10_CONTROL_REPLY - pClient->uiOutLength >= CONTROL_REPLY_ROOM) &&
+         (NULL != (pEnd = memchr(pClient->cIn, '\n', pClient->uiInLength)))) {
+    size_t uiLine = pEnd - pClient->cIn + 1 ;
+
+    *pEnd = '\0' ;
+
+    if (pClient->bSkipping)
+      pClient->bSkipping = false ;
+    else
+      cs10_control_batch(pClient, pClient->cIn) ;
+
+    pClient->uiInLength -= uiLine ;
+    memmove(pClient->cIn, pClient->cIn + uiLine, pClient->uiInLength) ;
+  } /* while */
+
+  /* a line that can never fit is answered, and thrown away up to
+   * its end
+   */
+  if ((CS10_CONTROL_LINE == pClient->uiInLength) &&
+      (CS10_CONTROL_REPLY - pClient->uiOutLength >= CONTROL_REPLY_ROOM)) {
+    if (!pClient->bSkipping)
+      pClient->uiOutLength += snprintf(pClient->cOut + pClient->uiOutLength,
+                                CS10_CONTROL_REPLY - pClient->uiOutLength,
+                                "error 0 line too long\n") ;
+    pClient->bSkipping = true ;
+    pClient->uiInLength = 0 ;
+  } /* if */
+} /* cs10_control_run */
+
+/*
+ * cs10_control_send
+ *
+ * write as much of pClient's replies as the socket takes
+ */
+static void
+cs10_control_send(
+  cs10_control_client_t *pClient) {
+
+  ssize_t iSent ;
+
+  if (0 == pClient->uiOutLength)
+    return ;
+
+  iSent = send(pClient->iFD, pClient->cOut, pClient->uiOutLength,
+               MSG_NOSIGNAL | MSG_DONTWAIT) ;
+
+  if (iSent < 0) {
+    if ((EAGAIN != errno) && (EINTR != errno))
+      cs10_control_drop(pClient) ;
+    return ;
+  } /* if */
+
+  pClient->uiOutLength -= iSent ;
+  memmove(pClient->cOut, pClient->cOut + iSent, pClient->uiOutLength) ;
+} /* cs10_control_send */
+
+/*
+ * cs10_control_read
+ *
+ * take what pClient sent and run it
+ */
+static void
+cs10_control_read(
+  cs10_control_client_t *pClient) {
+
+  ssize_t iRead ;
+
+  while (pClient->uiInLength < CS10_CONTROL_LINE) {
+    iRead = recv(pClient->iFD, pClient->cIn + pClient->uiInLength,
+                 CS10_CONTROL_LINE - pClient->uiInLength, MSG_DONTWAIT) ;
+
+    if (0 == iRead) {
+      pClient->bClosing = true ;
+      break ;
+    } /* if */
+
+    if (iRead < 0) {
+      if ((EAGAIN != errno) && (EINTR != errno))
+        pClient->bClosing = true ;
+      break ;
+    } /* if */
+
+    pClient->uiInLength += iRead ;
+    cs10_control_run(pClient) ;
+  } /* while */
+} /* cs10_control_read */
+
+/*
+ * cs10_control_poll_fds
+ *
+ * fill CS10_CONTROL_FDS slots of pFDs with what to wait for,
+ * unused slots get an fd of -1 and are skipped by poll
+ */
+void
+cs10_control_poll_fds(
+  struct pollfd *pFDs) {
+
+  unsigned int uiClient ;
+
+  pFDs[0].fd = control.iListenFD ;
+  pFDs[0].events = POLLIN ;
+  pFDs[0].revents = 0 ;
+
+  for (uiClient = 0 ; uiClient < CS10_CONTROL_CLIENTS ; uiClient++) {
+    cs10_control_client_t *pClient = &control.client[uiClient] ;
+    struct pollfd         *pFD = &pFDs[1 + uiClient] ;
+
+    pFD->fd = (control.iListenFD < 0) ? -1 : pClient->iFD ;
+    pFD->events = 0 ;
+    pFD->revents = 0 ;
+
+    /* a client that doesn't read its replies isn't read from either */
+    if (!pClient->bClosing &&
+        (pClient->uiInLength < CS10_CONTROL_LINE) &&
+        (CS10_CONTROL_REPLY - pClient->uiOutLength >= CONTROL_REPLY_ROOM))
+      pFD->events |= POLLIN ;
+
+    if (pClient->uiOutLength)
+      pFD->events |= POLLOUT ;
+  } /* for */
+} /* cs10_control_poll_fds */
+
+/*
+ * cs10_control_handle
+ *
+ * serve whatever poll found in the slots cs10_control_poll_fds filled
+ */
+void
+cs10_control_handle(
+  const struct pollfd *pFDs) {
+
+  unsigned int uiClient ;
+
+  if (control.iListenFD < 0)
+    return ;
+
+  if (pFDs[0].revents & POLLIN) {
+    int iFD ;
+
+    /* clients are only ever read and written with MSG_DONTWAIT */
+    while (0 <= (iFD = accept(control.iListenFD, NULL, NULL))) {
+      for (uiClient = 0 ; uiClient < CS10_CONTROL_CLIENTS ; uiClient++) {
+        if (control.client[uiClient].iFD < 0)
+          break ;
+      } /* for */
+
+      if (uiClient == CS10_CONTROL_CLIENTS) {
+        close(iFD) ;
+        continue ;
+      } /* if */
+
+      control.client[uiClient].iFD = iFD ;
+    } /* while */
+  } /* if */
+
+  for (uiClient = 0 ; uiClient < CS10_CONTROL_CLIENTS ; uiClient++) {
+    cs10_control_client_t *pClient = &control.client[uiClient] ;
+    short                  sEvents = pFDs[1 + uiClient].revents ;
+
+    if ((pClient->iFD < 0) || (pFDs[1 + uiClient].fd != pClient->iFD))
+      continue ;
+
+    if (sEvents & POLLIN)
+      cs10_control_read(pClient) ;
+
+    /* lines held back for room to reply run once replies have gone */
+    cs10_control_send(pClient) ;
+
+    if (pClient->iFD < 0)
+      continue ;
+
+    cs10_control_run(pClient) ;
+    cs10_control_send(pClient) ;
+
+    if (pClient->iFD < 0)
+      continue ;
+
+    if ((sEvents & (POLLERR | POLLNVAL)) ||
+        ((sEvents & POLLHUP) && !(sEvents & POLLIN)) ||
+        (pClient->bClosing && (0 == pClient->uiOutLength)))
+      cs10_control_drop(pClient) ;
+  } /* for */
+} /* cs10_control_handle */
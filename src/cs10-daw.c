@@ -0,0 +1,972 @@
+/*****************************************************************************/
+
+/* cs10-daw
+ *
+ * a stand-in for ardour's generic midi surface, for measuring what
+ * cs10-linux's restores and feedback really cost end to end. it links
+ * itself to mmc-io and takes control changes the way ardour would from
+ * the same .map file: faders and knobs either jump straight to the value
+ * (motorised) or only once they come within the threshold of it, or
+ * cross it, and toggles flip on the press. whatever changes is echoed
+ * back as feedback. mmc locates, steps and transport commands move a
+ * play head that is reported back as mtc, quarter frames while rolling.
+ *
+ * with --bench it also plays the surface on cs10-io, and times recalls,
+ * morphs, fader storms and locates through the daemon.
+ *
+ * with --check it runs the self checks in cs10-check.c instead, which
+ * need no sequencer, and exits non-zero if any of them failed.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <alsa/asoundlib.h>
+#include <getopt.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mmc.h"
+#include "cs10.h"
+#include "cs10-map.h"
+#include "cs10-check.h"
+
+/*****************************************************************************/
+
+#define DAW_SEQUENCER_NAME   "default"
+#define DAW_CLIENT_NAME      "cs10-daw"
+#define DAW_PORT_NAME        "generic-midi"
+#define DAW_SURFACE_PORT_NAME "surface"
+#define DAW_DEFAULT_TARGET   "cs10:0"
+#define DAW_DEFAULT_SURFACE  "cs10-surface:0"
+
+/* the layout cs10-linux uses without a map */
+#define DAW_DEFAULT_CHANNEL  0
+#define DAW_STRIPS_PER_CHANNEL 8
+#define DAW_DEFAULT_STRIPS   32
+
+#define DAW_DEFAULT_THRESHOLD 15   /* ardour's smoothing */
+#define DAW_MAX_CONTROL      0x7f
+#define DAW_TOGGLE_ON        0x40
+
+/* mtc at 25 frames a second, a quarter frame every 10ms */
+#define DAW_FPS              25
+#define DAW_RATE_CODE        1
+#define DAW_QFRAME_US        (1000000 / (DAW_FPS * 4))
+#define DAW_WIND_SECONDS     5
+
+#define DAW_NUM_FADERS       (LAST_FADER_ADDR - FIRST_FADER_ADDR + 1)
+#define DAW_SURFACE_CHANNEL  0
+
+/* a benchmark step is over once nothing has arrived for this long */
+#define DAW_QUIET_MS         250
+#define DAW_STEP_LIMIT_MS    120000
+#define DAW_DEFAULT_STORM    10000
+#define DAW_DEFAULT_LOCATES  100
+
+#define DAW_CHECK_DIRECTORY  "/tmp/cs10-check.XXXXXX"
+
+/*****************************************************************************/
+
+typedef struct DAW_COUNTS_S {
+  unsigned long ulReceived ;   /* control changes that came in */
+  unsigned long ulApplied ;    /* and changed something */
+  unsigned long ulRejected ;   /* held off by the threshold */
+  unsigned long ulFeedback ;   /* values echoed back */
+  unsigned long ulMMC ;
+} daw_counts_t ;
+
+static struct CS10_DAW_S {
+  bool            debug ;
+
+  snd_seq_t      *pSeq ;
+  int             iPortID ;
+  int             iSurfacePortID ;
+  char           *target ;
+  char           *surface_target ;
+
+  char           *map_filename ;
+  cs10_map_t      theMap ;
+
+  bool            bMotorised ;
+  unsigned int    uiThreshold ;
+  bool            bFeedback ;
+
+  /* the session, and the last value each cc brought in, plus one */
+  unsigned char   ucValue[CS10_MAP_MAX_STRIPS][NUM_VIRTUAL_TRACK_CONTROLS] ;
+  unsigned char   ucIncoming[CS10_MAP_NUM_CHANNELS][CS10_MAP_NUM_CCS] ;
+
+  /* the play head, in frames at DAW_FPS */
+  bool            bRolling ;
+  uint32_t        ulFrame ;
+  uint32_t        ulQFrameBase ;
+  unsigned int    uiQFramePiece ;
+  uint64_t        ullNextQFrame ;
+
+  daw_counts_t    counts ;
+  uint32_t        ulLastEvent ;
+  uint32_t        ulLastMMC ;
+
+  bool            bBench ;
+  unsigned int    uiStorm ;
+  unsigned int    uiLocates ;
+
+  bool            bCheck ;
+
+  volatile sig_atomic_t bStop ;
+} daw ;
+
+/*****************************************************************************/
+
+void
+sighandler(
+  int iSignal) {
+
+  daw.bStop = 1 ;
+} /* sighandler */
+
+/*
+ * daw_now_us
+ *
+ * a monotonic microsecond clock
+ */
+uint64_t
+daw_now_us(void) {
+
+  struct timespec tNow ;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow) ;
+
+  return (uint64_t)tNow.tv_sec * 1000000 + tNow.tv_nsec / 1000 ;
+} /* daw_now_us */
+
+/*
+ * daw_now_ms
+ *
+ * a monotonic millisecond clock, wrapping is fine for intervals
+ */
+uint32_t
+daw_now_ms(void) {
+
+  return (uint32_t)(daw_now_us() / 1000) ;
+} /* daw_now_ms */
+
+/*
+ * daw_link
+ *
+ * subscribe iPort both ways with the port named by pAddress
+ */
+bool
+daw_link(
+  int iPort,
+  const char *pAddress) {
+
+  snd_seq_addr_t theTarget ;
+
+  if ((0 > snd_seq_parse_address(daw.pSeq, &theTarget, pAddress)) ||
+      (0 > snd_seq_connect_to(daw.pSeq, iPort,
+                              theTarget.client, theTarget.port)) ||
+      (0 > snd_seq_connect_from(daw.pSeq, iPort,
+                                theTarget.client, theTarget.port))) {
+    fprintf(stderr, "can't link with %s\n", pAddress) ;
+    return false ;
+  } /* if */
+
+  return true ;
+} /* daw_link */
+
+/*
+ * daw_init
+ *
+ * open the sequencer, create our ports and link them up
+ */
+bool
+daw_init(void) {
+
+  if (0 != snd_seq_open(&daw.pSeq, DAW_SEQUENCER_NAME,
+                        SND_SEQ_OPEN_DUPLEX, 0)) {
+    fprintf(stderr, "can't open the sequencer\n") ;
+    return false ;
+  } /* if */
+
+  snd_seq_set_client_name(daw.pSeq, DAW_CLIENT_NAME) ;
+
+  daw.iPortID = snd_seq_create_simple_port(daw.pSeq, DAW_PORT_NAME,
+      SND_SEQ_PORT_CAP_READ |
+      SND_SEQ_PORT_CAP_WRITE |
+      SND_SEQ_PORT_CAP_SUBS_READ |
+      SND_SEQ_PORT_CAP_SUBS_WRITE,
+      SND_SEQ_PORT_TYPE_MIDI_GENERIC |
+      SND_SEQ_PORT_TYPE_APPLICATION) ;
+
+  if ((0 > daw.iPortID) || !daw_link(daw.iPortID, daw.target))
+    return false ;
+
+  if (!daw.bBench)
+    return true ;
+
+  daw.iSurfacePortID = snd_seq_create_simple_port(daw.pSeq,
+      DAW_SURFACE_PORT_NAME,
+      SND_SEQ_PORT_CAP_READ |
+      SND_SEQ_PORT_CAP_WRITE |
+      SND_SEQ_PORT_CAP_SUBS_READ |
+      SND_SEQ_PORT_CAP_SUBS_WRITE,
+      SND_SEQ_PORT_TYPE_MIDI_GENERIC |
+      SND_SEQ_PORT_TYPE_HARDWARE) ;
+
+  return ((0 <= daw.iSurfacePortID) &&
+          daw_link(daw.iSurfacePortID, daw.surface_target)) ;
+} /* daw_init */
+
+/*
+ * daw_output
+ *
+ * send pEvent to whoever is subscribed to iPort
+ */
+void
+daw_output(
+  int iPort,
+  snd_seq_event_t *pEvent) {
+
+  snd_seq_ev_set_source(pEvent, iPort) ;
+  snd_seq_ev_set_subs(pEvent) ;
+  snd_seq_ev_set_direct(pEvent) ;
+
+  /* a full output buffer is drained on the way */
+  snd_seq_event_output(daw.pSeq, pEvent) ;
+} /* daw_output */
+
+/*
+ * daw_send_sysex
+ *
+ * send uiLength bytes of sysex from the daw port
+ */
+void
+daw_send_sysex(
+  unsigned char *pData,
+  unsigned int uiLength) {
+
+  snd_seq_event_t theEvent ;
+
+  snd_seq_ev_clear(&theEvent) ;
+  snd_seq_ev_set_sysex(&theEvent, uiLength, pData) ;
+  daw_output(daw.iPortID, &theEvent) ;
+} /* daw_send_sysex */
+
+/*
+ * daw_send_full_frame
+ *
+ * tell the daemon where the play head is, as ardour does after a locate
+ */
+void
+daw_send_full_frame(void) {
+
+  uint32_t      ulSeconds = daw.ulFrame / DAW_FPS ;
+  unsigned char ucPacket[10] = {
+    0xf0, 0x7f, 0x7f, 0x01, 0x01,
+    (DAW_RATE_CODE << 5) | ((ulSeconds / 3600) % 24),
+    (ulSeconds / 60) % 60,
+    ulSeconds % 60,
+    daw.ulFrame % DAW_FPS,
+    0xf7 } ;
+
+  daw_send_sysex(ucPacket, sizeof(ucPacket)) ;
+} /* daw_send_full_frame */
+
+/*
+ * daw_send_qframe
+ *
+ * send the next quarter frame of the time at ulQFrameBase
+ */
+void
+daw_send_qframe(void) {
+
+  snd_seq_event_t theEvent ;
+  uint32_t        ulSeconds = daw.ulQFrameBase / DAW_FPS ;
+  unsigned int    uiField ;
+
+  switch (daw.uiQFramePiece) {
+    case 0: uiField = daw.ulQFrameBase % DAW_FPS ; break ;
+    case 1: uiField = (daw.ulQFrameBase % DAW_FPS) >> 4 ; break ;
+    case 2: uiField = ulSeconds % 60 ; break ;
+    case 3: uiField = (ulSeconds % 60) >> 4 ; break ;
+    case 4: uiField = (ulSeconds / 60) % 60 ; break ;
+    case 5: uiField = ((ulSeconds / 60) % 60) >> 4 ; break ;
+    case 6: uiField = (ulSeconds / 3600) % 24 ; break ;
+    default:
+      uiField = (DAW_RATE_CODE << 1) | ((((ulSeconds / 3600) % 24) >> 4) & 1) ;
+      break ;
+  } /* switch */
+
+  snd_seq_ev_clear(&theEvent) ;
+  theEvent.type = SND_SEQ_EVENT_QFRAME ;
+  snd_seq_ev_set_fixed(&theEvent) ;
+  theEvent.data.control.value = (daw.uiQFramePiece << 4) | (uiField & 0x0f) ;
+  daw_output(daw.iPortID, &theEvent) ;
+
+  /* a frame passes every fourth piece, the eight span two frames */
+  if (0 == ++daw.uiQFramePiece % 4)
+    daw.ulFrame++ ;
+
+  if (8 == daw.uiQFramePiece) {
+    daw.uiQFramePiece = 0 ;
+    daw.ulQFrameBase = daw.ulFrame ;
+  } /* if */
+} /* daw_send_qframe */
+
+/*
+ * daw_move_to
+ *
+ * put the play head at ulFrame and report it
+ */
+void
+daw_move_to(
+  int64_t llFrame) {
+
+  daw.ulFrame = (0 > llFrame ? 0 : (uint32_t)llFrame) ;
+  daw.ulQFrameBase = daw.ulFrame ;
+  daw.uiQFramePiece = 0 ;
+  daw.ullNextQFrame = daw_now_us() + DAW_QFRAME_US ;
+
+  daw_send_full_frame() ;
+} /* daw_move_to */
+
+/*
+ * daw_receive_mmc
+ *
+ * act on an mmc command the way a daw would
+ */
+void
+daw_receive_mmc(
+  const unsigned char *pData,
+  unsigned int uiLength) {
+
+  int iSteps ;
+
+  daw.counts.ulMMC++ ;
+  daw.ulLastMMC = daw_now_ms() ;
+
+  switch (pData[4]) {
+    case MMC_COMMAND_STOP:
+    case MMC_COMMAND_PAUSE:
+      daw.bRolling = false ;
+      daw_move_to(daw.ulFrame) ;
+      break ;
+
+    case MMC_COMMAND_PLAY:
+    case MMC_COMMAND_DEF_PLAY:
+      daw.bRolling = true ;
+      daw_move_to(daw.ulFrame) ;
+      break ;
+
+    /* ardour shuttles, a jump is near enough for timing */
+    case MMC_COMMAND_FF:
+      daw_move_to((int64_t)daw.ulFrame + DAW_WIND_SECONDS * DAW_FPS) ;
+      break ;
+
+    case MMC_COMMAND_REW:
+      daw_move_to((int64_t)daw.ulFrame - DAW_WIND_SECONDS * DAW_FPS) ;
+      break ;
+
+    case 0x44: /* locate */
+      if ((MMC_GOTO_SYSEX_PACKET_LENGTH <= uiLength) && (0x01 == pData[6]))
+        daw_move_to((((int64_t)(pData[7] & 0x1f) * 60 + pData[8]) * 60 +
+                     pData[9]) * DAW_FPS + pData[10]) ;
+      break ;
+
+    case 0x48: /* step */
+      if (MMC_STEP_SYSEX_PACKET_LENGTH <= uiLength) {
+        iSteps = (pData[6] & 0x40 ? -(int)(pData[6] & 0x3f) : pData[6]) ;
+        daw_move_to((int64_t)daw.ulFrame + iSteps) ;
+      } /* if */
+      break ;
+
+    default:
+      break ;
+  } /* switch */
+
+  if (daw.debug)
+    fprintf(stderr, "%s %02x at frame %u\n", __FUNCTION__, pData[4],
+      daw.ulFrame) ;
+} /* daw_receive_mmc */
+
+/*
+ * daw_receive_control
+ *
+ * apply a control change as ardour's generic midi surface would
+ */
+void
+daw_receive_control(
+  unsigned int uiChannel,
+  unsigned int uiCC,
+  unsigned int uiValue) {
+
+  unsigned int            uiStrip ;
+  virtual_track_control_t tcControl ;
+  unsigned char          *pValue ;
+  unsigned int            uiLast ;
+  unsigned int            uiNew = uiValue ;
+  snd_seq_event_t         theEvent ;
+
+  if (!cs10_map_from_cc(&daw.theMap, uiChannel, uiCC, &uiStrip, &tcControl))
+    return ;
+
+  daw.counts.ulReceived++ ;
+
+  pValue = &daw.ucValue[uiStrip][tcControl] ;
+  uiLast = daw.ucIncoming[uiChannel][uiCC] ;
+  daw.ucIncoming[uiChannel][uiCC] = uiValue + 1 ;
+
+  if (FADER_CONTROL > tcControl) {
+    /* a toggle flips on the press, the release is ignored */
+    if (DAW_TOGGLE_ON > uiValue)
+      return ;
+
+    uiNew = (*pValue ? 0 : DAW_MAX_CONTROL) ;
+  } else
+  if (!daw.bMotorised) {
+    int  iGap = (int)uiValue - (int)*pValue ;
+    bool bCrossed = (uiLast &&
+                     ((((int)uiLast - 1 < *pValue) && (uiValue >= *pValue)) ||
+                      (((int)uiLast - 1 > *pValue) && (uiValue <= *pValue)))) ;
+
+    /* too far from where the control is, and not swept across it */
+    if ((abs(iGap) >= (int)daw.uiThreshold) && !bCrossed) {
+      daw.counts.ulRejected++ ;
+      return ;
+    } /* if */
+  } /* if */
+
+  if (*pValue == uiNew)
+    return ;
+
+  *pValue = uiNew ;
+  daw.counts.ulApplied++ ;
+
+  if (!daw.bFeedback)
+    return ;
+
+  snd_seq_ev_clear(&theEvent) ;
+  snd_seq_ev_set_controller(&theEvent, uiChannel, uiCC, uiNew) ;
+  daw_output(daw.iPortID, &theEvent) ;
+  daw.counts.ulFeedback++ ;
+} /* daw_receive_control */
+
+/*
+ * daw_receive
+ *
+ * take one event from the daemon, on either port
+ */
+void
+daw_receive(
+  snd_seq_event_t *pEvent) {
+
+  unsigned char *pData = pEvent->data.ext.ptr ;
+
+  /* what the daemon lights on the bench surface doesn't matter here */
+  if (pEvent->dest.port != daw.iPortID)
+    return ;
+
+  daw.ulLastEvent = daw_now_ms() ;
+
+  if (SND_SEQ_EVENT_CONTROLLER == pEvent->type)
+    daw_receive_control(pEvent->data.control.channel,
+                        pEvent->data.control.param,
+                        pEvent->data.control.value) ;
+  else
+  if ((SND_SEQ_EVENT_SYSEX == pEvent->type) &&
+      (MMC_CMD_SYSEX_PACKET_LENGTH <= pEvent->data.ext.len) &&
+      (0xf0 == pData[0]) && (0x7f == pData[1]) && (0x06 == pData[3]))
+    daw_receive_mmc(pData, pEvent->data.ext.len) ;
+} /* daw_receive */
+
+/*
+ * daw_pump
+ *
+ * send what's queued, keep time code running and take in whatever
+ * arrives for up to iTimeout ms, -1 for as long as it takes
+ */
+void
+daw_pump(
+  int iTimeout) {
+
+  struct pollfd    theFDs[4] ;
+  int              iFDs ;
+  snd_seq_event_t *pEvent ;
+  uint64_t         ullNow ;
+
+  if (daw.bRolling) {
+    ullNow = daw_now_us() ;
+
+    while (daw.ullNextQFrame <= ullNow) {
+      daw_send_qframe() ;
+      daw.ullNextQFrame += DAW_QFRAME_US ;
+    } /* while */
+
+    if ((0 > iTimeout) ||
+        ((uint64_t)iTimeout * 1000 > daw.ullNextQFrame - ullNow))
+      iTimeout = (daw.ullNextQFrame - ullNow + 999) / 1000 ;
+  } /* if */
+
+  snd_seq_drain_output(daw.pSeq) ;
+
+  iFDs = snd_seq_poll_descriptors(daw.pSeq, theFDs, 4, POLLIN) ;
+
+  if (0 >= poll(theFDs, iFDs, iTimeout))
+    return ;
+
+  do {
+    if (0 <= snd_seq_event_input(daw.pSeq, &pEvent))
+      daw_receive(pEvent) ;
+  } while (0 < snd_seq_event_input_pending(daw.pSeq, 0)) ;
+} /* daw_pump */
+
+/*
+ * daw_press
+ *
+ * move a surface control, on the bench
+ */
+void
+daw_press(
+  unsigned int uiAddr,
+  unsigned int uiValue) {
+
+  snd_seq_event_t theEvent ;
+
+  snd_seq_ev_clear(&theEvent) ;
+  snd_seq_ev_set_controller(&theEvent, DAW_SURFACE_CHANNEL, uiAddr, uiValue) ;
+  daw_output(daw.iSurfacePortID, &theEvent) ;
+} /* daw_press */
+
+/*
+ * daw_wait_quiet
+ *
+ * take in events until none has come for DAW_QUIET_MS
+ * return the ms from ulStart to the last one
+ */
+uint32_t
+daw_wait_quiet(
+  uint32_t ulStart) {
+
+  daw.ulLastEvent = daw_now_ms() ;
+
+  while (!daw.bStop &&
+         (daw_now_ms() - daw.ulLastEvent < DAW_QUIET_MS) &&
+         (daw_now_ms() - ulStart < DAW_STEP_LIMIT_MS))
+    daw_pump(DAW_QUIET_MS) ;
+
+  return daw.ulLastEvent - ulStart ;
+} /* daw_wait_quiet */
+
+/*
+ * daw_set_faders
+ *
+ * move the first bank's faders to uiValue from the surface
+ */
+void
+daw_set_faders(
+  unsigned int uiValue) {
+
+  unsigned int uiTrack ;
+
+  for (uiTrack = 0 ; uiTrack < DAW_NUM_FADERS ; uiTrack++)
+    daw_press(FIRST_FADER_ADDR + uiTrack, uiValue) ;
+
+  daw_wait_quiet(daw_now_ms()) ;
+} /* daw_set_faders */
+
+/*
+ * daw_faders_at
+ *
+ * how many of the first bank's faders the session has at uiValue
+ */
+unsigned int
+daw_faders_at(
+  unsigned int uiValue) {
+
+  unsigned int uiTrack ;
+  unsigned int uiCount = 0 ;
+
+  for (uiTrack = 0 ; uiTrack < DAW_NUM_FADERS ; uiTrack++)
+    uiCount += (daw.ucValue[uiTrack][FADER_CONTROL] == uiValue) ;
+
+  return uiCount ;
+} /* daw_faders_at */
+
+/*
+ * daw_report
+ *
+ * print one benchmark result
+ */
+void
+daw_report(
+  const char *pName,
+  uint32_t ulMs,
+  unsigned long ulSent,
+  const char *pExtra) {
+
+  printf("%-24s %6u ms  sent %6lu  received %6lu  applied %6lu  "
+         "rejected %6lu  feedback %6lu%s\n",
+    pName, ulMs, ulSent,
+    daw.counts.ulReceived, daw.counts.ulApplied,
+    daw.counts.ulRejected, daw.counts.ulFeedback,
+    pExtra) ;
+} /* daw_report */
+
+/*
+ * daw_bench_recall
+ *
+ * save the faders at one place in F1, move them away and time the
+ * recall back, plain or as a one second morph
+ */
+void
+daw_bench_recall(
+  bool bMorph) {
+
+  const unsigned int uiSaved = 100 ;
+  const unsigned int uiAway = 20 ;
+  bool               bMotorised = daw.bMotorised ;
+  char               cExtra[64] ;
+  unsigned int       uiClick ;
+  uint32_t           ulStart ;
+  uint32_t           ulMs ;
+
+  /* setting up goes through whatever the threshold says */
+  daw.bMotorised = true ;
+
+  daw_set_faders(uiSaved) ;
+
+  daw_press(RECORD_BUTTON_ADDR, BUTTON_DOWN_VALUE) ;
+  daw_press(F1_BUTTON_ADDR, BUTTON_DOWN_VALUE) ;
+  daw_press(F1_BUTTON_ADDR, BUTTON_UP_VALUE) ;
+  daw_press(RECORD_BUTTON_ADDR, BUTTON_UP_VALUE) ;
+  daw_wait_quiet(daw_now_ms()) ;
+
+  daw_set_faders(uiAway) ;
+
+  daw.bMotorised = bMotorised ;
+  memset(&daw.counts, 0, sizeof(daw.counts)) ;
+
+  daw_press(F1_BUTTON_ADDR, BUTTON_DOWN_VALUE) ;
+
+  /* the wheel takes the morph time down to its shortest, a second */
+  if (bMorph) {
+    for (uiClick = 0 ; uiClick < 500 ; uiClick++)
+      daw_press(WHEEL_ADDR, 0x7f) ;
+  } /* if */
+
+  snd_seq_drain_output(daw.pSeq) ;
+  daw_wait_quiet(daw_now_ms()) ;
+
+  ulStart = daw_now_ms() ;
+  daw_press(F1_BUTTON_ADDR, BUTTON_UP_VALUE) ;
+  ulMs = daw_wait_quiet(ulStart) ;
+
+  snprintf(cExtra, sizeof(cExtra), "  faders home %u/%u",
+    daw_faders_at(uiSaved), DAW_NUM_FADERS) ;
+
+  daw_report(bMorph ? "morph recall (1s)" : "recall", ulMs, 0, cExtra) ;
+} /* daw_bench_recall */
+
+/*
+ * daw_bench_storm
+ *
+ * throw uiStorm random fader moves at the daemon as fast as it takes them
+ */
+void
+daw_bench_storm(void) {
+
+  unsigned int uiLast[DAW_NUM_FADERS] ;
+  unsigned int uiMove ;
+  unsigned int uiTrack ;
+  unsigned int uiHome = 0 ;
+  char         cExtra[64] ;
+  uint32_t     ulStart ;
+  uint32_t     ulMs ;
+
+  for (uiTrack = 0 ; uiTrack < DAW_NUM_FADERS ; uiTrack++)
+    uiLast[uiTrack] = daw.ucValue[uiTrack][FADER_CONTROL] ;
+
+  memset(&daw.counts, 0, sizeof(daw.counts)) ;
+  ulStart = daw_now_ms() ;
+
+  for (uiMove = 0 ; (uiMove < daw.uiStorm) && !daw.bStop ; uiMove++) {
+    int iValue ;
+
+    uiTrack = rand() % DAW_NUM_FADERS ;
+    iValue = (int)uiLast[uiTrack] + rand() % 9 - 4 ;
+
+    if (0 > iValue)
+      iValue = 0 ;
+
+    if (DAW_MAX_CONTROL < iValue)
+      iValue = DAW_MAX_CONTROL ;
+
+    uiLast[uiTrack] = iValue ;
+    daw_press(FIRST_FADER_ADDR + uiTrack, iValue) ;
+
+    /* keep taking in, so the daemon never waits on us */
+    if (0 == uiMove % 64)
+      daw_pump(0) ;
+  } /* for */
+
+  ulMs = daw_wait_quiet(ulStart) ;
+
+  /* the last move of each fader has to get through, whatever was dropped */
+  for (uiTrack = 0 ; uiTrack < DAW_NUM_FADERS ; uiTrack++)
+    uiHome += (daw.ucValue[uiTrack][FADER_CONTROL] == uiLast[uiTrack]) ;
+
+  snprintf(cExtra, sizeof(cExtra), "  last values %u/%u",
+    uiHome, DAW_NUM_FADERS) ;
+
+  daw_report("fader storm", ulMs, uiMove, cExtra) ;
+} /* daw_bench_storm */
+
+/*
+ * daw_bench_locates
+ *
+ * time surface transport presses through to the mmc they turn into,
+ * going back to zero and jogging on in turn
+ */
+void
+daw_bench_locates(void) {
+
+  unsigned int uiLocate ;
+  unsigned int uiArrived = 0 ;
+  uint32_t     ulWorst = 0 ;
+  uint64_t     ullTotal = 0 ;
+  char         cExtra[96] ;
+  uint32_t     ulStart ;
+  unsigned int uiClick ;
+
+  memset(&daw.counts, 0, sizeof(daw.counts)) ;
+
+  for (uiLocate = 0 ; (uiLocate < daw.uiLocates) && !daw.bStop ; uiLocate++) {
+    unsigned long ulBefore = daw.counts.ulMMC ;
+
+    ulStart = daw_now_ms() ;
+
+    if (uiLocate & 1) {
+      /* enough clicks to get past the daemon's jog threshold */
+      for (uiClick = 0 ; uiClick < 5 ; uiClick++)
+        daw_press(WHEEL_ADDR, 0x01) ;
+    } else {
+      daw_press(SHIFT_BUTTON_ADDR, BUTTON_DOWN_VALUE) ;
+      daw_press(REW_BUTTON_ADDR, BUTTON_DOWN_VALUE) ;
+      daw_press(REW_BUTTON_ADDR, BUTTON_UP_VALUE) ;
+      daw_press(SHIFT_BUTTON_ADDR, BUTTON_UP_VALUE) ;
+    } /* else */
+
+    while (!daw.bStop && (daw.counts.ulMMC == ulBefore) &&
+           (daw_now_ms() - ulStart < DAW_QUIET_MS * 4))
+      daw_pump(DAW_QUIET_MS) ;
+
+    if (daw.counts.ulMMC != ulBefore) {
+      uint32_t ulTaken = daw.ulLastMMC - ulStart ;
+
+      uiArrived++ ;
+      ullTotal += ulTaken ;
+
+      if (ulTaken > ulWorst)
+        ulWorst = ulTaken ;
+    } /* if */
+  } /* for */
+
+  ulStart = daw_now_ms() ;
+  daw_wait_quiet(ulStart) ;
+
+  snprintf(cExtra, sizeof(cExtra), "  mmc %u/%u avg %u ms worst %u ms",
+    uiArrived, uiLocate,
+    (unsigned int)(uiArrived ? ullTotal / uiArrived : 0), ulWorst) ;
+
+  daw_report("locates", (uint32_t)ullTotal, uiLocate, cExtra) ;
+} /* daw_bench_locates */
+
+/*
+ * daw_bench
+ *
+ * run every benchmark, under the pickup rules given
+ */
+void
+daw_bench(void) {
+
+  printf("pickup %s, threshold %u, feedback %s\n",
+    (daw.bMotorised ? "motorised" : "threshold"), daw.uiThreshold,
+    (daw.bFeedback ? "on" : "off")) ;
+
+  /* let the daemon settle from linking up */
+  daw_wait_quiet(daw_now_ms()) ;
+
+  daw_bench_recall(false) ;
+
+  if (!daw.bStop)
+    daw_bench_recall(true) ;
+
+  if (!daw.bStop)
+    daw_bench_storm() ;
+
+  if (!daw.bStop)
+    daw_bench_locates() ;
+} /* daw_bench */
+
+static struct option long_opts[] = {
+  { "verbose", no_argument, NULL, 'v'},
+  { "connect", required_argument, NULL, 'c'},
+  { "surface", required_argument, NULL, 's'},
+  { "map", required_argument, NULL, 'm'},
+  { "motorised", no_argument, NULL, 'M'},
+  { "threshold", required_argument, NULL, 't'},
+  { "no-feedback", no_argument, NULL, 'n'},
+  { "bench", no_argument, NULL, 'b'},
+  { "storm", required_argument, NULL, 'N'},
+  { "locates", required_argument, NULL, 'L'},
+  { "check", no_argument, NULL, 'C'},
+  { "help", no_argument, NULL, 'h'},
+  { NULL, 0, NULL, 0 }
+};
+
+void
+daw_help_exit(
+  int argc,
+  char** argv) {
+
+  fprintf(stderr, "%s options:\n", argv[0]);
+  fprintf(stderr, "  --connect, -c [client:port] of cs10-linux's mmc-io, %s by default\n",
+    DAW_DEFAULT_TARGET);
+  fprintf(stderr, "  --map, -m [path] to the ardour .map or native map cs10-linux uses\n");
+  fprintf(stderr, "  --motorised, -M take every value, as ardour does for motorised faders\n");
+  fprintf(stderr, "  --threshold, -t [steps] ardour's smoothing, %u by default\n",
+    DAW_DEFAULT_THRESHOLD);
+  fprintf(stderr, "  --no-feedback, -n don't echo changes back\n");
+  fprintf(stderr, "  --bench, -b play the surface too, and time recalls, a fader\n");
+  fprintf(stderr, "             storm and locates, then exit\n");
+  fprintf(stderr, "  --surface, -s [client:port] of cs10-linux's cs10-io, %s by default\n",
+    DAW_DEFAULT_SURFACE);
+  fprintf(stderr, "  --storm, -N [moves] in the fader storm, %u by default\n",
+    DAW_DEFAULT_STORM);
+  fprintf(stderr, "  --locates, -L [count] locates to time, %u by default\n",
+    DAW_DEFAULT_LOCATES);
+  fprintf(stderr, "  --check, -C run the self checks, without a sequencer, and exit\n");
+  fprintf(stderr, "  --verbose, -v print every mmc command\n");
+  fprintf(stderr, "  --help, -h show this help and exit\n");
+  exit(0);
+} /* daw_help_exit */
+
+int
+main(
+  int argc,
+  char** argv) {
+
+  int c;
+
+  memset(&daw, 0, sizeof(daw)) ;
+
+  daw.target = DAW_DEFAULT_TARGET ;
+  daw.surface_target = DAW_DEFAULT_SURFACE ;
+  daw.uiThreshold = DAW_DEFAULT_THRESHOLD ;
+  daw.bFeedback = true ;
+  daw.uiStorm = DAW_DEFAULT_STORM ;
+  daw.uiLocates = DAW_DEFAULT_LOCATES ;
+
+  while ((c = getopt_long(argc, argv, "vc:s:m:Mt:nbN:L:Ch",
+                          long_opts, NULL)) != -1) {
+    switch (c) {
+      case 'v':
+        daw.debug = true;
+        break;
+
+      case 'c':
+        daw.target = optarg;
+        break;
+
+      case 's':
+        daw.surface_target = optarg;
+        break;
+
+      case 'm':
+        daw.map_filename = optarg;
+        break;
+
+      case 'M':
+        daw.bMotorised = true;
+        break;
+
+      case 't':
+        daw.uiThreshold = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'n':
+        daw.bFeedback = false;
+        break;
+
+      case 'b':
+        daw.bBench = true;
+        break;
+
+      case 'N':
+        daw.uiStorm = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'L':
+        daw.uiLocates = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'C':
+        daw.bCheck = true;
+        break;
+
+      case 'h':
+      default:
+        daw_help_exit(argc, argv);
+        break;
+    } /* switch */
+  } /* while */
+
+  /* the checks make their files in a directory of their own */
+  if (daw.bCheck) {
+    char cDirectory[] = DAW_CHECK_DIRECTORY ;
+    bool bPassed ;
+
+    if (NULL == mkdtemp(cDirectory)) {
+      fprintf(stderr, "can't make %s\n", DAW_CHECK_DIRECTORY);
+      return 1;
+    } /* if */
+
+    bPassed = cs10_check(cDirectory, stdout) ;
+    rmdir(cDirectory) ;
+
+    return bPassed ? 0 : 1 ;
+  } /* if */
+
+  if (daw.map_filename) {
+    if (!cs10_map_load(&daw.theMap, daw.map_filename)) {
+      fprintf(stderr, "can't load map %s\n", daw.map_filename);
+      return 1;
+    } /* if */
+  } else
+    cs10_map_default(&daw.theMap, DAW_DEFAULT_CHANNEL,
+                     DAW_STRIPS_PER_CHANNEL, DAW_DEFAULT_STRIPS);
+
+  if (!daw_init())
+    return 1;
+
+  signal(SIGINT, sighandler) ;
+  signal(SIGTERM, sighandler) ;
+
+  if (daw.bBench)
+    daw_bench() ;
+  else {
+    while (!daw.bStop)
+      daw_pump(-1) ;
+
+    daw_report("session", 0, 0, "") ;
+  } /* else */
+
+  snd_seq_close(daw.pSeq) ;
+
+  return 0 ;
+} /* main */
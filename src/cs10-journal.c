@@ -0,0 +1,347 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cs10-journal.h"
+
+/*****************************************************************************/
+
+#define JOURNAL_MAGIC   "cs10jnl"
+#define JOURNAL_VERSION 1
+
+#define JOURNAL_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+typedef struct CS10_JOURNAL_HEADER_S {
+  char     cMagic[8] ;
+  uint32_t ulVersion ;
+  uint32_t ulSnapshotSize ;
+  uint32_t ulScratchSize ;
+  uint32_t ulRecords ;
+} cs10_journal_header_t ;
+
+/* a snapshot is only good once its sequence is written, and that is last */
+typedef struct CS10_JOURNAL_SLOT_S {
+  uint32_t ulSequence ;
+  uint32_t ulChecksum ;
+  unsigned char ucData[] ;
+} cs10_journal_slot_t ;
+
+/* a sequence of 0 is a record never written */
+typedef struct CS10_JOURNAL_RECORD_S {
+  uint32_t ulSequence ;
+  uint16_t usKey ;
+  uint16_t usValue ;
+} cs10_journal_record_t ;
+
+static struct CS10_JOURNAL_S {
+  unsigned char           *pBase ;
+  size_t                   uiLength ;
+  size_t                   uiSnapshotSize ;
+
+  cs10_journal_slot_t     *pSlot[2] ;
+  unsigned char           *pScratch ;
+  cs10_journal_record_t   *pRing ;
+
+  cs10_journal_snapshot_fn pfnSnapshot ;
+
+  unsigned int             uiLatestSlot ;
+  uint32_t                 ulSequence ;         /* last record appended */
+  uint32_t                 ulSnapshotSequence ; /* last record in a snapshot */
+
+  bool                     bWarm ;
+} journal ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_journal_checksum
+ *
+ * fnv-1a over a snapshot slot
+ */
+static uint32_t
+cs10_journal_checksum(
+  uint32_t ulSequence,
+  const unsigned char *pData,
+  size_t uiLength) {
+
+  uint32_t ulHash = 2166136261U ^ ulSequence ;
+  size_t   uiByte ;
+
+  for (uiByte = 0 ; uiByte < uiLength ; uiByte++) {
+    ulHash ^= pData[uiByte] ;
+    ulHash *= 16777619U ;
+  } /* for */
+
+  return ulHash ;
+} /* cs10_journal_checksum */
+
+/*
+ * cs10_journal_slot_valid
+ *
+ * did the snapshot in pSlot get written all the way
+ */
+static bool
+cs10_journal_slot_valid(
+  const cs10_journal_slot_t *pSlot) {
+
+  uint32_t ulSequence = __atomic_load_n(&pSlot->ulSequence, __ATOMIC_ACQUIRE) ;
+
+  return (ulSequence &&
+          (pSlot->ulChecksum ==
+           cs10_journal_checksum(ulSequence, pSlot->ucData,
+                                 journal.uiSnapshotSize))) ;
+} /* cs10_journal_slot_valid */
+
+/*
+ * cs10_journal_open
+ *
+ * map pFilename, creating it or starting it over if it doesn't match
+ * what we would write now
+ * pfnSnapshot is called for the state to write whenever the ring fills
+ */
+bool
+cs10_journal_open(
+  const char *pFilename,
+  size_t uiSnapshotSize,
+  size_t uiScratchSize,
+  cs10_journal_snapshot_fn pfnSnapshot) {
+
+  cs10_journal_header_t *pHeader ;
+  size_t                 uiSlotSize ;
+  struct stat            theStat ;
+  int                    iFD ;
+  unsigned int           uiSlot ;
+
+  uiSlotSize = JOURNAL_ALIGN(sizeof(cs10_journal_slot_t) + uiSnapshotSize) ;
+
+  memset(&journal, 0, sizeof(journal)) ;
+
+  journal.uiSnapshotSize = uiSnapshotSize ;
+  journal.pfnSnapshot = pfnSnapshot ;
+  journal.uiLength = JOURNAL_ALIGN(sizeof(cs10_journal_header_t)) +
+                     2 * uiSlotSize +
+                     JOURNAL_ALIGN(uiScratchSize) +
+                     CS10_JOURNAL_RECORDS * sizeof(cs10_journal_record_t) ;
+
+  iFD = open(pFilename, O_RDWR | O_CREAT | O_CLOEXEC, 0600) ;
+
+  if (0 > iFD)
+    return false ;
+
+  if ((0 != fstat(iFD, &theStat)) ||
+      (((size_t)theStat.st_size != journal.uiLength) &&
+       (0 != ftruncate(iFD, journal.uiLength)))) {
+    close(iFD) ;
+    return false ;
+  } /* if */
+
+  journal.pBase = mmap(NULL, journal.uiLength, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, iFD, 0) ;
+  close(iFD) ;
+
+  if (MAP_FAILED == journal.pBase) {
+    journal.pBase = NULL ;
+    return false ;
+  } /* if */
+
+  pHeader = (cs10_journal_header_t *)journal.pBase ;
+  journal.pSlot[0] = (cs10_journal_slot_t *)(journal.pBase +
+    JOURNAL_ALIGN(sizeof(cs10_journal_header_t))) ;
+  journal.pSlot[1] = (cs10_journal_slot_t *)((unsigned char *)
+    journal.pSlot[0] + uiSlotSize) ;
+  journal.pScratch = (unsigned char *)journal.pSlot[1] + uiSlotSize ;
+  journal.pRing = (cs10_journal_record_t *)(journal.pScratch +
+    JOURNAL_ALIGN(uiScratchSize)) ;
+
+  if ((0 != memcmp(pHeader->cMagic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))) ||
+      (JOURNAL_VERSION != pHeader->ulVersion) ||
+      (uiSnapshotSize != pHeader->ulSnapshotSize) ||
+      (uiScratchSize != pHeader->ulScratchSize) ||
+      (CS10_JOURNAL_RECORDS != pHeader->ulRecords)) {
+    /* new, or written by something else, start from nothing */
+    memset(journal.pBase, 0, journal.uiLength) ;
+    memcpy(pHeader->cMagic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) ;
+    pHeader->ulVersion = JOURNAL_VERSION ;
+    pHeader->ulSnapshotSize = uiSnapshotSize ;
+    pHeader->ulScratchSize = uiScratchSize ;
+    pHeader->ulRecords = CS10_JOURNAL_RECORDS ;
+    return true ;
+  } /* if */
+
+  /* pick up from the newest complete snapshot */
+  for (uiSlot = 0 ; uiSlot < 2 ; uiSlot++) {
+    if (cs10_journal_slot_valid(journal.pSlot[uiSlot]) &&
+        (!journal.bWarm ||
+         (journal.pSlot[uiSlot]->ulSequence > journal.ulSnapshotSequence))) {
+      journal.bWarm = true ;
+      journal.uiLatestSlot = uiSlot ;
+      journal.ulSnapshotSequence = journal.pSlot[uiSlot]->ulSequence ;
+    } /* if */
+  } /* for */
+
+  if (!journal.bWarm) {
+    memset(journal.pRing, 0,
+           CS10_JOURNAL_RECORDS * sizeof(cs10_journal_record_t)) ;
+    return true ;
+  } /* if */
+
+  /* and every record written after it, up to the first gap */
+  journal.ulSequence = journal.ulSnapshotSequence ;
+
+  while (journal.ulSequence - journal.ulSnapshotSequence <
+         CS10_JOURNAL_RECORDS) {
+    uint32_t ulNext = journal.ulSequence + 1 ;
+
+    if (journal.pRing[ulNext % CS10_JOURNAL_RECORDS].ulSequence != ulNext)
+      break ;
+
+    journal.ulSequence = ulNext ;
+  } /* while */
+
+  return true ;
+} /* cs10_journal_open */
+
+/*
+ * cs10_journal_replay
+ *
+ * rebuild the last state written into pSnapshot
+ * return false if there is nothing to go on
+ */
+bool
+cs10_journal_replay(
+  void *pSnapshot,
+  cs10_journal_record_fn pfnRecord) {
+
+  uint32_t ulSequence ;
+
+  if ((NULL == journal.pBase) || !journal.bWarm)
+    return false ;
+
+  memcpy(pSnapshot, journal.pSlot[journal.uiLatestSlot]->ucData,
+         journal.uiSnapshotSize) ;
+
+  for (ulSequence = journal.ulSnapshotSequence + 1 ;
+       ulSequence <= journal.ulSequence ;
+       ulSequence++) {
+    cs10_journal_record_t *pRecord =
+      &journal.pRing[ulSequence % CS10_JOURNAL_RECORDS] ;
+
+    pfnRecord(pSnapshot, pRecord->usKey, pRecord->usValue) ;
+  } /* for */
+
+  return true ;
+} /* cs10_journal_replay */
+
+/*
+ * cs10_journal_scratch
+ *
+ * the scratch area, zeroed whenever the journal starts over
+ */
+void *
+cs10_journal_scratch(void) {
+
+  return journal.pScratch ;
+} /* cs10_journal_scratch */
+
+/*
+ * cs10_journal_checkpoint
+ *
+ * write the whole state over the older snapshot, which frees the ring
+ * up to the record just appended
+ */
+void
+cs10_journal_checkpoint(void) {
+
+  unsigned int         uiSlot ;
+  cs10_journal_slot_t *pSlot ;
+
+  if (NULL == journal.pBase)
+    return ;
+
+  uiSlot = (journal.bWarm ? 1 - journal.uiLatestSlot : 0) ;
+  pSlot = journal.pSlot[uiSlot] ;
+
+  __atomic_store_n(&pSlot->ulSequence, 0, __ATOMIC_RELEASE) ;
+
+  journal.pfnSnapshot(pSlot->ucData) ;
+
+  /* a snapshot with no records before it still needs a sequence */
+  if (0 == journal.ulSequence)
+    journal.ulSequence = 1 ;
+
+  pSlot->ulChecksum = cs10_journal_checksum(journal.ulSequence, pSlot->ucData,
+                                            journal.uiSnapshotSize) ;
+  __atomic_store_n(&pSlot->ulSequence, journal.ulSequence, __ATOMIC_RELEASE) ;
+
+  journal.uiLatestSlot = uiSlot ;
+  journal.ulSnapshotSequence = journal.ulSequence ;
+  journal.bWarm = true ;
+} /* cs10_journal_checkpoint */
+
+/*
+ * cs10_journal_append
+ *
+ * note that uiKey changed to uiValue, after the change has been made
+ */
+void
+cs10_journal_append(
+  unsigned int uiKey,
+  unsigned int uiValue) {
+
+  cs10_journal_record_t *pRecord ;
+  uint32_t               ulSequence ;
+
+  if (NULL == journal.pBase)
+    return ;
+
+  /* records before the first snapshot would have nothing to replay onto */
+  if (!journal.bWarm) {
+    cs10_journal_checkpoint() ;
+    return ;
+  } /* if */
+
+  ulSequence = journal.ulSequence + 1 ;
+
+  /* sequence 0 marks an empty record, skip it on wrap */
+  if (0 == ulSequence)
+    ulSequence = 1 ;
+
+  pRecord = &journal.pRing[ulSequence % CS10_JOURNAL_RECORDS] ;
+
+  __atomic_store_n(&pRecord->ulSequence, 0, __ATOMIC_RELEASE) ;
+  pRecord->usKey = uiKey ;
+  pRecord->usValue = uiValue ;
+  __atomic_store_n(&pRecord->ulSequence, ulSequence, __ATOMIC_RELEASE) ;
+
+  journal.ulSequence = ulSequence ;
+
+  /* compact well before the ring could overtake the older snapshot */
+  if (journal.ulSequence - journal.ulSnapshotSequence >=
+      CS10_JOURNAL_RECORDS / 2)
+    cs10_journal_checkpoint() ;
+} /* cs10_journal_append */
+
+/*
+ * cs10_journal_close
+ *
+ * leave a snapshot of everything behind and unmap
+ */
+void
+cs10_journal_close(void) {
+
+  if (NULL == journal.pBase)
+    return ;
+
+  cs10_journal_checkpoint() ;
+
+  msync(journal.pBase, journal.uiLength, MS_SYNC) ;
+  munmap(journal.pBase, journal.uiLength) ;
+  journal.pBase = NULL ;
+} /* cs10_journal_close */
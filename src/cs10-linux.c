@@ -1,6 +1,7 @@
 /*****************************************************************************/
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
@@ -9,20 +10,65 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <pwd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <fnmatch.h>
 
 #include "mmc.h"
 #include "cs10.h"
+#include "seqlock.h"
+#include "cs10-output.h"
+#include "cs10-midi.h"
+#include "cs10-osc.h"
+#include "cs10-map.h"
+#include "cs10-journal.h"
+#include "cs10-automation.h"
+#include "cs10-log.h"
+#include "cs10-trace.h"
+#include "cs10-stats.h"
+#include "cs10-control.h"
+#include "cs10-shm.h"
+#include "cs10-undo.h"
+#include "cs10-macro.h"
+#include "cs10-target.h"
 
 /*****************************************************************************/
 
 #define CS10_DEFAULT_SETTINGS_FILENAME "cs10-linux.dat"
 #define CS10_DEFAULT_SETTINGS_PATH     "/.local/share/cs10/"
 #define CS10_DEFAULT_SETTINGS_DIR      "/cs10/"
+#define CS10_JOURNAL_SUFFIX            ".journal"
 
 #define CS10_SEQUENCER_NAME    "default"
 #define CS10_CLIENT_NAME       "cs10"
+#define CS10_SURFACE_CLIENT_NAME "cs10-surface"
 #define CS10_CONTROL_PORT_NAME "cs10-io"
 #define CS10_MMC_IO_PORT_NAME  "mmc-io"
+#define CS10_ANNOUNCE_PORT_NAME "announce"
+#define CS10_NAME_LENGTH       64
+
+/* how near a control must come to the stored value to pick it up */
+#define CS10_PICKUP_WINDOW     1
+
+/* how far a fader or knob must turn back before it counts as a move,
+ * and how often each one may send, unless told otherwise
+ */
+#define CS10_DEFAULT_DEADBAND     1
+#define CS10_DEFAULT_INTERVAL_MS  10
+#define CS10_MAX_CONTROL_VALUE    0x7f
+
+#define CS10_NUM_THROTTLES     (CS10_NUM_PHYSICAL_TRACKS + CS10_NUM_KNOBS)
+#define FADER_THROTTLE(track)  (track)
+#define KNOB_THROTTLE(idx)     (CS10_NUM_PHYSICAL_TRACKS + (idx))
+
+/* a fader or knob left alone this long has finished its gesture */
+#define CS10_GESTURE_IDLE_MS   500
+
+/* a toggle step is a press and a release, each for the daw and targets */
+#define CS10_MACRO_EVENTS      (CS10_MACRO_STEPS * 2 * (1 + CS10_MAX_TARGETS))
 
 #define CS10_MIDI_CONTROL_CHANNEL 0
 
@@ -41,6 +87,74 @@
 
 #define CS10_FADER_RESTORE_DELAY_US 5000
 
+/* a morph updates every control it moves this often, so a long one costs
+ * no more events a second than a short one
+ */
+#define CS10_MORPH_TICK_MS          40
+#define CS10_DEFAULT_MORPH_SECONDS  5
+#define CS10_MAX_MORPH_SECONDS      99
+
+/* what a recall covers, a bit per virtual track and per control */
+#define CS10_ALL_TRACKS     ((uint32_t)((1ULL << CS10_NUM_VIRTUAL_TRACKS) - 1))
+#define CS10_BANK_TRACKS(bank) \
+   (((1U << CS10_NUM_PHYSICAL_TRACKS) - 1) << ((bank) * CS10_NUM_PHYSICAL_TRACKS))
+#define CONTROL_BIT(control) (1U << (control))
+#define CS10_ALL_CONTROLS   (CONTROL_BIT(NUM_VIRTUAL_TRACK_CONTROLS) - 1)
+#define CS10_EQ_CONTROLS    (CONTROL_BIT(BOOST_CUT_CONTROL) | \
+                             CONTROL_BIT(FREQUENCY_CONTROL) | \
+                             CONTROL_BIT(BANDWDITH_CONTROL))
+#define CS10_MUTE_SOLO_CONTROLS (CONTROL_BIT(MUTE_CONTROL) | \
+                                 CONTROL_BIT(SOLO_CONTROL))
+
+/* surface refresh requests posted by the daw thread */
+#define CS10_REFRESH_MODE   0x01
+#define CS10_REFRESH_TIME   0x02
+#define CS10_REFRESH_TRACKS 0x04
+
+/* what a config reload changed, and so has to be re-applied */
+#define CS10_CHANGED_MAP      0x01
+#define CS10_CHANGED_OSC      0x02
+#define CS10_CHANGED_SETTINGS 0x04
+#define CS10_CHANGED_OUTPUT   0x08
+#define CS10_CHANGED_RESTART  0x10
+
+/* how long after we send a fader or knob value its echo is expected */
+#define CS10_ECHO_WINDOW_MS 500
+
+/* every LED and seven segment address, for the shadow of what's lit */
+#define CS10_NUM_LED_ADDRS     0x20
+
+/* journal keys, a mixer control is keyed by its track and control */
+#define JOURNAL_TRACK_KEY(track, control) (((track) << 4) | (control))
+#define JOURNAL_KEY_TRACK(key)            ((key) >> 4)
+#define JOURNAL_KEY_CONTROL(key)          ((key) & 0x0f)
+#define JOURNAL_BANK_KEY                  0x1000
+#define JOURNAL_MODE_KEY                  0x1001
+#define JOURNAL_SELECTED_KEY              0x1002
+
+/* automation keeps a stream for every fader and knob of every track */
+#define CS10_AUTOMATION_CONTROLS (NUM_VIRTUAL_TRACK_CONTROLS - FADER_CONTROL)
+#define CS10_AUTOMATION_STREAMS  (CS10_NUM_VIRTUAL_TRACKS * \
+                                  CS10_AUTOMATION_CONTROLS)
+#define AUTOMATION_STREAM(track, control) \
+  ((track) * CS10_AUTOMATION_CONTROLS + (control) - FADER_CONTROL)
+
+/* time code further on than this since playback last looked is a locate */
+#define CS10_AUTOMATION_SEEK_FRAMES 30
+
+#define CS10_NUM_MIDI_CHANNELS 16
+#define CS10_NUM_MIDI_CCS      128
+
+/* an echo table entry: the range of values sent in the current burst,
+ * and when the last one went out
+ */
+#define ECHO_ENTRY_VALID        (1ULL << 63)
+#define ECHO_ENTRY(low, high, stamp) \
+  (ECHO_ENTRY_VALID | ((uint64_t)(low) << 40) | ((uint64_t)(high) << 32) | \
+   (uint64_t)(stamp))
+#define ECHO_ENTRY_LOW(entry)   ((unsigned int)((entry) >> 40) & 0xff)
+#define ECHO_ENTRY_HIGH(entry)  ((unsigned int)((entry) >> 32) & 0xff)
+#define ECHO_ENTRY_STAMP(entry) ((uint32_t)(entry))
 
  static const unsigned int uiHexToSSDTable[] = HEX_TO_SSD_TABLE ; 
 
@@ -54,23 +168,42 @@ typedef struct SMPTE_TIME_S {
   unsigned char frames ;
 } smpte_time_t ;
 
-typedef enum VIRTUAL_TRACK_CONTROL_E {
-  ARMED_CONTROL,
-  MUTE_CONTROL,
-  SOLO_CONTROL,
-  FADER_CONTROL,
-  BOOST_CUT_CONTROL,
-  FREQUENCY_CONTROL,
-  BANDWDITH_CONTROL,
-  SEND_ONE_CONTROL,
-  SEND_TWO_CONTROL,
-  PAN_CONTROL,
-  NUM_VIRTUAL_TRACK_CONTROLS
-} virtual_track_control_t ;
+/* frames a second for each mtc rate code, 29.97 drop frame counts as 30 */
+static const unsigned int uiSMPTEFrameRate[] = { 24, 25, 30, 30 } ;
 
 #define VIRTUAL_CONTROL_TO_KNOB_INDEX(control) \
    (control - BOOST_CUT_CONTROL)
 
+/* ardour osc paths for each virtual track control, the eq knobs drive
+ * plugin parameters whose range only ardour knows, so they stay on midi
+ */
+static const char *oscControlPath[NUM_VIRTUAL_TRACK_CONTROLS] = {
+  "/strip/recenable",            /* ARMED_CONTROL */
+  "/strip/mute",                 /* MUTE_CONTROL */
+  "/strip/solo",                 /* SOLO_CONTROL */
+  "/strip/fader",                /* FADER_CONTROL */
+  NULL,                          /* BOOST_CUT_CONTROL */
+  NULL,                          /* FREQUENCY_CONTROL */
+  NULL,                          /* BANDWDITH_CONTROL */
+  "/strip/send/fader",           /* SEND_ONE_CONTROL */
+  "/strip/send/fader",           /* SEND_TWO_CONTROL */
+  "/strip/pan_stereo_position"   /* PAN_CONTROL */
+} ;
+
+/* what the control socket calls each virtual track control */
+static const char *controlName[NUM_VIRTUAL_TRACK_CONTROLS] = {
+  "armed",                       /* ARMED_CONTROL */
+  "mute",                        /* MUTE_CONTROL */
+  "solo",                        /* SOLO_CONTROL */
+  "fader",                       /* FADER_CONTROL */
+  "boost",                       /* BOOST_CUT_CONTROL */
+  "frequency",                   /* FREQUENCY_CONTROL */
+  "bandwidth",                   /* BANDWDITH_CONTROL */
+  "send1",                       /* SEND_ONE_CONTROL */
+  "send2",                       /* SEND_TWO_CONTROL */
+  "pan"                          /* PAN_CONTROL */
+} ;
+
 #define KNOB_ADDR_TO_KNOB_INDEX(addr) \
    (addr - FIRST_KNOB_ADDR)
 
@@ -86,6 +219,15 @@ typedef enum MODE_E {
   NUM_MODES
 } control_mode_t ;
 
+/* what the control socket calls each mode, as the buttons are labelled */
+static const char *modeName[NUM_MODES] = {
+  "sel",                         /* SELECT_MODE */
+  "loc",                         /* LOC_MODE */
+  "mute",                        /* MUTE_MODE */
+  "solo",                        /* SOLO_MODE */
+  "nullify"                      /* NULLIFY_MODE */
+} ;
+
 typedef enum DISPLAY_MODE_E {
   SMPTE_DISPLAY_MODE,
   BANK_DISPLAY_MODE,
@@ -100,6 +242,13 @@ typedef enum SMPTE_DISPLAY_MODE_E  {
   NUM_SMPTE_DISPLAY_MODES
 } smpte_display_mode_t;
 
+typedef enum AUTOMATION_MODE_E {
+  AUTOMATION_OFF,
+  AUTOMATION_PLAY,
+  AUTOMATION_RECORD,
+  NUM_AUTOMATION_MODES
+} automation_mode_t ;
+
 typedef struct CS10_TRACK_STATE_S {
   bool bArmed ;
   bool bMute ;
@@ -112,6 +261,86 @@ typedef struct {
   cs10_track_state_t tsTrack[CS10_NUM_VIRTUAL_TRACKS] ;
 } cs10_mixer_state_t ;
 
+/* soft takeover of one physical control, values are kept plus one so
+ * that 0 means unknown
+ */
+typedef struct CS10_PICKUP_S {
+  unsigned int uiPosition ;  /* where the control physically is */
+  unsigned int uiTrack ;     /* the virtual track it last drove */
+  unsigned int uiSent ;      /* and the value it drove it to */
+} cs10_pickup_t ;
+
+/* jitter filtering and rate limiting of one physical control */
+typedef struct CS10_THROTTLE_S {
+  unsigned int uiAccepted ;  /* last value let through, plus one */
+  int          iDirection ;  /* and which way it was heading */
+
+  uint32_t     ulLastSent ;
+  bool         bPending ;    /* a value held back for the interval */
+  unsigned int uiTrack ;
+  virtual_track_control_t tcControl ;
+  unsigned int uiValue ;
+} cs10_throttle_t ;
+
+/* one gesture of a physical control, from the value its virtual track
+ * control had before it was touched to where it has been moved
+ */
+typedef struct CS10_GESTURE_S {
+  bool         bOpen ;
+  unsigned int uiTrack ;
+  virtual_track_control_t tcControl ;
+  unsigned int uiFrom ;
+  unsigned int uiTo ;
+  uint32_t     ulLastMove ;
+} cs10_gesture_t ;
+
+/* an undo or redo step gathered up before it is sent */
+typedef struct CS10_UNDO_TARGET_S {
+  cs10_mixer_state_t csTarget ;
+  uint32_t           ulTrackMask ;
+  unsigned int       uiControlMask ;
+} cs10_undo_target_t ;
+
+/* what the journal keeps of a running session */
+typedef struct CS10_LIVE_STATE_S {
+  cs10_mixer_state_t csState ;
+  unsigned int       uiBank ;
+  unsigned int       theMode ;
+  unsigned int       uiSelectedTrack ;
+} cs10_live_state_t ;
+
+/* a snapshot restore, ramped out on the bulk lane by the surface loop */
+typedef struct CS10_RESTORE_S {
+  bool               bActive ;
+  cs10_mixer_state_t csSent ;    /* what the daw has been sent so far */
+  cs10_mixer_state_t csTarget ;
+  unsigned int       uiTrack ;
+  unsigned int       uiControl ;
+  struct timespec    tNextStep ;
+
+  /* a morph moves every fader and knob at once, along the line from
+   * csFrom to csTarget, over ulMorphMs. toggles flip halfway
+   */
+  bool               bMorph ;
+  cs10_mixer_state_t csFrom ;
+  uint32_t           ulMorphStart ;
+  uint32_t           ulMorphMs ;
+
+  /* only these tracks and controls are looked at */
+  uint32_t           ulTrackMask ;
+  unsigned int       uiControlMask ;
+} cs10_restore_t ;
+
+/* a map a reload swapped out, and the generation that replaced it */
+typedef struct CS10_RETIRED_MAP_S {
+  cs10_map_t                *pMap ;
+  unsigned int               uiGeneration ;
+  struct CS10_RETIRED_MAP_S *pNext ;
+} cs10_retired_map_t ;
+
+/* what the daw thread publishes while it waits in poll, using no map */
+#define CS10_DAW_MAP_IDLE 0
+
 /*****************************************************************************/
 
 struct CS10_S {
@@ -119,18 +348,121 @@ struct CS10_S {
 
   char           *settings_filename;
 
+  /* pSeq carries mmc-io and is read by the daw thread,
+   * pSurfaceSeq carries cs10-io and is read by the surface (main) thread.
+   * all output, on either handle, is written by the surface thread.
+   * with a rawmidi device the surface skips the sequencer entirely,
+   * pRawIn and pRawOut take the place of pSurfaceSeq.
+   */
   snd_seq_t      *pSeq ;
+  snd_seq_t      *pSurfaceSeq ;
+
+  char           *rawmidi_name;
+  snd_rawmidi_t  *pRawIn ;
+  snd_rawmidi_t  *pRawOut ;
+  cs10_midi_parser_t surfaceParser ;
+
+  /* with an osc destination, controls ardour can address by path go
+   * there instead of out as midi
+   */
+  char           *osc_target;
+  cs10_osc_packet_t oscPacket ;
+
+  /* where each virtual track control lives on the daw link.
+   * a reload swaps pMap in one go and bumps uiMapGeneration, the map
+   * it replaced waits on pRetiredMaps until the daw thread publishes,
+   * between events, a generation at least as new, or that it's idle
+   */
+  char           *map_filename;
+  cs10_map_t     *pMap ;
+  cs10_retired_map_t *pRetiredMaps ;
+  unsigned int    uiMapGeneration ;
+  unsigned int    uiDAWMapGeneration ;
+
+  /* the config file and map are watched and re-applied when they change,
+   * options given on the command line win over the config file
+   */
+  char           *config_filename;
+  bool            bCommandLine[128];
+
+  /* live state is journalled under the stateLock write lock, by
+   * whichever thread changed it
+   */
+  char           *journal_filename;
+
+  /* fader and knob moves recorded against time code, only the surface
+   * thread records or plays them
+   */
+  char           *automation_filename;
+  char           *trace_filename;
+  char           *stats_filename;
+  char           *control_path;
+  char           *shm_name;
+
+  /* button macros, written back when one is recorded from the surface */
+  char           *macro_filename;
+
+  /* extra ports following the surface besides the daw */
+  char           *targets_filename;
+
+  /* what each LED last went out as, plus one, 0 when unknown. it lives
+   * in the journal so a warm restart knows what the surface is showing.
+   * inside a batch, LEDs are only noted in ucLEDWanted and the
+   * differences go out when the batch ends
+   */
+  unsigned char  *pucLEDShadow ;
+  unsigned char   ucLEDFallback[CS10_NUM_LED_ADDRS] ;
+  unsigned char   ucLEDWanted[CS10_NUM_LED_ADDRS] ;
+  unsigned int    uiLEDBatch ;
+  bool            bStartup ;   /* until the first pass of the surface loop */
+  unsigned int    uiConfigChanges;
+  int             iNotifyFD ;
 
   int             hw_seq_client;
   int             hw_seq_port;
 
+  /* the interface is any port whose client:port names match port_pattern,
+   * or, given by number, the port with the names hw_seq_client:hw_seq_port
+   * had when we first linked to it. iLinkedClient is -1 while it's away
+   */
+  char           *port_pattern;
+  char            cInterfaceClient[CS10_NAME_LENGTH];
+  char            cInterfacePort[CS10_NAME_LENGTH];
+  int             iLinkedClient;
+  int             iLinkedPort;
+
+  /* 0 leaves the sequencer defaults alone */
+  unsigned int    uiOutputPool;
+  unsigned int    uiOutputBuffer;
+
+  volatile sig_atomic_t bDumpStats;
+
   int             iClientID ;
+  int             iSurfaceClientID ;
   int             iControlPortID ;
+  int             iAnnouncePortID ;
   int             iMMCPortID ;
   __sighandler_t  pOldSigHandler ;
 
+  pthread_t       dawThread ;
+  bool            bDAWThread ;
+  int             iDAWStopFD ;      /* written to have the daw thread return */
+  int             iWakeFD ;
+  volatile unsigned int uiRefreshFlags ;
+  volatile uint32_t uiDirtyTracks ;   /* a bit per virtual track the daw changed */
+
+  /* fader and knob values in flight to the daw, keyed by channel and cc,
+   * written by the surface thread and checked by the daw thread
+   */
+  volatile uint64_t ullEcho[CS10_NUM_MIDI_CHANNELS][CS10_NUM_MIDI_CCS] ;
+
+  /* guards csState and tCurrentTime, which both threads write */
+  seqlock_t       stateLock ;
+
   cs10_mixer_state_t csState ;
 
+  cs10_restore_t  restore ;
+
   smpte_time_t    tCurrentTime ;
 
   smpte_time_t    tQFTime ;
@@ -152,9 +484,47 @@ struct CS10_S {
   unsigned int    uiSelectedTrack ;
 
   bool            bRecordKeyDown ;
+
+  /* with bPickup, faders and knobs are ignored until they reach the
+   * value they'd be taking over from
+   */
+  bool            bPickup ;
+  cs10_pickup_t   puFader[CS10_NUM_PHYSICAL_TRACKS] ;
+  cs10_pickup_t   puKnob[CS10_NUM_KNOBS] ;
+
+  unsigned int    uiFaderDeadband ;
+  unsigned int    uiKnobDeadband ;
+  unsigned int    uiControlInterval ;  /* ms, 0 sends everything */
+  cs10_throttle_t thControl[CS10_NUM_THROTTLES] ;
   bool            bShiftKeyDown ;
+
+  /* recalls and finished gestures go into the undo ring, a gesture is
+   * finished once its control rests or moves on to another track
+   */
+  cs10_gesture_t  geControl[CS10_NUM_THROTTLES] ;
+
+  /* the F key held down, plus one, and whether the wheel has set a
+   * morph time for it since. other buttons pressed meanwhile narrow what
+   * it recalls, and their releases are swallowed
+   */
+  unsigned int    uiMorphKey ;
+  bool            bMorphTimeSet ;
+  unsigned int    uiMorphSeconds ;
+  bool            bRecallBank ;
+  unsigned int    uiRecallTracks ;   /* a bit per physical track */
+  unsigned int    uiRecallControls ;
+  uint32_t        ulSwallowButtons ;
   bool            bIgnoreRecordKeyUp ;
 
+  /* playback follows time code from ulAutomationFrame, a control moved
+   * while recording gets a bit in usTouched and is no longer played
+   * until the next locate
+   */
+  automation_mode_t automationMode ;
+  bool            bAutomationLocated ;
+  uint32_t        ulAutomationFrame ;
+  uint16_t        usTouched[CS10_NUM_VIRTUAL_TRACKS] ;
+
   bool            bJogging ;
   volatile int    iJogCount ;
 } cs10 ;
@@ -170,6 +540,117 @@ sighandler(
   exit(0) ;
 } /* sighandler */
 
+void
+statshandler(
+  int iSignal) {
+
+  (void) iSignal ;
+
+  cs10.bDumpStats = 1 ;
+} /* statshandler */
+
+#if (CS10_MACRO_SLOTS != CS10_NUM_PHYSICAL_TRACKS) || \
+    (CS10_MACRO_POSITIONS != CS10_NUM_SAVED_POSITIONS)
+#error there has to be a macro for each track button and F key position
+#endif
+
+#if (CS10_SHM_TRACKS != CS10_NUM_VIRTUAL_TRACKS) || \
+    (CS10_SHM_KNOBS != CS10_NUM_KNOBS)
+#error the shared state has to have room for every track and knob
+#endif
+
+/*
+ * cs10_publish_state
+ *
+ * mirror the bank, mode and selected track, and the tracks in ulTracks,
+ * into the shared segment, if there is one
+ * called with the stateLock write lock held, so there's only one writer
+ */
+void
+cs10_publish_state(
+  uint32_t ulTracks) {
+
+  cs10_shm_state_t *pShared = cs10_shm_write_begin() ;
+  unsigned int      uiTrack ;
+  unsigned int      uiKnob ;
+
+  if (NULL == pShared)
+    return ;
+
+  pShared->ucBank = cs10.uiBank ;
+  pShared->ucMode = cs10.theMode ;
+  pShared->ucSelectedTrack = cs10.uiSelectedTrack ;
+
+  for (uiTrack = 0 ; ulTracks ; uiTrack++, ulTracks >>= 1) {
+    const cs10_track_state_t *pTrack = &cs10.csState.tsTrack[uiTrack] ;
+    cs10_shm_track_t         *pSharedTrack = &pShared->track[uiTrack] ;
+
+    if (0 == (ulTracks & 1))
+      continue ;
+
+    pSharedTrack->ucFader = pTrack->uiFader ;
+
+    for (uiKnob = 0 ; uiKnob < CS10_NUM_KNOBS ; uiKnob++)
+      pSharedTrack->ucKnob[uiKnob] = pTrack->uiKnob[uiKnob] ;
+
+    pSharedTrack->ucArmed = pTrack->bArmed ;
+    pSharedTrack->ucMute = pTrack->bMute ;
+    pSharedTrack->ucSolo = pTrack->bSolo ;
+  } /* for */
+
+  cs10_shm_write_end() ;
+} /* cs10_publish_state */
+
+/*
+ * cs10_publish_time
+ *
+ * mirror just the time into the shared segment, if there is one
+ * called with the stateLock write lock held
+ */
+void
+cs10_publish_time(void) {
+
+  cs10_shm_state_t *pShared = cs10_shm_write_begin() ;
+
+  if (NULL == pShared)
+    return ;
+
+  pShared->ucHours = cs10.tCurrentTime.hours ;
+  pShared->ucMinutes = cs10.tCurrentTime.minutes ;
+  pShared->ucSeconds = cs10.tCurrentTime.seconds ;
+  pShared->ucFrames = cs10.tCurrentTime.frames ;
+  pShared->ucRate = cs10.tCurrentTime.flags ;
+
+  cs10_shm_write_end() ;
+} /* cs10_publish_time */
+
+/*
+ * cs10_state_write_end
+ *
+ * finish a change to the live state that touched the tracks in
+ * ulTracks, every change passes through here so the shared mirror
+ * never misses one
+ */
+void
+cs10_state_write_end(
+  uint32_t ulTracks) {
+
+  cs10_publish_state(ulTracks) ;
+  seqlock_write_end(&cs10.stateLock) ;
+} /* cs10_state_write_end */
+
+/*
+ * cs10_time_write_end
+ *
+ * finish a change to the time, the only thing a quarter frame touches
+ */
+void
+cs10_time_write_end(void) {
+
+  cs10_publish_time() ;
+  seqlock_write_end(&cs10.stateLock) ;
+} /* cs10_time_write_end */
+
 /*
  * cs10_fini
  *
@@ -178,15 +659,153 @@ sighandler(
 void
 cs10_fini(void) {
 
+  uint64_t ullStop = 1 ;
+
+  /* the daw thread reads pSeq and writes shared state, so it has to be
+   * gone before either is let go. it can't wait on itself, when it is
+   * the one that is leaving
+   */
+  if (cs10.bDAWThread &&
+      !pthread_equal(pthread_self(), cs10.dawThread)) {
+    write(cs10.iDAWStopFD, &ullStop, sizeof(ullStop)) ;
+    pthread_join(cs10.dawThread, NULL) ;
+  } /* if */
+
   if (0 <= cs10.iControlPortID)
-    snd_seq_delete_simple_port(cs10.pSeq, cs10.iControlPortID) ;
+    snd_seq_delete_simple_port(cs10.pSurfaceSeq, cs10.iControlPortID) ;
+
+  /* a macro still running goes with its queue */
+  cs10_macro_queue_close() ;
+  cs10_target_close() ;
 
   if (0 <= cs10.iMMCPortID)
     snd_seq_delete_simple_port(cs10.pSeq, cs10.iMMCPortID) ;
 
+  /* leave a snapshot behind for the next start */
+  seqlock_write_begin(&cs10.stateLock) ;
+  cs10_journal_close() ;
+  cs10_state_write_end(0) ;
+
+  cs10_automation_close() ;
+  cs10_shm_close() ;
+
+  /* what the threads logged goes out before the stats */
+  cs10_log_stop() ;
+  cs10_trace_close() ;
+  cs10_stats_stop() ;
+
+  if (cs10.debug) {
+    cs10_output_dump_stats(stderr) ;
+
+    if (cs10_osc_is_open())
+      cs10_osc_dump_stats(stderr) ;
+  } /* if */
+
+  cs10_osc_close() ;
+  cs10_control_close() ;
+
+  if (cs10.pSurfaceSeq)
+    snd_seq_close(cs10.pSurfaceSeq) ;
+
+  if (cs10.pRawIn)
+    snd_rawmidi_close(cs10.pRawIn) ;
+
+  if (cs10.pRawOut)
+    snd_rawmidi_close(cs10.pRawOut) ;
+
   snd_seq_close(cs10.pSeq) ;
+
+  if (0 <= cs10.iWakeFD)
+    close(cs10.iWakeFD) ;
+
+  if (0 <= cs10.iDAWStopFD)
+    close(cs10.iDAWStopFD) ;
+
+  if (0 <= cs10.iNotifyFD)
+    close(cs10.iNotifyFD) ;
 } /* cs10_fini */
 
+/*
+ * cs10_configure_output
+ *
+ * size the client pool and output buffer of pSeq, and make it
+ * non-blocking so that a full pool is reported rather than waited on
+ */
+void
+cs10_configure_output(
+  snd_seq_t *pSeq) {
+
+  if (cs10.uiOutputPool &&
+      (0 > snd_seq_set_client_pool_output(pSeq, cs10.uiOutputPool)))
+    fprintf(stderr, "can't set output pool to %u\n", cs10.uiOutputPool) ;
+
+  if (cs10.uiOutputBuffer &&
+      (0 > snd_seq_set_output_buffer_size(pSeq, cs10.uiOutputBuffer)))
+    fprintf(stderr, "can't set output buffer to %u\n", cs10.uiOutputBuffer) ;
+
+  snd_seq_nonblock(pSeq, 1) ;
+} /* cs10_configure_output */
+
+/*
+ * cs10_open_surface
+ *
+ * open whatever carries the surface link, the cs10-io sequencer client
+ * or, given a device name, the rawmidi device itself
+ */
+bool
+cs10_open_surface(void) {
+
+  if (cs10.rawmidi_name) {
+    cs10.pSurfaceSeq = NULL ;
+    cs10.iControlPortID = -1 ;
+    cs10.iAnnouncePortID = -1 ;
+
+    if (0 > snd_rawmidi_open(&cs10.pRawIn, &cs10.pRawOut, cs10.rawmidi_name,
+                             SND_RAWMIDI_NONBLOCK)) {
+      fprintf(stderr, "can't open rawmidi device %s\n", cs10.rawmidi_name) ;
+      return false ;
+    } /* if */
+
+    cs10_midi_parser_init(&cs10.surfaceParser) ;
+    return true ;
+  } /* if */
+
+  if (0 != snd_seq_open(&cs10.pSurfaceSeq, CS10_SEQUENCER_NAME,
+                        SND_SEQ_OPEN_DUPLEX, 0))
+    return false ;
+
+  cs10.iSurfaceClientID = snd_seq_client_id(cs10.pSurfaceSeq) ;
+  snd_seq_set_client_name(cs10.pSurfaceSeq, CS10_SURFACE_CLIENT_NAME) ;
+
+  cs10.iControlPortID = snd_seq_create_simple_port(cs10.pSurfaceSeq,
+      CS10_CONTROL_PORT_NAME,
+      SND_SEQ_PORT_CAP_WRITE |
+      SND_SEQ_PORT_CAP_READ |
+      SND_SEQ_PORT_CAP_SUBS_WRITE |
+      SND_SEQ_PORT_CAP_SUBS_READ,
+      SND_SEQ_PORT_TYPE_MIDI_GENERIC |
+      SND_SEQ_PORT_TYPE_APPLICATION) ;
+
+  /* hear about ports coming and going, so the interface can be relinked
+   * the moment it comes back
+   */
+  cs10.iAnnouncePortID = snd_seq_create_simple_port(cs10.pSurfaceSeq,
+      CS10_ANNOUNCE_PORT_NAME,
+      SND_SEQ_PORT_CAP_WRITE |
+      SND_SEQ_PORT_CAP_NO_EXPORT,
+      SND_SEQ_PORT_TYPE_APPLICATION) ;
+
+  if ((0 > cs10.iAnnouncePortID) ||
+      (0 > snd_seq_connect_from(cs10.pSurfaceSeq, cs10.iAnnouncePortID,
+                                SND_SEQ_CLIENT_SYSTEM,
+                                SND_SEQ_PORT_SYSTEM_ANNOUNCE)))
+    fprintf(stderr, "can't follow the system announce port\n") ;
+
+  cs10_configure_output(cs10.pSurfaceSeq) ;
+
+  return true ;
+} /* cs10_open_surface */
+
 /*
  * cs10_init
  *
@@ -197,39 +816,131 @@ cs10_init(void) {
 
   bool bRetValue = false ;
 
-  if (0 == snd_seq_open(&cs10.pSeq, CS10_SEQUENCER_NAME,
-                        SND_SEQ_OPEN_DUPLEX, 0)) {
-    cs10.iClientID = snd_seq_client_id(cs10.pSeq) ;
-    snd_seq_set_client_name(cs10.pSeq, CS10_CLIENT_NAME) ;
-
-    cs10.iControlPortID = snd_seq_create_simple_port(cs10.pSeq,
-        CS10_CONTROL_PORT_NAME,
-        SND_SEQ_PORT_CAP_WRITE |
-        SND_SEQ_PORT_CAP_READ |
-        SND_SEQ_PORT_CAP_SUBS_WRITE |
-        SND_SEQ_PORT_CAP_SUBS_READ,
-        SND_SEQ_PORT_TYPE_MIDI_GENERIC |
-        SND_SEQ_PORT_TYPE_APPLICATION) ;
-
-    cs10.iMMCPortID = snd_seq_create_simple_port(cs10.pSeq,
-        CS10_MMC_IO_PORT_NAME,
-        SND_SEQ_PORT_CAP_READ |
-        SND_SEQ_PORT_CAP_WRITE |
-        SND_SEQ_PORT_CAP_SUBS_READ |
-        SND_SEQ_PORT_CAP_SUBS_WRITE,
-        SND_SEQ_PORT_TYPE_MIDI_GENERIC |
-        SND_SEQ_PORT_TYPE_APPLICATION) ;
-
-    bRetValue = true ;
-
-    atexit(cs10_fini) ;
-
-    cs10.pOldSigHandler = signal(SIGTERM, sighandler) ;
+  seqlock_init(&cs10.stateLock) ;
+
+  cs10.iWakeFD = eventfd(0, EFD_NONBLOCK) ;
+  cs10.iDAWStopFD = eventfd(0, EFD_NONBLOCK) ;
+
+  if ((0 <= cs10.iWakeFD) && (0 <= cs10.iDAWStopFD) &&
+      (0 == snd_seq_open(&cs10.pSeq, CS10_SEQUENCER_NAME,
+                         SND_SEQ_OPEN_DUPLEX, 0))) {
+    if (cs10_open_surface()) {
+      cs10.iClientID = snd_seq_client_id(cs10.pSeq) ;
+      snd_seq_set_client_name(cs10.pSeq, CS10_CLIENT_NAME) ;
+
+      cs10.iMMCPortID = snd_seq_create_simple_port(cs10.pSeq,
+          CS10_MMC_IO_PORT_NAME,
+          SND_SEQ_PORT_CAP_READ |
+          SND_SEQ_PORT_CAP_WRITE |
+          SND_SEQ_PORT_CAP_SUBS_READ |
+          SND_SEQ_PORT_CAP_SUBS_WRITE,
+          SND_SEQ_PORT_TYPE_MIDI_GENERIC |
+          SND_SEQ_PORT_TYPE_APPLICATION) ;
+
+      cs10_configure_output(cs10.pSeq) ;
+
+      cs10_output_init(cs10.pSeq, cs10.iMMCPortID,
+                       cs10.pSurfaceSeq, cs10.iControlPortID) ;
+
+      if (cs10.pRawOut)
+        cs10_output_use_rawmidi(FEEDBACK_LANE, cs10.pRawOut) ;
+
+      bRetValue = true ;
+
+      atexit(cs10_fini) ;
+
+      cs10.pOldSigHandler = signal(SIGTERM, sighandler) ;
+      signal(SIGUSR1, statshandler) ;
+    } else
+      snd_seq_close(cs10.pSeq) ;
   } /* if open */
 
   return bRetValue ;
 } /* cs10_init */
 
+/*
+ * cs10_request_refresh
+ *
+ * ask the surface thread to bring the LEDs up to date with shared state.
+ * requests are coalesced, so a flood of feedback costs one refresh.
+ */
+void
+cs10_request_refresh(
+  unsigned int uiFlags) {
+
+  uint64_t ullWake = 1 ;
+
+  if (0 == __atomic_fetch_or(&cs10.uiRefreshFlags, uiFlags, __ATOMIC_RELEASE))
+    write(cs10.iWakeFD, &ullWake, sizeof(ullWake)) ;
+} /* cs10_request_refresh */
+
+/*
+ * cs10_read_track_state
+ *
+ * take a consistent copy of uiVirtualTrack's state
+ */
+void
+cs10_read_track_state(
+  unsigned int uiVirtualTrack,
+  cs10_track_state_t *pTrack) {
+
+  unsigned int uiSequence ;
+
+  do {
+    uiSequence = seqlock_read_begin(&cs10.stateLock) ;
+    *pTrack = cs10.csState.tsTrack[uiVirtualTrack] ;
+  } while (seqlock_read_retry(&cs10.stateLock, uiSequence)) ;
+} /* cs10_read_track_state */
+
+/*
+ * cs10_read_mixer_state
+ *
+ * take a consistent copy of the whole mixer state
+ */
+void
+cs10_read_mixer_state(
+  cs10_mixer_state_t *pState) {
+
+  unsigned int uiSequence ;
+
+  do {
+    uiSequence = seqlock_read_begin(&cs10.stateLock) ;
+    memcpy(pState, &cs10.csState, sizeof(cs10_mixer_state_t)) ;
+  } while (seqlock_read_retry(&cs10.stateLock, uiSequence)) ;
+} /* cs10_read_mixer_state */
+
+/*
+ * cs10_read_current_time
+ *
+ * take a consistent copy of the current time code
+ */
+smpte_time_t
+cs10_read_current_time(void) {
+
+  smpte_time_t tTime ;
+  unsigned int uiSequence ;
+
+  do {
+    uiSequence = seqlock_read_begin(&cs10.stateLock) ;
+    tTime = cs10.tCurrentTime ;
+  } while (seqlock_read_retry(&cs10.stateLock, uiSequence)) ;
+
+  return tTime ;
+} /* cs10_read_current_time */
+
+/*
+ * cs10_time_to_frame
+ *
+ * count the frames from zero to tTime at its own frame rate
+ */
+uint32_t
+cs10_time_to_frame(
+  smpte_time_t tTime) {
+
+  return (((uint32_t)tTime.hours * 60 + tTime.minutes) * 60 + tTime.seconds) *
+         uiSMPTEFrameRate[tTime.flags & 0x03] + tTime.frames ;
+} /* cs10_time_to_frame */
+
 /*
  * cs10_save_settings
  *
@@ -250,6 +961,7 @@ cs10_save_settings() {
     fwrite(cs10.tSavedPosition,
       sizeof(smpte_time_t), CS10_NUM_SAVED_POSITIONS, fp);
     fclose(fp);
+    CS10_COUNT(SAVE_COUNTER);
   } /* if */
 } /* cs10_save_settings */
 
@@ -276,6 +988,109 @@ cs10_load_settings() {
   } /* if */
 } /* cs10_load_settings */
 
+/*
+ * cs10_journal_snapshot
+ *
+ * the live state as the journal keeps it
+ * called with the stateLock write lock held, or before the daw thread runs
+ */
+void
+cs10_journal_snapshot(
+  void *pSnapshot) {
+
+  cs10_live_state_t *pLive = pSnapshot ;
+
+  memcpy(&pLive->csState, &cs10.csState, sizeof(cs10_mixer_state_t)) ;
+  pLive->uiBank = cs10.uiBank ;
+  pLive->theMode = cs10.theMode ;
+  pLive->uiSelectedTrack = cs10.uiSelectedTrack ;
+} /* cs10_journal_snapshot */
+
+/*
+ * cs10_journal_replay_record
+ *
+ * apply one journalled change to the live state in pSnapshot
+ */
+void
+cs10_journal_replay_record(
+  void *pSnapshot,
+  unsigned int uiKey,
+  unsigned int uiValue) {
+
+  cs10_live_state_t  *pLive = pSnapshot ;
+  cs10_track_state_t *pTrack ;
+  unsigned int        uiControl = JOURNAL_KEY_CONTROL(uiKey) ;
+
+  switch (uiKey) {
+    case JOURNAL_BANK_KEY:
+      pLive->uiBank = uiValue ;
+      return ;
+
+    case JOURNAL_MODE_KEY:
+      pLive->theMode = uiValue ;
+      return ;
+
+    case JOURNAL_SELECTED_KEY:
+      pLive->uiSelectedTrack = uiValue ;
+      return ;
+
+    default:
+      break ;
+  } /* switch */
+
+  if (JOURNAL_KEY_TRACK(uiKey) >= CS10_NUM_VIRTUAL_TRACKS)
+    return ;
+
+  pTrack = &pLive->csState.tsTrack[JOURNAL_KEY_TRACK(uiKey)] ;
+
+  switch (uiControl) {
+    case ARMED_CONTROL:
+      pTrack->bArmed = (uiValue ? true : false) ;
+      break ;
+
+    case MUTE_CONTROL:
+      pTrack->bMute = (uiValue ? true : false) ;
+      break ;
+
+    case SOLO_CONTROL:
+      pTrack->bSolo = (uiValue ? true : false) ;
+      break ;
+
+    case FADER_CONTROL:
+      pTrack->uiFader = uiValue ;
+      break ;
+
+    case PAN_CONTROL:
+    case SEND_ONE_CONTROL:
+    case SEND_TWO_CONTROL:
+    case BOOST_CUT_CONTROL:
+    case FREQUENCY_CONTROL:
+    case BANDWDITH_CONTROL:
+      pTrack->uiKnob[VIRTUAL_CONTROL_TO_KNOB_INDEX(uiControl)] = uiValue ;
+      break ;
+
+    default:
+      break ;
+  } /* switch */
+} /* cs10_journal_replay_record */
+
+/*
+ * cs10_journal_surface_state
+ *
+ * journal the bank, mode and selected track after any of them changed
+ * they belong to the surface thread, the state lock only keeps these
+ * appends in order with the daw thread's
+ */
+void
+cs10_journal_surface_state(void) {
+
+  seqlock_write_begin(&cs10.stateLock) ;
+  cs10_journal_append(JOURNAL_BANK_KEY, cs10.uiBank) ;
+  cs10_journal_append(JOURNAL_MODE_KEY, cs10.theMode) ;
+  cs10_journal_append(JOURNAL_SELECTED_KEY, cs10.uiSelectedTrack) ;
+  cs10_state_write_end(0) ;
+} /* cs10_journal_surface_state */
+
 /*
  * cs10_set_led
  *
@@ -286,24 +1101,119 @@ cs10_set_led(
   unsigned int uiAddr,
   unsigned int uiValue) {
 
-  bool             bRetValue ;
   snd_seq_event_t  theEvent ;
   unsigned char    ucCommand[LED_SYSEX_PACKET_LENGTH] =
      LED_SYSEX_PACKET(uiAddr, uiValue) ;
 
+  if (uiAddr < CS10_NUM_LED_ADDRS) {
+    if (cs10.uiLEDBatch) {
+      cs10.ucLEDWanted[uiAddr] = uiValue + 1 ;
+      return true ;
+    } /* if */
+
+    /* already showing */
+    if (cs10.pucLEDShadow[uiAddr] == uiValue + 1)
+      return true ;
+
+    cs10.pucLEDShadow[uiAddr] = uiValue + 1 ;
+  } /* if */
+
   snd_seq_ev_clear(&theEvent) ;
-  snd_seq_ev_set_dest(&theEvent, SND_SEQ_ADDRESS_SUBSCRIBERS, 0) ;
-  snd_seq_ev_set_source(&theEvent, cs10.iControlPortID) ;
-  snd_seq_ev_set_direct(&theEvent) ;
 
   snd_seq_ev_set_sysex(&theEvent, LED_SYSEX_PACKET_LENGTH, ucCommand) ;
 
-  snd_seq_event_output(cs10.pSeq, &theEvent) ;
-  snd_seq_drain_output(cs10.pSeq) ;
-
-  return bRetValue ;
+  /* only the newest value for an LED matters */
+  return cs10_output_queue_latest(FEEDBACK_LANE, &theEvent) ;
 } /* cs10_set_led */
 
+/*
+ * cs10_led_batch_begin
+ *
+ * hold LED changes back until cs10_led_batch_end
+ */
+void
+cs10_led_batch_begin(void) {
+
+  if (0 == cs10.uiLEDBatch++)
+    memset(cs10.ucLEDWanted, 0, sizeof(cs10.ucLEDWanted)) ;
+} /* cs10_led_batch_begin */
+
+/*
+ * cs10_led_batch_end
+ *
+ * send just the LEDs the batch left different from what's showing
+ */
+void
+cs10_led_batch_end(void) {
+
+  unsigned int uiAddr ;
+
+  if (--cs10.uiLEDBatch)
+    return ;
+
+  for (uiAddr = 0 ; uiAddr < CS10_NUM_LED_ADDRS ; uiAddr++) {
+    if (cs10.ucLEDWanted[uiAddr])
+      cs10_set_led(uiAddr, cs10.ucLEDWanted[uiAddr] - 1) ;
+  } /* for */
+} /* cs10_led_batch_end */
+
+/*
+ * cs10_forget_leds
+ *
+ * the surface may be showing anything, send every LED next time
+ */
+void
+cs10_forget_leds(void) {
+
+  memset(cs10.pucLEDShadow, 0, CS10_NUM_LED_ADDRS) ;
+} /* cs10_forget_leds */
+
+/*
+ * cs10_open_journal
+ *
+ * map the journal and pick up the live state it holds
+ * return true for a warm start
+ */
+bool
+cs10_open_journal(void) {
+
+  cs10_live_state_t theLive ;
+
+  cs10.pucLEDShadow = cs10.ucLEDFallback ;
+
+  if (NULL == cs10.journal_filename)
+    return false ;
+
+  if (!cs10_journal_open(cs10.journal_filename, sizeof(cs10_live_state_t),
+                         CS10_NUM_LED_ADDRS, cs10_journal_snapshot)) {
+    fprintf(stderr, "can't open journal %s\n", cs10.journal_filename) ;
+    return false ;
+  } /* if */
+
+  cs10.pucLEDShadow = cs10_journal_scratch() ;
+
+  if (!cs10_journal_replay(&theLive, cs10_journal_replay_record)) {
+    cs10_forget_leds() ;
+    return false ;
+  } /* if */
+
+  memcpy(&cs10.csState, &theLive.csState, sizeof(cs10_mixer_state_t)) ;
+
+  if (theLive.uiBank < CS10_NUM_BANKS)
+    cs10.uiBank = theLive.uiBank ;
+
+  if (theLive.theMode < NUM_MODES)
+    cs10.theMode = theLive.theMode ;
+
+  if (theLive.uiSelectedTrack < CS10_NUM_PHYSICAL_TRACKS)
+    cs10.uiSelectedTrack = theLive.uiSelectedTrack ;
+
+  if (cs10.debug)
+    fprintf(stderr, "warm start from %s\n", cs10.journal_filename) ;
+
+  return true ;
+} /* cs10_open_journal */
+
 /*
  * cs10_display_number_dec
  *
@@ -343,31 +1253,32 @@ void
 cs10_display_time() {
 
   unsigned char data = 0;
+  smpte_time_t  tTime = cs10_read_current_time();
 
   switch (cs10.smpteDisplayMode) {
     case SMPTE_DISPLAY_HOURS:
-      data = cs10.tCurrentTime.hours;
+      data = tTime.hours;
 
       cs10_set_led(TENS_DEC_LED_ADDR, LED_ON_VALUE);
       cs10_set_led(ONES_DEC_LED_ADDR, LED_ON_VALUE);
       break;
 
     case SMPTE_DISPLAY_MINUTES:
-      data = cs10.tCurrentTime.minutes;
+      data = tTime.minutes;
 
       cs10_set_led(TENS_DEC_LED_ADDR, LED_ON_VALUE);
       cs10_set_led(ONES_DEC_LED_ADDR, LED_OFF_VALUE);
       break;
 
     case SMPTE_DISPLAY_SECONDS:
-      data = cs10.tCurrentTime.seconds;
+      data = tTime.seconds;
 
       cs10_set_led(TENS_DEC_LED_ADDR, LED_OFF_VALUE);
       cs10_set_led(ONES_DEC_LED_ADDR, LED_ON_VALUE);
       break;
 
     case SMPTE_DISPLAY_FRAMES:
-      data = cs10.tCurrentTime.frames;
+      data = tTime.frames;
 
       cs10_set_led(TENS_DEC_LED_ADDR, LED_OFF_VALUE);
       cs10_set_led(ONES_DEC_LED_ADDR, LED_OFF_VALUE);
@@ -389,21 +1300,23 @@ cs10_update_display_time() {
   unsigned char data = 0;
 
   if (cs10.displayMode == SMPTE_DISPLAY_MODE) {
+    smpte_time_t tTime = cs10_read_current_time();
+
     switch (cs10.smpteDisplayMode) {
       case SMPTE_DISPLAY_HOURS:
-        data = cs10.tCurrentTime.hours;
+        data = tTime.hours;
         break;
 
       case SMPTE_DISPLAY_MINUTES:
-        data = cs10.tCurrentTime.minutes;
+        data = tTime.minutes;
         break;
 
       case SMPTE_DISPLAY_SECONDS:
-        data = cs10.tCurrentTime.seconds;
+        data = tTime.seconds;
         break;
 
       case SMPTE_DISPLAY_FRAMES:
-        data = cs10.tCurrentTime.frames;
+        data = tTime.frames;
         break;
 
       default:
@@ -435,6 +1348,12 @@ cs10_set_mode(
   control_mode_t theMode) {
 
   unsigned int uiTrack ;
+  cs10_track_state_t tsTrack ;
+
+  CS10_TRACE_BEGIN("set mode") ;
+
+  /* LEDs switched off on the way to being lit again never go out */
+  cs10_led_batch_begin() ;
 
   cs10_set_led(SELECT_LED_ADDR, LED_OFF_VALUE) ;
   cs10_set_led(LOCATE_LED_ADDR, LED_OFF_VALUE) ;
@@ -471,11 +1390,10 @@ cs10_set_mode(
       for (uiTrack = 0 ;
            uiTrack < CS10_NUM_PHYSICAL_TRACKS ;
            uiTrack++) {
+        cs10_read_track_state(
+            cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + uiTrack, &tsTrack) ;
         cs10_set_led(TRACK_TO_LED_ADDR(uiTrack),
-            (cs10.csState.tsTrack[
-               cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-               uiTrack].bArmed ?
-             LED_ON_VALUE : LED_OFF_VALUE)) ;
+            (tsTrack.bArmed ? LED_ON_VALUE : LED_OFF_VALUE)) ;
       } /* for */
       break ;
 
@@ -490,11 +1408,10 @@ cs10_set_mode(
       for (uiTrack = 0 ;
            uiTrack < CS10_NUM_PHYSICAL_TRACKS ;
            uiTrack++) {
+        cs10_read_track_state(
+            cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + uiTrack, &tsTrack) ;
         cs10_set_led(TRACK_TO_LED_ADDR(uiTrack),
-            (cs10.csState.tsTrack[
-               cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-               uiTrack].bMute ?
-             LED_ON_VALUE : LED_OFF_VALUE)) ;
+            (tsTrack.bMute ? LED_ON_VALUE : LED_OFF_VALUE)) ;
       } /* for */
       break ;
 
@@ -509,11 +1426,10 @@ cs10_set_mode(
       for (uiTrack = 0 ;
            uiTrack < CS10_NUM_PHYSICAL_TRACKS ;
            uiTrack++) {
+        cs10_read_track_state(
+            cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + uiTrack, &tsTrack) ;
         cs10_set_led(TRACK_TO_LED_ADDR(uiTrack),
-            (cs10.csState.tsTrack[
-               cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-               uiTrack].bSolo ?
-             LED_ON_VALUE : LED_OFF_VALUE)) ;
+            (tsTrack.bSolo ? LED_ON_VALUE : LED_OFF_VALUE)) ;
       } /* for */
       break ;
 
@@ -541,119 +1457,486 @@ cs10_set_mode(
     default:
       break ;
   } /* break */
+
+  /* the record light shows automation recording, not the transport */
+  cs10_set_led(RECORD_LED_ADDR,
+      (AUTOMATION_RECORD == cs10.automationMode ?
+       LED_ON_VALUE : LED_OFF_VALUE)) ;
+
+  cs10_led_batch_end() ;
+
+  CS10_TRACE_END("set mode") ;
 } /* cs10_set_mode */
 
+/*
+ * cs10_refresh_track_leds
+ *
+ * bring the track LEDs of the current bank up to date, for just the
+ * virtual tracks in uiDirty
+ */
+void
+cs10_refresh_track_leds(
+  uint32_t uiDirty) {
+
+  unsigned int uiTrack ;
+  cs10_track_state_t tsTrack ;
+
+  for (uiTrack = 0 ;
+       uiTrack < CS10_NUM_PHYSICAL_TRACKS ;
+       uiTrack++) {
+    unsigned int uiVirtualTrack =
+      cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + uiTrack ;
+
+    if (0 == (uiDirty & (1U << uiVirtualTrack)))
+      continue ;
+
+    cs10_read_track_state(uiVirtualTrack, &tsTrack) ;
+
+    switch (cs10.theMode) {
+      case LOC_MODE:
+        cs10_set_led(TRACK_TO_LED_ADDR(uiTrack),
+            (tsTrack.bArmed ? LED_ON_VALUE : LED_OFF_VALUE)) ;
+        break ;
+
+      case MUTE_MODE:
+        cs10_set_led(TRACK_TO_LED_ADDR(uiTrack),
+            (tsTrack.bMute ? LED_ON_VALUE : LED_OFF_VALUE)) ;
+        break ;
+
+      case SOLO_MODE:
+        cs10_set_led(TRACK_TO_LED_ADDR(uiTrack),
+            (tsTrack.bSolo ? LED_ON_VALUE : LED_OFF_VALUE)) ;
+        break ;
+
+      default:
+        break ;
+    } /* switch */
+  } /* for */
+} /* cs10_refresh_track_leds */
+
+/*
+ * cs10_fan_out_transport
+ *
+ * hand the mmc packet in pEvent on to every target following transport
+ */
+void
+cs10_fan_out_transport(
+  const snd_seq_event_t *pEvent) {
+
+  const cs10_target_t *pTarget ;
+  unsigned int         uiTarget ;
+
+  for (uiTarget = 0 ;
+       NULL != (pTarget = cs10_target_get(uiTarget)) ;
+       uiTarget++) {
+    if (pTarget->bTransport)
+      cs10_output_queue_to(TRANSPORT_LANE, pTarget->iPortID, pEvent) ;
+  } /* for */
+} /* cs10_fan_out_transport */
+
 /*
  * cs10_issue_mmc_command
  *
- * send uiCommand on cs10.iMMCPortID
+ * send uiCommand on cs10.iMMCPortID, and to the targets following transport
  */
 bool
 cs10_issue_mmc_command(
   unsigned int uiCommand) {
 
-  bool             bRetValue ;
   snd_seq_event_t  theEvent ;
   unsigned char    ucCommand[MMC_CMD_SYSEX_PACKET_LENGTH] =
      MMC_CMD_SYSEX_PACKET(MMC_DEVICEID_ALL, uiCommand) ;
+  bool             bSent ;
 
   snd_seq_ev_clear(&theEvent) ;
-  snd_seq_ev_set_dest(&theEvent, SND_SEQ_ADDRESS_SUBSCRIBERS, 0) ;
-  snd_seq_ev_set_source(&theEvent, cs10.iMMCPortID) ;
-  snd_seq_ev_set_direct(&theEvent) ;
 
   snd_seq_ev_set_sysex(&theEvent, MMC_CMD_SYSEX_PACKET_LENGTH, ucCommand) ;
 
-  snd_seq_event_output(cs10.pSeq, &theEvent) ;
-  snd_seq_drain_output(cs10.pSeq) ;
+  bSent = cs10_output_queue(TRANSPORT_LANE, &theEvent) ;
+  cs10_fan_out_transport(&theEvent) ;
 
-  return bRetValue ;
+  return bSent ;
 } /* cs10_issue_mmc_command */
 
 /*
  * cs10_issue_mmc_step_command
  *
- * send mmc step command on cs10.iMMCPortID
+ * send mmc step command on cs10.iMMCPortID, and to the targets following
+ * transport
  */
 bool
 cs10_issue_mmc_step_command(
   int iSteps) {
 
-  bool             bRetValue = true ;
   snd_seq_event_t  theEvent ;
   unsigned char    ucCommand[MMC_STEP_SYSEX_PACKET_LENGTH] =
      MMC_STEP_SYSEX_PACKET(MMC_DEVICEID_ALL, iSteps) ;
+  bool             bSent ;
 
   snd_seq_ev_clear(&theEvent) ;
-  snd_seq_ev_set_dest(&theEvent, SND_SEQ_ADDRESS_SUBSCRIBERS, 0) ;
-  snd_seq_ev_set_source(&theEvent, cs10.iMMCPortID) ;
-  snd_seq_ev_set_direct(&theEvent) ;
 
   snd_seq_ev_set_sysex(&theEvent, MMC_STEP_SYSEX_PACKET_LENGTH, ucCommand) ;
 
-  snd_seq_event_output(cs10.pSeq, &theEvent) ;
-  snd_seq_drain_output(cs10.pSeq) ;
+  bSent = cs10_output_queue(TRANSPORT_LANE, &theEvent) ;
+  cs10_fan_out_transport(&theEvent) ;
 
-  return bRetValue ;
+  return bSent ;
 } /* cs10_issue_mmc_step_command */
 
 /*
  * cs10_issue_mmc_goto_command
  *
- * send mmc goto command on cs10.iMMCPortID
+ * send mmc goto command on cs10.iMMCPortID, and to the targets following
+ * transport
  */
 bool
 cs10_issue_mmc_goto_command(
   smpte_time_t theTime) {
 
-  bool             bRetValue = true ;
   snd_seq_event_t  theEvent ;
   unsigned char    ucCommand[MMC_GOTO_SYSEX_PACKET_LENGTH] =
      MMC_GOTO_SYSEX_PACKET(MMC_DEVICEID_ALL,
          theTime.hours, theTime.minutes, theTime.seconds, theTime.frames, 0) ;
+  bool             bSent ;
 
   snd_seq_ev_clear(&theEvent) ;
-  snd_seq_ev_set_dest(&theEvent, SND_SEQ_ADDRESS_SUBSCRIBERS, 0) ;
-  snd_seq_ev_set_source(&theEvent, cs10.iMMCPortID) ;
-  snd_seq_ev_set_direct(&theEvent) ;
 
   snd_seq_ev_set_sysex(&theEvent, MMC_GOTO_SYSEX_PACKET_LENGTH, ucCommand) ;
 
-  snd_seq_event_output(cs10.pSeq, &theEvent) ;
-  snd_seq_drain_output(cs10.pSeq) ;
+  bSent = cs10_output_queue(TRANSPORT_LANE, &theEvent) ;
+  cs10_fan_out_transport(&theEvent) ;
 
-  return bRetValue ;
+  return bSent ;
 } /* cs10_issue_mmc_goto_command */
 
+/*
+ * cs10_now_ms
+ *
+ * a monotonic millisecond clock, wrapping is fine for interval checks
+ */
+uint32_t
+cs10_now_ms(void) {
+
+  struct timespec tNow ;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow) ;
+
+  return (uint32_t)(tNow.tv_sec * 1000 + tNow.tv_nsec / 1000000) ;
+} /* cs10_now_ms */
+
+/*
+ * cs10_echo_note_sent
+ *
+ * remember that uiValue is on its way to the daw on uiChannel/uiCC
+ */
+void
+cs10_echo_note_sent(
+  unsigned int uiChannel,
+  unsigned int uiCC,
+  unsigned int uiValue) {
+
+  volatile uint64_t *pEntry = &cs10.ullEcho[uiChannel][uiCC] ;
+  uint64_t     ullEntry = __atomic_load_n(pEntry, __ATOMIC_RELAXED) ;
+  uint32_t     uiNow = cs10_now_ms() ;
+  unsigned int uiLow = uiValue ;
+  unsigned int uiHigh = uiValue ;
+
+  /* a ramp or a fader move is one burst, its echoes fill the range */
+  if ((ullEntry & ECHO_ENTRY_VALID) &&
+      (uiNow - ECHO_ENTRY_STAMP(ullEntry) < CS10_ECHO_WINDOW_MS)) {
+    if (ECHO_ENTRY_LOW(ullEntry) < uiLow)
+      uiLow = ECHO_ENTRY_LOW(ullEntry) ;
+    if (ECHO_ENTRY_HIGH(ullEntry) > uiHigh)
+      uiHigh = ECHO_ENTRY_HIGH(ullEntry) ;
+  } /* if */
+
+  __atomic_store_n(pEntry, ECHO_ENTRY(uiLow, uiHigh, uiNow),
+                   __ATOMIC_RELEASE) ;
+} /* cs10_echo_note_sent */
+
+/*
+ * cs10_echo_is_ours
+ *
+ * is uiValue on uiChannel/uiCC just the daw handing back what we sent
+ */
+bool
+cs10_echo_is_ours(
+  unsigned int uiChannel,
+  unsigned int uiCC,
+  unsigned int uiValue) {
+
+  uint64_t ullEntry ;
+
+  if ((CS10_NUM_MIDI_CHANNELS <= uiChannel) || (CS10_NUM_MIDI_CCS <= uiCC))
+    return false ;
+
+  ullEntry = __atomic_load_n(&cs10.ullEcho[uiChannel][uiCC],
+                             __ATOMIC_ACQUIRE) ;
+
+  return ((ullEntry & ECHO_ENTRY_VALID) &&
+          (cs10_now_ms() - ECHO_ENTRY_STAMP(ullEntry) < CS10_ECHO_WINDOW_MS) &&
+          (ECHO_ENTRY_LOW(ullEntry) <= uiValue) &&
+          (ECHO_ENTRY_HIGH(ullEntry) >= uiValue)) ;
+} /* cs10_echo_is_ours */
+
+/*
+ * cs10_current_map
+ *
+ * the map in use right now, safe from either thread
+ */
+const cs10_map_t *
+cs10_current_map(void) {
+
+  return __atomic_load_n(&cs10.pMap, __ATOMIC_ACQUIRE) ;
+} /* cs10_current_map */
+
+/*
+ * cs10_daw_map_seen
+ *
+ * let the surface thread know the daw thread holds no map older than
+ * the current generation, called by the daw thread between events
+ */
+void
+cs10_daw_map_seen(void) {
+
+  unsigned int uiGeneration = __atomic_load_n(&cs10.uiMapGeneration,
+                                              __ATOMIC_SEQ_CST) ;
+
+  if (uiGeneration == __atomic_load_n(&cs10.uiDAWMapGeneration,
+                                      __ATOMIC_RELAXED))
+    return ;
+
+  /* before the next look at pMap */
+  __atomic_store_n(&cs10.uiDAWMapGeneration, uiGeneration, __ATOMIC_SEQ_CST) ;
+  __atomic_thread_fence(__ATOMIC_SEQ_CST) ;
+} /* cs10_daw_map_seen */
+
+/*
+ * cs10_reclaim_maps
+ *
+ * free the retired maps the daw thread has moved past
+ */
+void
+cs10_reclaim_maps(void) {
+
+  cs10_retired_map_t **ppRetired = &cs10.pRetiredMaps ;
+  unsigned int         uiSeen ;
+
+  uiSeen = __atomic_load_n(&cs10.uiDAWMapGeneration, __ATOMIC_SEQ_CST) ;
+
+  while (*ppRetired) {
+    cs10_retired_map_t *pRetired = *ppRetired ;
+
+    if ((CS10_DAW_MAP_IDLE == uiSeen) || (uiSeen >= pRetired->uiGeneration)) {
+      *ppRetired = pRetired->pNext ;
+      free(pRetired->pMap) ;
+      free(pRetired) ;
+    } else
+      ppRetired = &pRetired->pNext ;
+  } /* while */
+} /* cs10_reclaim_maps */
+
+/*
+ * cs10_fan_out_control
+ *
+ * hand pEvent, the controller going to the daw for uiVirtualTrack's
+ * tcControl, on to every target following it, each on its own channel
+ * and cc. pEvent is left with the last target's
+ */
+void
+cs10_fan_out_control(
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  snd_seq_event_t *pEvent,
+  cs10_output_lane_t lane) {
+
+  const cs10_map_t    *pMap = cs10_current_map() ;
+  const cs10_target_t *pTarget ;
+  unsigned int         uiTarget ;
+
+  for (uiTarget = 0 ;
+       NULL != (pTarget = cs10_target_get(uiTarget)) ;
+       uiTarget++) {
+    if (!cs10_target_remap(pTarget, pMap, uiVirtualTrack, tcControl, pEvent))
+      continue ;
+
+    if (tcControl >= FADER_CONTROL)
+      cs10_output_queue_latest_to(lane, pTarget->iPortID, pEvent) ;
+    else
+      cs10_output_queue_to(lane, pTarget->iPortID, pEvent) ;
+  } /* for */
+} /* cs10_fan_out_control */
+
+/*
+ * cs10_fan_out_value
+ *
+ * send uiValue for uiVirtualTrack's tcControl to the targets following
+ * it, for what went to the daw as osc
+ */
+void
+cs10_fan_out_value(
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiValue,
+  cs10_output_lane_t lane) {
+
+  snd_seq_event_t theEvent ;
+
+  if (0 == cs10_target_count())
+    return ;
+
+  snd_seq_ev_clear(&theEvent) ;
+  snd_seq_ev_set_controller(&theEvent, 0, 0, uiValue) ;
+
+  cs10_fan_out_control(uiVirtualTrack, tcControl, &theEvent, lane) ;
+} /* cs10_fan_out_value */
+
+/*
+ * cs10_bulk_room
+ *
+ * will the bulk lane take uiEvents more for the daw, with a copy of
+ * each for every target, without waiting
+ */
+bool
+cs10_bulk_room(
+  unsigned int uiEvents) {
+
+  return (uiEvents * (1 + cs10_target_count()) <=
+          cs10_output_room(BULK_LANE)) ;
+} /* cs10_bulk_room */
+
+/*
+ * cs10_osc_add_control
+ *
+ * add the message setting uiVirtualTrack's tcControl to pPacket,
+ * uiValue is 0 or 1 for the toggles
+ * return false if osc can't address tcControl or pPacket is full
+ */
+bool
+cs10_osc_add_control(
+  cs10_osc_packet_t *pPacket,
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiValue) {
+
+  const char *pPath = oscControlPath[tcControl] ;
+  int         iStrip = uiVirtualTrack + 1 ;
+  float       fValue = (float)uiValue / 127.0f ;
+
+  if (NULL == pPath)
+    return false ;
+
+  switch (tcControl) {
+    case ARMED_CONTROL:
+    case MUTE_CONTROL:
+    case SOLO_CONTROL:
+      return cs10_osc_add_message(pPacket, pPath, "ii",
+                                  iStrip, (uiValue ? 1 : 0)) ;
+
+    case SEND_ONE_CONTROL:
+      return cs10_osc_add_message(pPacket, pPath, "iif", iStrip, 1, fValue) ;
+
+    case SEND_TWO_CONTROL:
+      return cs10_osc_add_message(pPacket, pPath, "iif", iStrip, 2, fValue) ;
+
+    default:
+      return cs10_osc_add_message(pPacket, pPath, "if", iStrip, fValue) ;
+  } /* switch */
+} /* cs10_osc_add_control */
+
+/*
+ * cs10_osc_issue_virtual_control
+ *
+ * send virtual control move on uiVirtualTrack's tcControl as osc
+ * osc sets toggles outright, so the press of a press and release pair
+ * sends the flag already toggled in csState and the release is dropped
+ */
+bool
+cs10_osc_issue_virtual_control(
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiValue) {
+
+  if (tcControl < FADER_CONTROL) {
+#if CS10_TOGGLE_BUTTONS
+    uiValue = (BUTTON_DOWN_VALUE == uiValue) ;
+#else
+    cs10_track_state_t tsTrack ;
+
+    if (BUTTON_DOWN_VALUE != uiValue)
+      return true ;
+
+    cs10_read_track_state(uiVirtualTrack, &tsTrack) ;
+
+    if (ARMED_CONTROL == tcControl)
+      uiValue = tsTrack.bArmed ;
+    else
+    if (MUTE_CONTROL == tcControl)
+      uiValue = tsTrack.bMute ;
+    else
+      uiValue = tsTrack.bSolo ;
+#endif
+  } /* if */
+
+  cs10_osc_packet_init(&cs10.oscPacket, false) ;
+
+  if (!cs10_osc_add_control(&cs10.oscPacket, uiVirtualTrack,
+                            tcControl, uiValue))
+    return false ;
+
+  return cs10_osc_send(&cs10.oscPacket) ;
+} /* cs10_osc_issue_virtual_control */
+
 /*
  * cs10_issue_virtual_control
  *
- * issue virtual control move on uiVirtualTrack's tcControl
+ * issue virtual control move on uiVirtualTrack's tcControl via lane,
+ * to the daw and the targets following it
  */
 bool
 cs10_issue_virtual_control(
   unsigned int uiVirtualTrack,
   virtual_track_control_t tcControl,
-  unsigned int uiValue) {
+  unsigned int uiValue,
+  cs10_output_lane_t lane) {
 
-  bool             bRetValue ;
   snd_seq_event_t  theEvent ;
-  unsigned int     uiBank = uiVirtualTrack / CS10_NUM_PHYSICAL_TRACKS;
-  unsigned int     uiPhysicalTrack = uiVirtualTrack % CS10_NUM_PHYSICAL_TRACKS;
+  unsigned int     uiChannel = 0 ;
+  unsigned int     uiCC = 0 ;
+  bool             bMapped ;
+  bool             bSent ;
 
-  snd_seq_ev_clear(&theEvent) ;
-  snd_seq_ev_set_dest(&theEvent, SND_SEQ_ADDRESS_SUBSCRIBERS, 0) ;
-  snd_seq_ev_set_source(&theEvent, cs10.iMMCPortID) ;
-  snd_seq_ev_set_direct(&theEvent) ;
+  bMapped = cs10_map_to_cc(cs10_current_map(), uiVirtualTrack, tcControl,
+                           &uiChannel, &uiCC) ;
 
-  snd_seq_ev_set_controller(&theEvent, CS10_MIDI_CONTROL_CHANNEL + uiBank,
-      (uiPhysicalTrack * NUM_VIRTUAL_TRACK_CONTROLS) + tcControl,
-      uiValue) ;
+  /* ardour may still send midi feedback for what went out as osc */
+  if (bMapped && (tcControl >= FADER_CONTROL))
+    cs10_echo_note_sent(uiChannel, uiCC, uiValue) ;
 
-  snd_seq_event_output(cs10.pSeq, &theEvent) ;
-  snd_seq_drain_output(cs10.pSeq) ;
+  snd_seq_ev_clear(&theEvent) ;
 
-  return bRetValue ;
+  snd_seq_ev_set_controller(&theEvent, uiChannel, uiCC, uiValue) ;
+
+  if (cs10_osc_is_open() && oscControlPath[tcControl])
+    bSent = cs10_osc_issue_virtual_control(uiVirtualTrack, tcControl,
+                                           uiValue) ;
+  else
+  if (!bMapped)
+    /* the map leaves this control out */
+    bSent = false ;
+  else
+  /* toggles have to arrive in pairs, a fader or knob value is stale
+   * as soon as a newer one for the same control is waiting
+   */
+  if (tcControl >= FADER_CONTROL)
+    bSent = cs10_output_queue_latest(lane, &theEvent) ;
+  else
+    bSent = cs10_output_queue(lane, &theEvent) ;
+
+  /* the daw's copy is queued, the targets get the same event */
+  cs10_fan_out_control(uiVirtualTrack, tcControl, &theEvent, lane) ;
+
+  return bSent ;
 } /* cs10_issue_virtual_control */
 
 /*
@@ -661,6 +1944,8 @@ cs10_issue_virtual_control(
  *
  * receive control state from a peer connected to the sequencer
  * update mixer state accordingly
+ * runs on the daw thread, LEDs are left to the surface thread and only
+ * touched when a flag really changed
  */
 void
 cs10_receive_virtual_control(
@@ -668,23 +1953,60 @@ cs10_receive_virtual_control(
   virtual_track_control_t control,
   unsigned int value) {
 
+  cs10_track_state_t tsTrack ;
+  bool               bFlag = (value ? true : false) ;
+  bool               bChanged = false ;
+
+  /* feedback mostly confirms what we already have, skip all of that */
+  cs10_read_track_state(track, &tsTrack) ;
+
+  switch (control) {
+    case ARMED_CONTROL:
+      bChanged = (tsTrack.bArmed != bFlag) ;
+      break;
+
+    case MUTE_CONTROL:
+      bChanged = (tsTrack.bMute != bFlag) ;
+      break;
+
+    case SOLO_CONTROL:
+      bChanged = (tsTrack.bSolo != bFlag) ;
+      break;
+
+    case FADER_CONTROL:
+      bChanged = (tsTrack.uiFader != value) ;
+      break;
+
+    case PAN_CONTROL:
+    case SEND_ONE_CONTROL:
+    case SEND_TWO_CONTROL:
+    case BOOST_CUT_CONTROL:
+    case FREQUENCY_CONTROL:
+    case BANDWDITH_CONTROL:
+      bChanged = (tsTrack.uiKnob[VIRTUAL_CONTROL_TO_KNOB_INDEX(control)] !=
+                  value) ;
+      break;
+
+    default:
+      break;
+  } /* switch */
+
+  if (!bChanged)
+    return ;
+
+  seqlock_write_begin(&cs10.stateLock) ;
+
   switch (control) {
     case ARMED_CONTROL:
-      cs10.csState.tsTrack[track].bArmed =
-        (value ? true : false);
-      cs10_set_mode(cs10.theMode) ;
+      cs10.csState.tsTrack[track].bArmed = bFlag ;
       break;
 
     case MUTE_CONTROL:
-      cs10.csState.tsTrack[track].bMute =
-        (value ? true : false);
-      cs10_set_mode(cs10.theMode) ;
+      cs10.csState.tsTrack[track].bMute = bFlag ;
       break;
 
     case SOLO_CONTROL:
-      cs10.csState.tsTrack[track].bSolo =
-        (value ? true : false);
-      cs10_set_mode(cs10.theMode) ;
+      cs10.csState.tsTrack[track].bSolo = bFlag ;
       break;
 
     case FADER_CONTROL:
@@ -704,773 +2026,3694 @@ cs10_receive_virtual_control(
     default:
       break;
   } /* switch */
+
+  cs10_journal_append(JOURNAL_TRACK_KEY(track, control),
+                      (control < FADER_CONTROL) ? bFlag : value) ;
+
+  cs10_state_write_end(1U << track) ;
+
+  if (control < FADER_CONTROL) {
+    __atomic_fetch_or(&cs10.uiDirtyTracks, 1U << track, __ATOMIC_RELEASE) ;
+    cs10_request_refresh(CS10_REFRESH_TRACKS) ;
+  } /* if */
 } /* cs10_receive_virtual_control */
 
 /*
- * cs10_issue_control_state
+ * cs10_track_value
  *
- * re-send the entire control state
+ * where pTrack keeps the value of a fader or knob control,
+ * NULL for the toggles
  */
-bool
-cs10_issue_control_state(
-  cs10_mixer_state_t *pState) {
+unsigned int *
+cs10_track_value(
+  cs10_track_state_t *pTrack,
+  virtual_track_control_t tcControl) {
 
-  unsigned int uiTrack;
-  unsigned int uiControl;
+  if (FADER_CONTROL == tcControl)
+    return &pTrack->uiFader ;
 
-  for (uiTrack = 0 ;
-       uiTrack < CS10_NUM_VIRTUAL_TRACKS ;
-       uiTrack++) {
-    for (uiControl = 0 ;
-         uiControl < NUM_VIRTUAL_TRACK_CONTROLS ;
-         uiControl++) {
-      switch (uiControl) {
-        /* XXX NB toggle states need to be sent relative to the state that
-         * is being replaced
-         */
-        case ARMED_CONTROL:
-          if (cs10.csState.tsTrack[uiTrack].bArmed !=
-              pState->tsTrack[uiTrack].bArmed) {
-            cs10_issue_virtual_control(uiTrack,
-              ARMED_CONTROL, BUTTON_DOWN_VALUE);
-            cs10_issue_virtual_control(uiTrack,
-              ARMED_CONTROL, BUTTON_UP_VALUE);
-          } /* if */
-          break;
+  if (FADER_CONTROL < tcControl)
+    return &pTrack->uiKnob[VIRTUAL_CONTROL_TO_KNOB_INDEX(tcControl)] ;
 
-        case MUTE_CONTROL:
-          if (cs10.csState.tsTrack[uiTrack].bMute !=
-              pState->tsTrack[uiTrack].bMute) {
-            cs10_issue_virtual_control(uiTrack,
-              MUTE_CONTROL, BUTTON_DOWN_VALUE);
-            cs10_issue_virtual_control(uiTrack,
-              MUTE_CONTROL, BUTTON_UP_VALUE);
-          } /* if */
-          break;
+  return NULL ;
+} /* cs10_track_value */
 
-        case SOLO_CONTROL:
-          if (cs10.csState.tsTrack[uiTrack].bSolo !=
-              pState->tsTrack[uiTrack].bSolo) {
-            cs10_issue_virtual_control(uiTrack,
-              SOLO_CONTROL, BUTTON_DOWN_VALUE);
-            cs10_issue_virtual_control(uiTrack,
-              SOLO_CONTROL, BUTTON_UP_VALUE);
-          } /* if */
-          break;
+/*
+ * cs10_track_flag
+ *
+ * where pTrack keeps a toggle, NULL for the faders and knobs
+ */
+bool *
+cs10_track_flag(
+  cs10_track_state_t *pTrack,
+  virtual_track_control_t tcControl) {
 
-        /* XXX NB control states need to be sent in increments,
-         * starting at the state that is being replaced
-         */
-        case FADER_CONTROL:
-          {
-            unsigned int uiTarget = pState->tsTrack[uiTrack].uiFader;
+  switch (tcControl) {
+    case ARMED_CONTROL:
+      return &pTrack->bArmed ;
 
-            while (cs10.csState.tsTrack[uiTrack].uiFader != uiTarget) {
-              if (cs10.csState.tsTrack[uiTrack].uiFader > uiTarget)
-                cs10.csState.tsTrack[uiTrack].uiFader--;
-              else
-                cs10.csState.tsTrack[uiTrack].uiFader++;
+    case MUTE_CONTROL:
+      return &pTrack->bMute ;
 
-              cs10_issue_virtual_control(uiTrack, FADER_CONTROL,
-                cs10.csState.tsTrack[uiTrack].uiFader);
-#ifdef CS10_FADER_RESTORE_DELAY_US
-              usleep(CS10_FADER_RESTORE_DELAY_US);
-#endif
-            }
-          }
-          break;
+    case SOLO_CONTROL:
+      return &pTrack->bSolo ;
 
-        case PAN_CONTROL:
-        case SEND_ONE_CONTROL:
-        case SEND_TWO_CONTROL:
-        case BANDWDITH_CONTROL:
-        case FREQUENCY_CONTROL:
-        case BOOST_CUT_CONTROL:
-          {
-            unsigned int idx = VIRTUAL_CONTROL_TO_KNOB_INDEX(uiControl);
-            unsigned int uiTarget = pState->tsTrack[uiTrack].uiKnob[idx];
-
-            while (cs10.csState.tsTrack[uiTrack].uiKnob[idx] != uiTarget) {
-              if (cs10.csState.tsTrack[uiTrack].uiKnob[idx] > uiTarget)
-                cs10.csState.tsTrack[uiTrack].uiKnob[idx]--;
-              else
-                cs10.csState.tsTrack[uiTrack].uiKnob[idx]++;
-
-              cs10_issue_virtual_control(uiTrack, uiControl,
-                cs10.csState.tsTrack[uiTrack].uiKnob[idx]);
-#ifdef CS10_FADER_RESTORE_DELAY_US
-              usleep(CS10_FADER_RESTORE_DELAY_US);
-#endif
-            } /* while */
-          }
-          break;
-      } /* switch */
-    } /* for */
-  } /* for */
-} /* cs10_issue_control_state */
+    default:
+      return NULL ;
+  } /* switch */
+} /* cs10_track_flag */
 
 /*
- * cs10_handle_button
+ * cs10_get_track_control
  *
- * do stuff based on uiButtonAddr and uiButtonVal
+ * the value of any of pTrack's controls, toggles as 0 or 1
  */
-void
-cs10_handle_button(
-  unsigned int uiButtonAddr,
-  int uiButtonVal) {
+unsigned int
+cs10_get_track_control(
+  cs10_track_state_t *pTrack,
+  virtual_track_control_t tcControl) {
 
-  if (cs10.debug)
-    fprintf(stderr, "%s %u %d\n",
-      __FUNCTION__,
-      uiButtonAddr,
-      uiButtonVal);
+  bool *pbFlag = cs10_track_flag(pTrack, tcControl) ;
 
-  /* handle track buttons */
-  if (((FIRST_TRACK_BUTTON_ADDR <= uiButtonAddr) &&
-     (LAST_TRACK_BUTTON_ADDR >= uiButtonAddr)) &&
-     (BUTTON_UP_VALUE == uiButtonVal)) {
-    switch (cs10.theMode) {
-      case NULLIFY_MODE:
-      case SELECT_MODE:
-        cs10_set_led(TRACK_TO_LED_ADDR(cs10.uiSelectedTrack),
-            LED_OFF_VALUE) ;
+  return (pbFlag ? *pbFlag : *cs10_track_value(pTrack, tcControl)) ;
+} /* cs10_get_track_control */
 
-        cs10.uiSelectedTrack =
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr) ;
+/*
+ * cs10_set_track_control
+ *
+ * set any of pTrack's controls to uiValue, toggles on for anything but 0
+ */
+void
+cs10_set_track_control(
+  cs10_track_state_t *pTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiValue) {
 
-        cs10_set_led(TRACK_TO_LED_ADDR(cs10.uiSelectedTrack),
-            LED_ON_VALUE) ;
-        break ;
+  bool *pbFlag = cs10_track_flag(pTrack, tcControl) ;
 
-      case LOC_MODE:
-        cs10.csState.tsTrack[
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bArmed =
-          (cs10.csState.
-           tsTrack[
-             cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-             BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bArmed == 0) ;
+  if (pbFlag)
+    *pbFlag = (uiValue ? true : false) ;
+  else
+    *cs10_track_value(pTrack, tcControl) = uiValue ;
+} /* cs10_set_track_control */
+
+/*
+ * cs10_merge_state
+ *
+ * copy the tracks in ulTrackMask and controls in uiControlMask from
+ * pFrom to pInto, leaving the rest of pInto alone
+ */
+void
+cs10_merge_state(
+  cs10_mixer_state_t *pInto,
+  cs10_mixer_state_t *pFrom,
+  uint32_t ulTrackMask,
+  unsigned int uiControlMask) {
+
+  unsigned int uiTrack ;
+  unsigned int uiControl ;
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    if (0 == (ulTrackMask & (1U << uiTrack)))
+      continue ;
+
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++) {
+      if (0 == (uiControlMask & CONTROL_BIT(uiControl)))
+        continue ;
+
+      if (uiControl < FADER_CONTROL)
+        *cs10_track_flag(&pInto->tsTrack[uiTrack], uiControl) =
+          *cs10_track_flag(&pFrom->tsTrack[uiTrack], uiControl) ;
+      else
+        *cs10_track_value(&pInto->tsTrack[uiTrack], uiControl) =
+          *cs10_track_value(&pFrom->tsTrack[uiTrack], uiControl) ;
+    } /* for */
+  } /* for */
+} /* cs10_merge_state */
+
+/*
+ * cs10_morph_step
+ *
+ * move every control the morph in progress hasn't finished with to where
+ * it should be by now, osc as one bundle and midi on the bulk lane
+ * a tick the bulk lane can't take is picked up by the next one, which
+ * carries on from wherever the controls have got to
+ */
+void
+cs10_morph_step(void) {
+
+  cs10_restore_t *pRestore = &cs10.restore ;
+  uint32_t        ulElapsed = cs10_now_ms() - pRestore->ulMorphStart ;
+  bool            bOSC = cs10_osc_is_open() ;
+  bool            bDone = true ;
+  unsigned int    uiTrack ;
+  unsigned int    uiControl ;
+
+  if (ulElapsed > pRestore->ulMorphMs)
+    ulElapsed = pRestore->ulMorphMs ;
+
+  if (bOSC)
+    cs10_osc_packet_init(&cs10.oscPacket, true) ;
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    if (0 == (pRestore->ulTrackMask & (1U << uiTrack)))
+      continue ;
+
+    cs10_track_state_t *pFrom = &pRestore->csFrom.tsTrack[uiTrack] ;
+    cs10_track_state_t *pSent = &pRestore->csSent.tsTrack[uiTrack] ;
+    cs10_track_state_t *pTarget = &pRestore->csTarget.tsTrack[uiTrack] ;
+    bool *pbSent[] = { &pSent->bArmed, &pSent->bMute, &pSent->bSolo } ;
+    bool *pbTarget[] = { &pTarget->bArmed, &pTarget->bMute, &pTarget->bSolo } ;
+
+    for (uiControl = ARMED_CONTROL ;
+         uiControl < FADER_CONTROL ;
+         uiControl++) {
+      if ((0 == (pRestore->uiControlMask & CONTROL_BIT(uiControl))) ||
+          (*pbSent[uiControl] == *pbTarget[uiControl]))
+        continue ;
+
+      if ((2 * ulElapsed < pRestore->ulMorphMs) ||
+          !cs10_bulk_room(2)) {
+        bDone = false ;
+        continue ;
+      } /* if */
+
+      cs10_issue_virtual_control(uiTrack, uiControl,
+                                 BUTTON_DOWN_VALUE, BULK_LANE) ;
+      cs10_issue_virtual_control(uiTrack, uiControl,
+                                 BUTTON_UP_VALUE, BULK_LANE) ;
+      *pbSent[uiControl] = *pbTarget[uiControl] ;
+    } /* for */
+
+    for (uiControl = FADER_CONTROL ;
+         uiControl < NUM_VIRTUAL_TRACK_CONTROLS ;
+         uiControl++) {
+      int           iFrom = *cs10_track_value(pFrom, uiControl) ;
+      int           iTarget = *cs10_track_value(pTarget, uiControl) ;
+      unsigned int *puiSent = cs10_track_value(pSent, uiControl) ;
+      unsigned int  uiValue ;
+      unsigned int  uiChannel ;
+      unsigned int  uiCC ;
+
+      if (0 == (pRestore->uiControlMask & CONTROL_BIT(uiControl)))
+        continue ;
+
+      uiValue = iFrom + (int)(((long long)(iTarget - iFrom) * ulElapsed) /
+                              (long long)pRestore->ulMorphMs) ;
+
+      if (uiValue != (unsigned int)iTarget)
+        bDone = false ;
+
+      if (uiValue == *puiSent)
+        continue ;
+
+      if (bOSC && oscControlPath[uiControl]) {
+        if (!cs10_osc_add_control(&cs10.oscPacket, uiTrack, uiControl,
+                                  uiValue)) {
+          cs10_osc_send(&cs10.oscPacket) ;
+          cs10_osc_add_control(&cs10.oscPacket, uiTrack, uiControl, uiValue) ;
+        } /* if */
+
+        if (cs10_map_to_cc(cs10_current_map(), uiTrack, uiControl,
+                           &uiChannel, &uiCC))
+          cs10_echo_note_sent(uiChannel, uiCC, uiValue) ;
+
+        cs10_fan_out_value(uiTrack, uiControl, uiValue, BULK_LANE) ;
+      } else {
+        if (!cs10_bulk_room(1)) {
+          bDone = false ;
+          continue ;
+        } /* if */
+
+        cs10_issue_virtual_control(uiTrack, uiControl, uiValue, BULK_LANE) ;
+      } /* else */
+
+      *puiSent = uiValue ;
+    } /* for */
+  } /* for */
+
+  if (bOSC)
+    cs10_osc_send(&cs10.oscPacket) ;
+
+  if (bDone) {
+    pRestore->bMorph = false ;
+    pRestore->bActive = false ;
+    return ;
+  } /* if */
+
+  clock_gettime(CLOCK_MONOTONIC, &pRestore->tNextStep) ;
+  pRestore->tNextStep.tv_nsec += CS10_MORPH_TICK_MS * 1000000L ;
+  if (pRestore->tNextStep.tv_nsec >= 1000000000) {
+    pRestore->tNextStep.tv_sec++ ;
+    pRestore->tNextStep.tv_nsec -= 1000000000 ;
+  } /* if */
+} /* cs10_morph_step */
+
+/*
+ * cs10_restore_step
+ *
+ * send whatever the restore in progress has due
+ * toggles go out as soon as they are reached, faders and knobs
+ * move one increment every CS10_FADER_RESTORE_DELAY_US
+ */
+void
+cs10_restore_step(void) {
+
+  cs10_restore_t *pRestore = &cs10.restore;
+  struct timespec tNow;
+
+  if (!pRestore->bActive)
+    return;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow);
+
+  if ((tNow.tv_sec < pRestore->tNextStep.tv_sec) ||
+      ((tNow.tv_sec == pRestore->tNextStep.tv_sec) &&
+       (tNow.tv_nsec < pRestore->tNextStep.tv_nsec)))
+    return;
+
+  CS10_COUNT(RESTORE_STEP_COUNTER);
+
+  if (pRestore->bMorph) {
+    cs10_morph_step();
+    return;
+  } /* if */
+
+  while (pRestore->uiTrack < CS10_NUM_VIRTUAL_TRACKS) {
+    /* outside the recall filter */
+    if (0 == (pRestore->ulTrackMask & (1U << pRestore->uiTrack))) {
+      pRestore->uiControl = 0;
+      pRestore->uiTrack++;
+      continue;
+    } /* if */
+
+    if (0 == (pRestore->uiControlMask & CONTROL_BIT(pRestore->uiControl))) {
+      if (NUM_VIRTUAL_TRACK_CONTROLS == ++pRestore->uiControl) {
+        pRestore->uiControl = 0;
+        pRestore->uiTrack++;
+      } /* if */
+      continue;
+    } /* if */
+
+    cs10_track_state_t *pSent = &pRestore->csSent.tsTrack[pRestore->uiTrack];
+    cs10_track_state_t *pTarget =
+      &pRestore->csTarget.tsTrack[pRestore->uiTrack];
+    unsigned int *puiSent = NULL;
+    unsigned int *puiTarget = NULL;
+    bool *pbSent = NULL;
+    bool *pbTarget = NULL;
+
+    switch (pRestore->uiControl) {
+      /* XXX NB toggle states need to be sent relative to the state that
+       * is being replaced
+       */
+      case ARMED_CONTROL:
+        pbSent = &pSent->bArmed;
+        pbTarget = &pTarget->bArmed;
+        break;
+
+      case MUTE_CONTROL:
+        pbSent = &pSent->bMute;
+        pbTarget = &pTarget->bMute;
+        break;
+
+      case SOLO_CONTROL:
+        pbSent = &pSent->bSolo;
+        pbTarget = &pTarget->bSolo;
+        break;
+
+      /* XXX NB control states need to be sent in increments,
+       * starting at the state that is being replaced
+       */
+      case FADER_CONTROL:
+        puiSent = &pSent->uiFader;
+        puiTarget = &pTarget->uiFader;
+        break;
+
+      case PAN_CONTROL:
+      case SEND_ONE_CONTROL:
+      case SEND_TWO_CONTROL:
+      case BANDWDITH_CONTROL:
+      case FREQUENCY_CONTROL:
+      case BOOST_CUT_CONTROL:
+        puiSent = &pSent->uiKnob[
+          VIRTUAL_CONTROL_TO_KNOB_INDEX(pRestore->uiControl)];
+        puiTarget = &pTarget->uiKnob[
+          VIRTUAL_CONTROL_TO_KNOB_INDEX(pRestore->uiControl)];
+        break;
+    } /* switch */
+
+    /* hold back rather than crowd the bulk lane */
+    if (!cs10_bulk_room(2))
+      return;
+
+    if (pbSent && (*pbSent != *pbTarget)) {
+      cs10_issue_virtual_control(pRestore->uiTrack,
+        pRestore->uiControl, BUTTON_DOWN_VALUE, BULK_LANE);
+      cs10_issue_virtual_control(pRestore->uiTrack,
+        pRestore->uiControl, BUTTON_UP_VALUE, BULK_LANE);
+      *pbSent = *pbTarget;
+    } else
+    if (puiSent && (*puiSent != *puiTarget)) {
+      if (*puiSent > *puiTarget)
+        (*puiSent)--;
+      else
+        (*puiSent)++;
+
+      cs10_issue_virtual_control(pRestore->uiTrack,
+        pRestore->uiControl, *puiSent, BULK_LANE);
+#ifdef CS10_FADER_RESTORE_DELAY_US
+      pRestore->tNextStep = tNow;
+      pRestore->tNextStep.tv_nsec += CS10_FADER_RESTORE_DELAY_US * 1000;
+      if (pRestore->tNextStep.tv_nsec >= 1000000000) {
+        pRestore->tNextStep.tv_sec++;
+        pRestore->tNextStep.tv_nsec -= 1000000000;
+      } /* if */
+      return;
+#else
+      continue;
+#endif
+    } /* if */
+
+    if (NUM_VIRTUAL_TRACK_CONTROLS == ++pRestore->uiControl) {
+      pRestore->uiControl = 0;
+      pRestore->uiTrack++;
+    } /* if */
+  } /* while */
+
+  pRestore->bActive = false;
+} /* cs10_restore_step */
+
+/*
+ * cs10_restore_timeout
+ *
+ * milliseconds until the restore in progress has something due,
+ * -1 when there is nothing to wait for
+ */
+int
+cs10_restore_timeout(void) {
+
+  struct timespec tNow;
+  long            lTimeout;
+
+  if (!cs10.restore.bActive)
+    return -1;
+
+  /* waiting on the sequencer to take what's already on the bulk lane */
+  if (!cs10_bulk_room(2))
+    return CS10_OUTPUT_RETRY_MS;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow);
+
+  lTimeout = (cs10.restore.tNextStep.tv_sec - tNow.tv_sec) * 1000 +
+    (cs10.restore.tNextStep.tv_nsec - tNow.tv_nsec + 999999) / 1000000;
+
+  return (lTimeout > 0 ? lTimeout : 0);
+} /* cs10_restore_timeout */
+
+/*
+ * cs10_restore_override
+ *
+ * the surface moved a control while a restore is in progress,
+ * make sure the restore leaves it where the user put it
+ */
+void
+cs10_restore_override(
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiValue) {
+
+  cs10_track_state_t *pSent;
+  cs10_track_state_t *pTarget;
+  bool *pbSent = NULL;
+  bool *pbTarget = NULL;
+
+  if (!cs10.restore.bActive)
+    return;
+
+  pSent = &cs10.restore.csSent.tsTrack[uiVirtualTrack];
+  pTarget = &cs10.restore.csTarget.tsTrack[uiVirtualTrack];
+
+  /* a morph holds the control still where the user left it */
+  if (tcControl >= FADER_CONTROL)
+    *cs10_track_value(&cs10.restore.csFrom.tsTrack[uiVirtualTrack],
+                      tcControl) = uiValue;
+
+  switch (tcControl) {
+    case ARMED_CONTROL:
+      pbSent = &pSent->bArmed;
+      pbTarget = &pTarget->bArmed;
+      break;
 
+    case MUTE_CONTROL:
+      pbSent = &pSent->bMute;
+      pbTarget = &pTarget->bMute;
+      break;
+
+    case SOLO_CONTROL:
+      pbSent = &pSent->bSolo;
+      pbTarget = &pTarget->bSolo;
+      break;
+
+    case FADER_CONTROL:
+      pSent->uiFader = pTarget->uiFader = uiValue;
+      break;
+
+    case PAN_CONTROL:
+    case SEND_ONE_CONTROL:
+    case SEND_TWO_CONTROL:
+    case BANDWDITH_CONTROL:
+    case FREQUENCY_CONTROL:
+    case BOOST_CUT_CONTROL:
+      pSent->uiKnob[VIRTUAL_CONTROL_TO_KNOB_INDEX(tcControl)] =
+        pTarget->uiKnob[VIRTUAL_CONTROL_TO_KNOB_INDEX(tcControl)] = uiValue;
+      break;
+
+    default:
+      break;
+  } /* switch */
+
+  if (pbSent) {
 #if CS10_TOGGLE_BUTTONS
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          ARMED_CONTROL,
-          (cs10.csState.
-             tsTrack[
-               cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-               BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bArmed ?
-             BUTTON_DOWN_VALUE : BUTTON_UP_VALUE)) ;
+    *pbSent = (uiValue ? true : false);
 #else
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          ARMED_CONTROL, BUTTON_DOWN_VALUE);
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          ARMED_CONTROL, BUTTON_UP_VALUE);
+    /* a toggle flips whatever the daw has now */
+    *pbSent = !*pbSent;
 #endif
+    *pbTarget = (uiValue ? true : false);
+  } /* if */
+} /* cs10_restore_override */
 
-        cs10_set_led(TRACK_TO_LED_ADDR(BUTTON_ADDR_TO_TRACK(uiButtonAddr)),
-         (cs10.csState.
-          tsTrack[
-            cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-            BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bArmed ?
-          LED_ON_VALUE : LED_OFF_VALUE)) ;
-        break ;
+/*
+ * cs10_osc_issue_control_state
+ *
+ * send every osc addressable control of pState that differs from what
+ * ardour was last sent, as one bundle
+ * osc values land exactly, so they are taken as sent and as the live state
+ */
+void
+cs10_osc_issue_control_state(
+  const cs10_mixer_state_t *pState) {
 
-      case MUTE_MODE:
-        cs10.csState.tsTrack[
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bMute =
-          (cs10.csState.
-           tsTrack[
-             cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-             BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bMute == 0) ;
+  cs10_mixer_state_t *pSent = &cs10.restore.csSent;
+  unsigned int        uiTrack;
+  unsigned int        uiControl;
+  unsigned int        uiChannel;
+  unsigned int        uiCC;
+  uint32_t            uiChanged = 0;
+
+  cs10_osc_packet_init(&cs10.oscPacket, true);
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    const cs10_track_state_t *pTarget = &pState->tsTrack[uiTrack];
+    cs10_track_state_t       *pTrack = &pSent->tsTrack[uiTrack];
+
+    if (0 == (cs10.restore.ulTrackMask & (1U << uiTrack)))
+      continue;
+
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++) {
+      unsigned int uiValue;
+      bool         bSame;
+
+      if ((NULL == oscControlPath[uiControl]) ||
+          (0 == (cs10.restore.uiControlMask & CONTROL_BIT(uiControl))))
+        continue;
+
+      switch (uiControl) {
+        case ARMED_CONTROL:
+          uiValue = pTarget->bArmed;
+          bSame = (pTrack->bArmed == pTarget->bArmed);
+          break;
+
+        case MUTE_CONTROL:
+          uiValue = pTarget->bMute;
+          bSame = (pTrack->bMute == pTarget->bMute);
+          break;
+
+        case SOLO_CONTROL:
+          uiValue = pTarget->bSolo;
+          bSame = (pTrack->bSolo == pTarget->bSolo);
+          break;
+
+        case FADER_CONTROL:
+          uiValue = pTarget->uiFader;
+          bSame = (pTrack->uiFader == pTarget->uiFader);
+          break;
+
+        default:
+          uiValue = pTarget->uiKnob[VIRTUAL_CONTROL_TO_KNOB_INDEX(uiControl)];
+          bSame = (pTrack->uiKnob[VIRTUAL_CONTROL_TO_KNOB_INDEX(uiControl)] ==
+                   uiValue);
+          break;
+      } /* switch */
+
+      /* only what the mask lets through is taken as sent */
+      cs10_set_track_control(pTrack, uiControl, uiValue);
+
+      if (bSame)
+        continue;
+
+      /* a bundle too big for one datagram goes out in pieces */
+      if (!cs10_osc_add_control(&cs10.oscPacket, uiTrack, uiControl,
+                                uiValue)) {
+        cs10_osc_send(&cs10.oscPacket);
+        cs10_osc_add_control(&cs10.oscPacket, uiTrack, uiControl, uiValue);
+      } /* if */
+
+      if ((uiControl >= FADER_CONTROL) &&
+          cs10_map_to_cc(cs10_current_map(), uiTrack, uiControl,
+                         &uiChannel, &uiCC))
+        cs10_echo_note_sent(uiChannel, uiCC, uiValue);
+
+      /* targets only take midi, a toggle as the press and release */
+      if (uiControl < FADER_CONTROL) {
+        cs10_fan_out_value(uiTrack, uiControl, BUTTON_DOWN_VALUE, BULK_LANE);
+        cs10_fan_out_value(uiTrack, uiControl, BUTTON_UP_VALUE, BULK_LANE);
+      } else
+        cs10_fan_out_value(uiTrack, uiControl, uiValue, BULK_LANE);
+
+      uiChanged |= 1U << uiTrack;
+    } /* for */
+  } /* for */
+
+  cs10_osc_send(&cs10.oscPacket);
+
+  if (0 == uiChanged)
+    return;
+
+  seqlock_write_begin(&cs10.stateLock);
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    cs10_track_state_t *pLive = &cs10.csState.tsTrack[uiTrack];
+    cs10_track_state_t *pTrack = &pSent->tsTrack[uiTrack];
+
+    if (0 == (uiChanged & (1U << uiTrack)))
+      continue;
+
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++)
+      if ((NULL != oscControlPath[uiControl]) &&
+          (cs10.restore.uiControlMask & CONTROL_BIT(uiControl)))
+        cs10_set_track_control(pLive, uiControl,
+                               cs10_get_track_control(pTrack, uiControl));
+  } /* for */
+
+  /* cheaper to start the journal over than note every change */
+  cs10_journal_checkpoint();
+
+  cs10_state_write_end(uiChanged);
+
+  cs10_refresh_track_leds(uiChanged);
+} /* cs10_osc_issue_control_state */
+
+/*
+ * cs10_restore_filter
+ *
+ * narrow the next restore to ulTrackMask and uiControlMask, or widen one
+ * in progress by them, so nothing it hasn't finished is dropped
+ */
+void
+cs10_restore_filter(
+  uint32_t ulTrackMask,
+  unsigned int uiControlMask) {
+
+  if (cs10.restore.bActive) {
+    cs10.restore.ulTrackMask |= ulTrackMask;
+    cs10.restore.uiControlMask |= uiControlMask;
+    return;
+  } /* if */
+
+  cs10_read_mixer_state(&cs10.restore.csSent);
+  cs10.restore.ulTrackMask = ulTrackMask;
+  cs10.restore.uiControlMask = uiControlMask;
+} /* cs10_restore_filter */
+
+/*
+ * cs10_issue_control_state
+ *
+ * start re-sending the tracks in ulTrackMask and controls in
+ * uiControlMask of pState, everything else in it should match the
+ * live state
+ * the restore is ramped out by cs10_restore_step, a restore already in
+ * progress is simply retargeted from wherever it has got to
+ */
+bool
+cs10_issue_control_state(
+  cs10_mixer_state_t *pState,
+  uint32_t ulTrackMask,
+  unsigned int uiControlMask) {
+
+  CS10_TRACE_BEGIN("issue control state");
+
+  if (cs10.restore.bActive)
+    CS10_COUNT(RESTORE_ABORTED_COUNTER);
+
+  cs10_restore_filter(ulTrackMask, uiControlMask);
+
+  memcpy(&cs10.restore.csTarget, pState, sizeof(cs10_mixer_state_t));
+
+  /* osc takes everything it can address at once, the ramp is left with
+   * whatever has to go as midi
+   */
+  if (cs10_osc_is_open())
+    cs10_osc_issue_control_state(pState);
+
+  cs10.restore.uiTrack = 0;
+  cs10.restore.uiControl = 0;
+  cs10.restore.bMorph = false;
+  cs10.restore.bActive = true;
+  clock_gettime(CLOCK_MONOTONIC, &cs10.restore.tNextStep);
+
+  cs10_restore_step();
+
+  CS10_TRACE_END("issue control state");
+
+  return true;
+} /* cs10_issue_control_state */
+
+/*
+ * cs10_morph_control_state
+ *
+ * start moving the tracks in ulTrackMask and controls in uiControlMask
+ * from where the daw has them to pState, all together, over ulMs
+ * a restore or morph already in progress is taken over from wherever
+ * it has got to
+ */
+bool
+cs10_morph_control_state(
+  cs10_mixer_state_t *pState,
+  uint32_t ulTrackMask,
+  unsigned int uiControlMask,
+  uint32_t ulMs) {
+
+  if (cs10.restore.bActive)
+    CS10_COUNT(RESTORE_ABORTED_COUNTER);
+
+  cs10_restore_filter(ulTrackMask, uiControlMask);
+
+  memcpy(&cs10.restore.csFrom, &cs10.restore.csSent,
+         sizeof(cs10_mixer_state_t));
+  memcpy(&cs10.restore.csTarget, pState, sizeof(cs10_mixer_state_t));
+
+  cs10.restore.ulMorphStart = cs10_now_ms();
+  cs10.restore.ulMorphMs = (ulMs ? ulMs : 1);
+  cs10.restore.bMorph = true;
+  cs10.restore.bActive = true;
+  clock_gettime(CLOCK_MONOTONIC, &cs10.restore.tNextStep);
+
+  cs10_restore_step();
+
+  return true;
+} /* cs10_morph_control_state */
+
+/*
+ * cs10_undo_note_state
+ *
+ * note every control in ulTrackMask and uiControlMask that differs
+ * between pFrom and pTo in the undo step being noted
+ */
+void
+cs10_undo_note_state(
+  cs10_mixer_state_t *pFrom,
+  cs10_mixer_state_t *pTo,
+  uint32_t ulTrackMask,
+  unsigned int uiControlMask) {
+
+  unsigned int uiTrack ;
+  unsigned int uiControl ;
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    if (0 == (ulTrackMask & (1U << uiTrack)))
+      continue ;
+
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++) {
+      unsigned int uiFrom ;
+      unsigned int uiTo ;
+
+      if (0 == (uiControlMask & CONTROL_BIT(uiControl)))
+        continue ;
+
+      uiFrom = cs10_get_track_control(&pFrom->tsTrack[uiTrack], uiControl) ;
+      uiTo = cs10_get_track_control(&pTo->tsTrack[uiTrack], uiControl) ;
+
+      if (uiFrom != uiTo)
+        cs10_undo_note(JOURNAL_TRACK_KEY(uiTrack, uiControl), uiFrom, uiTo) ;
+    } /* for */
+  } /* for */
+} /* cs10_undo_note_state */
+
+/*
+ * cs10_gesture_close
+ *
+ * pGesture is finished, it's an undo step if it changed anything
+ */
+void
+cs10_gesture_close(
+  cs10_gesture_t *pGesture) {
+
+  if (!pGesture->bOpen)
+    return ;
+
+  pGesture->bOpen = false ;
+
+  if (pGesture->uiFrom == pGesture->uiTo)
+    return ;
+
+  cs10_undo_begin() ;
+  cs10_undo_note(JOURNAL_TRACK_KEY(pGesture->uiTrack, pGesture->tcControl),
+                 pGesture->uiFrom, pGesture->uiTo) ;
+} /* cs10_gesture_close */
+
+/*
+ * cs10_gesture_finish
+ *
+ * close the gestures that have come to rest, or all of them with bAll
+ */
+void
+cs10_gesture_finish(
+  bool bAll) {
+
+  unsigned int uiGesture ;
+  uint32_t     ulNow = cs10_now_ms() ;
+
+  for (uiGesture = 0 ; uiGesture < CS10_NUM_THROTTLES ; uiGesture++) {
+    cs10_gesture_t *pGesture = &cs10.geControl[uiGesture] ;
+
+    if (pGesture->bOpen &&
+        (bAll || (ulNow - pGesture->ulLastMove >= CS10_GESTURE_IDLE_MS)))
+      cs10_gesture_close(pGesture) ;
+  } /* for */
+} /* cs10_gesture_finish */
+
+/*
+ * cs10_gesture_move
+ *
+ * the physical control behind pGesture moved uiVirtualTrack's tcControl
+ * from uiFrom to uiTo
+ */
+void
+cs10_gesture_move(
+  cs10_gesture_t *pGesture,
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiFrom,
+  unsigned int uiTo) {
+
+  /* gestures that have finished meanwhile go in first, in order */
+  cs10_gesture_finish(false) ;
+
+  if (pGesture->bOpen &&
+      ((pGesture->uiTrack != uiVirtualTrack) ||
+       (pGesture->tcControl != tcControl)))
+    cs10_gesture_close(pGesture) ;
+
+  if (!pGesture->bOpen) {
+    pGesture->bOpen = true ;
+    pGesture->uiTrack = uiVirtualTrack ;
+    pGesture->tcControl = tcControl ;
+    pGesture->uiFrom = uiFrom ;
+  } /* if */
+
+  pGesture->uiTo = uiTo ;
+  pGesture->ulLastMove = cs10_now_ms() ;
+} /* cs10_gesture_move */
+
+/*
+ * cs10_undo_apply
+ *
+ * put one delta of an undo or redo step into the pArg target
+ */
+void
+cs10_undo_apply(
+  void *pArg,
+  unsigned int uiKey,
+  unsigned int uiValue) {
+
+  cs10_undo_target_t *pTarget = (cs10_undo_target_t *)pArg ;
+  unsigned int        uiTrack = JOURNAL_KEY_TRACK(uiKey) ;
+  unsigned int        uiControl = JOURNAL_KEY_CONTROL(uiKey) ;
+
+  if ((uiTrack >= CS10_NUM_VIRTUAL_TRACKS) ||
+      (uiControl >= NUM_VIRTUAL_TRACK_CONTROLS))
+    return ;
+
+  cs10_set_track_control(&pTarget->csTarget.tsTrack[uiTrack], uiControl,
+                         uiValue) ;
+  pTarget->ulTrackMask |= 1U << uiTrack ;
+  pTarget->uiControlMask |= CONTROL_BIT(uiControl) ;
+} /* cs10_undo_apply */
+
+/*
+ * cs10_undo_step
+ *
+ * undo, or with bRedo redo, the last step and send what it changed
+ * through the restore, as a recall would
+ * return false if there was nothing to do
+ */
+bool
+cs10_undo_step(
+  bool bRedo) {
+
+  cs10_undo_target_t utTarget ;
+  unsigned int       uiTrack ;
+  unsigned int       uiControl ;
+
+  cs10_gesture_finish(true) ;
+
+  cs10_read_mixer_state(&utTarget.csTarget) ;
+  utTarget.ulTrackMask = 0 ;
+  utTarget.uiControlMask = 0 ;
+
+  if (!(bRedo ?
+        cs10_redo(cs10_undo_apply, &utTarget) :
+        cs10_undo(cs10_undo_apply, &utTarget)))
+    return false ;
+
+  if (cs10.debug)
+    CS10_LOG("redo %d tracks %x controls %x\n",
+      bRedo, utTarget.ulTrackMask, utTarget.uiControlMask) ;
+
+  /* everything else in the masks is as live, so only the step goes out */
+  cs10_issue_control_state(&utTarget.csTarget,
+                           utTarget.ulTrackMask, utTarget.uiControlMask) ;
+
+  seqlock_write_begin(&cs10.stateLock) ;
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    cs10_track_state_t *pLive = &cs10.csState.tsTrack[uiTrack] ;
+    cs10_track_state_t *pTarget = &utTarget.csTarget.tsTrack[uiTrack] ;
+
+    if (0 == (utTarget.ulTrackMask & (1U << uiTrack)))
+      continue ;
+
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++) {
+      unsigned int uiValue = cs10_get_track_control(pTarget, uiControl) ;
+
+      if ((0 == (utTarget.uiControlMask & CONTROL_BIT(uiControl))) ||
+          (uiValue == cs10_get_track_control(pLive, uiControl)))
+        continue ;
+
+      cs10_set_track_control(pLive, uiControl, uiValue) ;
+      cs10_journal_append(JOURNAL_TRACK_KEY(uiTrack, uiControl), uiValue) ;
+    } /* for */
+  } /* for */
+
+  cs10_state_write_end(utTarget.ulTrackMask) ;
+
+  cs10_set_mode(cs10.theMode) ;
+
+  if (cs10.displayMode == BANK_DISPLAY_MODE)
+    cs10_display_bank() ;
+  else
+    cs10_display_time() ;
+
+  return true ;
+} /* cs10_undo_step */
+
+/*
+ * cs10_recall_state
+ *
+ * send saved state uiState where ulTrackMask and uiControlMask let it
+ * through, leaving the live state everywhere else, and take it as the
+ * live state. over ulMorphMs as a morph, or straight away for 0
+ */
+void
+cs10_recall_state(
+  unsigned int uiState,
+  uint32_t ulTrackMask,
+  unsigned int uiControlMask,
+  uint32_t ulMorphMs) {
+
+  cs10_mixer_state_t csLive;
+  cs10_mixer_state_t csTarget;
+
+  cs10_read_mixer_state(&csLive);
+  memcpy(&csTarget, &csLive, sizeof(cs10_mixer_state_t));
+  cs10_merge_state(&csTarget, &cs10.csSavedState[uiState],
+                   ulTrackMask, uiControlMask);
+
+  /* the recall is one undo step, after any gesture made before it */
+  cs10_gesture_finish(true);
+  cs10_undo_begin();
+  cs10_undo_note_state(&csLive, &csTarget, ulTrackMask, uiControlMask);
+
+  /* send state out over midi seq */
+  if (ulMorphMs)
+    cs10_morph_control_state(&csTarget, ulTrackMask, uiControlMask,
+                             ulMorphMs);
+  else
+    cs10_issue_control_state(&csTarget, ulTrackMask, uiControlMask);
+
+  seqlock_write_begin(&cs10.stateLock);
+  cs10_merge_state(&cs10.csState, &cs10.csSavedState[uiState],
+                   ulTrackMask, uiControlMask);
+  cs10_journal_checkpoint();
+  cs10_state_write_end(ulTrackMask);
+
+  /* the track LEDs may have been showing the recall's tracks */
+  cs10_set_mode(cs10.theMode);
+
+  if (cs10.displayMode == BANK_DISPLAY_MODE)
+    cs10_display_bank();
+  else
+    cs10_display_time();
+} /* cs10_recall_state */
+
+/*
+ * cs10_save_state
+ *
+ * keep the live mixer state as saved state uiState, on disk too
+ */
+void
+cs10_save_state(
+  unsigned int uiState) {
+
+  cs10_read_mixer_state(&cs10.csSavedState[uiState]);
+  cs10_save_settings();
+} /* cs10_save_state */
+
+/*
+ * cs10_set_bank
+ *
+ * switch the surface to virtual bank uiBank
+ */
+void
+cs10_set_bank(
+  unsigned int uiBank) {
+
+  cs10.uiBank = uiBank;
+  cs10_journal_surface_state();
+
+  if (cs10.displayMode == BANK_DISPLAY_MODE)
+    cs10_display_bank();
+
+  cs10_set_mode(cs10.theMode) ;
+} /* cs10_set_bank */
+
+/* the mmc command behind each transport step of a macro */
+static const unsigned int macroCommand[MACRO_LOCATE_SAVED] = {
+  MMC_COMMAND_PLAY,              /* MACRO_PLAY */
+  MMC_COMMAND_STOP,              /* MACRO_STOP */
+  MMC_COMMAND_REC_PAUSE,         /* MACRO_RECORD */
+  MMC_COMMAND_FF,                /* MACRO_FF */
+  MMC_COMMAND_REW                /* MACRO_REW */
+} ;
+
+/*
+ * cs10_add_macro_event
+ *
+ * add pEvent, due ulDue, to the events of a macro, for the daw and again
+ * for every target following it. tcControl is what pEvent sets on
+ * uiVirtualTrack, NUM_VIRTUAL_TRACK_CONTROLS for an mmc packet
+ */
+void
+cs10_add_macro_event(
+  snd_seq_event_t *pEvents,
+  uint32_t *pulDue,
+  unsigned int *puiEvents,
+  snd_seq_event_t *pEvent,
+  uint32_t ulDue,
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl) {
+
+  const cs10_map_t    *pMap = cs10_current_map() ;
+  const cs10_target_t *pTarget ;
+  unsigned int         uiTarget ;
+
+  snd_seq_ev_set_source(pEvent, cs10.iMMCPortID) ;
+  pEvents[*puiEvents] = *pEvent ;
+  pulDue[(*puiEvents)++] = ulDue ;
+
+  for (uiTarget = 0 ;
+       NULL != (pTarget = cs10_target_get(uiTarget)) ;
+       uiTarget++) {
+    if (NUM_VIRTUAL_TRACK_CONTROLS == tcControl) {
+      if (!pTarget->bTransport)
+        continue ;
+    } else
+    if (!cs10_target_remap(pTarget, pMap, uiVirtualTrack, tcControl, pEvent))
+      continue ;
+
+    snd_seq_ev_set_source(pEvent, pTarget->iPortID) ;
+    pEvents[*puiEvents] = *pEvent ;
+    pulDue[(*puiEvents)++] = ulDue ;
+  } /* for */
+} /* cs10_add_macro_event */
+
+/*
+ * cs10_run_macro
+ *
+ * compile macro uiSlot into the events it makes, each stamped with when
+ * it is due, and put them all on the macro queue at once
+ * track controls go out as midi whatever osc could take, and the live
+ * state takes them straight away rather than when they are due
+ * return false if there is no such macro
+ */
+bool
+cs10_run_macro(
+  unsigned int uiSlot) {
+
+  const cs10_macro_t *pMacro = cs10_macro_get(uiSlot) ;
+  snd_seq_event_t     theEvent[CS10_MACRO_EVENTS] ;
+  uint32_t            ulDue[CS10_MACRO_EVENTS] ;
+  unsigned char       ucSysex[CS10_MACRO_STEPS][MMC_GOTO_SYSEX_PACKET_LENGTH] ;
+  unsigned int        uiEvents = 0 ;
+  uint32_t            ulAt = 0 ;
+  uint32_t            ulChanged = 0 ;
+  unsigned int        uiControlMask[CS10_NUM_VIRTUAL_TRACKS] = { 0 } ;
+  cs10_mixer_state_t  csTarget ;
+  unsigned int        uiStep ;
+  unsigned int        uiTrack ;
+  unsigned int        uiControl ;
+
+  if (NULL == pMacro)
+    return false ;
+
+  cs10_read_mixer_state(&csTarget) ;
+
+  for (uiStep = 0 ; uiStep < pMacro->uiSteps ; uiStep++) {
+    const cs10_macro_step_t *pStep = &pMacro->step[uiStep] ;
+    snd_seq_event_t          theStep ;
+    cs10_track_state_t      *pTrack ;
+    smpte_time_t             tLocate ;
+    unsigned int             uiValue ;
+    unsigned int             uiChannel ;
+    unsigned int             uiCC ;
+
+    ulAt += pStep->ulWaitMs ;
+    snd_seq_ev_clear(&theStep) ;
+
+    switch (pStep->ucAction) {
+      case MACRO_LOCATE_SAVED:
+      case MACRO_LOCATE:
+        if (MACRO_LOCATE_SAVED == pStep->ucAction)
+          tLocate = cs10.tSavedPosition[pStep->ucArg[0]] ;
+        else {
+          tLocate.hours = pStep->ucArg[0] ;
+          tLocate.minutes = pStep->ucArg[1] ;
+          tLocate.seconds = pStep->ucArg[2] ;
+          tLocate.frames = pStep->ucArg[3] ;
+        } /* else */
+
+        {
+          unsigned char ucGoto[MMC_GOTO_SYSEX_PACKET_LENGTH] =
+            MMC_GOTO_SYSEX_PACKET(MMC_DEVICEID_ALL, tLocate.hours,
+              tLocate.minutes, tLocate.seconds, tLocate.frames, 0) ;
+
+          memcpy(ucSysex[uiStep], ucGoto, sizeof(ucGoto)) ;
+        }
+
+        snd_seq_ev_set_sysex(&theStep, MMC_GOTO_SYSEX_PACKET_LENGTH,
+                             ucSysex[uiStep]) ;
+        cs10_add_macro_event(theEvent, ulDue, &uiEvents, &theStep, ulAt,
+                             0, NUM_VIRTUAL_TRACK_CONTROLS) ;
+        break ;
+
+      case MACRO_SET:
+        uiTrack = pStep->ucArg[0] ;
+        uiControl = pStep->ucArg[1] ;
+        uiValue = pStep->ucArg[2] ;
+        pTrack = &csTarget.tsTrack[uiTrack] ;
+
+        /* a toggle already where the macro wants it is left alone */
+        if ((uiControl < FADER_CONTROL) &&
+            (cs10_get_track_control(pTrack, uiControl) == (uiValue ? 1 : 0)))
+          continue ;
+
+        if (!cs10_map_to_cc(cs10_current_map(), uiTrack, uiControl,
+                            &uiChannel, &uiCC))
+          continue ;
+
+        cs10_set_track_control(pTrack, uiControl, uiValue) ;
+        ulChanged |= 1U << uiTrack ;
+
+        if (uiControl >= FADER_CONTROL) {
+          snd_seq_ev_set_controller(&theStep, uiChannel, uiCC, uiValue) ;
+          cs10_add_macro_event(theEvent, ulDue, &uiEvents, &theStep, ulAt,
+                               uiTrack, uiControl) ;
+          break ;
+        } /* if */
+
+#if CS10_TOGGLE_BUTTONS
+        snd_seq_ev_set_controller(&theStep, uiChannel, uiCC,
+          (uiValue ? BUTTON_DOWN_VALUE : BUTTON_UP_VALUE)) ;
+        cs10_add_macro_event(theEvent, ulDue, &uiEvents, &theStep, ulAt,
+                             uiTrack, uiControl) ;
+#else
+        snd_seq_ev_set_controller(&theStep, uiChannel, uiCC,
+                                  BUTTON_DOWN_VALUE) ;
+        cs10_add_macro_event(theEvent, ulDue, &uiEvents, &theStep, ulAt,
+                             uiTrack, uiControl) ;
+
+        snd_seq_ev_set_controller(&theStep, uiChannel, uiCC,
+                                  BUTTON_UP_VALUE) ;
+        cs10_add_macro_event(theEvent, ulDue, &uiEvents, &theStep, ulAt,
+                             uiTrack, uiControl) ;
+#endif
+        break ;
+
+      default:
+        {
+          unsigned char ucCommand[MMC_CMD_SYSEX_PACKET_LENGTH] =
+            MMC_CMD_SYSEX_PACKET(MMC_DEVICEID_ALL,
+                                 macroCommand[pStep->ucAction]) ;
+
+          memcpy(ucSysex[uiStep], ucCommand, sizeof(ucCommand)) ;
+        }
+
+        snd_seq_ev_set_sysex(&theStep, MMC_CMD_SYSEX_PACKET_LENGTH,
+                             ucSysex[uiStep]) ;
+        cs10_add_macro_event(theEvent, ulDue, &uiEvents, &theStep, ulAt,
+                             0, NUM_VIRTUAL_TRACK_CONTROLS) ;
+        break ;
+    } /* switch */
+  } /* for */
+
+  if (cs10.debug)
+    CS10_LOG("macro %u, %u events over %u ms\n",
+      uiSlot + 1, uiEvents, ulAt) ;
+
+  if (!cs10_macro_schedule(theEvent, ulDue, uiEvents))
+    fprintf(stderr, "macro %u didn't all make it to the sequencer\n",
+      uiSlot + 1) ;
+
+  if (0 == ulChanged)
+    return true ;
+
+  seqlock_write_begin(&cs10.stateLock) ;
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    if (0 == (ulChanged & (1U << uiTrack)))
+      continue ;
+
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++) {
+      unsigned int uiValue =
+        cs10_get_track_control(&csTarget.tsTrack[uiTrack], uiControl) ;
+
+      if (uiValue == cs10_get_track_control(&cs10.csState.tsTrack[uiTrack],
+                                            uiControl))
+        continue ;
+
+      cs10_set_track_control(&cs10.csState.tsTrack[uiTrack], uiControl,
+                             uiValue) ;
+      cs10_journal_append(JOURNAL_TRACK_KEY(uiTrack, uiControl), uiValue) ;
+      uiControlMask[uiTrack] |= 1U << uiControl ;
+    } /* for */
+  } /* for */
+
+  cs10_state_write_end(ulChanged) ;
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++)
+      if (uiControlMask[uiTrack] & (1U << uiControl))
+        cs10_restore_override(uiTrack, uiControl,
+          cs10_get_track_control(&csTarget.tsTrack[uiTrack], uiControl)) ;
+  } /* for */
+
+  cs10_refresh_track_leds(ulChanged) ;
+
+  return true ;
+} /* cs10_run_macro */
+
+/*
+ * cs10_macro_button
+ *
+ * shift and a track button keep the macro being recorded as macro
+ * uiSlot, on disk too, or else run macro uiSlot
+ * return false if there was nothing to do
+ */
+bool
+cs10_macro_button(
+  unsigned int uiSlot) {
+
+  if (!cs10_macro_is_recording())
+    return cs10_run_macro(uiSlot) ;
+
+  if (!cs10_macro_record_keep(uiSlot)) {
+    if (cs10.debug)
+      CS10_LOG("nothing recorded for macro %u\n", uiSlot + 1) ;
+    return true ;
+  } /* if */
+
+  if (cs10.macro_filename &&
+      !cs10_macro_save(cs10.macro_filename, controlName))
+    fprintf(stderr, "can't save macros to %s\n", cs10.macro_filename) ;
+
+  return true ;
+} /* cs10_macro_button */
+
+/*
+ * cs10_toggle_track_flag
+ *
+ * flip the armed, mute or solo flag of uiVirtualTrack
+ * return the new setting
+ */
+bool
+cs10_toggle_track_flag(
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl) {
+
+  bool bFlag = false ;
+  cs10_track_state_t *pTrack = &cs10.csState.tsTrack[uiVirtualTrack] ;
+
+  seqlock_write_begin(&cs10.stateLock) ;
+
+  switch (tcControl) {
+    case ARMED_CONTROL:
+      bFlag = pTrack->bArmed = (pTrack->bArmed == 0) ;
+      break ;
+
+    case MUTE_CONTROL:
+      bFlag = pTrack->bMute = (pTrack->bMute == 0) ;
+      break ;
+
+    case SOLO_CONTROL:
+      bFlag = pTrack->bSolo = (pTrack->bSolo == 0) ;
+      break ;
+
+    default:
+      break ;
+  } /* switch */
+
+  cs10_journal_append(JOURNAL_TRACK_KEY(uiVirtualTrack, tcControl), bFlag) ;
+
+  cs10_state_write_end(1U << uiVirtualTrack) ;
+
+  return bFlag ;
+} /* cs10_toggle_track_flag */
+
+/*
+ * cs10_apply_virtual_control
+ *
+ * set uiVirtualTrack's tcControl to uiValue and send it on, as a move
+ * on the surface would, unless it's there already
+ */
+void
+cs10_apply_virtual_control(
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiValue) {
+
+  cs10_track_state_t tsTrack ;
+
+  cs10_read_track_state(uiVirtualTrack, &tsTrack) ;
+
+  if (*cs10_track_value(&tsTrack, tcControl) == uiValue)
+    return ;
+
+  seqlock_write_begin(&cs10.stateLock) ;
+  *cs10_track_value(&cs10.csState.tsTrack[uiVirtualTrack], tcControl) =
+    uiValue ;
+  cs10_journal_append(JOURNAL_TRACK_KEY(uiVirtualTrack, tcControl), uiValue) ;
+  cs10_state_write_end(1U << uiVirtualTrack) ;
+
+  cs10_restore_override(uiVirtualTrack, tcControl, uiValue) ;
+
+  cs10_issue_virtual_control(uiVirtualTrack, tcControl, uiValue,
+                             INTERACTIVE_LANE) ;
+} /* cs10_apply_virtual_control */
+
+/*
+ * cs10_automation_follow
+ *
+ * time code moved, send whatever the untouched streams hold for it.
+ * running on from the last frame only the values passed since go out,
+ * after a locate every stream is looked up afresh
+ */
+void
+cs10_automation_follow(void) {
+
+  uint32_t     ulFrame ;
+  bool         bSeek ;
+  unsigned int uiTrack ;
+  unsigned int uiControl ;
+
+  if (AUTOMATION_OFF == cs10.automationMode)
+    return ;
+
+  ulFrame = cs10_time_to_frame(cs10_read_current_time()) ;
+
+  bSeek = (!cs10.bAutomationLocated ||
+           (ulFrame < cs10.ulAutomationFrame) ||
+           (ulFrame - cs10.ulAutomationFrame > CS10_AUTOMATION_SEEK_FRAMES)) ;
+
+  /* a locate ends the take, controls have to be moved again to record */
+  if (bSeek && cs10.bAutomationLocated)
+    memset(cs10.usTouched, 0, sizeof(cs10.usTouched)) ;
+
+  cs10.bAutomationLocated = true ;
+  cs10.ulAutomationFrame = ulFrame ;
+
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    for (uiControl = FADER_CONTROL ;
+         uiControl < NUM_VIRTUAL_TRACK_CONTROLS ;
+         uiControl++) {
+      int iValue ;
+
+      if (cs10.usTouched[uiTrack] & CONTROL_BIT(uiControl))
+        continue ;
+
+      iValue = (bSeek ?
+        cs10_automation_seek(AUTOMATION_STREAM(uiTrack, uiControl), ulFrame) :
+        cs10_automation_play(AUTOMATION_STREAM(uiTrack, uiControl), ulFrame)) ;
+
+      if (0 <= iValue)
+        cs10_apply_virtual_control(uiTrack, uiControl, iValue) ;
+    } /* for */
+  } /* for */
+} /* cs10_automation_follow */
+
+/*
+ * cs10_automation_touch
+ *
+ * the surface moved uiVirtualTrack's tcControl to uiValue, while
+ * recording that replaces the control's stream from here on
+ */
+void
+cs10_automation_touch(
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiValue) {
+
+  if (AUTOMATION_RECORD != cs10.automationMode)
+    return ;
+
+  cs10.usTouched[uiVirtualTrack] |= CONTROL_BIT(tcControl) ;
+
+  if (!cs10_automation_record(AUTOMATION_STREAM(uiVirtualTrack, tcControl),
+        cs10_time_to_frame(cs10_read_current_time()), uiValue) &&
+      cs10.debug)
+    CS10_LOG("track %u control %u is full\n",
+      uiVirtualTrack, tcControl) ;
+} /* cs10_automation_touch */
+
+/*
+ * cs10_set_automation_mode
+ *
+ * switch between leaving automation alone, playing it and recording it
+ */
+void
+cs10_set_automation_mode(
+  automation_mode_t theMode) {
+
+  cs10.automationMode = theMode ;
+
+  /* playback picks up with a fresh look at every stream */
+  cs10.bAutomationLocated = false ;
+  memset(cs10.usTouched, 0, sizeof(cs10.usTouched)) ;
+
+  cs10_set_led(RECORD_LED_ADDR,
+      (AUTOMATION_RECORD == theMode ? LED_ON_VALUE : LED_OFF_VALUE)) ;
+
+  if (cs10.debug)
+    CS10_LOG("%d\n", theMode) ;
+
+  cs10_automation_follow() ;
+} /* cs10_set_automation_mode */
+
+/*
+ * cs10_narrow_recall
+ *
+ * a button pressed while an F key is held picks what the F key recalls:
+ * track buttons those tracks of the bank, MODE the whole bank, UP the
+ * faders, DOWN the EQ knobs, LEFT mute and solo. picks add up
+ * return false for buttons that don't pick anything
+ */
+bool
+cs10_narrow_recall(
+  unsigned int uiButtonAddr) {
+
+  if (LAST_TRACK_BUTTON_ADDR >= uiButtonAddr) {
+    cs10.uiRecallTracks |= 1U << BUTTON_ADDR_TO_TRACK(uiButtonAddr);
+    cs10_set_led(TRACK_TO_LED_ADDR(BUTTON_ADDR_TO_TRACK(uiButtonAddr)),
+                 LED_ON_VALUE);
+    return true;
+  } /* if */
+
+  switch (uiButtonAddr) {
+    case MODE_BUTTON_ADDR:
+      cs10.bRecallBank = true;
+      return true;
+
+    case UP_BUTTON_ADDR:
+      cs10.uiRecallControls |= CONTROL_BIT(FADER_CONTROL);
+      return true;
+
+    case DOWN_BUTTON_ADDR:
+      cs10.uiRecallControls |= CS10_EQ_CONTROLS;
+      return true;
+
+    case LEFT_BUTTON_ADDR:
+      cs10.uiRecallControls |= CS10_MUTE_SOLO_CONTROLS;
+      return true;
+
+    default:
+      return false;
+  } /* switch */
+} /* cs10_narrow_recall */
+
+/*
+ * cs10_handle_button
+ *
+ * do stuff based on uiButtonAddr and uiButtonVal
+ */
+void
+cs10_handle_button(
+  unsigned int uiButtonAddr,
+  int uiButtonVal) {
+
+  bool bFlag ;
+
+  if (cs10.debug)
+    CS10_LOG("%u %d\n",
+      uiButtonAddr,
+      uiButtonVal);
+
+  /* the release of a button that narrowed a recall does nothing else */
+  if ((BUTTON_UP_VALUE == uiButtonVal) && (uiButtonAddr < 32) &&
+      (cs10.ulSwallowButtons & (1U << uiButtonAddr))) {
+    cs10.ulSwallowButtons &= ~(1U << uiButtonAddr);
+    return;
+  } /* if */
+
+  /* with an F key held, pick what it recalls */
+  if (cs10.uiMorphKey && (BUTTON_DOWN_VALUE == uiButtonVal) &&
+      cs10_narrow_recall(uiButtonAddr)) {
+    cs10.ulSwallowButtons |= 1U << uiButtonAddr;
+    return;
+  } /* if */
+
+  /* with shift held, track buttons are for macros when there are any */
+  if (cs10.bShiftKeyDown && (BUTTON_UP_VALUE == uiButtonVal) &&
+      (LAST_TRACK_BUTTON_ADDR >= uiButtonAddr) &&
+      cs10_macro_button(BUTTON_ADDR_TO_TRACK(uiButtonAddr)))
+    return ;
+
+  /* handle track buttons */
+  if (((FIRST_TRACK_BUTTON_ADDR <= uiButtonAddr) &&
+     (LAST_TRACK_BUTTON_ADDR >= uiButtonAddr)) &&
+     (BUTTON_UP_VALUE == uiButtonVal)) {
+    switch (cs10.theMode) {
+      case NULLIFY_MODE:
+      case SELECT_MODE:
+        cs10_set_led(TRACK_TO_LED_ADDR(cs10.uiSelectedTrack),
+            LED_OFF_VALUE) ;
+
+        cs10.uiSelectedTrack =
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr) ;
+        cs10_journal_surface_state() ;
+
+        cs10_set_led(TRACK_TO_LED_ADDR(cs10.uiSelectedTrack),
+            LED_ON_VALUE) ;
+        break ;
+
+      case LOC_MODE:
+        bFlag = cs10_toggle_track_flag(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          ARMED_CONTROL) ;
+
+        cs10_macro_record_step(MACRO_SET,
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          ARMED_CONTROL, bFlag, 0) ;
+
+        cs10_restore_override(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          ARMED_CONTROL, bFlag) ;
+
+#if CS10_TOGGLE_BUTTONS
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          ARMED_CONTROL,
+          (bFlag ? BUTTON_DOWN_VALUE : BUTTON_UP_VALUE),
+          INTERACTIVE_LANE) ;
+#else
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          ARMED_CONTROL, BUTTON_DOWN_VALUE, INTERACTIVE_LANE);
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          ARMED_CONTROL, BUTTON_UP_VALUE, INTERACTIVE_LANE);
+#endif
+
+        cs10_set_led(TRACK_TO_LED_ADDR(BUTTON_ADDR_TO_TRACK(uiButtonAddr)),
+         (bFlag ? LED_ON_VALUE : LED_OFF_VALUE)) ;
+        break ;
+
+      case MUTE_MODE:
+        bFlag = cs10_toggle_track_flag(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          MUTE_CONTROL) ;
+
+        cs10_macro_record_step(MACRO_SET,
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          MUTE_CONTROL, bFlag, 0) ;
+
+        cs10_restore_override(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          MUTE_CONTROL, bFlag) ;
+
+#if CS10_TOGGLE_BUTTONS
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          MUTE_CONTROL,
+          (bFlag ? BUTTON_DOWN_VALUE : BUTTON_UP_VALUE),
+          INTERACTIVE_LANE) ;
+#else
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          MUTE_CONTROL, BUTTON_DOWN_VALUE, INTERACTIVE_LANE);
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          MUTE_CONTROL, BUTTON_UP_VALUE, INTERACTIVE_LANE);
+#endif
+
+        cs10_set_led(TRACK_TO_LED_ADDR(BUTTON_ADDR_TO_TRACK(uiButtonAddr)),
+         (bFlag ? LED_ON_VALUE : LED_OFF_VALUE)) ;
+        break ;
+
+      case SOLO_MODE:
+        bFlag = cs10_toggle_track_flag(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          SOLO_CONTROL) ;
+
+        cs10_macro_record_step(MACRO_SET,
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          SOLO_CONTROL, bFlag, 0) ;
+
+        cs10_restore_override(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          SOLO_CONTROL, bFlag) ;
+
+#if CS10_TOGGLE_BUTTONS
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          SOLO_CONTROL,
+          (bFlag ? BUTTON_DOWN_VALUE : BUTTON_UP_VALUE),
+          INTERACTIVE_LANE) ;
+#else
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          SOLO_CONTROL, BUTTON_DOWN_VALUE, INTERACTIVE_LANE);
+        cs10_issue_virtual_control(
+          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
+          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
+          SOLO_CONTROL, BUTTON_UP_VALUE, INTERACTIVE_LANE);
+#endif
+
+        cs10_set_led(TRACK_TO_LED_ADDR(BUTTON_ADDR_TO_TRACK(uiButtonAddr)),
+         (bFlag ? LED_ON_VALUE : LED_OFF_VALUE)) ;
+        break ;
+
+      default: 
+        break ;
+    } /* switch */
+  } else
+  if ((F1_BUTTON_ADDR <= uiButtonAddr) &&
+     (F9_BUTTON_ADDR >= uiButtonAddr)) {
+    if (cs10.bShiftKeyDown) {
+      /* save/restore position */
+      if (cs10.bRecordKeyDown) {
+        cs10.bIgnoreRecordKeyUp = true ;
+        cs10.tSavedPosition[uiButtonAddr - F1_BUTTON_ADDR] =
+          cs10_read_current_time() ;
+        cs10_save_settings();
+      } else {
+        if (BUTTON_UP_VALUE == uiButtonVal)
+          cs10_macro_record_step(MACRO_LOCATE_SAVED,
+            uiButtonAddr - F1_BUTTON_ADDR, 0, 0, 0) ;
+
+        cs10_issue_mmc_goto_command(
+            cs10.tSavedPosition[uiButtonAddr - F1_BUTTON_ADDR]) ;
+      } /* !bRecordKeyDown */
+    } else {
+      /* save/restore fader settings */
+      if (cs10.bRecordKeyDown) {
+        cs10.bIgnoreRecordKeyUp = true ;
+        cs10_save_state(uiButtonAddr - F1_BUTTON_ADDR);
+      } else
+      if (BUTTON_DOWN_VALUE == uiButtonVal) {
+        /* wait for the release, the wheel may set a morph time and
+         * other buttons narrow the recall first
+         */
+        cs10.uiMorphKey = uiButtonAddr - F1_BUTTON_ADDR + 1;
+        cs10.bMorphTimeSet = false;
+        cs10.bRecallBank = false;
+        cs10.uiRecallTracks = 0;
+        cs10.uiRecallControls = 0;
+      } else {
+        uint32_t ulTrackMask = CS10_ALL_TRACKS;
+        unsigned int uiControlMask = CS10_ALL_CONTROLS;
+
+        if (cs10.uiMorphKey == uiButtonAddr - F1_BUTTON_ADDR + 1) {
+          if (cs10.uiRecallTracks)
+            ulTrackMask = (uint32_t)cs10.uiRecallTracks <<
+                          (cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS);
+          else
+          if (cs10.bRecallBank)
+            ulTrackMask = CS10_BANK_TRACKS(cs10.uiBank);
+
+          if (cs10.uiRecallControls)
+            uiControlMask = cs10.uiRecallControls;
+        } /* if */
+
+        if (cs10.bMorphTimeSet &&
+            (cs10.uiMorphKey == uiButtonAddr - F1_BUTTON_ADDR + 1))
+          cs10_recall_state(uiButtonAddr - F1_BUTTON_ADDR,
+                            ulTrackMask, uiControlMask,
+                            cs10.uiMorphSeconds * 1000);
+        else
+          cs10_recall_state(uiButtonAddr - F1_BUTTON_ADDR,
+                            ulTrackMask, uiControlMask, 0);
+        cs10.uiMorphKey = 0;
+        cs10.bMorphTimeSet = false;
+      } /* !bRecordKeyDown */
+    } /* !bShiftKeyDown */
+  } else
+  switch (uiButtonAddr) {
+    case SHIFT_BUTTON_ADDR:
+      cs10.bShiftKeyDown = (BUTTON_DOWN_VALUE == uiButtonVal) ;
+      break ;
+
+    case REW_BUTTON_ADDR:
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        if (cs10.bShiftKeyDown) {
+          smpte_time_t tZero = {0, 0, 0, 0, 0} ;
+
+          cs10_macro_record_step(MACRO_LOCATE, 0, 0, 0, 0) ;
+          cs10_issue_mmc_goto_command(tZero) ;
+        } else {
+          cs10_macro_record_step(MACRO_REW, 0, 0, 0, 0) ;
+          cs10_issue_mmc_command(MMC_COMMAND_REW) ;
+        } /* !bShiftKeyDown */
+      } /* if */
+      break ;
+
+    case FF_BUTTON_ADDR:
+      if ((BUTTON_UP_VALUE == uiButtonVal) && cs10.bShiftKeyDown) {
+        /* shift ff starts recording a macro, or gives up on one */
+        if (cs10_macro_is_recording())
+          cs10_macro_record_abandon() ;
+        else
+          cs10_macro_record_start() ;
+      } else
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        cs10_macro_record_step(MACRO_FF, 0, 0, 0, 0) ;
+        cs10_issue_mmc_command(MMC_COMMAND_FF) ;
+      } /* if */
+      break;
+
+    case STOP_BUTTON_ADDR:
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        cs10_macro_record_step(MACRO_STOP, 0, 0, 0, 0) ;
+        cs10_issue_mmc_command(MMC_COMMAND_STOP) ;
+      } /* if */
+      break ;
+
+    case PLAY_BUTTON_ADDR:
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        if (cs10.bShiftKeyDown) {
+          cs10_macro_record_step(MACRO_LOCATE, cs10.tPlayFromTime.hours,
+            cs10.tPlayFromTime.minutes, cs10.tPlayFromTime.seconds,
+            cs10.tPlayFromTime.frames) ;
+          cs10_issue_mmc_goto_command(cs10.tPlayFromTime) ;
+        } else {
+          cs10.tPlayFromTime = cs10_read_current_time() ;
+          cs10_macro_record_step(MACRO_PLAY, 0, 0, 0, 0) ;
+          cs10_issue_mmc_command(MMC_COMMAND_PLAY) ;
+        } /* !bShiftKeyDown */
+      } /* BUTTON_UP_VALUE */
+      break ;
+
+    case RECORD_BUTTON_ADDR:
+      cs10.bRecordKeyDown = (BUTTON_DOWN_VALUE == uiButtonVal) ;
+
+      if (!cs10.bRecordKeyDown) {
+        if (cs10.bIgnoreRecordKeyUp)
+          cs10.bIgnoreRecordKeyUp = false ;
+        else {
+          if (cs10.bShiftKeyDown) {
+            cs10_macro_record_step(MACRO_LOCATE, cs10.tRecordFromTime.hours,
+              cs10.tRecordFromTime.minutes, cs10.tRecordFromTime.seconds,
+              cs10.tRecordFromTime.frames) ;
+            cs10_issue_mmc_goto_command(cs10.tRecordFromTime) ;
+          } else {
+            cs10.tRecordFromTime = cs10_read_current_time() ;
+            cs10_macro_record_step(MACRO_RECORD, 0, 0, 0, 0) ;
+            cs10_issue_mmc_command(MMC_COMMAND_REC_PAUSE) ;
+          } /* !bShiftKeyDown */
+        } /* !bIgnoreRecordKeyUp */
+      } /* !bRecordKeyDown */
+      break ;
+
+    case MODE_BUTTON_ADDR:
+      if ((BUTTON_UP_VALUE == uiButtonVal) &&
+          cs10.bShiftKeyDown && cs10_automation_is_open()) {
+        /* shift mode steps automation through off, play and record */
+        cs10_set_automation_mode(
+          (cs10.automationMode + 1) % NUM_AUTOMATION_MODES) ;
+      } else
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        if (NUM_MODES == ++cs10.theMode)
+          cs10.theMode = SELECT_MODE ;
+
+        cs10_journal_surface_state() ;
+        cs10_set_mode(cs10.theMode) ;
+      } /* if */
+      break ;
+
+    case RIGHT_BUTTON_ADDR:
+      if ((BUTTON_UP_VALUE == uiButtonVal) && cs10.bShiftKeyDown) {
+        /* shift right redoes what was last undone */
+        cs10_undo_step(true);
+      } else
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        if (cs10.displayMode == BANK_DISPLAY_MODE) {
+          cs10_set_bank((cs10.uiBank + 1) % CS10_NUM_BANKS);
+        } else {
+          if (++cs10.smpteDisplayMode >= NUM_SMPTE_DISPLAY_MODES)
+            cs10.smpteDisplayMode = 0;
+          cs10_display_time();
+        } /* else */
+      } /* if */
+      break;
+
+    case LEFT_BUTTON_ADDR:
+      if ((BUTTON_UP_VALUE == uiButtonVal) && cs10.bShiftKeyDown) {
+        /* shift left undoes the last recall or fader or knob move */
+        cs10_undo_step(false);
+      } else
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        if (cs10.displayMode == BANK_DISPLAY_MODE) {
+          cs10_set_bank((cs10.uiBank + CS10_NUM_BANKS - 1) % CS10_NUM_BANKS);
+        } else {
+          if (cs10.smpteDisplayMode-- == 0)
+            cs10.smpteDisplayMode = NUM_SMPTE_DISPLAY_MODES - 1;
+          cs10_display_time();
+        } /* else */
+      } /* if */
+      break;
+
+    case UP_BUTTON_ADDR:
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        if (++cs10.displayMode == NUM_DISPLAY_MODES)
+          cs10.displayMode = 0;
+
+        if (cs10.displayMode == BANK_DISPLAY_MODE) {
+          cs10_set_led(TENS_DEC_LED_ADDR, LED_OFF_VALUE);
+          cs10_set_led(ONES_DEC_LED_ADDR, LED_OFF_VALUE);
+          cs10_display_bank();
+        } else {
+          cs10_display_time();
+        } /* else */
+      } /* if */
+      break;
+
+    case DOWN_BUTTON_ADDR:
+      if (BUTTON_UP_VALUE == uiButtonVal) {
+        if (cs10.displayMode-- == 0)
+          cs10.displayMode = NUM_DISPLAY_MODES - 1;
+
+        if (cs10.displayMode == BANK_DISPLAY_MODE) {
+          cs10_set_led(TENS_DEC_LED_ADDR, LED_OFF_VALUE);
+          cs10_set_led(ONES_DEC_LED_ADDR, LED_OFF_VALUE);
+          cs10_display_bank();
+        } else {
+          cs10_display_time();
+        } /* else */
+      } /* if */
+      break;
+
+    default:
+      break ;
+  } /* switch */
+} /* cs10_handle_button */
+
+/*
+ * cs10_show_null
+ *
+ * light the null LED pointing the way from iValue to iTarget
+ */
+void
+cs10_show_null(
+  unsigned int uiDownAddr,
+  unsigned int uiUpAddr,
+  int iValue,
+  int iTarget) {
+
+  if (iValue < iTarget) {
+    cs10_set_led(uiDownAddr, LED_OFF_VALUE);
+    cs10_set_led(uiUpAddr, LED_ON_VALUE);
+  } else
+  if (iValue > iTarget) {
+    cs10_set_led(uiDownAddr, LED_ON_VALUE);
+    cs10_set_led(uiUpAddr, LED_OFF_VALUE);
+  } else {
+    cs10_set_led(uiDownAddr, LED_OFF_VALUE);
+    cs10_set_led(uiUpAddr, LED_OFF_VALUE);
+  }
+} /* cs10_show_null */
+
+/*
+ * cs10_pickup
+ *
+ * the control behind pPickup moved to iValue, while its target on
+ * uiVirtualTrack holds iStored
+ * return true if it has caught the target and should drive it
+ */
+bool
+cs10_pickup(
+  cs10_pickup_t *pPickup,
+  unsigned int uiVirtualTrack,
+  int iValue,
+  int iStored) {
+
+  int  iFrom = (int)pPickup->uiPosition - 1 ;
+  bool bCaught ;
+
+  pPickup->uiPosition = iValue + 1 ;
+
+  /* nothing else has touched the target since this control last drove
+   * it, so they still agree
+   */
+  if (pPickup->uiSent && (pPickup->uiTrack == uiVirtualTrack) &&
+      (abs(iStored - ((int)pPickup->uiSent - 1)) <= CS10_PICKUP_WINDOW))
+    bCaught = true ;
+  else
+    /* close enough, or moved right across it */
+    bCaught = ((abs(iValue - iStored) <= CS10_PICKUP_WINDOW) ||
+               ((0 <= iFrom) &&
+                (((iFrom < iStored) && (iValue > iStored)) ||
+                 ((iFrom > iStored) && (iValue < iStored))))) ;
+
+  if (bCaught) {
+    pPickup->uiTrack = uiVirtualTrack ;
+    pPickup->uiSent = iValue + 1 ;
+  } /* if */
+
+  return bCaught ;
+} /* cs10_pickup */
+
+/*
+ * cs10_deadband
+ *
+ * filter the jitter out of a physical control, a move that carries on
+ * the way it was going always counts, one back the other way has to be
+ * more than uiDeadband
+ * return true if uiValue should be acted on
+ */
+bool
+cs10_deadband(
+  cs10_throttle_t *pThrottle,
+  unsigned int uiValue,
+  unsigned int uiDeadband) {
+
+  int iMove = (int)uiValue - ((int)pThrottle->uiAccepted - 1) ;
+
+  if (0 == pThrottle->uiAccepted) {
+    pThrottle->uiAccepted = uiValue + 1 ;
+    return true ;
+  } /* if */
+
+  if (0 == iMove)
+    return false ;
+
+  /* the ends of travel are always reachable */
+  if ((0 != uiValue) && (CS10_MAX_CONTROL_VALUE != uiValue) &&
+      (((0 > iMove) != (0 > pThrottle->iDirection)) ||
+       (0 == pThrottle->iDirection)) &&
+      ((unsigned int)abs(iMove) <= uiDeadband))
+    return false ;
+
+  pThrottle->iDirection = (0 < iMove ? 1 : -1) ;
+  pThrottle->uiAccepted = uiValue + 1 ;
+
+  return true ;
+} /* cs10_deadband */
+
+/*
+ * cs10_throttle_flush
+ *
+ * send the value pThrottle is holding back
+ */
+void
+cs10_throttle_flush(
+  cs10_throttle_t *pThrottle) {
+
+  if (!pThrottle->bPending)
+    return ;
+
+  pThrottle->bPending = false ;
+  pThrottle->ulLastSent = cs10_now_ms() ;
+
+  cs10_issue_virtual_control(pThrottle->uiTrack, pThrottle->tcControl,
+                             pThrottle->uiValue, INTERACTIVE_LANE) ;
+} /* cs10_throttle_flush */
+
+/*
+ * cs10_throttle_issue
+ *
+ * send uiValue for uiVirtualTrack's tcControl at most once every
+ * uiControlInterval ms for the physical control behind pThrottle
+ * a value held back goes out when the interval is up, so a move always
+ * ends where the control stopped
+ */
+void
+cs10_throttle_issue(
+  cs10_throttle_t *pThrottle,
+  unsigned int uiVirtualTrack,
+  virtual_track_control_t tcControl,
+  unsigned int uiValue) {
+
+  /* a value held for the last target is the last word on it */
+  if (pThrottle->bPending &&
+      ((pThrottle->uiTrack != uiVirtualTrack) ||
+       (pThrottle->tcControl != tcControl)))
+    cs10_throttle_flush(pThrottle) ;
+
+  pThrottle->uiTrack = uiVirtualTrack ;
+  pThrottle->tcControl = tcControl ;
+  pThrottle->uiValue = uiValue ;
+  pThrottle->bPending = true ;
+
+  if (cs10_now_ms() - pThrottle->ulLastSent >= cs10.uiControlInterval)
+    cs10_throttle_flush(pThrottle) ;
+} /* cs10_throttle_issue */
+
+/*
+ * cs10_throttle_step
+ *
+ * send every held back value whose interval is up
+ */
+void
+cs10_throttle_step(void) {
+
+  unsigned int uiThrottle ;
+  uint32_t     ulNow = cs10_now_ms() ;
+
+  for (uiThrottle = 0 ; uiThrottle < CS10_NUM_THROTTLES ; uiThrottle++) {
+    cs10_throttle_t *pThrottle = &cs10.thControl[uiThrottle] ;
+
+    if (pThrottle->bPending &&
+        (ulNow - pThrottle->ulLastSent >= cs10.uiControlInterval))
+      cs10_throttle_flush(pThrottle) ;
+  } /* for */
+} /* cs10_throttle_step */
+
+/*
+ * cs10_throttle_timeout
+ *
+ * milliseconds until a held back value is due, -1 if none is
+ */
+int
+cs10_throttle_timeout(void) {
+
+  unsigned int uiThrottle ;
+  uint32_t     ulNow = cs10_now_ms() ;
+  int          iTimeout = -1 ;
+
+  for (uiThrottle = 0 ; uiThrottle < CS10_NUM_THROTTLES ; uiThrottle++) {
+    cs10_throttle_t *pThrottle = &cs10.thControl[uiThrottle] ;
+    uint32_t         ulWaited = ulNow - pThrottle->ulLastSent ;
+    int              iLeft ;
+
+    if (!pThrottle->bPending)
+      continue ;
+
+    iLeft = (ulWaited >= cs10.uiControlInterval ?
+             0 : (int)(cs10.uiControlInterval - ulWaited)) ;
+
+    if ((0 > iTimeout) || (iLeft < iTimeout))
+      iTimeout = iLeft ;
+  } /* for */
+
+  return iTimeout ;
+} /* cs10_throttle_timeout */
+
+/*
+ * cs10_handle_fader
+ *
+ * do stuff based on uiFaderAddr and uiFaderVal
+ */
+void
+cs10_handle_fader(
+  unsigned int uiFaderAddr,
+  int uiFaderVal) {
+
+  unsigned int uiVirtualTrack = cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
+    FADER_ADDR_TO_TRACK(uiFaderAddr);
+  unsigned int uiFrom;
+
+  if (cs10.debug)
+    CS10_LOG("%u %d\n",
+      uiFaderAddr,
+      uiFaderVal);
+
+  if (!cs10_deadband(&cs10.thControl[
+                       FADER_THROTTLE(FADER_ADDR_TO_TRACK(uiFaderAddr))],
+                     uiFaderVal, cs10.uiFaderDeadband))
+    return;
+
+  if (NULLIFY_MODE == cs10.theMode) {
+    cs10_track_state_t tsTrack;
+
+    cs10_read_track_state(uiVirtualTrack, &tsTrack);
+
+    cs10_show_null(DOWN_NULL_LED_ADDR, UP_NULL_LED_ADDR,
+                   uiFaderVal, tsTrack.uiFader);
+  } else {
+    if (cs10.bPickup) {
+      cs10_track_state_t tsTrack;
+
+      cs10_read_track_state(uiVirtualTrack, &tsTrack);
+
+      if (!cs10_pickup(&cs10.puFader[FADER_ADDR_TO_TRACK(uiFaderAddr)],
+                       uiVirtualTrack, uiFaderVal, tsTrack.uiFader)) {
+        cs10_show_null(DOWN_NULL_LED_ADDR, UP_NULL_LED_ADDR,
+                       uiFaderVal, tsTrack.uiFader);
+        return;
+      } /* if */
+
+      cs10_show_null(DOWN_NULL_LED_ADDR, UP_NULL_LED_ADDR, 0, 0);
+    } /* if */
+
+    seqlock_write_begin(&cs10.stateLock);
+    uiFrom = cs10.csState.tsTrack[uiVirtualTrack].uiFader;
+    cs10.csState.tsTrack[uiVirtualTrack].uiFader = uiFaderVal;
+    cs10_journal_append(JOURNAL_TRACK_KEY(uiVirtualTrack, FADER_CONTROL),
+                        uiFaderVal);
+    cs10_state_write_end(1U << uiVirtualTrack);
+
+    cs10_gesture_move(
+        &cs10.geControl[FADER_THROTTLE(FADER_ADDR_TO_TRACK(uiFaderAddr))],
+        uiVirtualTrack, FADER_CONTROL, uiFrom, uiFaderVal);
+
+    cs10_restore_override(uiVirtualTrack, FADER_CONTROL, uiFaderVal);
+    cs10_automation_touch(uiVirtualTrack, FADER_CONTROL, uiFaderVal);
+
+    cs10_throttle_issue(
+        &cs10.thControl[FADER_THROTTLE(FADER_ADDR_TO_TRACK(uiFaderAddr))],
+        uiVirtualTrack,
+        FADER_CONTROL,
+        uiFaderVal) ;
+  } /* else */
+} /* cs10_handle_fader */
+
+/*
+ * cs10_handle_knob
+ *
+ * do stuff based on uiKnobAddr and uiKnobVal
+ */
+void
+cs10_handle_knob(
+  unsigned int uiKnobAddr,
+  unsigned int uiKnobVal) {
+
+  unsigned int idx = KNOB_ADDR_TO_KNOB_INDEX(uiKnobAddr);
+  unsigned int uiVirtualTrack = cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
+    cs10.uiSelectedTrack;
+  unsigned int uiFrom;
+
+  if (cs10.debug)
+    CS10_LOG("%u %d\n",
+      uiKnobAddr,
+      uiKnobVal);
+
+  if (!cs10_deadband(&cs10.thControl[KNOB_THROTTLE(idx)],
+                     uiKnobVal, cs10.uiKnobDeadband))
+    return;
+
+  if (NULLIFY_MODE == cs10.theMode) {
+    cs10_track_state_t tsTrack;
+
+    cs10_read_track_state(uiVirtualTrack, &tsTrack);
+
+    cs10_show_null(LEFT_WHEEL_LED_ADDR, RIGHT_WHEEL_LED_ADDR,
+                   uiKnobVal, tsTrack.uiKnob[idx]);
+  } else {
+    if (cs10.bPickup) {
+      cs10_track_state_t tsTrack;
+
+      cs10_read_track_state(uiVirtualTrack, &tsTrack);
+
+      if (!cs10_pickup(&cs10.puKnob[idx], uiVirtualTrack,
+                       uiKnobVal, tsTrack.uiKnob[idx])) {
+        cs10_show_null(LEFT_WHEEL_LED_ADDR, RIGHT_WHEEL_LED_ADDR,
+                       uiKnobVal, tsTrack.uiKnob[idx]);
+        return;
+      } /* if */
+
+      cs10_show_null(LEFT_WHEEL_LED_ADDR, RIGHT_WHEEL_LED_ADDR, 0, 0);
+    } /* if */
+
+    seqlock_write_begin(&cs10.stateLock);
+    uiFrom = cs10.csState.tsTrack[uiVirtualTrack].uiKnob[idx];
+    cs10.csState.tsTrack[uiVirtualTrack].uiKnob[idx] = uiKnobVal ;
+    cs10_journal_append(JOURNAL_TRACK_KEY(uiVirtualTrack,
+                          KNOB_ADDR_TO_VIRTUAL_CONTROL(uiKnobAddr)),
+                        uiKnobVal);
+    cs10_state_write_end(1U << uiVirtualTrack);
+
+    cs10_gesture_move(&cs10.geControl[KNOB_THROTTLE(idx)], uiVirtualTrack,
+        KNOB_ADDR_TO_VIRTUAL_CONTROL(uiKnobAddr), uiFrom, uiKnobVal);
+
+    cs10_restore_override(uiVirtualTrack,
+        KNOB_ADDR_TO_VIRTUAL_CONTROL(uiKnobAddr), uiKnobVal);
+    cs10_automation_touch(uiVirtualTrack,
+        KNOB_ADDR_TO_VIRTUAL_CONTROL(uiKnobAddr), uiKnobVal);
+
+    cs10_throttle_issue(
+        &cs10.thControl[KNOB_THROTTLE(idx)],
+        uiVirtualTrack,
+        KNOB_ADDR_TO_VIRTUAL_CONTROL(uiKnobAddr), uiKnobVal) ;
+  } /* else */
+} /* cs10_handle_knob */
+
+/*
+ * cs10_handle_morph_wheel
+ *
+ * turn the morph time up or down a second every CS10_JOG_THRESHOLD,
+ * and show it on the seven segment display
+ */
+void
+cs10_handle_morph_wheel(
+  unsigned int uiWheelVal) {
+
+  cs10.iJogCount += (uiWheelVal & 0x40 ?
+      0 - (((~uiWheelVal) & 0x7f) + 1) :
+      uiWheelVal) ;
+
+  if (CS10_JOG_THRESHOLD < cs10.iJogCount) {
+    if (cs10.uiMorphSeconds < CS10_MAX_MORPH_SECONDS)
+      cs10.uiMorphSeconds++ ;
+    cs10.iJogCount = 0 ;
+  } else
+  if (-CS10_JOG_THRESHOLD > cs10.iJogCount) {
+    if (cs10.uiMorphSeconds > 1)
+      cs10.uiMorphSeconds-- ;
+    cs10.iJogCount = 0 ;
+  } /* if */
+
+  cs10.bMorphTimeSet = true ;
+
+  cs10_set_led(TENS_DEC_LED_ADDR, LED_OFF_VALUE) ;
+  cs10_set_led(ONES_DEC_LED_ADDR, LED_OFF_VALUE) ;
+  cs10_display_number_dec(cs10.uiMorphSeconds) ;
+} /* cs10_handle_morph_wheel */
+
+/*
+ * cs10_handle_wheel
+ *
+ * issue MMC step commands based on uiWheelVal
+ */
+void
+cs10_handle_wheel(
+  unsigned int uiWheelVal) {
+
+  if (cs10.debug)
+    CS10_LOG("%u\n",
+      uiWheelVal);
+
+  /* holding an F key, the wheel sets how long its scene takes to morph */
+  if (cs10.uiMorphKey) {
+    cs10_handle_morph_wheel(uiWheelVal) ;
+    return ;
+  } /* if */
+
+  /* add to cs10.iJogCount */
+  cs10.iJogCount += (uiWheelVal & 0x40 ?
+      0 - (((~uiWheelVal) & 0x7f) + 1) :
+      uiWheelVal) ;
+
+  if ((CS10_JOG_THRESHOLD < cs10.iJogCount) ||
+      (-CS10_JOG_THRESHOLD > cs10.iJogCount)) {
+    int iStepValue = (cs10.iJogCount / CS10_JOG_DIVISOR) ;
+
+    iStepValue = (iStepValue > 0 ? iStepValue :
+        -iStepValue | 0x40) & 0x7f ;
+
+    cs10_issue_mmc_step_command(iStepValue) ;
+
+    cs10.iJogCount = 0 ;
+  } /* if */
+} /* cs10_handle_wheel */
+
+/*
+ * cs10_receive_sysex
+ *
+ * receive a sysex message from the DAW or whatever
+ * scrape out MTC or whatever
+ */
+void
+cs10_receive_sysex(
+  unsigned int length,
+  unsigned char *data) {
+
+  if ((10 == length) &&
+      (0xf0 == data[0]) &&
+      (0x7f == data[1]) &&
+      (0x01 == data[3]) &&
+      (0x01 == data[4])) {
+
+    /* the rate code rides in the top of the hours */
+    seqlock_write_begin(&cs10.stateLock) ;
+    cs10.tCurrentTime.flags =
+      (data[5] >> 5) & 0x03 ;
+    cs10.tCurrentTime.hours =
+      data[5] & 0x1f ;
+    cs10.tCurrentTime.minutes =
+      data[6] ;
+    cs10.tCurrentTime.seconds =
+      data[7] ;
+    cs10.tCurrentTime.frames =
+      data[8] ;
+    cs10_time_write_end() ;
+
+    CS10_COUNT(FULL_FRAME_TIME_COUNTER) ;
+    cs10_request_refresh(CS10_REFRESH_TIME);
+
+    if (cs10.debug)
+      CS10_LOG("%02d:%02d:%02d:%02d\n",
+        cs10.tCurrentTime.hours,
+        cs10.tCurrentTime.minutes,
+        cs10.tCurrentTime.seconds,
+        cs10.tCurrentTime.frames) ;
+
+  } else /* MTC full frame time */
+  if ((12 <= length) &&
+      (0xf0 == data[0]) &&
+      (0x7f == data[1]) &&
+      (0x06 == data[3]) &&
+      (0x44 == data[4]) &&
+      (0x06 == data[5]) &&
+      (0x01 == data[6])) {
+
+    seqlock_write_begin(&cs10.stateLock) ;
+    cs10.tCurrentTime.flags =
+      (data[7] >> 5) & 0x03 ;
+    cs10.tCurrentTime.hours =
+      data[7] & 0x1f ;
+    cs10.tCurrentTime.minutes =
+      data[8] ;
+    cs10.tCurrentTime.seconds =
+      data[9] ;
+    cs10.tCurrentTime.frames =
+      data[10] ;
+    cs10_time_write_end() ;
+
+    CS10_COUNT(LOCATE_TIME_COUNTER) ;
+    cs10_request_refresh(CS10_REFRESH_TIME);
+
+    if (cs10.debug)
+      CS10_LOG("MMC LOC %02d:%02d:%02d:%02d\n",
+        cs10.tCurrentTime.hours,
+        cs10.tCurrentTime.minutes,
+        cs10.tCurrentTime.seconds,
+        cs10.tCurrentTime.frames) ;
+
+  } else { /* MMC locate */
+    if (cs10.debug) {
+      unsigned int uiBytes[3] = { 0, 0, 0 } ;
+      unsigned int i ;
+
+      /* the log takes ints, so the first nine bytes go three to one */
+      for (i = 0 ; (i < length) && (i < 9) ; i++)
+        uiBytes[i / 3] |= data[i] << (8 * (2 - (i % 3))) ;
+
+      CS10_LOG("sysex %u bytes %06x %06x %06x\n",
+        length, uiBytes[0], uiBytes[1], uiBytes[2]) ;
+    } /* if */
+  } /* else */
+} /* cs10_receive_sysex */
+
+/*
+ * cs10_receive_qframe
+ *
+ * receive qframe slices of time code and re-assemble them
+ */
+void
+cs10_receive_qframe(
+  unsigned char qframe_data) {
+
+  unsigned char ucField = ((qframe_data & 0xf0) >> 4) ;
+  unsigned char ucData = (qframe_data & 0x0f) ;
+
+  if (cs10.debug)
+    CS10_LOG("%x %x\n",
+      ucField, ucData); 
+
+  switch(ucField) {
+    case 0:
+      cs10.tQFTime.frames = (cs10.tQFTime.frames & 0xf0) + ucData ;
+      break ;
+
+    case 1:
+      cs10.tQFTime.frames = (cs10.tQFTime.frames & 0x0f) + (ucData << 4) ;
+      break ;
+
+    case 2:
+      cs10.tQFTime.seconds = (cs10.tQFTime.seconds & 0xf0) + ucData ;
+      break ;
+
+    case 3:
+      cs10.tQFTime.seconds = (cs10.tQFTime.seconds & 0x0f) + (ucData << 4) ;
+      break ;
+
+    case 4:
+      cs10.tQFTime.minutes = (cs10.tQFTime.minutes & 0xf0) + ucData ;
+      break ;
+
+    case 5:
+      cs10.tQFTime.minutes = (cs10.tQFTime.minutes & 0x0f) + (ucData << 4) ;
+      break ;
+
+    case 6:
+      cs10.tQFTime.hours = (cs10.tQFTime.hours & 0xf0) + ucData ;
+      break ;
+
+    case 7:
+      cs10.tQFTime.hours = (cs10.tQFTime.hours & 0x0f) +
+        ((ucData & 0x01) << 4) ;
+      cs10.tQFTime.flags = (ucData >> 1) ;
+      break ;
+  } /* switch */
+
+  cs10.ucQuarterFrameFlags |= 1 << ucField ;
+
+  if (0xff == cs10.ucQuarterFrameFlags) {
+    seqlock_write_begin(&cs10.stateLock) ;
+    cs10.tCurrentTime = cs10.tQFTime ;
+    cs10_time_write_end() ;
+    cs10.ucQuarterFrameFlags = 0 ;
+
+    CS10_COUNT(QFRAME_TIME_COUNTER) ;
+    cs10_request_refresh(CS10_REFRESH_TIME);
+
+    if (cs10.debug)
+      CS10_LOG("%02d:%02d:%02d:%02d\n",
+        cs10.tCurrentTime.hours,
+        cs10.tCurrentTime.minutes,
+        cs10.tCurrentTime.seconds,
+        cs10.tCurrentTime.frames) ;
+
+  } /* if */
+} /* cs10_receive_qframe */
+
+
+/*
+ * cs10_handle_daw_event
+ *
+ * dispatch one event read from mmc-io
+ */
+void
+cs10_handle_daw_event(
+  snd_seq_event_t *pNewEvent) {
+
+  if (SND_SEQ_EVENT_PORT_SUBSCRIBED == pNewEvent->type) {
+    cs10_request_refresh(CS10_REFRESH_MODE) ;
+    return ;
+  } /* if */
+
+  if (pNewEvent->dest.port == cs10.iMMCPortID) {
+    if (SND_SEQ_EVENT_SYSEX == pNewEvent->type) {
+      CS10_COUNT(DAW_SYSEX_IN_COUNTER) ;
+      cs10_receive_sysex(pNewEvent->data.ext.len,
+                        (unsigned char*)pNewEvent->data.ext.ptr);
+    } else /* SND_SEQ_EVENT_SYSEX */
+    if (SND_SEQ_EVENT_QFRAME == pNewEvent->type) {
+      CS10_COUNT(DAW_QFRAME_IN_COUNTER) ;
+      cs10_receive_qframe(pNewEvent->data.control.value);
+    } else /* SND_SEQ_EVENT_QFRAME */
+    if (SND_SEQ_EVENT_CONTROLLER == pNewEvent->type) {
+      unsigned int            event_track ;
+      virtual_track_control_t event_control ;
+
+      CS10_COUNT(DAW_CONTROL_IN_COUNTER) ;
+
+      if (cs10_map_from_cc(cs10_current_map(),
+                           pNewEvent->data.control.channel,
+                           pNewEvent->data.control.param,
+                           &event_track, &event_control) &&
+          (event_track < CS10_NUM_VIRTUAL_TRACKS)) {
+        /* our own fader and knob values coming back, nothing to do */
+        if ((event_control >= FADER_CONTROL) &&
+            cs10_echo_is_ours(pNewEvent->data.control.channel,
+                              pNewEvent->data.control.param,
+                              pNewEvent->data.control.value))
+          return ;
+
+        cs10_receive_virtual_control(event_track, 
+          event_control, pNewEvent->data.control.value) ;
+      } /* if */
+    } else /* SND_SEQ_EVENT_CONTROLLER */
+      CS10_COUNT(DAW_OTHER_IN_COUNTER) ;
+  } /* iMMCPortID */
+} /* cs10_handle_daw_event */
+
+/*
+ * cs10_daw_thread
+ *
+ * read feedback, time code and sysex from the daw on mmc-io so that
+ * a flood of feedback never queues up behind, or in front of,
+ * the surface
+ */
+void *
+cs10_daw_thread(
+  void *pArg) {
+
+  snd_seq_event_t *pNewEvent ;
+  struct pollfd   *pFDs ;
+  int              iFDs ;
+  int              iResult ;
+  sigset_t         sigs ;
+
+  (void) pArg ;
+
+  /* SIGTERM and SIGUSR1 go to the surface thread, which can stop this one */
+  sigemptyset(&sigs) ;
+  sigaddset(&sigs, SIGTERM) ;
+  sigaddset(&sigs, SIGUSR1) ;
+  pthread_sigmask(SIG_BLOCK, &sigs, NULL) ;
+
+  /* pSeq is non-blocking for the sake of output, so wait in poll,
+   * with the stop request after its descriptors
+   */
+  iFDs = snd_seq_poll_descriptors_count(cs10.pSeq, POLLIN) ;
+  pFDs = calloc(iFDs + 1, sizeof(struct pollfd)) ;
+
+  /* without this thread there is no feedback, so the daemon goes too,
+   * through SIGTERM to the surface thread like any other shutdown
+   */
+  if (NULL == pFDs) {
+    fprintf(stderr, "daw thread out of memory, exiting\n") ;
+    kill(getpid(), SIGTERM) ;
+    return NULL ;
+  } /* if */
+
+  snd_seq_poll_descriptors(cs10.pSeq, pFDs, iFDs, POLLIN) ;
+  pFDs[iFDs].fd = cs10.iDAWStopFD ;
+  pFDs[iFDs].events = POLLIN ;
+
+  CS10_TRACE_THREAD("daw") ;
+  cs10_stats_thread("daw") ;
+
+  for (;;) {
+    __atomic_store_n(&cs10.uiDAWMapGeneration, CS10_DAW_MAP_IDLE,
+                     __ATOMIC_SEQ_CST) ;
+
+    CS10_TRACE_BEGIN("poll") ;
+    iResult = poll(pFDs, iFDs + 1, -1) ;
+    CS10_TRACE_END("poll") ;
+
+    cs10_daw_map_seen() ;
+
+    if (iResult < 0) {
+      if (EINTR == errno)
+        continue ;
+
+      fprintf(stderr, "daw thread poll failed: %s, exiting\n",
+              strerror(errno)) ;
+      kill(getpid(), SIGTERM) ;
+      break ;
+    } /* if */
+
+    if (pFDs[iFDs].revents & POLLIN)
+      break ;
+
+    while ((iResult = snd_seq_event_input(cs10.pSeq, &pNewEvent)) != -EAGAIN) {
+      if (iResult >= 0) {
+        CS10_TRACE_BEGIN("daw event") ;
+        cs10_handle_daw_event(pNewEvent) ;
+        CS10_TRACE_END("daw event") ;
+        cs10_daw_map_seen() ;
+      } else
+      if (-ENOSPC != iResult)
+        break ; /* -ENOSPC, input overran, carry on with what's coming */
+    } /* while */
+  } /* for */
+
+  free(pFDs) ;
+
+  return NULL ;
+} /* cs10_daw_thread */
+
+/*
+ * cs10_handle_refresh
+ *
+ * catch the surface LEDs up with whatever the daw thread changed
+ */
+void
+cs10_handle_refresh(void) {
+
+  uint64_t     ullWake ;
+  unsigned int uiFlags ;
+
+  CS10_TRACE_BEGIN("refresh") ;
+
+  read(cs10.iWakeFD, &ullWake, sizeof(ullWake)) ;
+  uiFlags = __atomic_exchange_n(&cs10.uiRefreshFlags, 0, __ATOMIC_ACQUIRE) ;
+
+  if (uiFlags & CS10_REFRESH_TRACKS) {
+    uint32_t uiDirty = __atomic_exchange_n(&cs10.uiDirtyTracks, 0,
+                                           __ATOMIC_ACQUIRE) ;
+
+    /* a full mode refresh covers the tracks too */
+    if (!(uiFlags & CS10_REFRESH_MODE))
+      cs10_refresh_track_leds(uiDirty) ;
+  } /* if */
+
+  if (uiFlags & CS10_REFRESH_MODE)
+    cs10_set_mode(cs10.theMode) ;
+
+  if (uiFlags & CS10_REFRESH_TIME) {
+    cs10_update_display_time() ;
+    cs10_automation_follow() ;
+  } /* if */
+
+  CS10_TRACE_END("refresh") ;
+} /* cs10_handle_refresh */
+
+/*
+ * cs10_handle_surface_control
+ *
+ * dispatch one controller move from the surface
+ */
+void
+cs10_handle_surface_control(
+  unsigned int uiParam,
+  int iValue) {
+
+  if ((FIRST_BUTTON_ADDR <= uiParam) && (LAST_BUTTON_ADDR >= uiParam))
+    cs10_handle_button(uiParam, iValue) ;
+  else
+  if ((FIRST_FADER_ADDR <= uiParam) && (LAST_FADER_ADDR >= uiParam)) {
+    cs10_handle_fader(uiParam, iValue) ;
+  } else
+  if ((FIRST_KNOB_ADDR <= uiParam) && (LAST_KNOB_ADDR >= uiParam)) {
+    cs10_handle_knob(uiParam, iValue) ;
+  } else
+  if (WHEEL_ADDR == uiParam) {
+    cs10_handle_wheel(iValue) ;
+  } /* WHEEL_ADDR */
+} /* cs10_handle_surface_control */
+
+/*
+ * cs10_resync_surface
+ *
+ * bring a surface that may be showing anything up to date, in one batch
+ */
+void
+cs10_resync_surface(void) {
+
+  cs10_led_batch_begin() ;
+
+  cs10_forget_leds() ;
+  cs10_set_mode(cs10.theMode) ;
+
+  if (cs10.displayMode == BANK_DISPLAY_MODE)
+    cs10_display_bank() ;
+  else
+    cs10_display_time() ;
+
+  cs10_led_batch_end() ;
+} /* cs10_resync_surface */
+
+/*
+ * cs10_port_names
+ *
+ * look up the client and port names of iClient:iPort
+ * return false if the port doesn't exist or can't carry the surface
+ */
+bool
+cs10_port_names(
+  int iClient,
+  int iPort,
+  char *pClientName,
+  char *pPortName) {
+
+  snd_seq_client_info_t *pClientInfo ;
+  snd_seq_port_info_t   *pPortInfo ;
+  unsigned int           uiNeeded = SND_SEQ_PORT_CAP_READ |
+                                    SND_SEQ_PORT_CAP_WRITE |
+                                    SND_SEQ_PORT_CAP_SUBS_READ |
+                                    SND_SEQ_PORT_CAP_SUBS_WRITE ;
+
+  snd_seq_client_info_alloca(&pClientInfo) ;
+  snd_seq_port_info_alloca(&pPortInfo) ;
+
+  if ((0 > snd_seq_get_any_client_info(cs10.pSurfaceSeq, iClient,
+                                       pClientInfo)) ||
+      (0 > snd_seq_get_any_port_info(cs10.pSurfaceSeq, iClient, iPort,
+                                     pPortInfo)) ||
+      (uiNeeded != (snd_seq_port_info_get_capability(pPortInfo) & uiNeeded)))
+    return false ;
+
+  snprintf(pClientName, CS10_NAME_LENGTH, "%s",
+           snd_seq_client_info_get_name(pClientInfo)) ;
+  snprintf(pPortName, CS10_NAME_LENGTH, "%s",
+           snd_seq_port_info_get_name(pPortInfo)) ;
+
+  return true ;
+} /* cs10_port_names */
+
+/*
+ * cs10_is_interface
+ *
+ * is iClient:iPort the hardware interface
+ */
+bool
+cs10_is_interface(
+  int iClient,
+  int iPort) {
+
+  char  cClient[CS10_NAME_LENGTH] ;
+  char  cPort[CS10_NAME_LENGTH] ;
+  char  cPattern[2 * CS10_NAME_LENGTH] ;
+  char *pPortPattern ;
+
+  if ((iClient == cs10.iClientID) || (iClient == cs10.iSurfaceClientID) ||
+      !cs10_port_names(iClient, iPort, cClient, cPort))
+    return false ;
+
+  if (cs10.port_pattern) {
+    /* client pattern, then optionally :port pattern */
+    snprintf(cPattern, sizeof(cPattern), "%s", cs10.port_pattern) ;
+    pPortPattern = strrchr(cPattern, ':') ;
+
+    if (pPortPattern)
+      *pPortPattern++ = '\0' ;
+
+    return ((0 == fnmatch(cPattern, cClient, 0)) &&
+            ((NULL == pPortPattern) || (0 == fnmatch(pPortPattern, cPort, 0)))) ;
+  } /* if */
+
+  if (cs10.cInterfaceClient[0])
+    return ((0 == strcmp(cClient, cs10.cInterfaceClient)) &&
+            (0 == strcmp(cPort, cs10.cInterfacePort))) ;
+
+  return (cs10.hw_seq_client && (iClient == cs10.hw_seq_client) &&
+          (iPort == cs10.hw_seq_port)) ;
+} /* cs10_is_interface */
+
+/*
+ * cs10_link_interface
+ *
+ * connect cs10-io both ways with the interface at iClient:iPort
+ * the resync happens when the subscription is announced
+ */
+bool
+cs10_link_interface(
+  int iClient,
+  int iPort) {
+
+  if (cs10.debug)
+    fprintf(stderr, "link to %d:%d\n", iClient, iPort) ;
+
+  if ((0 > snd_seq_connect_to(cs10.pSurfaceSeq, cs10.iControlPortID,
+                              iClient, iPort)) ||
+      (0 > snd_seq_connect_from(cs10.pSurfaceSeq, cs10.iControlPortID,
+                                iClient, iPort))) {
+    fprintf(stderr, "can't link to %d:%d\n", iClient, iPort) ;
+    return false ;
+  } /* if */
+
+  /* from now on it's known by name, wherever it turns up */
+  if (!cs10.port_pattern)
+    cs10_port_names(iClient, iPort,
+                    cs10.cInterfaceClient, cs10.cInterfacePort) ;
+
+  cs10.iLinkedClient = iClient ;
+  cs10.iLinkedPort = iPort ;
+
+  return true ;
+} /* cs10_link_interface */
+
+/*
+ * cs10_find_interface
+ *
+ * look through every port for the interface and link to the first found
+ */
+bool
+cs10_find_interface(void) {
+
+  snd_seq_client_info_t *pClientInfo ;
+  snd_seq_port_info_t   *pPortInfo ;
+
+  snd_seq_client_info_alloca(&pClientInfo) ;
+  snd_seq_port_info_alloca(&pPortInfo) ;
+
+  snd_seq_client_info_set_client(pClientInfo, -1) ;
+
+  while (0 <= snd_seq_query_next_client(cs10.pSurfaceSeq, pClientInfo)) {
+    int iClient = snd_seq_client_info_get_client(pClientInfo) ;
+
+    snd_seq_port_info_set_client(pPortInfo, iClient) ;
+    snd_seq_port_info_set_port(pPortInfo, -1) ;
+
+    while (0 <= snd_seq_query_next_port(cs10.pSurfaceSeq, pPortInfo)) {
+      int iPort = snd_seq_port_info_get_port(pPortInfo) ;
+
+      if (cs10_is_interface(iClient, iPort))
+        return cs10_link_interface(iClient, iPort) ;
+    } /* while */
+  } /* while */
+
+  return false ;
+} /* cs10_find_interface */
+
+/*
+ * cs10_handle_announce
+ *
+ * follow the interface as it comes and goes, and bring anything newly
+ * listening to cs10-io up to date
+ */
+void
+cs10_handle_announce(
+  snd_seq_event_t *pNewEvent) {
+
+  snd_seq_addr_t *pAddr = &pNewEvent->data.addr ;
+
+  switch (pNewEvent->type) {
+    case SND_SEQ_EVENT_PORT_START:
+      if ((0 > cs10.iLinkedClient) &&
+          (cs10.port_pattern || cs10.hw_seq_client) &&
+          cs10_is_interface(pAddr->client, pAddr->port))
+        cs10_link_interface(pAddr->client, pAddr->port) ;
+      break ;
+
+    case SND_SEQ_EVENT_PORT_EXIT:
+    case SND_SEQ_EVENT_CLIENT_EXIT:
+      if ((pAddr->client == cs10.iLinkedClient) &&
+          ((SND_SEQ_EVENT_CLIENT_EXIT == pNewEvent->type) ||
+           (pAddr->port == cs10.iLinkedPort))) {
+        if (cs10.debug)
+          fprintf(stderr, "lost %d:%d\n", cs10.iLinkedClient,
+                  cs10.iLinkedPort) ;
+
+        /* the sequencer drops the subscriptions along with the port */
+        cs10.iLinkedClient = -1 ;
+        cs10.iLinkedPort = -1 ;
+      } /* if */
+      break ;
+
+    case SND_SEQ_EVENT_PORT_SUBSCRIBED:
+      /* something new is listening to cs10-io.
+       * links made at startup were brought up to date by main, from the
+       * journal's LED shadow on a warm start, anything linked since may
+       * be showing anything
+       */
+      if ((pNewEvent->data.connect.sender.client == cs10.iSurfaceClientID) &&
+          (pNewEvent->data.connect.sender.port == cs10.iControlPortID) &&
+          !cs10.bStartup)
+        cs10_resync_surface() ;
+      break ;
+
+    default:
+      break ;
+  } /* switch */
+} /* cs10_handle_announce */
+
+/*
+ * cs10_handle_surface_event
+ *
+ * dispatch one event read from cs10-io
+ */
+void
+cs10_handle_surface_event(
+  snd_seq_event_t *pNewEvent) {
+
+  if (pNewEvent->dest.port == cs10.iAnnouncePortID) {
+    cs10_handle_announce(pNewEvent) ;
+    return ;
+  } /* if */
+
+  if (pNewEvent->dest.port == cs10.iControlPortID) {
+    if (SND_SEQ_EVENT_CONTROLLER == pNewEvent->type) {
+      CS10_COUNT(SURFACE_CONTROL_IN_COUNTER) ;
+      cs10_handle_surface_control(pNewEvent->data.control.param,
+                                  pNewEvent->data.control.value) ;
+    } else { 
+      /* pass on any non-controller events */
+      CS10_COUNT(SURFACE_OTHER_IN_COUNTER) ;
+      cs10_output_queue(INTERACTIVE_LANE, pNewEvent) ;
+    } /* if controller */
+  } /* if msg to cs10 */
+} /* cs10_handle_surface_event */
+
+/*
+ * cs10_handle_surface_message
+ *
+ * dispatch one message parsed off the rawmidi link
+ * controllers drive the surface, channel messages and sysex are passed on
+ * to the daw as they would be from cs10-io
+ */
+void
+cs10_handle_surface_message(
+  const cs10_midi_message_t *pMessage) {
+
+  snd_seq_event_t theEvent ;
+  unsigned char   ucChannel = MIDI_STATUS_CHANNEL(pMessage->ucStatus) ;
+
+  snd_seq_ev_clear(&theEvent) ;
+
+  switch (MIDI_STATUS_TYPE(pMessage->ucStatus)) {
+    case MIDI_CONTROLLER:
+      CS10_COUNT(SURFACE_CONTROL_IN_COUNTER) ;
+      cs10_handle_surface_control(pMessage->ucData1, pMessage->ucData2) ;
+      return ;
+
+    case MIDI_NOTE_OFF:
+      snd_seq_ev_set_noteoff(&theEvent, ucChannel,
+                             pMessage->ucData1, pMessage->ucData2) ;
+      break ;
+
+    case MIDI_NOTE_ON:
+      snd_seq_ev_set_noteon(&theEvent, ucChannel,
+                            pMessage->ucData1, pMessage->ucData2) ;
+      break ;
+
+    case MIDI_KEY_PRESSURE:
+      snd_seq_ev_set_keypress(&theEvent, ucChannel,
+                              pMessage->ucData1, pMessage->ucData2) ;
+      break ;
+
+    case MIDI_PROGRAM_CHANGE:
+      snd_seq_ev_set_pgmchange(&theEvent, ucChannel, pMessage->ucData1) ;
+      break ;
+
+    case MIDI_CHAN_PRESSURE:
+      snd_seq_ev_set_chanpress(&theEvent, ucChannel, pMessage->ucData1) ;
+      break ;
+
+    case MIDI_PITCH_BEND:
+      snd_seq_ev_set_pitchbend(&theEvent, ucChannel,
+        ((pMessage->ucData2 << 7) | pMessage->ucData1) - 8192) ;
+      break ;
+
+    default:
+      if (MIDI_SYSEX_START != pMessage->ucStatus)
+        return ; /* real time and system common stay on the wire */
+
+      snd_seq_ev_set_sysex(&theEvent, pMessage->uiSysexLength,
+                           (void *)pMessage->pSysex) ;
+      break ;
+  } /* switch */
+
+  CS10_COUNT(SURFACE_OTHER_IN_COUNTER) ;
+  cs10_output_queue(INTERACTIVE_LANE, &theEvent) ;
+} /* cs10_handle_surface_message */
+
+/*
+ * cs10_read_rawmidi
+ *
+ * take everything the rawmidi device has for us and parse it
+ */
+void
+cs10_read_rawmidi(void) {
+
+  unsigned char       ucBuffer[256] ;
+  cs10_midi_message_t theMessage ;
+  ssize_t             iRead ;
+  ssize_t             iByte ;
+
+  while ((iRead = snd_rawmidi_read(cs10.pRawIn, ucBuffer,
+                                   sizeof(ucBuffer))) > 0) {
+    for (iByte = 0 ; iByte < iRead ; iByte++) {
+      if (cs10_midi_parse_byte(&cs10.surfaceParser, ucBuffer[iByte],
+                               &theMessage)) {
+        CS10_TRACE_BEGIN("surface message") ;
+        cs10_handle_surface_message(&theMessage) ;
+        CS10_TRACE_END("surface message") ;
+      } /* if */
+    } /* for */
+  } /* while */
+} /* cs10_read_rawmidi */
+
+/*
+ * cs10_get_local_data_file
+ *
+ * wrangle whatever environment variables to get a path to the local data file
+ */
+void
+cs10_get_local_data_file() {
+  char *datadir = getenv("XDG_DATA_HOME");
+
+  if (datadir == NULL) {
+    char *homedir = getenv("HOME");
+    int   data_path_len = 0;
+
+    if (homedir == NULL) {
+      homedir = getpwuid(getuid())->pw_dir;
+    } /* if */
+
+    if (homedir == NULL)
+      return;
+
+    data_path_len = strlen(homedir) +
+      strlen(CS10_DEFAULT_SETTINGS_PATH) +
+      strlen(CS10_DEFAULT_SETTINGS_FILENAME) + 1;
+
+    cs10.settings_filename = malloc(data_path_len);
+
+    if (cs10.settings_filename) {
+      strcpy(cs10.settings_filename, homedir);
+      strcat(cs10.settings_filename, CS10_DEFAULT_SETTINGS_PATH);
+
+      mkdir(cs10.settings_filename, 0700);
+
+      strcat(cs10.settings_filename, CS10_DEFAULT_SETTINGS_FILENAME);
+    } /* if */
+  } else {
+    int data_path_len = strlen(datadir) +
+      strlen(CS10_DEFAULT_SETTINGS_DIR) +
+      strlen(CS10_DEFAULT_SETTINGS_FILENAME) + 1;
+
+    cs10.settings_filename = malloc(data_path_len);
+
+    if (cs10.settings_filename) {
+      strcpy(cs10.settings_filename, datadir);
+      strcat(cs10.settings_filename, CS10_DEFAULT_SETTINGS_DIR);
+
+      mkdir(cs10.settings_filename, 0700);
+
+      strcat(cs10.settings_filename, CS10_DEFAULT_SETTINGS_FILENAME);
+    } /* if */
+  } /* else */
+} /* cs10_get_local_data_file */
+
+static struct option long_opts[] = {
+  { "verbose", no_argument, NULL, 'v'},
+  { "pickup", no_argument, NULL, 'k'},
+  { "file", required_argument, NULL, 'f'},
+  { "port", required_argument, NULL, 'p'},
+  { "rawmidi", required_argument, NULL, 'r'},
+  { "osc", required_argument, NULL, 'u'},
+  { "map", required_argument, NULL, 'm'},
+  { "config", required_argument, NULL, 'c'},
+  { "journal", required_argument, NULL, 'j'},
+  { "automation", required_argument, NULL, 'a'},
+  { "trace", required_argument, NULL, 't'},
+  { "stats", required_argument, NULL, 's'},
+  { "control", required_argument, NULL, 'C'},
+  { "shm", required_argument, NULL, 'S'},
+  { "macros", required_argument, NULL, 'M'},
+  { "targets", required_argument, NULL, 'T'},
+  { "deadband", required_argument, NULL, 'd'},
+  { "interval", required_argument, NULL, 'i'},
+  { "output-pool", required_argument, NULL, 'o'},
+  { "output-buffer", required_argument, NULL, 'b'},
+  { "help", no_argument, NULL, 'h'},
+  { NULL, 0, NULL, 0 }
+};
+
+void
+cs10_help_exit(
+  int argc,
+  char** argv) {
+
+  fprintf(stderr, "%s options:\n", argv[0]);
+  fprintf(stderr, "  --file, -f [path] to persistent data file\n");
+  fprintf(stderr, "  --port, -p [client:port] of midi hardware interface, or a\n");
+  fprintf(stderr, "             client name pattern with an optional :port name pattern\n");
+  fprintf(stderr, "  --rawmidi, -r [hw:X,Y] talk to the surface through this rawmidi device\n");
+  fprintf(stderr, "  --osc, -u [host:port] send mixer controls to ardour as osc\n");
+  fprintf(stderr, "  --map, -m [path] to ardour .map or native mapping file\n");
+  fprintf(stderr, "  --config, -c [path] to config file, reloaded when it changes\n");
+  fprintf(stderr, "  --journal, -j [path] to live state journal, for warm restarts\n");
+  fprintf(stderr, "  --automation, -a [path] to fader automation recorded against mtc\n");
+  fprintf(stderr, "  --trace, -t [path] to chrome trace json written on exit,\n");
+  fprintf(stderr, "             if built with make TRACE=1\n");
+  fprintf(stderr, "  --stats, -s [path] to prometheus text file of counters\n");
+  fprintf(stderr, "  --control, -C [path] to unix domain control socket\n");
+  fprintf(stderr, "  --shm, -S [name] of shared memory to mirror the live state in,\n");
+  fprintf(stderr, "             e.g. " CS10_SHM_DEFAULT_NAME "\n");
+  fprintf(stderr, "  --macros, -M [path] to button macros file\n");
+  fprintf(stderr, "  --targets, -T [path] to file of extra ports to follow the surface\n");
+  fprintf(stderr, "  --deadband, -d [fader[,knob]] steps a control must turn back to count\n");
+  fprintf(stderr, "  --interval, -i [ms] least time between values sent for one control\n");
+  fprintf(stderr, "  --output-pool, -o [events] sequencer client output pool size\n");
+  fprintf(stderr, "  --output-buffer, -b [bytes] sequencer output buffer size\n");
+  fprintf(stderr, "  --pickup, -k only let faders and knobs take over once they\n");
+  fprintf(stderr, "             reach the value they'd be changing\n");
+  fprintf(stderr, "  --verbose, -v print debug information\n");
+  fprintf(stderr, "  --help, -h show this help and exit\n");
+  exit(0);
+} /* cs10_help_exit */
+
+/*
+ * cs10_replace_string
+ *
+ * point *ppString at a copy of pValue
+ * return true if that changed anything
+ */
+bool
+cs10_replace_string(
+  char **ppString,
+  const char *pValue) {
+
+  if (*ppString && pValue && (0 == strcmp(*ppString, pValue)))
+    return false ;
+
+  free(*ppString) ;
+  *ppString = (pValue ? strdup(pValue) : NULL) ;
+
+  return true ;
+} /* cs10_replace_string */
+
+/*
+ * cs10_option_flag
+ *
+ * a switch given on the command line is on, in the config file it's on
+ * unless it says otherwise
+ */
+bool
+cs10_option_flag(
+  const char *pArg) {
+
+  return !(pArg &&
+           ((0 == strcmp(pArg, "0")) ||
+            (0 == strcmp(pArg, "no")) ||
+            (0 == strcmp(pArg, "false"))));
+} /* cs10_option_flag */
+
+/*
+ * cs10_set_option
+ *
+ * apply one option, from the command line or the config file
+ * note what changed in uiConfigChanges
+ * return false if pArg makes no sense
+ */
+bool
+cs10_set_option(
+  int iOption,
+  const char *pArg) {
+
+  switch (iOption) {
+    case 'v':
+      /* verbose = true, unless the config file says otherwise */
+      cs10.debug = cs10_option_flag(pArg);
+      break;
 
-#if CS10_TOGGLE_BUTTONS
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          MUTE_CONTROL,
-          (cs10.csState.
-             tsTrack[
-               cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-               BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bMute ?
-             BUTTON_DOWN_VALUE : BUTTON_UP_VALUE)) ;
-#else
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          MUTE_CONTROL, BUTTON_DOWN_VALUE);
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          MUTE_CONTROL, BUTTON_UP_VALUE);
-#endif
+    case 'k':
+      /* soft takeover = true, unless the config file says otherwise */
+      cs10.bPickup = cs10_option_flag(pArg);
+      break;
 
-        cs10_set_led(TRACK_TO_LED_ADDR(BUTTON_ADDR_TO_TRACK(uiButtonAddr)),
-         (cs10.csState.
-          tsTrack[
-            cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-            BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bMute ?
-          LED_ON_VALUE : LED_OFF_VALUE)) ;
-        break ;
+    case 'f':
+      /* filename = pArg */
+      if (cs10_replace_string(&cs10.settings_filename, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_SETTINGS;
+      break;
 
-      case SOLO_MODE:
-        cs10.csState.tsTrack[
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bSolo =
-          (cs10.csState.
-           tsTrack[
-             cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-             BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bSolo == 0) ;
+    case 'p':
+      /* midi port = pArg */
+      {
+        const char *startptr;
+        char *nextptr;
+        unsigned long client_id = strtoul(pArg, &nextptr, 10);
+        unsigned long port_id = 0;
+
+        if ((nextptr != pArg) && (*nextptr == ':')) {
+          startptr = nextptr + 1;
+          port_id = strtoul(startptr, &nextptr, 10);
+        } /* if */
+
+        /* anything but client:port numbers is a name pattern */
+        if ((nextptr == pArg) || (*nextptr != '\0')) {
+          if (cs10_replace_string(&cs10.port_pattern, pArg))
+            cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
+          if (cs10.debug)
+            fprintf(stderr, "hw midi port matching %s\n", pArg);
+          break;
+        } /* if */
 
-#if CS10_TOGGLE_BUTTONS
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          SOLO_CONTROL,
-          (cs10.csState.
-             tsTrack[
-               cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-               BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bSolo ?
-             BUTTON_DOWN_VALUE : BUTTON_UP_VALUE)) ;
-#else
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          SOLO_CONTROL, BUTTON_DOWN_VALUE);
-        cs10_issue_virtual_control(
-          cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-          BUTTON_ADDR_TO_TRACK(uiButtonAddr),
-          SOLO_CONTROL, BUTTON_UP_VALUE);
-#endif
+        if ((cs10.hw_seq_client != client_id) ||
+            (cs10.hw_seq_port != port_id))
+          cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
 
-        cs10_set_led(TRACK_TO_LED_ADDR(BUTTON_ADDR_TO_TRACK(uiButtonAddr)),
-         (cs10.csState.
-          tsTrack[
-            cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS + 
-            BUTTON_ADDR_TO_TRACK(uiButtonAddr)].bSolo ?
-          LED_ON_VALUE : LED_OFF_VALUE)) ;
-        break ;
+        cs10.hw_seq_client = client_id; 
+        cs10.hw_seq_port = port_id; 
+        if (cs10.debug)
+          fprintf(stderr, "hw midi port %ld:%ld\n", client_id, port_id);
+      }
+      break;
 
-      default: 
-        break ;
-    } /* switch */
-  } else
-  if ((F1_BUTTON_ADDR <= uiButtonAddr) &&
-     (F9_BUTTON_ADDR >= uiButtonAddr)) {
-    if (cs10.bShiftKeyDown) {
-      /* save/restore position */
-      if (cs10.bRecordKeyDown) {
-        cs10.bIgnoreRecordKeyUp = true ;
-        cs10.tSavedPosition[uiButtonAddr - F1_BUTTON_ADDR] =
-          cs10.tCurrentTime ;
-        cs10_save_settings();
-      } else {
-        cs10_issue_mmc_goto_command(
-            cs10.tSavedPosition[uiButtonAddr - F1_BUTTON_ADDR]) ;
-      } /* !bRecordKeyDown */
-    } else {
-      /* save/restore fader settings */
-      if (cs10.bRecordKeyDown) {
-        cs10.bIgnoreRecordKeyUp = true ;
-        memcpy(&cs10.csSavedState[uiButtonAddr - F1_BUTTON_ADDR],
-               &cs10.csState, sizeof(cs10_mixer_state_t));
-        cs10_save_settings();
-      } else {
-        /* send state out over midi seq */
-        cs10_issue_control_state(
-          &cs10.csSavedState[uiButtonAddr - F1_BUTTON_ADDR]);
-        memcpy(&cs10.csState,
-               &cs10.csSavedState[uiButtonAddr - F1_BUTTON_ADDR],
-               sizeof(cs10_mixer_state_t));
-        cs10_display_bank();
-      } /* !bRecordKeyDown */
-    } /* !bShiftKeyDown */
-  } else
-  switch (uiButtonAddr) {
-    case SHIFT_BUTTON_ADDR:
-      cs10.bShiftKeyDown = (BUTTON_DOWN_VALUE == uiButtonVal) ;
-      break ;
+    case 'r':
+      /* rawmidi device = pArg */
+      if (cs10_replace_string(&cs10.rawmidi_name, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
+      break;
 
-    case REW_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal)
-        if (cs10.bShiftKeyDown) {
-          smpte_time_t tZero = {0, 0, 0, 0, 0} ;
+    case 'u':
+      /* osc destination = pArg */
+      if (cs10_replace_string(&cs10.osc_target, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_OSC;
+      break;
 
-          cs10_issue_mmc_goto_command(tZero) ;
-        } else
-          cs10_issue_mmc_command(MMC_COMMAND_REW) ;
-      break ;
+    case 'm':
+      /* mapping file = pArg */
+      if (cs10_replace_string(&cs10.map_filename, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_MAP;
+      break;
 
-    case FF_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal)
-        cs10_issue_mmc_command(MMC_COMMAND_FF) ;
+    case 'j':
+      /* journal file = pArg */
+      if (cs10_replace_string(&cs10.journal_filename, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
       break;
 
-    case STOP_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal)
-        cs10_issue_mmc_command(MMC_COMMAND_STOP) ;
-      break ;
+    case 'a':
+      /* automation file = pArg */
+      if (cs10_replace_string(&cs10.automation_filename, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
+      break;
 
-    case PLAY_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal) {
-        if (cs10.bShiftKeyDown)
-          cs10_issue_mmc_goto_command(cs10.tPlayFromTime) ;
-        else {
-          cs10.tPlayFromTime = cs10.tCurrentTime ;
-          cs10_issue_mmc_command(MMC_COMMAND_PLAY) ;
-        } /* !bShiftKeyDown */
-      } /* BUTTON_UP_VALUE */
-      break ;
+    case 't':
+      /* trace file = pArg */
+      if (cs10_replace_string(&cs10.trace_filename, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
+      break;
 
-    case RECORD_BUTTON_ADDR:
-      cs10.bRecordKeyDown = (BUTTON_DOWN_VALUE == uiButtonVal) ;
+    case 's':
+      /* stats file = pArg */
+      if (cs10_replace_string(&cs10.stats_filename, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
+      break;
 
-      if (!cs10.bRecordKeyDown) {
-        if (cs10.bIgnoreRecordKeyUp)
-          cs10.bIgnoreRecordKeyUp = false ;
-        else {
-          if (cs10.bShiftKeyDown)
-            cs10_issue_mmc_goto_command(cs10.tRecordFromTime) ;
-          else {
-            cs10.tRecordFromTime = cs10.tCurrentTime ;
-            cs10_issue_mmc_command(MMC_COMMAND_REC_PAUSE) ;
-          } /* !bShiftKeyDown */
-        } /* !bIgnoreRecordKeyUp */
-      } /* !bRecordKeyDown */
-      break ;
+    case 'C':
+      /* control socket = pArg */
+      if (cs10_replace_string(&cs10.control_path, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
+      break;
 
-    case MODE_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal) {
-        if (NUM_MODES == ++cs10.theMode)
-          cs10.theMode = SELECT_MODE ;
+    case 'S':
+      /* shared memory name = pArg */
+      if (cs10_replace_string(&cs10.shm_name, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
+      break;
 
-        cs10_set_mode(cs10.theMode) ;
-      } /* if */
-      break ;
+    case 'M':
+      /* macros file = pArg */
+      if (cs10_replace_string(&cs10.macro_filename, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
+      break;
 
-    case RIGHT_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal) {
-        if (cs10.displayMode == BANK_DISPLAY_MODE) {
-          if (++cs10.uiBank >= CS10_NUM_BANKS)
-            cs10.uiBank = 0;
-          cs10_display_bank();
-          cs10_set_mode(cs10.theMode) ;
-        } else {
-          if (++cs10.smpteDisplayMode >= NUM_SMPTE_DISPLAY_MODES)
-            cs10.smpteDisplayMode = 0;
-          cs10_display_time();
-        } /* else */
-      } /* if */
+    case 'T':
+      /* targets file = pArg */
+      if (cs10_replace_string(&cs10.targets_filename, pArg))
+        cs10.uiConfigChanges |= CS10_CHANGED_RESTART;
       break;
 
-    case LEFT_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal) {
-        if (cs10.displayMode == BANK_DISPLAY_MODE) {
-          if (cs10.uiBank-- == 0)
-            cs10.uiBank = CS10_NUM_BANKS - 1;
-          cs10_display_bank();
-          cs10_set_mode(cs10.theMode) ;
-        } else {
-          if (cs10.smpteDisplayMode-- == 0)
-            cs10.smpteDisplayMode = NUM_SMPTE_DISPLAY_MODES - 1;
-          cs10_display_time();
-        } /* else */
-      } /* if */
+    case 'c':
+      /* config file = pArg */
+      cs10_replace_string(&cs10.config_filename, pArg);
       break;
 
-    case UP_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal) {
-        if (++cs10.displayMode == NUM_DISPLAY_MODES)
-          cs10.displayMode = 0;
+    case 'd':
+      /* fader and knob deadband = pArg */
+      {
+        char *nextptr;
 
-        if (cs10.displayMode == BANK_DISPLAY_MODE) {
-          cs10_set_led(TENS_DEC_LED_ADDR, LED_OFF_VALUE);
-          cs10_set_led(ONES_DEC_LED_ADDR, LED_OFF_VALUE);
-          cs10_display_bank();
-        } else {
-          cs10_display_time();
-        } /* else */
-      } /* if */
+        cs10.uiFaderDeadband = strtoul(pArg, &nextptr, 10);
+        cs10.uiKnobDeadband = cs10.uiFaderDeadband;
+
+        if (nextptr == pArg)
+          return false;
+
+        if (*nextptr == ',')
+          cs10.uiKnobDeadband = strtoul(nextptr + 1, NULL, 10);
+      }
       break;
 
-    case DOWN_BUTTON_ADDR:
-      if (BUTTON_UP_VALUE == uiButtonVal) {
-        if (cs10.displayMode-- == 0)
-          cs10.displayMode = NUM_DISPLAY_MODES - 1;
+    case 'i':
+      /* per control output interval = pArg */
+      cs10.uiControlInterval = strtoul(pArg, NULL, 10);
+      break;
 
-        if (cs10.displayMode == BANK_DISPLAY_MODE) {
-          cs10_set_led(TENS_DEC_LED_ADDR, LED_OFF_VALUE);
-          cs10_set_led(ONES_DEC_LED_ADDR, LED_OFF_VALUE);
-          cs10_display_bank();
-        } else {
-          cs10_display_time();
-        } /* else */
-      } /* if */
+    case 'o':
+      /* output pool = pArg */
+      if (cs10.uiOutputPool != strtoul(pArg, NULL, 10))
+        cs10.uiConfigChanges |= CS10_CHANGED_OUTPUT;
+      cs10.uiOutputPool = strtoul(pArg, NULL, 10);
+      break;
+
+    case 'b':
+      /* output buffer = pArg */
+      if (cs10.uiOutputBuffer != strtoul(pArg, NULL, 10))
+        cs10.uiConfigChanges |= CS10_CHANGED_OUTPUT;
+      cs10.uiOutputBuffer = strtoul(pArg, NULL, 10);
       break;
 
     default:
-      break ;
+      break;
   } /* switch */
-} /* cs10_handle_button */
+
+  return true;
+} /* cs10_set_option */
 
 /*
- * cs10_handle_fader
+ * cs10_load_config
  *
- * do stuff based on uiFaderAddr and uiFaderVal
+ * read the config file, one option to a line as its long name and value:
+ *   map /home/me/cs10-linux.map
+ *   osc localhost:3819
+ * blank lines and lines starting with # are skipped
  */
 void
-cs10_handle_fader(
-  unsigned int uiFaderAddr,
-  int uiFaderVal) {
+cs10_load_config(void) {
 
-  if (cs10.debug)
-    fprintf(stderr, "%s %u %d\n",
-      __FUNCTION__,
-      uiFaderAddr,
-      uiFaderVal);
+  FILE        *fp;
+  char         cLine[256];
+  unsigned int uiLine = 0;
 
-  if (NULLIFY_MODE == cs10.theMode) {
-    if (uiFaderVal <
-         cs10.csState.tsTrack[
-         cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-         FADER_ADDR_TO_TRACK(uiFaderAddr)].uiFader){
-      cs10_set_led(DOWN_NULL_LED_ADDR, LED_OFF_VALUE);
-      cs10_set_led(UP_NULL_LED_ADDR, LED_ON_VALUE);
-    } else
-    if (uiFaderVal >
-         cs10.csState.tsTrack[
-         cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-         FADER_ADDR_TO_TRACK(uiFaderAddr)].uiFader){
-      cs10_set_led(DOWN_NULL_LED_ADDR, LED_ON_VALUE);
-      cs10_set_led(UP_NULL_LED_ADDR, LED_OFF_VALUE);
-    } else {
-      cs10_set_led(DOWN_NULL_LED_ADDR, LED_OFF_VALUE);
-      cs10_set_led(UP_NULL_LED_ADDR, LED_OFF_VALUE);
-    }
-  } else {
-    cs10.csState.
-      tsTrack[
-        cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-        FADER_ADDR_TO_TRACK(uiFaderAddr)].
-      uiFader = uiFaderVal;
-
-    cs10_issue_virtual_control(
-        cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-        FADER_ADDR_TO_TRACK(uiFaderAddr),
-        FADER_CONTROL,
-        uiFaderVal) ;
-  } /* else */
-} /* cs10_handle_fader */
+  fp = fopen(cs10.config_filename, "r");
+
+  if (NULL == fp) {
+    fprintf(stderr, "can't read config %s\n", cs10.config_filename);
+    return;
+  } /* if */
+
+  while (fgets(cLine, sizeof(cLine), fp)) {
+    struct option *pOption;
+    char          *pKey;
+    char          *pValue;
+    char          *pSave = NULL;
+
+    uiLine++;
+
+    pKey = strtok_r(cLine, " \t\r\n", &pSave);
+
+    if ((NULL == pKey) || ('#' == *pKey))
+      continue;
+
+    pValue = strtok_r(NULL, " \t\r\n", &pSave);
+
+    for (pOption = long_opts ; pOption->name ; pOption++) {
+      if (0 == strcmp(pOption->name, pKey))
+        break;
+    } /* for */
+
+    if ((NULL == pOption->name) ||
+        ('h' == pOption->val) || ('c' == pOption->val)) {
+      fprintf(stderr, "%s:%u: unknown option %s\n",
+        cs10.config_filename, uiLine, pKey);
+      continue;
+    } /* if */
+
+    if (cs10.bCommandLine[pOption->val])
+      continue;
+
+    if (((required_argument == pOption->has_arg) && (NULL == pValue)) ||
+        !cs10_set_option(pOption->val, pValue))
+      fprintf(stderr, "%s:%u: bad value for %s\n",
+        cs10.config_filename, uiLine, pKey);
+  } /* while */
+
+  fclose(fp);
+} /* cs10_load_config */
 
 /*
- * cs10_handle_knob
+ * cs10_reload_map
  *
- * do stuff based on uiKnobAddr and uiKnobVal
+ * build the map off to the side and swap it in between events
+ * a map that won't load leaves the one in use alone
+ */
+bool
+cs10_reload_map(void) {
+
+  cs10_map_t         *pNewMap = malloc(sizeof(cs10_map_t));
+  cs10_retired_map_t *pRetired = malloc(sizeof(cs10_retired_map_t));
+
+  if ((NULL == pNewMap) || (NULL == pRetired)) {
+    free(pNewMap);
+    free(pRetired);
+    return false;
+  } /* if */
+
+  if (cs10.map_filename) {
+    if (!cs10_map_load(pNewMap, cs10.map_filename)) {
+      fprintf(stderr, "can't load map %s\n", cs10.map_filename);
+      free(pNewMap);
+      free(pRetired);
+      return false;
+    } /* if */
+
+    if (cs10.debug)
+      fprintf(stderr, "using map %s, %u bindings\n",
+        cs10.map_filename, pNewMap->uiBindings);
+  } else
+    cs10_map_default(pNewMap, CS10_MIDI_CONTROL_CHANNEL,
+                     CS10_NUM_PHYSICAL_TRACKS, CS10_NUM_VIRTUAL_TRACKS);
+
+  /* the daw thread may be part way through an event with the old map */
+  pRetired->pMap = __atomic_exchange_n(&cs10.pMap, pNewMap,
+                                       __ATOMIC_SEQ_CST);
+  pRetired->uiGeneration = __atomic_add_fetch(&cs10.uiMapGeneration, 1,
+                                              __ATOMIC_SEQ_CST);
+
+  if (pRetired->pMap) {
+    pRetired->pNext = cs10.pRetiredMaps;
+    cs10.pRetiredMaps = pRetired;
+  } else
+    free(pRetired);
+
+  cs10_reclaim_maps();
+
+  return true;
+} /* cs10_reload_map */
+
+/*
+ * cs10_watch_file
+ *
+ * watch the directory holding pFilename, editors tend to replace a file
+ * rather than write it in place
  */
 void
-cs10_handle_knob(
-  unsigned int uiKnobAddr,
-  unsigned int uiKnobVal) {
+cs10_watch_file(
+  const char *pFilename) {
 
-  unsigned int idx = KNOB_ADDR_TO_KNOB_INDEX(uiKnobAddr);
+  char *pDirectory;
+  char *pSlash;
 
-  if (cs10.debug)
-    fprintf(stderr, "%s %u %d\n",
-      __FUNCTION__,
-      uiKnobAddr,
-      uiKnobVal);
+  if ((0 > cs10.iNotifyFD) || (NULL == pFilename))
+    return;
 
-  if (NULLIFY_MODE == cs10.theMode) {
-    if (uiKnobVal <
-         cs10.csState.tsTrack[
-         cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-         cs10.uiSelectedTrack].uiKnob[idx]) {
-      cs10_set_led(LEFT_WHEEL_LED_ADDR, LED_OFF_VALUE);
-      cs10_set_led(RIGHT_WHEEL_LED_ADDR, LED_ON_VALUE);
-    } else
-    if (uiKnobVal >
-         cs10.csState.tsTrack[
-         cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-         cs10.uiSelectedTrack].uiKnob[idx]) {
-      cs10_set_led(LEFT_WHEEL_LED_ADDR, LED_ON_VALUE);
-      cs10_set_led(RIGHT_WHEEL_LED_ADDR, LED_OFF_VALUE);
-    } else {
-      cs10_set_led(LEFT_WHEEL_LED_ADDR, LED_OFF_VALUE);
-      cs10_set_led(RIGHT_WHEEL_LED_ADDR, LED_OFF_VALUE);
-    }
-  } else {
-    cs10.csState.
-      tsTrack[
-      cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-      cs10.uiSelectedTrack].
-      uiKnob[idx] = uiKnobVal ;
-
-    cs10_issue_virtual_control(
-        cs10.uiBank * CS10_NUM_PHYSICAL_TRACKS +
-        cs10.uiSelectedTrack,
-        KNOB_ADDR_TO_VIRTUAL_CONTROL(uiKnobAddr), uiKnobVal) ;
-  } /* else */
-} /* cs10_handle_knob */
+  pDirectory = strdup(pFilename);
+
+  if (NULL == pDirectory)
+    return;
+
+  pSlash = strrchr(pDirectory, '/');
+
+  if (NULL == pSlash)
+    strcpy(pDirectory, ".");
+  else
+  if (pSlash == pDirectory)
+    pSlash[1] = '\0';
+  else
+    *pSlash = '\0';
+
+  /* watching the same directory twice just hands back the same watch */
+  if (0 > inotify_add_watch(cs10.iNotifyFD, pDirectory,
+                            IN_CLOSE_WRITE | IN_MOVED_TO))
+    fprintf(stderr, "can't watch %s\n", pDirectory);
+
+  free(pDirectory);
+} /* cs10_watch_file */
+
+/*
+ * cs10_is_file
+ *
+ * is pName, from an inotify event, the last part of pFilename
+ */
+bool
+cs10_is_file(
+  const char *pFilename,
+  const char *pName) {
+
+  const char *pBase;
+
+  if (NULL == pFilename)
+    return false;
+
+  pBase = strrchr(pFilename, '/');
+
+  return (0 == strcmp(pBase ? pBase + 1 : pFilename, pName));
+} /* cs10_is_file */
 
 /*
- * cs10_handle_wheel
+ * cs10_apply_config_changes
  *
- * issue MMC step commands based on uiWheelVal
+ * bring the running daemon in line with whatever the config reload changed
  */
 void
-cs10_handle_wheel(
-  unsigned int uiWheelVal) {
+cs10_apply_config_changes(void) {
 
-  if (cs10.debug)
-    fprintf(stderr, "%s %u\n",
-      __FUNCTION__,
-      uiWheelVal);
+  unsigned int uiChanges = cs10.uiConfigChanges;
 
-  /* add to cs10.iJogCount */
-  cs10.iJogCount += (uiWheelVal & 0x40 ?
-      0 - (((~uiWheelVal) & 0x7f) + 1) :
-      uiWheelVal) ;
+  cs10.uiConfigChanges = 0;
 
-  if ((CS10_JOG_THRESHOLD < cs10.iJogCount) ||
-      (-CS10_JOG_THRESHOLD > cs10.iJogCount)) {
-    int iStepValue = (cs10.iJogCount / CS10_JOG_DIVISOR) ;
+  if (uiChanges & CS10_CHANGED_MAP) {
+    cs10_reload_map();
+    cs10_watch_file(cs10.map_filename);
+  } /* if */
 
-    iStepValue = (iStepValue > 0 ? iStepValue :
-        -iStepValue | 0x40) & 0x7f ;
+  if (uiChanges & CS10_CHANGED_OSC) {
+    cs10_osc_close();
 
-    cs10_issue_mmc_step_command(iStepValue) ;
+    if (cs10.osc_target && !cs10_osc_open(cs10.osc_target))
+      fprintf(stderr, "can't send osc to %s\n", cs10.osc_target);
+  } /* if */
 
-    cs10.iJogCount = 0 ;
+  /* the live mixer state stays as it is, only the saved scenes change */
+  if (uiChanges & CS10_CHANGED_SETTINGS)
+    cs10_load_settings();
+
+  if (uiChanges & CS10_CHANGED_OUTPUT) {
+    cs10_configure_output(cs10.pSeq);
+
+    if (cs10.pSurfaceSeq)
+      cs10_configure_output(cs10.pSurfaceSeq);
   } /* if */
-} /* cs10_handle_wheel */
+
+  /* verbose turned on in the config file starts the log writer */
+  if (cs10.debug)
+    cs10_log_start(stderr);
+
+  if (uiChanges & CS10_CHANGED_RESTART)
+    fprintf(stderr, "port, rawmidi, journal, automation, trace, stats, "
+                    "control, shm, macros and targets changes take "
+                    "effect on restart\n");
+} /* cs10_apply_config_changes */
 
 /*
- * cs10_receive_sysex
+ * cs10_control_number
  *
- * receive a sysex message from the DAW or whatever
- * scrape out MTC or whatever
+ * read pArg as a number from uiMin to uiMax
  */
-void
-cs10_receive_sysex(
-  unsigned int length,
-  unsigned char *data) {
+bool
+cs10_control_number(
+  const char *pArg,
+  unsigned int uiMin,
+  unsigned int uiMax,
+  unsigned int *puiValue) {
 
-  if (10 == length) {
-    if ((0xf0 == data[0]) &&
-        (0x7f == data[1]) &&
-        (0x01 == data[3]) &&
-        (0x01 == data[4])) {
-
-      cs10.tCurrentTime.hours =
-        data[5] ;
-      cs10.tCurrentTime.minutes =
-        data[6] ;
-      cs10.tCurrentTime.seconds =
-        data[7] ;
-      cs10.tCurrentTime.frames =
-        data[8] ;
-
-      cs10_update_display_time();
-
-      if (cs10.debug)
-        fprintf(stderr, "%s %02d:%02d:%02d:%02d\n",
-          __FUNCTION__,
-          cs10.tCurrentTime.hours,
-          cs10.tCurrentTime.minutes,
-          cs10.tCurrentTime.seconds,
-          cs10.tCurrentTime.frames) ;
-
-    } else /* MTC full frame time */
-    if ((0xf0 == data[0]) &&
-        (0x7f == data[1]) &&
-        (0x06 == data[3]) &&
-        (0x44 == data[4]) &&
-        (0x06 == data[5]) &&
-        (0x01 == data[6])) {
-
-      cs10.tCurrentTime.hours =
-        data[7] ;
-      cs10.tCurrentTime.minutes =
-        data[8] ;
-      cs10.tCurrentTime.seconds =
-        data[9] ;
-      cs10.tCurrentTime.frames =
-        data[10] ;
-
-      cs10_update_display_time();
-
-      if (cs10.debug)
-        fprintf(stderr, "%s MMC LOC %02d:%02d:%02d:%02d\n",
-          __FUNCTION__,
-          cs10.tCurrentTime.hours,
-          cs10.tCurrentTime.minutes,
-          cs10.tCurrentTime.seconds,
-          cs10.tCurrentTime.frames) ;
-
-    } else { /* MMC locate */
-      if (cs10.debug) {
-        unsigned int i;
-
-        fprintf(stderr, "%s sysex", __FUNCTION__);
-        for (i = 0;
-             i < length ;
-             i++) {
-          fprintf(stderr, " %02x", data[i]);
-        } /* for */
-        fprintf(stderr, "\n");
-      } /* if */
-    } /* else */
-  } /* length matches MTC full frame time */
-} /* cs10_receive_sysex */
+  char          *pEnd ;
+  unsigned long  ulValue = strtoul(pArg, &pEnd, 0) ;
+
+  if (('\0' != *pEnd) || (pEnd == pArg) ||
+      (ulValue < uiMin) || (ulValue > uiMax))
+    return false ;
+
+  *puiValue = ulValue ;
+
+  return true ;
+} /* cs10_control_number */
 
 /*
- * cs10_receive_qframe
+ * cs10_control_state
  *
- * receive qframe slices of time code and re-assemble them
+ * print the bank, mode, time and every virtual track to pReply
  */
 void
-cs10_receive_qframe(
-  unsigned char qframe_data) {
+cs10_control_state(
+  FILE *pReply) {
 
-  unsigned char ucField = ((qframe_data & 0xf0) >> 4) ;
-  unsigned char ucData = (qframe_data & 0x0f) ;
+  cs10_mixer_state_t csState ;
+  smpte_time_t       tTime = cs10_read_current_time() ;
+  unsigned int       uiTrack ;
+  unsigned int       uiControl ;
 
-  if (cs10.debug)
-    fprintf(stderr, "%s %x %x\n",
-      __FUNCTION__, ucField, ucData); 
+  cs10_read_mixer_state(&csState) ;
 
-  switch(ucField) {
-    case 0:
-      cs10.tQFTime.frames = (cs10.tQFTime.frames & 0xf0) + ucData ;
-      break ;
+  fprintf(pReply, "bank %u\n", cs10.uiBank + 1) ;
+  fprintf(pReply, "mode %s\n", modeName[cs10.theMode]) ;
+  fprintf(pReply, "selected %u\n", cs10.uiSelectedTrack + 1) ;
+  fprintf(pReply, "time %02u:%02u:%02u:%02u\n",
+    tTime.hours, tTime.minutes, tTime.seconds, tTime.frames) ;
 
-    case 1:
-      cs10.tQFTime.frames = (cs10.tQFTime.frames & 0x0f) + (ucData << 4) ;
-      break ;
+  for (uiTrack = 0 ; uiTrack < CS10_NUM_VIRTUAL_TRACKS ; uiTrack++) {
+    cs10_track_state_t *pTrack = &csState.tsTrack[uiTrack] ;
 
-    case 2:
-      cs10.tQFTime.seconds = (cs10.tQFTime.seconds & 0xf0) + ucData ;
-      break ;
+    fprintf(pReply, "track %u", uiTrack + 1) ;
 
-    case 3:
-      cs10.tQFTime.seconds = (cs10.tQFTime.seconds & 0x0f) + (ucData << 4) ;
-      break ;
+    for (uiControl = 0 ;
+         uiControl < NUM_VIRTUAL_TRACK_CONTROLS ;
+         uiControl++) {
+      bool *pbFlag = cs10_track_flag(pTrack, uiControl) ;
 
-    case 4:
-      cs10.tQFTime.minutes = (cs10.tQFTime.minutes & 0xf0) + ucData ;
-      break ;
+      fprintf(pReply, " %s %u", controlName[uiControl],
+        pbFlag ? *pbFlag : *cs10_track_value(pTrack, uiControl)) ;
+    } /* for */
 
-    case 5:
-      cs10.tQFTime.minutes = (cs10.tQFTime.minutes & 0x0f) + (ucData << 4) ;
-      break ;
+    fprintf(pReply, "\n") ;
+  } /* for */
+} /* cs10_control_state */
 
-    case 6:
-      cs10.tQFTime.hours = (cs10.tQFTime.hours & 0xf0) + ucData ;
-      break ;
+/*
+ * cs10_control_command
+ *
+ * run one command from the control socket
+ * return NULL or why it failed
+ */
+const char *
+cs10_control_command(
+  unsigned int uiArgs,
+  char **ppArgs,
+  FILE *pReply) {
 
-    case 7:
-      cs10.tQFTime.hours = (cs10.tQFTime.hours & 0x0f) +
-        ((ucData << 4) & 0x01) ;
-      cs10.tQFTime.flags = (ucData >> 1) ;
-      break ;
-  } /* switch */
+  unsigned int uiNumber ;
+  unsigned int uiTrack ;
+  unsigned int uiControl ;
+  unsigned int uiValue ;
 
-  cs10.ucQuarterFrameFlags |= 1 << ucField ;
+  if (0 == strcmp("state", ppArgs[0])) {
+    cs10_control_state(pReply) ;
+    return NULL ;
+  } /* if */
 
-  if (0xff == cs10.ucQuarterFrameFlags) {
-    cs10.tCurrentTime = cs10.tQFTime ;
-    cs10.ucQuarterFrameFlags = 0 ;
+  if (0 == strcmp("bank", ppArgs[0])) {
+    if ((2 != uiArgs) ||
+        !cs10_control_number(ppArgs[1], 1, CS10_NUM_BANKS, &uiNumber))
+      return "usage: bank 1-4" ;
 
-    cs10_update_display_time();
+    cs10_set_bank(uiNumber - 1) ;
+    return NULL ;
+  } /* if */
 
-    if (cs10.debug)
-      fprintf(stderr, "%s %02d:%02d:%02d:%02d\n",
-        __FUNCTION__,
-        cs10.tCurrentTime.hours,
-        cs10.tCurrentTime.minutes,
-        cs10.tCurrentTime.seconds,
-        cs10.tCurrentTime.frames) ;
+  if (0 == strcmp("save", ppArgs[0])) {
+    if ((2 != uiArgs) ||
+        !cs10_control_number(ppArgs[1], 1, CS10_NUM_SAVED_STATES, &uiNumber))
+      return "usage: save 1-9" ;
 
+    cs10_save_state(uiNumber - 1) ;
+    return NULL ;
   } /* if */
-} /* cs10_receive_qframe */
 
+  if (0 == strcmp("recall", ppArgs[0])) {
+    unsigned int uiSeconds = 0 ;
 
-/*
- * cs10_get_local_data_file
- *
- * wrangle whatever environment variables to get a path to the local data file
- */
-void
-cs10_get_local_data_file() {
-  char *datadir = getenv("XDG_DATA_HOME");
-
-  if (datadir == NULL) {
-    char *homedir = getenv("HOME");
-    int   data_path_len = 0;
+    if ((2 > uiArgs) || (3 < uiArgs) ||
+        !cs10_control_number(ppArgs[1], 1, CS10_NUM_SAVED_STATES, &uiNumber) ||
+        ((3 == uiArgs) &&
+         !cs10_control_number(ppArgs[2], 0, CS10_MAX_MORPH_SECONDS,
+                              &uiSeconds)))
+      return "usage: recall 1-9 [morph seconds]" ;
 
-    if (homedir == NULL) {
-      homedir = getpwuid(getuid())->pw_dir;
-    } /* if */
+    cs10_recall_state(uiNumber - 1, CS10_ALL_TRACKS, CS10_ALL_CONTROLS,
+                      uiSeconds * 1000) ;
+    return NULL ;
+  } /* if */
 
-    if (homedir == NULL)
-      return;
+  if ((0 == strcmp("undo", ppArgs[0])) || (0 == strcmp("redo", ppArgs[0]))) {
+    if (1 != uiArgs)
+      return "usage: undo or redo" ;
 
-    data_path_len = strlen(homedir) +
-      strlen(CS10_DEFAULT_SETTINGS_PATH) +
-      strlen(CS10_DEFAULT_SETTINGS_FILENAME) + 1;
+    if (!cs10_undo_step('r' == ppArgs[0][0]))
+      return "nothing to do" ;
 
-    cs10.settings_filename = malloc(data_path_len);
+    return NULL ;
+  } /* if */
 
-    if (cs10.settings_filename) {
-      strcpy(cs10.settings_filename, homedir);
-      strcat(cs10.settings_filename, CS10_DEFAULT_SETTINGS_PATH);
+  if (0 == strcmp("macro", ppArgs[0])) {
+    if ((2 != uiArgs) ||
+        !cs10_control_number(ppArgs[1], 1, CS10_MACRO_SLOTS, &uiNumber))
+      return "usage: macro 1-8" ;
 
-      mkdir(cs10.settings_filename, 0700);
+    if (!cs10_run_macro(uiNumber - 1))
+      return "no such macro" ;
 
-      strcat(cs10.settings_filename, CS10_DEFAULT_SETTINGS_FILENAME);
-    } /* if */
-  } else {
-    int data_path_len = strlen(datadir) +
-      strlen(CS10_DEFAULT_SETTINGS_DIR) +
-      strlen(CS10_DEFAULT_SETTINGS_FILENAME) + 1;
+    return NULL ;
+  } /* if */
 
-    cs10.settings_filename = malloc(data_path_len);
+  if (0 == strcmp("set", ppArgs[0])) {
+    if ((4 != uiArgs) ||
+        !cs10_control_number(ppArgs[1], 1, CS10_NUM_VIRTUAL_TRACKS,
+                             &uiTrack) ||
+        !cs10_control_number(ppArgs[3], 0, CS10_MAX_CONTROL_VALUE, &uiValue))
+      return "usage: set track control value" ;
 
-    if (cs10.settings_filename) {
-      strcpy(cs10.settings_filename, datadir);
-      strcat(cs10.settings_filename, CS10_DEFAULT_SETTINGS_DIR);
+    for (uiControl = 0 ;
+         uiControl < NUM_VIRTUAL_TRACK_CONTROLS ;
+         uiControl++) {
+      if (0 == strcmp(controlName[uiControl], ppArgs[2]))
+        break ;
+    } /* for */
 
-      mkdir(cs10.settings_filename, 0700);
+    /* the toggles come before the fader */
+    if ((NUM_VIRTUAL_TRACK_CONTROLS == uiControl) ||
+        (FADER_CONTROL > uiControl))
+      return "only a fader or knob can be set" ;
 
-      strcat(cs10.settings_filename, CS10_DEFAULT_SETTINGS_FILENAME);
-    } /* if */
-  } /* else */
-} /* cs10_get_local_data_file */
+    cs10_apply_virtual_control(uiTrack - 1, uiControl, uiValue) ;
+    return NULL ;
+  } /* if */
 
-static struct option long_opts[] = {
-  { "verbose", no_argument, NULL, 'v'},
-  { "file", required_argument, NULL, 'f'},
-  { "port", required_argument, NULL, 'p'},
-  { "help", no_argument, NULL, 'h'},
-};
+  return "unknown command" ;
+} /* cs10_control_command */
 
+/*
+ * cs10_handle_notify
+ *
+ * the config file or map changed on disk, re-apply it
+ */
 void
-cs10_help_exit(
-  int argc,
-  char** argv) {
+cs10_handle_notify(void) {
 
-  fprintf(stderr, "%s options:\n", argv[0]);
-  fprintf(stderr, "  --file, -f [path] to persistent data file\n");
-  fprintf(stderr, "  --port, -p [client:port] of midi hardware interface\n");
-  fprintf(stderr, "  --verbose, -v print debug information\n");
-  fprintf(stderr, "  --help, -h show this help and exit\n");
-  exit(0);
-} /* cs10_help_exit */
+  char    cBuffer[4096]
+            __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  ssize_t iLength;
+  bool    bConfig = false;
+  bool    bMap = false;
+
+  while ((iLength = read(cs10.iNotifyFD, cBuffer, sizeof(cBuffer))) > 0) {
+    char *pNext;
+
+    for (pNext = cBuffer ;
+         pNext < cBuffer + iLength ;
+         pNext += sizeof(struct inotify_event) +
+                  ((struct inotify_event *)pNext)->len) {
+      struct inotify_event *pEvent = (struct inotify_event *)pNext;
+
+      if (0 == pEvent->len)
+        continue;
+
+      if (cs10_is_file(cs10.config_filename, pEvent->name))
+        bConfig = true;
+
+      if (cs10_is_file(cs10.map_filename, pEvent->name))
+        bMap = true;
+    } /* for */
+  } /* while */
+
+  cs10.uiConfigChanges = 0;
+
+  if (bConfig) {
+    if (cs10.debug)
+      fprintf(stderr, "reloading config %s\n", cs10.config_filename);
+    cs10_load_config();
+  } /* if */
+
+  if (bMap)
+    cs10.uiConfigChanges |= CS10_CHANGED_MAP;
+
+  cs10_apply_config_changes();
+} /* cs10_handle_notify */
 
 int 
 main(
@@ -1481,141 +5724,251 @@ main(
 
   memset(&cs10, sizeof(cs10), 0) ;
 
-  while ((c = getopt_long(argc, argv, "vf:p:h", long_opts, NULL)) != -1) {
-    switch (c) {
-      case 'v':
-        /* verbose = true */
-        cs10.debug = true;
-        break;
+  cs10.iNotifyFD = -1 ;
+  cs10.bStartup = true ;
+  cs10.uiFaderDeadband = CS10_DEFAULT_DEADBAND ;
+  cs10.uiKnobDeadband = CS10_DEFAULT_DEADBAND ;
+  cs10.uiControlInterval = CS10_DEFAULT_INTERVAL_MS ;
+  cs10.uiMorphSeconds = CS10_DEFAULT_MORPH_SECONDS ;
+  cs10.iLinkedClient = -1 ;
+  cs10.iLinkedPort = -1 ;
+
+  while ((c = getopt_long(argc, argv, "vkf:p:r:u:m:c:j:a:t:s:C:S:M:T:d:i:o:b:h",
+                          long_opts, NULL)) != -1) {
+    if ('h' == c)
+      cs10_help_exit(argc, argv) ;
+
+    if ('?' == c)
+      continue ;
+
+    if (!cs10_set_option(c, optarg)) {
+      fprintf(stderr, "bad parameter: %s\n", optarg);
+      cs10_help_exit(argc, argv);
+    } /* if */
 
-      case 'f':
-        /* filename = optarg */
-        cs10.settings_filename = strdup(optarg); 
-        break;
+    cs10.bCommandLine[(unsigned char)c] = true ;
+  } /* while */
 
-      case 'p':
-        /* midi port = optarg */
-        {
-          char *startptr, *nextptr;
-          unsigned long client_id = strtoul(optarg, &nextptr, 10);
-          unsigned long port_id = 0;
-          bool bad_param = false;
-
-          if ((nextptr != optarg) &&
-              (*nextptr = ':')) {
-            startptr = nextptr + 1;
-            port_id = strtoul(startptr, &nextptr, 10);
-            if (nextptr != startptr) {
-              cs10.hw_seq_client = client_id; 
-              cs10.hw_seq_port = port_id; 
-              if (cs10.debug)
-                fprintf(stderr, "hw midi port %ld:%ld\n", client_id, port_id);
-            } else
-              bad_param = true;
-          } else
-            bad_param = true;
+  if (cs10.config_filename)
+    cs10_load_config();
 
-          if (bad_param) {
-            fprintf(stderr, "bad parameter: %s\n", optarg);
-            cs10_help_exit(argc, argv);
-          } /* if */
-        }
-        break;
+  if (cs10.settings_filename == NULL)
+    cs10_get_local_data_file();
 
-      case 'h':
-        /* help exit */
-        cs10_help_exit(argc, argv) ;
-        break;
+  /* the journal lives next to the settings unless told otherwise */
+  if ((cs10.journal_filename == NULL) && cs10.settings_filename) {
+    cs10.journal_filename = malloc(strlen(cs10.settings_filename) +
+                                   strlen(CS10_JOURNAL_SUFFIX) + 1);
 
-      default:
-        break;
-    } /* switch */
-  } /* while */
+    if (cs10.journal_filename) {
+      strcpy(cs10.journal_filename, cs10.settings_filename);
+      strcat(cs10.journal_filename, CS10_JOURNAL_SUFFIX);
+    } /* if */
+  } /* if */
 
-  if (cs10.settings_filename == NULL)
-    cs10_get_local_data_file();
+  if (!cs10_reload_map())
+    return 1;
+
+  if (cs10.targets_filename &&
+      !cs10_target_load(cs10.targets_filename, controlName)) {
+    fprintf(stderr, "can't load targets %s\n", cs10.targets_filename);
+    return 1;
+  } /* if */
 
   if (cs10.debug)
     fprintf(stderr, "using settings file %s\n", cs10.settings_filename);
 
   if (cs10_init()) {
     snd_seq_event_t *pNewEvent ;
+    struct pollfd   *pFDs ;
+    int              iSurfaceFDs ;
+    int              iFD ;
+    int              iResult ;
 
-    if (cs10.hw_seq_client) {
-      if (cs10.debug)
-        fprintf(stderr, "connect to %d:%d\n",
-          cs10.hw_seq_client, cs10.hw_seq_port);
-      snd_seq_connect_to(cs10.pSeq, 0, cs10.hw_seq_client, cs10.hw_seq_port);
-      if (cs10.debug)
-        fprintf(stderr, "connect from %d:%d\n",
-          cs10.hw_seq_client, cs10.hw_seq_port);
-      snd_seq_connect_from(cs10.pSeq, 0, cs10.hw_seq_client, cs10.hw_seq_port);
+    if ((cs10.hw_seq_client || cs10.port_pattern) && cs10.rawmidi_name) {
+      fprintf(stderr, "--port is ignored with --rawmidi\n");
+    } else
+    if (cs10.hw_seq_client || cs10.port_pattern) {
+      /* if it isn't there yet, it's linked when it turns up */
+      if (!cs10_find_interface() && cs10.debug)
+        fprintf(stderr, "waiting for the interface\n");
+    } /* if */
+
+    if (cs10.osc_target && !cs10_osc_open(cs10.osc_target)) {
+      fprintf(stderr, "can't send osc to %s\n", cs10.osc_target);
+      return 1 ;
     } /* if */
 
+    /* the target ports are there before anything can go out to them */
+    if (!cs10_target_open(cs10.pSeq))
+      fprintf(stderr, "can't make the target ports\n");
+
+    cs10_open_journal();
     cs10_load_settings();
+
+    if (cs10.shm_name) {
+      if (cs10_shm_open(cs10.shm_name)) {
+        /* readers start from the state the journal brought back */
+        seqlock_write_begin(&cs10.stateLock) ;
+        cs10_publish_time() ;
+        cs10_state_write_end(CS10_ALL_TRACKS) ;
+      } else
+        fprintf(stderr, "can't share state as %s\n", cs10.shm_name);
+    } /* if */
+
+    if (cs10.automation_filename &&
+        !cs10_automation_open(cs10.automation_filename,
+                              CS10_AUTOMATION_STREAMS))
+      fprintf(stderr, "can't open automation %s\n", cs10.automation_filename);
+
+    if (!cs10_macro_queue_open(cs10.pSeq, CS10_MACRO_EVENTS))
+      fprintf(stderr, "can't get a sequencer queue for macros\n");
+    else
+    if (cs10.macro_filename &&
+        !cs10_macro_load(cs10.macro_filename, controlName) &&
+        cs10.debug)
+      fprintf(stderr, "no macros in %s yet\n", cs10.macro_filename);
+
     cs10_set_mode(cs10.theMode) ;
 
-    while (snd_seq_event_input(cs10.pSeq, &pNewEvent) >= 0) {
-      if (SND_SEQ_EVENT_PORT_SUBSCRIBED == pNewEvent->type) {
-        cs10_set_mode(cs10.theMode) ;
-        continue;
-      } /* else */
+    if (cs10.debug && !cs10_log_start(stderr))
+      fprintf(stderr, "can't start log writer\n");
 
-      if (pNewEvent->dest.port == cs10.iMMCPortID) {
-        if (SND_SEQ_EVENT_SYSEX == pNewEvent->type) {
-          cs10_receive_sysex(pNewEvent->data.ext.len,
-                            (unsigned char*)pNewEvent->data.ext.ptr);
-        } else /* SND_SEQ_EVENT_SYSEX */
-        if (SND_SEQ_EVENT_QFRAME == pNewEvent->type) {
-          cs10_receive_qframe(pNewEvent->data.control.value);
-        } else /* SND_SEQ_EVENT_QFRAME */
-        if (SND_SEQ_EVENT_CONTROLLER == pNewEvent->type) {
-          if ((pNewEvent->data.control.param >= 0) &&
-             (pNewEvent->data.control.param <=
-                NUM_VIRTUAL_TRACK_CONTROLS * CS10_NUM_PHYSICAL_TRACKS)) {
-            unsigned int event_track =
-              (pNewEvent->data.control.param / NUM_VIRTUAL_TRACK_CONTROLS) +
-              ((pNewEvent->data.control.channel - CS10_MIDI_CONTROL_CHANNEL) *
-                CS10_NUM_PHYSICAL_TRACKS);
-            unsigned int event_control =
-              pNewEvent->data.control.param % NUM_VIRTUAL_TRACK_CONTROLS ;
-
-            cs10_receive_virtual_control(event_track, 
-              event_control, pNewEvent->data.control.value) ;
-          } /* if */
-        } /* SND_SEQ_EVENT_CONTROLLER */
-      } /* iMMCPortID */
-
-      if (pNewEvent->dest.port == cs10.iControlPortID) {
-        if (SND_SEQ_EVENT_CONTROLLER == pNewEvent->type) {
-          if ((FIRST_BUTTON_ADDR <= pNewEvent->data.control.param) &&
-             (LAST_BUTTON_ADDR >= pNewEvent->data.control.param))
-            cs10_handle_button(pNewEvent->data.control.param,
-                               pNewEvent->data.control.value) ;
-          else
-          if ((FIRST_FADER_ADDR <= pNewEvent->data.control.param) &&
-              (LAST_FADER_ADDR >= pNewEvent->data.control.param)) {
-            cs10_handle_fader(pNewEvent->data.control.param,
-                              pNewEvent->data.control.value) ;
-          } else
-          if ((FIRST_KNOB_ADDR <= pNewEvent->data.control.param) &&
-              (LAST_KNOB_ADDR >= pNewEvent->data.control.param)) {
-            cs10_handle_knob(pNewEvent->data.control.param,
-                             pNewEvent->data.control.value) ;
+    if (cs10.trace_filename && !cs10_trace_open(cs10.trace_filename))
+      fprintf(stderr, "can't trace to %s, tracing needs make TRACE=1\n",
+        cs10.trace_filename);
+
+    CS10_TRACE_THREAD("surface") ;
+    cs10_stats_thread("surface") ;
+
+    if (cs10.stats_filename && !cs10_stats_start(cs10.stats_filename))
+      fprintf(stderr, "can't write stats to %s\n", cs10.stats_filename);
+
+    if (cs10.control_path &&
+        !cs10_control_open(cs10.control_path, cs10_control_command))
+      fprintf(stderr, "can't listen on %s\n", cs10.control_path);
+
+    if (0 != pthread_create(&cs10.dawThread, NULL, cs10_daw_thread, NULL)) {
+      fprintf(stderr, "can't start daw thread\n");
+      return 1 ;
+    } /* if */
+
+    cs10.bDAWThread = true ;
+
+    /* the surface thread sleeps on cs10-io, or the rawmidi device,
+     * and on refresh requests
+     */
+    if (cs10.pRawIn)
+      iSurfaceFDs = snd_rawmidi_poll_descriptors_count(cs10.pRawIn) ;
+    else
+      iSurfaceFDs = snd_seq_poll_descriptors_count(cs10.pSurfaceSeq, POLLIN) ;
+
+    pFDs = calloc(iSurfaceFDs + 2 + CS10_CONTROL_FDS,
+                  sizeof(struct pollfd)) ;
+
+    if (NULL == pFDs)
+      return 1 ;
+
+    if (cs10.config_filename || cs10.map_filename) {
+      cs10.iNotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC) ;
+      cs10_watch_file(cs10.config_filename) ;
+      cs10_watch_file(cs10.map_filename) ;
+    } /* if */
+
+    if (cs10.pRawIn)
+      snd_rawmidi_poll_descriptors(cs10.pRawIn, pFDs, iSurfaceFDs) ;
+    else
+      snd_seq_poll_descriptors(cs10.pSurfaceSeq, pFDs, iSurfaceFDs, POLLIN) ;
+
+    pFDs[iSurfaceFDs].fd = cs10.iWakeFD ;
+    pFDs[iSurfaceFDs].events = POLLIN ;
+
+    /* poll skips the slot when nothing is being watched */
+    pFDs[iSurfaceFDs + 1].fd = cs10.iNotifyFD ;
+    pFDs[iSurfaceFDs + 1].events = POLLIN ;
+
+    for (;;) {
+      int iTimeout ;
+      int iThrottle ;
+
+      /* everything queued by the last pass goes out, transport first */
+      cs10_output_flush() ;
+
+      if (cs10.pRetiredMaps)
+        cs10_reclaim_maps() ;
+
+      iTimeout = cs10_restore_timeout() ;
+      iThrottle = cs10_throttle_timeout() ;
+
+      if ((0 <= iThrottle) && ((iTimeout < 0) || (iThrottle < iTimeout)))
+        iTimeout = iThrottle ;
+
+      /* whatever the sequencer pushed back gets another go shortly */
+      if (cs10_output_pending() &&
+          ((iTimeout < 0) || (iTimeout > CS10_OUTPUT_RETRY_MS)))
+        iTimeout = CS10_OUTPUT_RETRY_MS ;
+
+      if (cs10.bDumpStats) {
+        cs10.bDumpStats = 0 ;
+        cs10_output_dump_stats(stderr) ;
+
+        if (cs10_osc_is_open())
+          cs10_osc_dump_stats(stderr) ;
+      } /* if */
+
+      cs10_control_poll_fds(&pFDs[iSurfaceFDs + 2]) ;
+
+      CS10_TRACE_BEGIN("poll") ;
+      iResult = poll(pFDs, iSurfaceFDs + 2 + CS10_CONTROL_FDS, iTimeout) ;
+      CS10_TRACE_END("poll") ;
+
+      if (iResult < 0) {
+        if (EINTR == errno)
+          continue ;
+        break ;
+      } /* if */
+
+      if (pFDs[iSurfaceFDs].revents & POLLIN)
+        cs10_handle_refresh() ;
+
+      if (pFDs[iSurfaceFDs + 1].revents & POLLIN)
+        cs10_handle_notify() ;
+
+      cs10_control_handle(&pFDs[iSurfaceFDs + 2]) ;
+
+      for (iFD = 0 ; iFD < iSurfaceFDs ; iFD++) {
+        if (pFDs[iFD].revents & POLLIN)
+          break ;
+      } /* for */
+
+      if ((iFD < iSurfaceFDs) && cs10.pRawIn) {
+        cs10_read_rawmidi() ;
+      } else
+      if (iFD < iSurfaceFDs) {
+        while ((iResult = snd_seq_event_input(cs10.pSurfaceSeq,
+                                              &pNewEvent)) != -EAGAIN) {
+          if (iResult >= 0) {
+            CS10_TRACE_BEGIN("surface event") ;
+            cs10_handle_surface_event(pNewEvent) ;
+            CS10_TRACE_END("surface event") ;
           } else
-          if (WHEEL_ADDR == pNewEvent->data.control.param) {
-            cs10_handle_wheel(pNewEvent->data.control.value) ;
-          } /* WHEEL_ADDR */
-        } else { 
-          /* pass on any non-controller events */
-          snd_seq_ev_set_dest(pNewEvent, SND_SEQ_ADDRESS_SUBSCRIBERS, 0) ;
-          snd_seq_ev_set_source(pNewEvent, cs10.iMMCPortID) ;
-          snd_seq_ev_set_direct(pNewEvent) ;
-          snd_seq_event_output(cs10.pSeq, pNewEvent) ;
-          snd_seq_drain_output(cs10.pSeq) ;
-        } /* if controller */
-      } /* if msg to cs10 */
-    } /* while */
+          if (-ENOSPC != iResult)
+            break ;
+        } /* while */
+
+      } /* if */
+
+      /* our own links were announced in the first batch */
+      cs10.bStartup = false ;
+
+      if (cs10.restore.bActive) {
+        CS10_TRACE_BEGIN("restore step") ;
+        cs10_restore_step() ;
+        CS10_TRACE_END("restore step") ;
+      } /* if */
+
+      cs10_throttle_step() ;
+    } /* for */
   } /* pSeq */
 
   return 0 ;
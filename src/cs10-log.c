@@ -0,0 +1,238 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "cs10-log.h"
+
+/*****************************************************************************/
+
+#define LOG_MASK (CS10_LOG_RECORDS - 1)
+
+typedef struct CS10_LOG_RECORD_S {
+  uint64_t    ullTime ;     /* ns, monotonic */
+  const char *pFunction ;
+  const char *pFormat ;
+  int         iArg[4] ;
+} cs10_log_record_t ;
+
+/* the owning thread moves the head, the writer thread the tail, each on
+ * a cache line of its own
+ */
+typedef struct CS10_LOG_RING_S {
+  uint32_t          ulHead __attribute__ ((aligned(64))) ;
+  uint32_t          ulDropped ;
+  uint32_t          ulTail __attribute__ ((aligned(64))) ;
+  uint32_t          ulReported ;
+  cs10_log_record_t records[CS10_LOG_RECORDS] ;
+} cs10_log_ring_t ;
+
+static struct CS10_LOG_S {
+  cs10_log_ring_t rings[CS10_LOG_THREADS] ;
+  unsigned int    uiRings ;      /* claimed so far, may overshoot */
+
+  FILE           *pFile ;
+  pthread_t       writerThread ;
+  bool            bRunning ;
+  uint64_t        ullStart ;
+} logger ;
+
+/* the ring of the calling thread, claimed on its first record */
+static __thread cs10_log_ring_t *pThreadRing ;
+static __thread bool             bNoRing ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_log_now
+ *
+ * monotonic time in ns
+ */
+static uint64_t
+cs10_log_now(void) {
+
+  struct timespec tNow ;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow) ;
+
+  return (uint64_t)tNow.tv_sec * 1000000000ULL + tNow.tv_nsec ;
+} /* cs10_log_now */
+
+/*
+ * cs10_log_put
+ *
+ * copy one record onto the calling thread's ring, the format waits
+ * for the writer thread
+ */
+void
+cs10_log_put(
+  const char *pFunction,
+  const char *pFormat,
+  ...) {
+
+  cs10_log_ring_t   *pRing = pThreadRing ;
+  cs10_log_record_t *pRecord ;
+  uint32_t           ulHead ;
+  va_list            args ;
+
+  if (NULL == pRing) {
+    unsigned int uiRing ;
+
+    if (bNoRing)
+      return ;
+
+    uiRing = __atomic_fetch_add(&logger.uiRings, 1, __ATOMIC_ACQ_REL) ;
+
+    if (uiRing >= CS10_LOG_THREADS) {
+      bNoRing = true ;
+      return ;
+    } /* if */
+
+    pRing = pThreadRing = &logger.rings[uiRing] ;
+  } /* if */
+
+  ulHead = pRing->ulHead ;
+
+  if (ulHead - __atomic_load_n(&pRing->ulTail, __ATOMIC_ACQUIRE) >=
+      CS10_LOG_RECORDS) {
+    __atomic_store_n(&pRing->ulDropped, pRing->ulDropped + 1,
+                     __ATOMIC_RELAXED) ;
+    return ;
+  } /* if */
+
+  pRecord = &pRing->records[ulHead & LOG_MASK] ;
+  pRecord->ullTime = cs10_log_now() ;
+  pRecord->pFunction = pFunction ;
+  pRecord->pFormat = pFormat ;
+
+  va_start(args, pFormat) ;
+  pRecord->iArg[0] = va_arg(args, int) ;
+  pRecord->iArg[1] = va_arg(args, int) ;
+  pRecord->iArg[2] = va_arg(args, int) ;
+  pRecord->iArg[3] = va_arg(args, int) ;
+  va_end(args) ;
+
+  __atomic_store_n(&pRing->ulHead, ulHead + 1, __ATOMIC_RELEASE) ;
+} /* cs10_log_put */
+
+/*
+ * cs10_log_drain
+ *
+ * format whatever every ring holds, ring by ring
+ */
+static void
+cs10_log_drain(void) {
+
+  unsigned int uiRings = __atomic_load_n(&logger.uiRings, __ATOMIC_ACQUIRE) ;
+  unsigned int uiRing ;
+
+  if (uiRings > CS10_LOG_THREADS)
+    uiRings = CS10_LOG_THREADS ;
+
+  for (uiRing = 0 ; uiRing < uiRings ; uiRing++) {
+    cs10_log_ring_t *pRing = &logger.rings[uiRing] ;
+    uint32_t         ulHead = __atomic_load_n(&pRing->ulHead,
+                                              __ATOMIC_ACQUIRE) ;
+    uint32_t         ulTail = pRing->ulTail ;
+    uint32_t         ulDropped ;
+
+    for (; ulTail != ulHead ; ulTail++) {
+      const cs10_log_record_t *pRecord = &pRing->records[ulTail & LOG_MASK] ;
+      uint64_t                 ullTime = 0 ;
+
+      /* records made before the writer started are stamped with its start */
+      if (pRecord->ullTime > logger.ullStart)
+        ullTime = pRecord->ullTime - logger.ullStart ;
+
+      fprintf(logger.pFile, "%4lu.%06lu %s ",
+        (unsigned long)(ullTime / 1000000000ULL),
+        (unsigned long)(ullTime % 1000000000ULL / 1000),
+        pRecord->pFunction) ;
+      fprintf(logger.pFile, pRecord->pFormat,
+        pRecord->iArg[0], pRecord->iArg[1],
+        pRecord->iArg[2], pRecord->iArg[3]) ;
+    } /* for */
+
+    __atomic_store_n(&pRing->ulTail, ulTail, __ATOMIC_RELEASE) ;
+
+    ulDropped = __atomic_load_n(&pRing->ulDropped, __ATOMIC_RELAXED) ;
+
+    if (ulDropped != pRing->ulReported) {
+      fprintf(logger.pFile, "log ring %u dropped %u records\n",
+        uiRing, ulDropped - pRing->ulReported) ;
+      pRing->ulReported = ulDropped ;
+    } /* if */
+  } /* for */
+
+  fflush(logger.pFile) ;
+} /* cs10_log_drain */
+
+/*
+ * cs10_log_writer
+ *
+ * the writer thread, empties the rings every CS10_LOG_FLUSH_MS
+ */
+static void *
+cs10_log_writer(
+  void *pArg) {
+
+  struct timespec tPause = { 0, CS10_LOG_FLUSH_MS * 1000000L } ;
+
+  (void) pArg ;
+
+  while (__atomic_load_n(&logger.bRunning, __ATOMIC_ACQUIRE)) {
+    cs10_log_drain() ;
+    nanosleep(&tPause, NULL) ;
+  } /* while */
+
+  return NULL ;
+} /* cs10_log_writer */
+
+/*
+ * cs10_log_start
+ *
+ * start writing records to pFile, does nothing if already started
+ */
+bool
+cs10_log_start(
+  FILE *pFile) {
+
+  if (logger.bRunning)
+    return true ;
+
+  logger.pFile = pFile ;
+
+  if (0 == logger.ullStart)
+    logger.ullStart = cs10_log_now() ;
+
+  __atomic_store_n(&logger.bRunning, true, __ATOMIC_RELEASE) ;
+
+  if (0 != pthread_create(&logger.writerThread, NULL,
+                          cs10_log_writer, NULL)) {
+    logger.bRunning = false ;
+    return false ;
+  } /* if */
+
+  return true ;
+} /* cs10_log_start */
+
+/*
+ * cs10_log_stop
+ *
+ * stop the writer thread and write out what is left
+ */
+void
+cs10_log_stop(void) {
+
+  if (!logger.bRunning)
+    return ;
+
+  __atomic_store_n(&logger.bRunning, false, __ATOMIC_RELEASE) ;
+  pthread_join(logger.writerThread, NULL) ;
+
+  cs10_log_drain() ;
+} /* cs10_log_stop */
@@ -0,0 +1,503 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <alsa/asoundlib.h>
+
+#include "mmc.h"
+#include "cs10-macro.h"
+
+/*****************************************************************************/
+
+/* what each action is called in the file, MACRO_LOCATE_SAVED and
+ * MACRO_LOCATE share a name and MACRO_SET has arguments of its own
+ */
+static const char *actionName[NUM_MACRO_ACTIONS] = {
+  "play",
+  "stop",
+  "record",
+  "ff",
+  "rew",
+  "locate",
+  "locate",
+  "set"
+} ;
+
+static struct CS10_MACRO_MODULE_S {
+  cs10_macro_t macro[CS10_MACRO_SLOTS] ;
+
+  /* the macro being recorded, and when its last step was */
+  bool         bRecording ;
+  cs10_macro_t recording ;
+  uint32_t     ulLastStep ;
+
+  snd_seq_t   *pSeq ;
+  int          iQueue ;
+} macros = {
+  .iQueue = -1
+} ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_macro_now_ms
+ *
+ * a monotonic millisecond clock
+ */
+static uint32_t
+cs10_macro_now_ms(void) {
+
+  struct timespec tNow ;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow) ;
+
+  return (uint32_t)(tNow.tv_sec * 1000 + tNow.tv_nsec / 1000000) ;
+} /* cs10_macro_now_ms */
+
+/*
+ * cs10_macro_parse_step
+ *
+ * turn one line of a macro file into pStep
+ * return false if it isn't a step
+ */
+static bool
+cs10_macro_parse_step(
+  const char *pLine,
+  const char * const *ppControlNames,
+  cs10_macro_step_t *pStep) {
+
+  char         cWord[16] ;
+  char         cControl[16] ;
+  char         cExtra ;
+  unsigned int uiArg[4] ;
+  unsigned int uiAction ;
+
+  if (1 != sscanf(pLine, "%15s", cWord))
+    return false ;
+
+  for (uiAction = 0 ; uiAction < MACRO_LOCATE_SAVED ; uiAction++) {
+    if (0 == strcmp(actionName[uiAction], cWord)) {
+      pStep->ucAction = uiAction ;
+      return (1 == sscanf(pLine, "%15s %c", cWord, &cExtra)) ;
+    } /* if */
+  } /* for */
+
+  if ((1 == sscanf(pLine, "locate f%u %c", &uiArg[0], &cExtra)) ||
+      (1 == sscanf(pLine, "locate F%u %c", &uiArg[0], &cExtra))) {
+    if ((1 > uiArg[0]) || (CS10_MACRO_POSITIONS < uiArg[0]))
+      return false ;
+
+    pStep->ucAction = MACRO_LOCATE_SAVED ;
+    pStep->ucArg[0] = uiArg[0] - 1 ;
+    return true ;
+  } /* if */
+
+  if (4 == sscanf(pLine, "locate %u:%u:%u:%u %c",
+                  &uiArg[0], &uiArg[1], &uiArg[2], &uiArg[3], &cExtra)) {
+    if ((23 < uiArg[0]) || (59 < uiArg[1]) ||
+        (59 < uiArg[2]) || (29 < uiArg[3]))
+      return false ;
+
+    pStep->ucAction = MACRO_LOCATE ;
+    pStep->ucArg[0] = uiArg[0] ;
+    pStep->ucArg[1] = uiArg[1] ;
+    pStep->ucArg[2] = uiArg[2] ;
+    pStep->ucArg[3] = uiArg[3] ;
+    return true ;
+  } /* if */
+
+  if (3 == sscanf(pLine, "set %u %15s %u %c",
+                  &uiArg[0], cControl, &uiArg[2], &cExtra)) {
+    for (uiArg[1] = 0 ; uiArg[1] < NUM_VIRTUAL_TRACK_CONTROLS ; uiArg[1]++) {
+      if (0 == strcmp(ppControlNames[uiArg[1]], cControl))
+        break ;
+    } /* for */
+
+    if ((1 > uiArg[0]) || (CS10_MAP_MAX_STRIPS < uiArg[0]) ||
+        (NUM_VIRTUAL_TRACK_CONTROLS == uiArg[1]) || (0x7f < uiArg[2]))
+      return false ;
+
+    pStep->ucAction = MACRO_SET ;
+    pStep->ucArg[0] = uiArg[0] - 1 ;
+    pStep->ucArg[1] = uiArg[1] ;
+    pStep->ucArg[2] = uiArg[2] ;
+    return true ;
+  } /* if */
+
+  return false ;
+} /* cs10_macro_parse_step */
+
+/*
+ * cs10_macro_load
+ *
+ * replace every macro with those in pFilename
+ * return false if the file can't be read
+ */
+bool
+cs10_macro_load(
+  const char *pFilename,
+  const char * const *ppControlNames) {
+
+  FILE         *fp ;
+  char          cLine[256] ;
+  unsigned int  uiLine = 0 ;
+  cs10_macro_t *pMacro = NULL ;
+  uint32_t      ulWaitMs = 0 ;
+
+  fp = fopen(pFilename, "r") ;
+
+  if (NULL == fp)
+    return false ;
+
+  memset(macros.macro, 0, sizeof(macros.macro)) ;
+
+  while (fgets(cLine, sizeof(cLine), fp)) {
+    char              *pLine = cLine ;
+    cs10_macro_step_t  theStep ;
+    unsigned int       uiNumber ;
+    char               cExtra ;
+
+    uiLine++ ;
+
+    while (isspace((unsigned char)*pLine))
+      pLine++ ;
+
+    if (('\0' == *pLine) || ('#' == *pLine))
+      continue ;
+
+    if (1 == sscanf(pLine, "macro %u %c", &uiNumber, &cExtra)) {
+      if ((1 > uiNumber) || (CS10_MACRO_SLOTS < uiNumber)) {
+        fprintf(stderr, "%s:%u: no macro %u\n",
+          pFilename, uiLine, uiNumber) ;
+        pMacro = NULL ;
+        continue ;
+      } /* if */
+
+      pMacro = &macros.macro[uiNumber - 1] ;
+      pMacro->uiSteps = 0 ;
+      ulWaitMs = 0 ;
+      continue ;
+    } /* if */
+
+    if (NULL == pMacro)
+      continue ;
+
+    if (1 == sscanf(pLine, "wait %u %c", &uiNumber, &cExtra)) {
+      ulWaitMs += uiNumber ;
+      if (CS10_MACRO_MAX_WAIT_MS < ulWaitMs)
+        ulWaitMs = CS10_MACRO_MAX_WAIT_MS ;
+      continue ;
+    } /* if */
+
+    memset(&theStep, 0, sizeof(theStep)) ;
+
+    if (!cs10_macro_parse_step(pLine, ppControlNames, &theStep)) {
+      fprintf(stderr, "%s:%u: ignoring step %s", pFilename, uiLine, pLine) ;
+      continue ;
+    } /* if */
+
+    if (CS10_MACRO_STEPS == pMacro->uiSteps) {
+      fprintf(stderr, "%s:%u: too many steps\n", pFilename, uiLine) ;
+      continue ;
+    } /* if */
+
+    theStep.ulWaitMs = ulWaitMs ;
+    pMacro->step[pMacro->uiSteps++] = theStep ;
+    ulWaitMs = 0 ;
+  } /* while */
+
+  fclose(fp) ;
+
+  return true ;
+} /* cs10_macro_load */
+
+/*
+ * cs10_macro_save
+ *
+ * write every macro to pFilename, as cs10_macro_load reads them
+ */
+bool
+cs10_macro_save(
+  const char *pFilename,
+  const char * const *ppControlNames) {
+
+  FILE        *fp ;
+  unsigned int uiSlot ;
+  unsigned int uiStep ;
+
+  fp = fopen(pFilename, "w") ;
+
+  if (NULL == fp)
+    return false ;
+
+  fprintf(fp, "# cs10-linux button macros, shift and a track button runs one\n") ;
+
+  for (uiSlot = 0 ; uiSlot < CS10_MACRO_SLOTS ; uiSlot++) {
+    const cs10_macro_t *pMacro = &macros.macro[uiSlot] ;
+
+    if (0 == pMacro->uiSteps)
+      continue ;
+
+    fprintf(fp, "\nmacro %u\n", uiSlot + 1) ;
+
+    for (uiStep = 0 ; uiStep < pMacro->uiSteps ; uiStep++) {
+      const cs10_macro_step_t *pStep = &pMacro->step[uiStep] ;
+
+      if (pStep->ulWaitMs)
+        fprintf(fp, "wait %lu\n", (unsigned long)pStep->ulWaitMs) ;
+
+      switch (pStep->ucAction) {
+        case MACRO_LOCATE_SAVED:
+          fprintf(fp, "locate f%u\n", pStep->ucArg[0] + 1) ;
+          break ;
+
+        case MACRO_LOCATE:
+          fprintf(fp, "locate %02u:%02u:%02u:%02u\n",
+            pStep->ucArg[0], pStep->ucArg[1],
+            pStep->ucArg[2], pStep->ucArg[3]) ;
+          break ;
+
+        case MACRO_SET:
+          fprintf(fp, "set %u %s %u\n", pStep->ucArg[0] + 1,
+            ppControlNames[pStep->ucArg[1]], pStep->ucArg[2]) ;
+          break ;
+
+        default:
+          fprintf(fp, "%s\n", actionName[pStep->ucAction]) ;
+          break ;
+      } /* switch */
+    } /* for */
+  } /* for */
+
+  return (0 == fclose(fp)) ;
+} /* cs10_macro_save */
+
+/*
+ * cs10_macro_get
+ *
+ * macro uiSlot, NULL if it has no steps
+ */
+const cs10_macro_t *
+cs10_macro_get(
+  unsigned int uiSlot) {
+
+  if ((CS10_MACRO_SLOTS <= uiSlot) || (0 == macros.macro[uiSlot].uiSteps))
+    return NULL ;
+
+  return &macros.macro[uiSlot] ;
+} /* cs10_macro_get */
+
+/*
+ * cs10_macro_record_start
+ *
+ * start recording a macro, steps are timed from now
+ */
+void
+cs10_macro_record_start(void) {
+
+  macros.recording.uiSteps = 0 ;
+  macros.ulLastStep = cs10_macro_now_ms() ;
+  macros.bRecording = true ;
+} /* cs10_macro_record_start */
+
+/*
+ * cs10_macro_is_recording
+ *
+ * are we recording a macro
+ */
+bool
+cs10_macro_is_recording(void) {
+
+  return macros.bRecording ;
+} /* cs10_macro_is_recording */
+
+/*
+ * cs10_macro_record_step
+ *
+ * add action to the macro being recorded, waiting as long as it has
+ * been since the last step, the first step goes straight away
+ */
+void
+cs10_macro_record_step(
+  cs10_macro_action_t action,
+  unsigned int uiArg0,
+  unsigned int uiArg1,
+  unsigned int uiArg2,
+  unsigned int uiArg3) {
+
+  cs10_macro_step_t *pStep ;
+  uint32_t           ulNow = cs10_macro_now_ms() ;
+
+  if (!macros.bRecording ||
+      (CS10_MACRO_STEPS == macros.recording.uiSteps))
+    return ;
+
+  pStep = &macros.recording.step[macros.recording.uiSteps] ;
+
+  pStep->ulWaitMs = (macros.recording.uiSteps ?
+                     ulNow - macros.ulLastStep : 0) ;
+  if (CS10_MACRO_MAX_WAIT_MS < pStep->ulWaitMs)
+    pStep->ulWaitMs = CS10_MACRO_MAX_WAIT_MS ;
+
+  pStep->ucAction = action ;
+  pStep->ucArg[0] = uiArg0 ;
+  pStep->ucArg[1] = uiArg1 ;
+  pStep->ucArg[2] = uiArg2 ;
+  pStep->ucArg[3] = uiArg3 ;
+
+  macros.recording.uiSteps++ ;
+  macros.ulLastStep = ulNow ;
+} /* cs10_macro_record_step */
+
+/*
+ * cs10_macro_record_keep
+ *
+ * stop recording and keep what was recorded as macro uiSlot
+ * return false if nothing was
+ */
+bool
+cs10_macro_record_keep(
+  unsigned int uiSlot) {
+
+  macros.bRecording = false ;
+
+  if ((CS10_MACRO_SLOTS <= uiSlot) || (0 == macros.recording.uiSteps))
+    return false ;
+
+  macros.macro[uiSlot] = macros.recording ;
+
+  return true ;
+} /* cs10_macro_record_keep */
+
+/*
+ * cs10_macro_record_abandon
+ *
+ * stop recording and forget what was recorded
+ */
+void
+cs10_macro_record_abandon(void) {
+
+  macros.bRecording = false ;
+} /* cs10_macro_record_abandon */
+
+/*
+ * cs10_macro_queue_open
+ *
+ * get a queue of our own going on pSeq, with room in its pool and output
+ * buffer for a macro of uiEvents events on top of what's there already
+ */
+bool
+cs10_macro_queue_open(
+  snd_seq_t *pSeq,
+  unsigned int uiEvents) {
+
+  snd_seq_client_pool_t *pPool ;
+  size_t                 uiBuffer ;
+
+  cs10_macro_queue_close() ;
+
+  snd_seq_client_pool_alloca(&pPool) ;
+
+  if ((0 > snd_seq_get_client_pool(pSeq, pPool)) ||
+      (0 > snd_seq_set_client_pool_output(pSeq,
+             snd_seq_client_pool_get_output_pool(pPool) + uiEvents)))
+    return false ;
+
+  /* a locate is the longest event a macro makes */
+  uiBuffer = snd_seq_get_output_buffer_size(pSeq) +
+             uiEvents * (sizeof(snd_seq_event_t) + MMC_GOTO_SYSEX_PACKET_LENGTH) ;
+
+  if (0 > snd_seq_set_output_buffer_size(pSeq, uiBuffer))
+    return false ;
+
+  macros.iQueue = snd_seq_alloc_named_queue(pSeq, CS10_MACRO_QUEUE_NAME) ;
+
+  if (macros.iQueue < 0)
+    return false ;
+
+  macros.pSeq = pSeq ;
+
+  snd_seq_start_queue(pSeq, macros.iQueue, NULL) ;
+  snd_seq_drain_output(pSeq) ;
+
+  return true ;
+} /* cs10_macro_queue_open */
+
+/*
+ * cs10_macro_cancel
+ *
+ * drop whatever a macro still has waiting on the queue
+ */
+static void
+cs10_macro_cancel(void) {
+
+  snd_seq_remove_events_t *pRemove ;
+
+  snd_seq_remove_events_alloca(&pRemove) ;
+  snd_seq_remove_events_set_queue(pRemove, macros.iQueue) ;
+  snd_seq_remove_events_set_condition(pRemove, SND_SEQ_REMOVE_OUTPUT) ;
+  snd_seq_remove_events(macros.pSeq, pRemove) ;
+} /* cs10_macro_cancel */
+
+/*
+ * cs10_macro_queue_close
+ *
+ * drop anything still waiting and free the queue
+ */
+void
+cs10_macro_queue_close(void) {
+
+  if (macros.iQueue < 0)
+    return ;
+
+  cs10_macro_cancel() ;
+  snd_seq_free_queue(macros.pSeq, macros.iQueue) ;
+  macros.iQueue = -1 ;
+} /* cs10_macro_queue_close */
+
+/*
+ * cs10_macro_schedule
+ *
+ * put uiEvents events on the queue, pEvents[n] due pulDueMs[n] from now,
+ * each out of the port set as its source
+ * return false if the sequencer wouldn't take them all, whatever is
+ * left in the output buffer goes with the next drain of pSeq
+ */
+bool
+cs10_macro_schedule(
+  snd_seq_event_t *pEvents,
+  const uint32_t *pulDueMs,
+  unsigned int uiEvents) {
+
+  unsigned int uiEvent ;
+  unsigned int uiLost = 0 ;
+
+  if (macros.iQueue < 0)
+    return false ;
+
+  cs10_macro_cancel() ;
+
+  for (uiEvent = 0 ; uiEvent < uiEvents ; uiEvent++) {
+    snd_seq_event_t    *pEvent = &pEvents[uiEvent] ;
+    snd_seq_real_time_t tDue ;
+
+    tDue.tv_sec = pulDueMs[uiEvent] / 1000 ;
+    tDue.tv_nsec = (pulDueMs[uiEvent] % 1000) * 1000000 ;
+
+    snd_seq_ev_set_dest(pEvent, SND_SEQ_ADDRESS_SUBSCRIBERS, 0) ;
+    snd_seq_ev_schedule_real(pEvent, macros.iQueue, 1, &tDue) ;
+
+    /* the buffer was sized for a whole macro when the queue was opened */
+    if (0 > snd_seq_event_output_buffer(macros.pSeq, pEvent))
+      uiLost++ ;
+  } /* for */
+
+  if (0 != snd_seq_drain_output(macros.pSeq))
+    return false ;
+
+  return (0 == uiLost) ;
+} /* cs10_macro_schedule */
@@ -0,0 +1,356 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "cs10-map.h"
+
+/*****************************************************************************/
+
+#define MAP_XML_TAG      "<ArdourMIDIBindings"
+#define MAP_BINDING_TAG  "<Binding"
+#define MAP_MAX_VALUE    128
+
+/*****************************************************************************/
+
+/*
+ * cs10_map_clear
+ *
+ * forget every binding
+ */
+static void
+cs10_map_clear(
+  cs10_map_t *pMap) {
+
+  memset(pMap->ucChannel, CS10_MAP_UNMAPPED, sizeof(pMap->ucChannel)) ;
+  memset(pMap->ucCC, CS10_MAP_UNMAPPED, sizeof(pMap->ucCC)) ;
+  memset(pMap->ucStrip, CS10_MAP_UNMAPPED, sizeof(pMap->ucStrip)) ;
+  memset(pMap->ucControl, CS10_MAP_UNMAPPED, sizeof(pMap->ucControl)) ;
+  pMap->uiBindings = 0 ;
+} /* cs10_map_clear */
+
+/*
+ * cs10_map_bind
+ *
+ * carry uiStrip's tcControl on uiChannel's uiCC
+ * a cc bound twice keeps the later binding, a control bound to several
+ * ccs is read from all of them and sent on the last
+ */
+static void
+cs10_map_bind(
+  cs10_map_t *pMap,
+  unsigned int uiChannel,
+  unsigned int uiCC,
+  unsigned int uiStrip,
+  virtual_track_control_t tcControl) {
+
+  pMap->ucChannel[uiStrip][tcControl] = uiChannel ;
+  pMap->ucCC[uiStrip][tcControl] = uiCC ;
+
+  pMap->ucStrip[uiChannel][uiCC] = uiStrip ;
+  pMap->ucControl[uiChannel][uiCC] = tcControl ;
+
+  pMap->uiBindings++ ;
+} /* cs10_map_bind */
+
+/*
+ * cs10_map_default
+ *
+ * the layout cs10-linux has always used: uiStripsPerChannel strips to a
+ * channel from uiFirstChannel on, each taking NUM_VIRTUAL_TRACK_CONTROLS
+ * consecutive ccs in control order
+ */
+void
+cs10_map_default(
+  cs10_map_t *pMap,
+  unsigned int uiFirstChannel,
+  unsigned int uiStripsPerChannel,
+  unsigned int uiStrips) {
+
+  unsigned int uiStrip ;
+  unsigned int uiControl ;
+
+  cs10_map_clear(pMap) ;
+
+  for (uiStrip = 0 ;
+       (uiStrip < uiStrips) && (uiStrip < CS10_MAP_MAX_STRIPS) ;
+       uiStrip++) {
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++)
+      cs10_map_bind(pMap,
+        uiFirstChannel + uiStrip / uiStripsPerChannel,
+        (uiStrip % uiStripsPerChannel) * NUM_VIRTUAL_TRACK_CONTROLS +
+          uiControl,
+        uiStrip, uiControl) ;
+  } /* for */
+} /* cs10_map_default */
+
+/*
+ * cs10_map_parse_uri
+ *
+ * turn an ardour binding uri into the strip and control it drives
+ *   /route/recenable N, /route/mute N, /route/solo N, /route/gain N,
+ *   /route/plugin/parameter P 1 N, for P of 1 to 3 on the first plugin,
+ *   /route/send/gain S N, for S of 1 or 2, and /route/pandirection N
+ * N counts from 1, the strip returned counts from 0
+ */
+bool
+cs10_map_parse_uri(
+  const char *pURI,
+  unsigned int *puiStrip,
+  virtual_track_control_t *pControl) {
+
+  unsigned int uiArg[3] ;
+  char         cExtra ;
+
+  /* a trailing %c only matches when there is junk after the uri */
+  if (1 == sscanf(pURI, "/route/recenable %u %c", &uiArg[0], &cExtra))
+    *pControl = ARMED_CONTROL ;
+  else
+  if (1 == sscanf(pURI, "/route/mute %u %c", &uiArg[0], &cExtra))
+    *pControl = MUTE_CONTROL ;
+  else
+  if (1 == sscanf(pURI, "/route/solo %u %c", &uiArg[0], &cExtra))
+    *pControl = SOLO_CONTROL ;
+  else
+  if (1 == sscanf(pURI, "/route/gain %u %c", &uiArg[0], &cExtra))
+    *pControl = FADER_CONTROL ;
+  else
+  if (1 == sscanf(pURI, "/route/pandirection %u %c", &uiArg[0], &cExtra))
+    *pControl = PAN_CONTROL ;
+  else
+  if (3 == sscanf(pURI, "/route/plugin/parameter %u %u %u %c",
+                  &uiArg[1], &uiArg[2], &uiArg[0], &cExtra)) {
+    if ((1 != uiArg[2]) || (1 > uiArg[1]) || (3 < uiArg[1]))
+      return false ;
+
+    *pControl = BOOST_CUT_CONTROL + uiArg[1] - 1 ;
+  } else
+  if (2 == sscanf(pURI, "/route/send/gain %u %u %c",
+                  &uiArg[1], &uiArg[0], &cExtra)) {
+    if ((1 > uiArg[1]) || (2 < uiArg[1]))
+      return false ;
+
+    *pControl = SEND_ONE_CONTROL + uiArg[1] - 1 ;
+  } else
+    return false ;
+
+  if ((1 > uiArg[0]) || (CS10_MAP_MAX_STRIPS < uiArg[0]))
+    return false ;
+
+  *puiStrip = uiArg[0] - 1 ;
+
+  return true ;
+} /* cs10_map_parse_uri */
+
+/*
+ * cs10_map_add_binding
+ *
+ * bind pURI to channel and cc as written in a map file, channel from 1
+ */
+static bool
+cs10_map_add_binding(
+  cs10_map_t *pMap,
+  unsigned long ulChannel,
+  unsigned long ulCC,
+  const char *pURI) {
+
+  unsigned int            uiStrip ;
+  virtual_track_control_t tcControl ;
+
+  if ((1 > ulChannel) || (CS10_MAP_NUM_CHANNELS < ulChannel) ||
+      (CS10_MAP_NUM_CCS <= ulCC) ||
+      !cs10_map_parse_uri(pURI, &uiStrip, &tcControl))
+    return false ;
+
+  cs10_map_bind(pMap, ulChannel - 1, ulCC, uiStrip, tcControl) ;
+
+  return true ;
+} /* cs10_map_add_binding */
+
+/*
+ * cs10_map_attribute
+ *
+ * copy the value of pName="..." from the tag running from pTag to pEnd
+ */
+static bool
+cs10_map_attribute(
+  const char *pTag,
+  const char *pEnd,
+  const char *pName,
+  char *pValue,
+  size_t uiSize) {
+
+  size_t      uiNameLength = strlen(pName) ;
+  const char *pFound = pTag ;
+
+  while ((pFound = strstr(pFound, pName)) && (pFound < pEnd)) {
+    const char *pStart = pFound + uiNameLength ;
+    const char *pClose ;
+
+    if (isspace((unsigned char)pFound[-1]) &&
+        ('=' == pStart[0]) && ('"' == pStart[1])) {
+      pStart += 2 ;
+      pClose = strchr(pStart, '"') ;
+
+      if ((NULL == pClose) || (pClose > pEnd) ||
+          ((size_t)(pClose - pStart) >= uiSize))
+        return false ;
+
+      memcpy(pValue, pStart, pClose - pStart) ;
+      pValue[pClose - pStart] = '\0' ;
+      return true ;
+    } /* if */
+
+    pFound = pStart ;
+  } /* while */
+
+  return false ;
+} /* cs10_map_attribute */
+
+/*
+ * cs10_map_parse_xml
+ *
+ * pick the cc bindings out of an ardour generic midi map
+ * note, pitchbend and encoder bindings are none of our business
+ */
+static void
+cs10_map_parse_xml(
+  cs10_map_t *pMap,
+  const char *pText,
+  const char *pFilename) {
+
+  const char *pNext = pText ;
+
+  for (;;) {
+    const char *pBinding = strstr(pNext, MAP_BINDING_TAG) ;
+    const char *pComment = strstr(pNext, "<!--") ;
+    const char *pEnd ;
+    char        cChannel[8] ;
+    char        cCC[8] ;
+    char        cURI[MAP_MAX_VALUE] ;
+
+    if (NULL == pBinding)
+      break ;
+
+    /* skip commented out bindings */
+    if (pComment && (pComment < pBinding)) {
+      pNext = strstr(pComment, "-->") ;
+
+      if (NULL == pNext)
+        break ;
+      continue ;
+    } /* if */
+
+    pEnd = strchr(pBinding, '>') ;
+
+    if (NULL == pEnd)
+      break ;
+
+    pNext = pEnd + 1 ;
+
+    if (!cs10_map_attribute(pBinding, pEnd, "ctl", cCC, sizeof(cCC)))
+      continue ;
+
+    if (!cs10_map_attribute(pBinding, pEnd, "channel",
+                            cChannel, sizeof(cChannel)) ||
+        !cs10_map_attribute(pBinding, pEnd, "uri", cURI, sizeof(cURI)) ||
+        !cs10_map_add_binding(pMap, strtoul(cChannel, NULL, 10),
+                              strtoul(cCC, NULL, 10), cURI))
+      fprintf(stderr, "%s: ignoring binding %.*s\n",
+        pFilename, (int)(pEnd - pBinding + 1), pBinding) ;
+  } /* for */
+} /* cs10_map_parse_xml */
+
+/*
+ * cs10_map_parse_text
+ *
+ * read the native format, one binding to a line:
+ *   channel cc uri
+ * with the channel counting from 1 and the uri as ardour writes it,
+ * blank lines and lines starting with # are skipped
+ */
+static void
+cs10_map_parse_text(
+  cs10_map_t *pMap,
+  char *pText,
+  const char *pFilename) {
+
+  unsigned int uiLine = 0 ;
+  char        *pLine ;
+  char        *pSave = NULL ;
+
+  for (pLine = strtok_r(pText, "\n", &pSave) ;
+       pLine ;
+       pLine = strtok_r(NULL, "\n", &pSave)) {
+    unsigned long ulChannel ;
+    unsigned long ulCC ;
+    int           iURI = 0 ;
+
+    uiLine++ ;
+
+    while (isspace((unsigned char)*pLine))
+      pLine++ ;
+
+    if (('\0' == *pLine) || ('#' == *pLine))
+      continue ;
+
+    if ((2 != sscanf(pLine, "%lu %lu %n", &ulChannel, &ulCC, &iURI)) ||
+        (0 == iURI) ||
+        !cs10_map_add_binding(pMap, ulChannel, ulCC, pLine + iURI))
+      fprintf(stderr, "%s:%u: ignoring binding %s\n",
+        pFilename, uiLine, pLine) ;
+  } /* for */
+} /* cs10_map_parse_text */
+
+/*
+ * cs10_map_load
+ *
+ * replace pMap with the bindings in pFilename
+ * return false if the file can't be read or binds nothing
+ */
+bool
+cs10_map_load(
+  cs10_map_t *pMap,
+  const char *pFilename) {
+
+  FILE *fp ;
+  char *pText ;
+  long  lLength ;
+
+  fp = fopen(pFilename, "r") ;
+
+  if (NULL == fp)
+    return false ;
+
+  if ((0 != fseek(fp, 0, SEEK_END)) ||
+      (0 > (lLength = ftell(fp))) ||
+      (0 != fseek(fp, 0, SEEK_SET))) {
+    fclose(fp) ;
+    return false ;
+  } /* if */
+
+  pText = malloc(lLength + 1) ;
+
+  if (NULL == pText) {
+    fclose(fp) ;
+    return false ;
+  } /* if */
+
+  lLength = fread(pText, 1, lLength, fp) ;
+  pText[lLength] = '\0' ;
+  fclose(fp) ;
+
+  cs10_map_clear(pMap) ;
+
+  if (strstr(pText, MAP_XML_TAG))
+    cs10_map_parse_xml(pMap, pText, pFilename) ;
+  else
+    cs10_map_parse_text(pMap, pText, pFilename) ;
+
+  free(pText) ;
+
+  return (0 != pMap->uiBindings) ;
+} /* cs10_map_load */
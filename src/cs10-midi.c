@@ -0,0 +1,154 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "cs10-midi.h"
+
+/*****************************************************************************/
+
+/*
+ * cs10_midi_data_length
+ *
+ * how many data bytes follow ucStatus
+ */
+static unsigned int
+cs10_midi_data_length(
+  unsigned char ucStatus) {
+
+  switch (MIDI_STATUS_TYPE(ucStatus)) {
+    case MIDI_PROGRAM_CHANGE:
+    case MIDI_CHAN_PRESSURE:
+      return 1 ;
+
+    case 0xF0:
+      switch (ucStatus) {
+        case 0xF1: /* mtc quarter frame */
+        case 0xF3: /* song select */
+          return 1 ;
+
+        case 0xF2: /* song position */
+          return 2 ;
+
+        default:
+          return 0 ;
+      } /* switch */
+
+    default:
+      return 2 ;
+  } /* switch */
+} /* cs10_midi_data_length */
+
+/*
+ * cs10_midi_parser_init
+ *
+ * start from a clean slate, with no running status
+ */
+void
+cs10_midi_parser_init(
+  cs10_midi_parser_t *pParser) {
+
+  memset(pParser, 0, sizeof(cs10_midi_parser_t)) ;
+} /* cs10_midi_parser_init */
+
+/*
+ * cs10_midi_parse_byte
+ *
+ * feed one byte from the wire
+ * return true, and fill in pMessage, when a message is complete
+ */
+bool
+cs10_midi_parse_byte(
+  cs10_midi_parser_t *pParser,
+  unsigned char ucByte,
+  cs10_midi_message_t *pMessage) {
+
+  memset(pMessage, 0, sizeof(cs10_midi_message_t)) ;
+
+  /* real time bytes can turn up anywhere and don't disturb anything */
+  if (MIDI_REAL_TIME_FIRST <= ucByte) {
+    pMessage->ucStatus = ucByte ;
+    return true ;
+  } /* if */
+
+  if (pParser->bInSysex) {
+    if (ucByte & 0x80) {
+      bool bComplete = ((MIDI_SYSEX_END == ucByte) &&
+                        !pParser->bSysexOverflow) ;
+
+      pParser->bInSysex = false ;
+
+      if (bComplete) {
+        pParser->ucSysex[pParser->uiSysexLength++] = ucByte ;
+
+        pMessage->ucStatus = MIDI_SYSEX_START ;
+        pMessage->pSysex = pParser->ucSysex ;
+        pMessage->uiSysexLength = pParser->uiSysexLength ;
+        return true ;
+      } /* if */
+
+      /* a truncated or oversized packet is dropped, any other status
+       * byte that cut it short still gets parsed below
+       */
+      if (MIDI_SYSEX_END == ucByte)
+        return false ;
+    } else {
+      /* leave room for the closing f7 */
+      if (pParser->uiSysexLength < CS10_MIDI_MAX_SYSEX - 1)
+        pParser->ucSysex[pParser->uiSysexLength++] = ucByte ;
+      else
+        pParser->bSysexOverflow = true ;
+      return false ;
+    } /* else */
+  } /* if */
+
+  if (ucByte & 0x80) {
+    pParser->uiDataCount = 0 ;
+
+    if (MIDI_SYSEX_START == ucByte) {
+      pParser->bInSysex = true ;
+      pParser->bSysexOverflow = false ;
+      pParser->ucSysex[0] = ucByte ;
+      pParser->uiSysexLength = 1 ;
+      pParser->ucRunningStatus = 0 ;
+      return false ;
+    } /* if */
+
+    if (0xF0 == MIDI_STATUS_TYPE(ucByte)) {
+      /* system common messages cancel running status */
+      pParser->ucRunningStatus = 0 ;
+
+      if (0 == cs10_midi_data_length(ucByte)) {
+        if (MIDI_SYSEX_END == ucByte)
+          return false ; /* stray end of sysex */
+
+        pMessage->ucStatus = ucByte ;
+        return true ;
+      } /* if */
+    } /* if */
+
+    pParser->ucRunningStatus = ucByte ;
+    return false ;
+  } /* if */
+
+  /* a data byte with no status to hang it off */
+  if (0 == pParser->ucRunningStatus)
+    return false ;
+
+  pParser->ucData[pParser->uiDataCount++] = ucByte ;
+
+  if (pParser->uiDataCount < cs10_midi_data_length(pParser->ucRunningStatus))
+    return false ;
+
+  pMessage->ucStatus = pParser->ucRunningStatus ;
+  pMessage->ucData1 = pParser->ucData[0] ;
+  pMessage->ucData2 = (2 == pParser->uiDataCount) ? pParser->ucData[1] : 0 ;
+
+  pParser->uiDataCount = 0 ;
+
+  /* system common messages don't run */
+  if (0xF0 == MIDI_STATUS_TYPE(pParser->ucRunningStatus))
+    pParser->ucRunningStatus = 0 ;
+
+  return true ;
+} /* cs10_midi_parse_byte */
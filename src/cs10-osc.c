@@ -0,0 +1,314 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "cs10-osc.h"
+
+/*****************************************************************************/
+
+#define OSC_BUNDLE_TAG      "#bundle"
+#define OSC_TIMETAG_NOW     1ULL   /* the special timetag for immediately */
+
+static struct CS10_OSC_S {
+  int           iSocket ;
+
+  unsigned long ulMessages ;
+  unsigned long ulPackets ;
+  unsigned long ulDropped ;
+} osc = { -1, 0, 0, 0 } ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_osc_open
+ *
+ * set up a udp socket aimed at pHostPort, given as host:port
+ */
+bool
+cs10_osc_open(
+  const char *pHostPort) {
+
+  struct addrinfo  hints ;
+  struct addrinfo *pResults ;
+  struct addrinfo *pAddr ;
+  char            *pHost ;
+  char            *pPort ;
+
+  pHost = strdup(pHostPort) ;
+
+  if (NULL == pHost)
+    return false ;
+
+  pPort = strrchr(pHost, ':') ;
+
+  if ((NULL == pPort) || (pPort == pHost) || ('\0' == pPort[1])) {
+    free(pHost) ;
+    return false ;
+  } /* if */
+
+  *pPort++ = '\0' ;
+
+  memset(&hints, 0, sizeof(hints)) ;
+  hints.ai_family = AF_UNSPEC ;
+  hints.ai_socktype = SOCK_DGRAM ;
+
+  if (0 != getaddrinfo(pHost, pPort, &hints, &pResults)) {
+    free(pHost) ;
+    return false ;
+  } /* if */
+
+  for (pAddr = pResults ; pAddr ; pAddr = pAddr->ai_next) {
+    osc.iSocket = socket(pAddr->ai_family, pAddr->ai_socktype,
+                         pAddr->ai_protocol) ;
+
+    if (0 > osc.iSocket)
+      continue ;
+
+    if (0 == connect(osc.iSocket, pAddr->ai_addr, pAddr->ai_addrlen))
+      break ;
+
+    close(osc.iSocket) ;
+    osc.iSocket = -1 ;
+  } /* for */
+
+  freeaddrinfo(pResults) ;
+  free(pHost) ;
+
+  if (0 > osc.iSocket)
+    return false ;
+
+  /* a busy network drops a datagram rather than holding up the surface */
+  fcntl(osc.iSocket, F_SETFL, fcntl(osc.iSocket, F_GETFL) | O_NONBLOCK) ;
+
+  return true ;
+} /* cs10_osc_open */
+
+/*
+ * cs10_osc_close
+ *
+ * stop sending
+ */
+void
+cs10_osc_close(void) {
+
+  if (0 <= osc.iSocket)
+    close(osc.iSocket) ;
+
+  osc.iSocket = -1 ;
+} /* cs10_osc_close */
+
+/*
+ * cs10_osc_is_open
+ *
+ * is there anywhere to send to
+ */
+bool
+cs10_osc_is_open(void) {
+
+  return (0 <= osc.iSocket) ;
+} /* cs10_osc_is_open */
+
+/*
+ * cs10_osc_packet_init
+ *
+ * empty pPacket, ready for one message or, with bBundle, a bundle of them
+ */
+void
+cs10_osc_packet_init(
+  cs10_osc_packet_t *pPacket,
+  bool bBundle) {
+
+  pPacket->bBundle = bBundle ;
+  pPacket->uiLength = 0 ;
+
+  if (bBundle) {
+    uint32_t ulHigh = htonl((uint32_t)(OSC_TIMETAG_NOW >> 32)) ;
+    uint32_t ulLow = htonl((uint32_t)OSC_TIMETAG_NOW) ;
+
+    memcpy(pPacket->ucData, OSC_BUNDLE_TAG, sizeof(OSC_BUNDLE_TAG)) ;
+    memcpy(pPacket->ucData + 8, &ulHigh, 4) ;
+    memcpy(pPacket->ucData + 12, &ulLow, 4) ;
+    pPacket->uiLength = 16 ;
+  } /* if */
+} /* cs10_osc_packet_init */
+
+/*
+ * cs10_osc_add_string
+ *
+ * append pString, nul terminated and padded out to 4 bytes
+ */
+static bool
+cs10_osc_add_string(
+  cs10_osc_packet_t *pPacket,
+  const char *pString) {
+
+  unsigned int uiLength = strlen(pString) + 1 ;
+  unsigned int uiPadded = (uiLength + 3) & ~3U ;
+
+  if (CS10_OSC_MAX_PACKET - pPacket->uiLength < uiPadded)
+    return false ;
+
+  memcpy(pPacket->ucData + pPacket->uiLength, pString, uiLength) ;
+  memset(pPacket->ucData + pPacket->uiLength + uiLength, 0,
+         uiPadded - uiLength) ;
+  pPacket->uiLength += uiPadded ;
+
+  return true ;
+} /* cs10_osc_add_string */
+
+/*
+ * cs10_osc_add_word
+ *
+ * append a 32 bit big endian word
+ */
+static bool
+cs10_osc_add_word(
+  cs10_osc_packet_t *pPacket,
+  uint32_t ulWord) {
+
+  if (CS10_OSC_MAX_PACKET - pPacket->uiLength < 4)
+    return false ;
+
+  ulWord = htonl(ulWord) ;
+  memcpy(pPacket->ucData + pPacket->uiLength, &ulWord, 4) ;
+  pPacket->uiLength += 4 ;
+
+  return true ;
+} /* cs10_osc_add_word */
+
+/*
+ * cs10_osc_add_message
+ *
+ * append the message pPath with arguments described by pTypes,
+ * 'i' for an int and 'f' for a float
+ * return false, leaving pPacket as it was, if it doesn't fit
+ */
+bool
+cs10_osc_add_message(
+  cs10_osc_packet_t *pPacket,
+  const char *pPath,
+  const char *pTypes,
+  ...) {
+
+  va_list      args ;
+  unsigned int uiStart = pPacket->uiLength ;
+  bool         bFits = true ;
+  char         cTypeTag[16] ;
+  const char  *pType ;
+
+  /* a lone message is the whole packet */
+  if (!pPacket->bBundle && pPacket->uiLength)
+    return false ;
+
+  if (sizeof(cTypeTag) - 1 <= strlen(pTypes))
+    return false ;
+
+  cTypeTag[0] = ',' ;
+  strcpy(cTypeTag + 1, pTypes) ;
+
+  /* bundle elements are prefixed by their size, filled in at the end */
+  if (pPacket->bBundle)
+    bFits = cs10_osc_add_word(pPacket, 0) ;
+
+  bFits = bFits &&
+          cs10_osc_add_string(pPacket, pPath) &&
+          cs10_osc_add_string(pPacket, cTypeTag) ;
+
+  va_start(args, pTypes) ;
+
+  for (pType = pTypes ; bFits && *pType ; pType++) {
+    switch (*pType) {
+      case 'i':
+        bFits = cs10_osc_add_word(pPacket, (uint32_t)va_arg(args, int)) ;
+        break ;
+
+      case 'f':
+        {
+          float    fValue = (float)va_arg(args, double) ;
+          uint32_t ulBits ;
+
+          memcpy(&ulBits, &fValue, 4) ;
+          bFits = cs10_osc_add_word(pPacket, ulBits) ;
+        }
+        break ;
+
+      default:
+        bFits = false ;
+        break ;
+    } /* switch */
+  } /* for */
+
+  va_end(args) ;
+
+  if (!bFits) {
+    pPacket->uiLength = uiStart ;
+    return false ;
+  } /* if */
+
+  if (pPacket->bBundle) {
+    uint32_t ulSize = htonl(pPacket->uiLength - uiStart - 4) ;
+
+    memcpy(pPacket->ucData + uiStart, &ulSize, 4) ;
+  } /* if */
+
+  osc.ulMessages++ ;
+
+  return true ;
+} /* cs10_osc_add_message */
+
+/*
+ * cs10_osc_send
+ *
+ * send pPacket as one datagram and empty it for reuse
+ */
+bool
+cs10_osc_send(
+  cs10_osc_packet_t *pPacket) {
+
+  ssize_t iSent ;
+  bool    bBundle = pPacket->bBundle ;
+
+  /* nothing in it */
+  if ((bBundle && (16 == pPacket->uiLength)) || (0 == pPacket->uiLength))
+    return true ;
+
+  iSent = send(osc.iSocket, pPacket->ucData, pPacket->uiLength, 0) ;
+
+  cs10_osc_packet_init(pPacket, bBundle) ;
+
+  if (0 > iSent) {
+    osc.ulDropped++ ;
+    return false ;
+  } /* if */
+
+  osc.ulPackets++ ;
+
+  return true ;
+} /* cs10_osc_send */
+
+/*
+ * cs10_osc_dump_stats
+ *
+ * print the counters
+ */
+void
+cs10_osc_dump_stats(
+  FILE *fp) {
+
+  fprintf(fp, "%-11s messages %lu packets %lu dropped %lu\n",
+    "osc",
+    osc.ulMessages,
+    osc.ulPackets,
+    osc.ulDropped) ;
+} /* cs10_osc_dump_stats */
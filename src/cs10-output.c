@@ -0,0 +1,753 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <alsa/asoundlib.h>
+
+#include "cs10-output.h"
+#include "cs10-trace.h"
+#include "cs10-stats.h"
+
+/*****************************************************************************/
+
+/* what a lane may do when it fills up, before it uses its backlog,
+ * and once the backlog is full too
+ */
+typedef enum CS10_DROP_POLICY_E {
+  NEVER_DROP,        /* wait for the sequencer to take something */
+  HOLD_BACK,         /* nothing, the sender checks for room, then drop */
+  DROP_STALE         /* throw away the oldest latest-value event, then drop */
+} cs10_drop_policy_t ;
+
+static const cs10_drop_policy_t dropPolicy[NUM_OUTPUT_LANES] = {
+  NEVER_DROP,        /* TRANSPORT_LANE */
+  DROP_STALE,        /* INTERACTIVE_LANE */
+  DROP_STALE,        /* FEEDBACK_LANE */
+  HOLD_BACK          /* BULK_LANE, restores check cs10_output_room */
+} ;
+
+/* as many descriptors as a sequencer or rawmidi handle will want */
+#define CS10_OUTPUT_WAIT_FDS 4
+
+static const char *laneName[NUM_OUTPUT_LANES] = {
+  "transport",
+  "interactive",
+  "feedback",
+  "bulk"
+} ;
+
+typedef struct CS10_OUTPUT_SLOT_S {
+  snd_seq_event_t theEvent ;
+  int             iPortID ;   /* the port it goes out of */
+  bool            bLatest ;   /* a newer value for the same target wins */
+  bool            bDelayed ;
+  unsigned char   ucData[CS10_OUTPUT_MAX_SYSEX] ;
+} cs10_output_slot_t ;
+
+#define CS10_OUTPUT_LANE_SLOTS \
+  (CS10_OUTPUT_LANE_DEPTH + CS10_OUTPUT_BACKLOG_DEPTH)
+
+typedef struct CS10_OUTPUT_QUEUE_S {
+  cs10_output_slot_t slot[CS10_OUTPUT_LANE_SLOTS] ;
+  unsigned int       uiHead ;
+  unsigned int       uiCount ;
+} cs10_output_queue_t ;
+
+static struct CS10_OUTPUT_S {
+  snd_seq_t          *pSeq[NUM_OUTPUT_LANES] ;
+  int                 iPortID[NUM_OUTPUT_LANES] ;
+
+  /* lanes routed straight to hardware, bytes the device hasn't taken yet */
+  snd_rawmidi_t      *pRawMidi[NUM_OUTPUT_LANES] ;
+  unsigned char       ucRaw[NUM_OUTPUT_LANES][CS10_OUTPUT_RAW_BUFFER] ;
+  unsigned int        uiRawLength[NUM_OUTPUT_LANES] ;
+
+  cs10_output_queue_t lane[NUM_OUTPUT_LANES] ;
+  cs10_output_stats_t stats[NUM_OUTPUT_LANES] ;
+} output ;
+
+#define SLOT_INDEX(pQueue, n) \
+  (((pQueue)->uiHead + (n)) % CS10_OUTPUT_LANE_SLOTS)
+
+/*****************************************************************************/
+
+/*
+ * cs10_output_init
+ *
+ * route the lanes: feedback goes to the surface, everything else to the daw
+ */
+bool
+cs10_output_init(
+  snd_seq_t *pDAWSeq,
+  int iDAWPortID,
+  snd_seq_t *pSurfaceSeq,
+  int iSurfacePortID) {
+
+  unsigned int uiLane ;
+
+  memset(&output, 0, sizeof(output)) ;
+
+  for (uiLane = 0 ; uiLane < NUM_OUTPUT_LANES ; uiLane++) {
+    if (FEEDBACK_LANE == uiLane) {
+      output.pSeq[uiLane] = pSurfaceSeq ;
+      output.iPortID[uiLane] = iSurfacePortID ;
+    } else {
+      output.pSeq[uiLane] = pDAWSeq ;
+      output.iPortID[uiLane] = iDAWPortID ;
+    } /* else */
+  } /* for */
+
+  return true ;
+} /* cs10_output_init */
+
+/*
+ * cs10_output_use_rawmidi
+ *
+ * send lane straight to a rawmidi device instead of the sequencer
+ */
+void
+cs10_output_use_rawmidi(
+  cs10_output_lane_t lane,
+  snd_rawmidi_t *pRawMidi) {
+
+  output.pRawMidi[lane] = pRawMidi ;
+  output.pSeq[lane] = NULL ;
+  output.uiRawLength[lane] = 0 ;
+} /* cs10_output_use_rawmidi */
+
+/*
+ * cs10_output_target
+ *
+ * whatever lane ends up writing to, lanes sharing one block together
+ */
+static const void *
+cs10_output_target(
+  cs10_output_lane_t lane) {
+
+  if (output.pRawMidi[lane])
+    return output.pRawMidi[lane] ;
+
+  return output.pSeq[lane] ;
+} /* cs10_output_target */
+
+/*
+ * cs10_output_backlog
+ *
+ * is anything for lane sitting below us, in the sequencer or our byte buffer
+ */
+static bool
+cs10_output_backlog(
+  cs10_output_lane_t lane) {
+
+  if (output.pRawMidi[lane])
+    return (0 != output.uiRawLength[lane]) ;
+
+  return (0 < snd_seq_event_output_pending(output.pSeq[lane])) ;
+} /* cs10_output_backlog */
+
+/*
+ * cs10_output_encode
+ *
+ * turn pEvent into the bytes that go down the wire
+ * sysex payloads are already encoded, they are copied as is
+ * return the length, or 0 if pEvent isn't something we send raw
+ */
+static unsigned int
+cs10_output_encode(
+  const snd_seq_event_t *pEvent,
+  unsigned char *pBuffer) {
+
+  switch (pEvent->type) {
+    case SND_SEQ_EVENT_SYSEX:
+      memcpy(pBuffer, pEvent->data.ext.ptr, pEvent->data.ext.len) ;
+      return pEvent->data.ext.len ;
+
+    case SND_SEQ_EVENT_CONTROLLER:
+      pBuffer[0] = 0xB0 | (pEvent->data.control.channel & 0x0F) ;
+      pBuffer[1] = pEvent->data.control.param & 0x7F ;
+      pBuffer[2] = pEvent->data.control.value & 0x7F ;
+      return 3 ;
+
+    default:
+      return 0 ;
+  } /* switch */
+} /* cs10_output_encode */
+
+/*
+ * cs10_output_count_sent
+ *
+ * count pEvent, uiBytes long on the wire, as sent on lane
+ */
+static void
+cs10_output_count_sent(
+  cs10_output_lane_t lane,
+  const snd_seq_event_t *pEvent,
+  unsigned int uiBytes) {
+
+  output.stats[lane].ulSent++ ;
+  CS10_TRACE_INSTANT(laneName[lane], pEvent->type) ;
+
+  if (SND_SEQ_EVENT_CONTROLLER == pEvent->type)
+    CS10_COUNT(CONTROL_OUT_COUNTER) ;
+  else
+  if ((SND_SEQ_EVENT_SYSEX == pEvent->type) && (FEEDBACK_LANE == lane))
+    CS10_COUNT(LED_SYSEX_OUT_COUNTER) ;
+  else
+  if ((SND_SEQ_EVENT_SYSEX == pEvent->type) && (TRANSPORT_LANE == lane))
+    CS10_COUNT(MMC_OUT_COUNTER) ;
+  else
+    CS10_COUNT(OTHER_OUT_COUNTER) ;
+
+  if (FEEDBACK_LANE == lane)
+    CS10_COUNT_ADD(SURFACE_BYTES_OUT_COUNTER, uiBytes) ;
+} /* cs10_output_count_sent */
+
+/*
+ * cs10_output_write_raw
+ *
+ * hand lane's buffered bytes to the device, keeping whatever it won't take
+ */
+static void
+cs10_output_write_raw(
+  cs10_output_lane_t lane) {
+
+  ssize_t iWritten ;
+
+  if (0 == output.uiRawLength[lane])
+    return ;
+
+  CS10_COUNT(OUTPUT_DRAIN_COUNTER) ;
+
+  iWritten = snd_rawmidi_write(output.pRawMidi[lane], output.ucRaw[lane],
+                               output.uiRawLength[lane]) ;
+
+  if ((-EAGAIN == iWritten) || (0 == iWritten))
+    return ;
+
+  if (iWritten < 0) {
+    /* the device is gone or broken, nothing buffered will ever get there */
+    output.uiRawLength[lane] = 0 ;
+    return ;
+  } /* if */
+
+  output.uiRawLength[lane] -= iWritten ;
+  memmove(output.ucRaw[lane], output.ucRaw[lane] + iWritten,
+          output.uiRawLength[lane]) ;
+} /* cs10_output_write_raw */
+
+/*
+ * cs10_output_same_target
+ *
+ * would pNew make pOld stale?
+ * controllers match on channel and param, sysex packets match on
+ * everything but their value byte, the one before the closing f7
+ */
+static bool
+cs10_output_same_target(
+  const snd_seq_event_t *pOld,
+  const snd_seq_event_t *pNew) {
+
+  if (pOld->type != pNew->type)
+    return false ;
+
+  if (SND_SEQ_EVENT_CONTROLLER == pNew->type)
+    return ((pOld->data.control.channel == pNew->data.control.channel) &&
+            (pOld->data.control.param == pNew->data.control.param)) ;
+
+  if ((SND_SEQ_EVENT_SYSEX == pNew->type) &&
+      (pOld->data.ext.len == pNew->data.ext.len) &&
+      (2 <= pNew->data.ext.len))
+    return (0 == memcmp(pOld->data.ext.ptr, pNew->data.ext.ptr,
+                        pNew->data.ext.len - 2)) ;
+
+  return false ;
+} /* cs10_output_same_target */
+
+/*
+ * cs10_output_mark_delayed
+ *
+ * everything still on lane had to wait for the sequencer
+ */
+static void
+cs10_output_mark_delayed(
+  cs10_output_lane_t lane) {
+
+  cs10_output_queue_t *pQueue = &output.lane[lane] ;
+  unsigned int         uiSlot ;
+
+  for (uiSlot = 0 ; uiSlot < pQueue->uiCount ; uiSlot++) {
+    cs10_output_slot_t *pSlot = &pQueue->slot[SLOT_INDEX(pQueue, uiSlot)] ;
+
+    if (!pSlot->bDelayed) {
+      pSlot->bDelayed = true ;
+      output.stats[lane].ulDelayed++ ;
+    } /* if */
+  } /* for */
+} /* cs10_output_mark_delayed */
+
+/*
+ * cs10_output_flush_lane_raw
+ *
+ * pack as much of lane as fits into its byte buffer and write it in one go
+ * return false if the device pushed back
+ */
+static bool
+cs10_output_flush_lane_raw(
+  cs10_output_lane_t lane) {
+
+  cs10_output_queue_t *pQueue = &output.lane[lane] ;
+
+  /* older bytes go first */
+  cs10_output_write_raw(lane) ;
+
+  while (pQueue->uiCount) {
+    snd_seq_event_t *pEvent = &pQueue->slot[pQueue->uiHead].theEvent ;
+    unsigned int     uiLength ;
+
+    if (CS10_OUTPUT_RAW_BUFFER - output.uiRawLength[lane] <
+        CS10_OUTPUT_MAX_SYSEX)
+      break ;
+
+    uiLength = cs10_output_encode(pEvent,
+                 output.ucRaw[lane] + output.uiRawLength[lane]) ;
+
+    if (uiLength) {
+      output.uiRawLength[lane] += uiLength ;
+      cs10_output_count_sent(lane, pEvent, uiLength) ;
+    } else
+      output.stats[lane].ulDropped++ ;
+
+    pQueue->uiHead = (pQueue->uiHead + 1) % CS10_OUTPUT_LANE_SLOTS ;
+    pQueue->uiCount-- ;
+  } /* while */
+
+  cs10_output_write_raw(lane) ;
+
+  if (output.uiRawLength[lane] || pQueue->uiCount) {
+    cs10_output_mark_delayed(lane) ;
+    return false ;
+  } /* if */
+
+  return true ;
+} /* cs10_output_flush_lane_raw */
+
+/*
+ * cs10_output_flush_lane
+ *
+ * write out and drain as much of lane as the sequencer will take
+ * return false if the sequencer pushed back
+ */
+static bool
+cs10_output_flush_lane(
+  cs10_output_lane_t lane) {
+
+  cs10_output_queue_t *pQueue = &output.lane[lane] ;
+  snd_seq_t           *pSeq = output.pSeq[lane] ;
+  int                  iResult ;
+
+  if (output.pRawMidi[lane])
+    return cs10_output_flush_lane_raw(lane) ;
+
+  /* an empty lane still drains, but only a drain with events counts */
+  if (pQueue->uiCount)
+    CS10_COUNT(OUTPUT_DRAIN_COUNTER) ;
+
+  while (pQueue->uiCount) {
+    snd_seq_event_t *pEvent = &pQueue->slot[pQueue->uiHead].theEvent ;
+
+    snd_seq_ev_set_dest(pEvent, SND_SEQ_ADDRESS_SUBSCRIBERS, 0) ;
+    snd_seq_ev_set_source(pEvent, pQueue->slot[pQueue->uiHead].iPortID) ;
+    snd_seq_ev_set_direct(pEvent) ;
+
+    iResult = snd_seq_event_output(pSeq, pEvent) ;
+
+    if ((-EAGAIN == iResult) || (-ENOSPC == iResult))
+      break ;
+
+    if (iResult < 0)
+      output.stats[lane].ulDropped++ ;
+    else
+      cs10_output_count_sent(lane, pEvent,
+        (SND_SEQ_EVENT_SYSEX == pEvent->type) ? pEvent->data.ext.len : 3) ;
+
+    pQueue->uiHead = (pQueue->uiHead + 1) % CS10_OUTPUT_LANE_SLOTS ;
+    pQueue->uiCount-- ;
+  } /* while */
+
+  iResult = snd_seq_drain_output(pSeq) ;
+
+  if ((iResult < 0) && (-EAGAIN != iResult) && (-ENOSPC != iResult)) {
+    /* the sequencer won't ever take what's buffered, don't hang on to it */
+    snd_seq_drop_output(pSeq) ;
+    iResult = 0 ;
+  } /* if */
+
+  if ((0 != iResult) || pQueue->uiCount) {
+    cs10_output_mark_delayed(lane) ;
+    return false ;
+  } /* if */
+
+  return true ;
+} /* cs10_output_flush_lane */
+
+/*
+ * cs10_output_flush
+ *
+ * drain every lane, highest priority first
+ * once a sequencer handle pushes back, lower lanes for that handle stay
+ * queued here rather than piling up in front of later transport commands
+ */
+void
+cs10_output_flush(void) {
+
+  unsigned int uiLane ;
+  unsigned int uiBlocked = 0 ;
+  const void  *pBlocked[NUM_OUTPUT_LANES] ;
+
+  CS10_TRACE_BEGIN("output flush") ;
+
+  for (uiLane = 0 ; uiLane < NUM_OUTPUT_LANES ; uiLane++) {
+    unsigned int uiCheck ;
+
+    for (uiCheck = 0 ; uiCheck < uiBlocked ; uiCheck++) {
+      if (pBlocked[uiCheck] == cs10_output_target(uiLane))
+        break ;
+    } /* for */
+
+    if (uiCheck < uiBlocked) {
+      cs10_output_mark_delayed(uiLane) ;
+      continue ;
+    } /* if */
+
+    if (!cs10_output_flush_lane(uiLane))
+      pBlocked[uiBlocked++] = cs10_output_target(uiLane) ;
+  } /* for */
+
+  CS10_TRACE_END("output flush") ;
+} /* cs10_output_flush */
+
+/*
+ * cs10_output_drop_stale
+ *
+ * make room on a full lane by discarding its oldest latest-value event
+ */
+static bool
+cs10_output_drop_stale(
+  cs10_output_lane_t lane) {
+
+  cs10_output_queue_t *pQueue = &output.lane[lane] ;
+  unsigned int         uiSlot ;
+
+  for (uiSlot = 0 ; uiSlot < pQueue->uiCount ; uiSlot++) {
+    if (pQueue->slot[SLOT_INDEX(pQueue, uiSlot)].bLatest)
+      break ;
+  } /* for */
+
+  if (uiSlot == pQueue->uiCount)
+    return false ;
+
+  /* close the gap, keeping everything else in order */
+  for ( ; uiSlot + 1 < pQueue->uiCount ; uiSlot++) {
+    cs10_output_slot_t *pSlot = &pQueue->slot[SLOT_INDEX(pQueue, uiSlot)] ;
+
+    *pSlot = pQueue->slot[SLOT_INDEX(pQueue, uiSlot + 1)] ;
+
+    if (SND_SEQ_EVENT_SYSEX == pSlot->theEvent.type)
+      pSlot->theEvent.data.ext.ptr = pSlot->ucData ;
+  } /* for */
+
+  pQueue->uiCount-- ;
+  output.stats[lane].ulDropped++ ;
+
+  return true ;
+} /* cs10_output_drop_stale */
+
+/*
+ * cs10_output_wait
+ *
+ * sleep until lane's sequencer, or device, can take more, or
+ * iTimeout ms are up
+ * return false if it still can't
+ */
+static bool
+cs10_output_wait(
+  cs10_output_lane_t lane,
+  int iTimeout) {
+
+  struct pollfd pFDs[CS10_OUTPUT_WAIT_FDS] ;
+  int           iFDs ;
+
+  if (output.pRawMidi[lane])
+    iFDs = snd_rawmidi_poll_descriptors(output.pRawMidi[lane], pFDs,
+                                        CS10_OUTPUT_WAIT_FDS) ;
+  else
+    iFDs = snd_seq_poll_descriptors(output.pSeq[lane], pFDs,
+                                    CS10_OUTPUT_WAIT_FDS, POLLOUT) ;
+
+  if (iFDs <= 0)
+    return false ;
+
+  return (0 < poll(pFDs, iFDs, iTimeout)) ;
+} /* cs10_output_wait */
+
+/*
+ * cs10_output_make_room
+ *
+ * get a free slot on a full lane, according to the lane's policy, or
+ * else one in its backlog
+ * a never drop lane with a full backlog waits for the sequencer, for
+ * up to CS10_OUTPUT_WAIT_MS, and says so if even that isn't enough
+ * return false if there is still no room
+ */
+static bool
+cs10_output_make_room(
+  cs10_output_lane_t lane) {
+
+  cs10_output_queue_t *pQueue = &output.lane[lane] ;
+  struct timespec      tStart ;
+  struct timespec      tNow ;
+  long                 lWaited ;
+
+  cs10_output_flush() ;
+
+  if (CS10_OUTPUT_LANE_DEPTH > pQueue->uiCount)
+    return true ;
+
+  if ((DROP_STALE == dropPolicy[lane]) && cs10_output_drop_stale(lane))
+    return true ;
+
+  /* the poll loop comes back for it in CS10_OUTPUT_RETRY_MS */
+  if (CS10_OUTPUT_LANE_SLOTS > pQueue->uiCount)
+    return true ;
+
+  if (NEVER_DROP != dropPolicy[lane])
+    return false ;
+
+  clock_gettime(CLOCK_MONOTONIC, &tStart) ;
+
+  do {
+    clock_gettime(CLOCK_MONOTONIC, &tNow) ;
+    lWaited = (tNow.tv_sec - tStart.tv_sec) * 1000 +
+              (tNow.tv_nsec - tStart.tv_nsec) / 1000000 ;
+
+    if ((lWaited >= CS10_OUTPUT_WAIT_MS) ||
+        !cs10_output_wait(lane, CS10_OUTPUT_WAIT_MS - lWaited))
+      break ;
+
+    cs10_output_flush() ;
+  } while (CS10_OUTPUT_LANE_SLOTS <= pQueue->uiCount) ;
+
+  if (CS10_OUTPUT_LANE_SLOTS > pQueue->uiCount)
+    return true ;
+
+  fprintf(stderr, "%s output stalled for %d ms, dropping an event\n",
+          laneName[lane], CS10_OUTPUT_WAIT_MS) ;
+
+  return false ;
+} /* cs10_output_make_room */
+
+/*
+ * cs10_output_add
+ *
+ * copy pEvent, and any sysex payload, onto the end of lane, to go out
+ * of iPortID
+ */
+static bool
+cs10_output_add(
+  cs10_output_lane_t lane,
+  int iPortID,
+  const snd_seq_event_t *pEvent,
+  bool bLatest) {
+
+  cs10_output_queue_t *pQueue = &output.lane[lane] ;
+  cs10_output_slot_t  *pSlot ;
+
+  /* too big to keep a copy of, and nothing cs10-linux makes is */
+  if ((SND_SEQ_EVENT_SYSEX == pEvent->type) &&
+      (CS10_OUTPUT_MAX_SYSEX < pEvent->data.ext.len)) {
+    output.stats[lane].ulDropped++ ;
+    return false ;
+  } /* if */
+
+  if ((CS10_OUTPUT_LANE_DEPTH <= pQueue->uiCount) &&
+      !cs10_output_make_room(lane)) {
+    output.stats[lane].ulDropped++ ;
+    return false ;
+  } /* if */
+
+  pSlot = &pQueue->slot[SLOT_INDEX(pQueue, pQueue->uiCount)] ;
+
+  pSlot->theEvent = *pEvent ;
+  pSlot->iPortID = iPortID ;
+  pSlot->bLatest = bLatest ;
+  pSlot->bDelayed = false ;
+
+  if (SND_SEQ_EVENT_SYSEX == pEvent->type) {
+    memcpy(pSlot->ucData, pEvent->data.ext.ptr, pEvent->data.ext.len) ;
+    pSlot->theEvent.data.ext.ptr = pSlot->ucData ;
+  } /* if */
+
+  output.stats[lane].ulQueued++ ;
+
+  /* past the lane's depth it waits in the backlog */
+  if (CS10_OUTPUT_LANE_DEPTH <= pQueue->uiCount++) {
+    pSlot->bDelayed = true ;
+    output.stats[lane].ulDelayed++ ;
+  } /* if */
+
+  return true ;
+} /* cs10_output_add */
+
+/*
+ * cs10_output_queue
+ *
+ * queue an event that must go out, such as a transport command
+ * or one half of a toggle
+ */
+bool
+cs10_output_queue(
+  cs10_output_lane_t lane,
+  const snd_seq_event_t *pEvent) {
+
+  return cs10_output_add(lane, output.iPortID[lane], pEvent, false) ;
+} /* cs10_output_queue */
+
+/*
+ * cs10_output_queue_to
+ *
+ * cs10_output_queue, out of iPortID on lane's sequencer rather than
+ * the lane's own port
+ */
+bool
+cs10_output_queue_to(
+  cs10_output_lane_t lane,
+  int iPortID,
+  const snd_seq_event_t *pEvent) {
+
+  return cs10_output_add(lane, iPortID, pEvent, false) ;
+} /* cs10_output_queue_to */
+
+/*
+ * cs10_output_queue_latest
+ *
+ * queue an event that only matters until a newer value for the same
+ * target turns up, a waiting older value is overwritten in place
+ */
+bool
+cs10_output_queue_latest(
+  cs10_output_lane_t lane,
+  const snd_seq_event_t *pEvent) {
+
+  return cs10_output_queue_latest_to(lane, output.iPortID[lane], pEvent) ;
+} /* cs10_output_queue_latest */
+
+/*
+ * cs10_output_queue_latest_to
+ *
+ * cs10_output_queue_latest, out of iPortID on lane's sequencer rather
+ * than the lane's own port
+ */
+bool
+cs10_output_queue_latest_to(
+  cs10_output_lane_t lane,
+  int iPortID,
+  const snd_seq_event_t *pEvent) {
+
+  cs10_output_queue_t *pQueue = &output.lane[lane] ;
+  unsigned int         uiSlot ;
+
+  for (uiSlot = 0 ; uiSlot < pQueue->uiCount ; uiSlot++) {
+    cs10_output_slot_t *pSlot = &pQueue->slot[SLOT_INDEX(pQueue, uiSlot)] ;
+
+    if (pSlot->bLatest && (pSlot->iPortID == iPortID) &&
+        cs10_output_same_target(&pSlot->theEvent, pEvent)) {
+      pSlot->theEvent = *pEvent ;
+
+      if (SND_SEQ_EVENT_SYSEX == pEvent->type) {
+        memcpy(pSlot->ucData, pEvent->data.ext.ptr, pEvent->data.ext.len) ;
+        pSlot->theEvent.data.ext.ptr = pSlot->ucData ;
+      } /* if */
+
+      output.stats[lane].ulQueued++ ;
+      output.stats[lane].ulReplaced++ ;
+
+      return true ;
+    } /* if */
+  } /* for */
+
+  return cs10_output_add(lane, iPortID, pEvent, true) ;
+} /* cs10_output_queue_latest_to */
+
+/*
+ * cs10_output_room
+ *
+ * how many more events lane will take without waiting or dropping
+ */
+unsigned int
+cs10_output_room(
+  cs10_output_lane_t lane) {
+
+  if (CS10_OUTPUT_LANE_DEPTH <= output.lane[lane].uiCount)
+    return 0 ;
+
+  return CS10_OUTPUT_LANE_DEPTH - output.lane[lane].uiCount ;
+} /* cs10_output_room */
+
+/*
+ * cs10_output_pending
+ *
+ * is anything waiting on any lane or in a sequencer output buffer
+ */
+bool
+cs10_output_pending(void) {
+
+  unsigned int uiLane ;
+
+  for (uiLane = 0 ; uiLane < NUM_OUTPUT_LANES ; uiLane++) {
+    if (output.lane[uiLane].uiCount || cs10_output_backlog(uiLane))
+      return true ;
+  } /* for */
+
+  return false ;
+} /* cs10_output_pending */
+
+/*
+ * cs10_output_get_stats
+ *
+ * copy out the counters for lane
+ */
+void
+cs10_output_get_stats(
+  cs10_output_lane_t lane,
+  cs10_output_stats_t *pStats) {
+
+  *pStats = output.stats[lane] ;
+} /* cs10_output_get_stats */
+
+/*
+ * cs10_output_dump_stats
+ *
+ * print the counters for every lane
+ */
+void
+cs10_output_dump_stats(
+  FILE *fp) {
+
+  unsigned int uiLane ;
+
+  for (uiLane = 0 ; uiLane < NUM_OUTPUT_LANES ; uiLane++) {
+    fprintf(fp, "%-11s queued %lu sent %lu delayed %lu "
+                "replaced %lu dropped %lu waiting %u\n",
+      laneName[uiLane],
+      output.stats[uiLane].ulQueued,
+      output.stats[uiLane].ulSent,
+      output.stats[uiLane].ulDelayed,
+      output.stats[uiLane].ulReplaced,
+      output.stats[uiLane].ulDropped,
+      output.lane[uiLane].uiCount) ;
+  } /* for */
+} /* cs10_output_dump_stats */
@@ -0,0 +1,128 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cs10-shm.h"
+
+/*****************************************************************************/
+
+static struct CS10_SHM_S {
+  cs10_shm_state_t *pState ;
+  char             *pName ;
+} shm ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_shm_open
+ *
+ * create, or take over, the shared segment pName
+ */
+bool
+cs10_shm_open(
+  const char *pName) {
+
+  int iFD ;
+
+  cs10_shm_close() ;
+
+  iFD = shm_open(pName, O_RDWR | O_CREAT, 0644) ;
+
+  if (iFD < 0)
+    return false ;
+
+  if (0 != ftruncate(iFD, sizeof(cs10_shm_state_t))) {
+    close(iFD) ;
+    return false ;
+  } /* if */
+
+  shm.pState = mmap(NULL, sizeof(cs10_shm_state_t), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, iFD, 0) ;
+  close(iFD) ;
+
+  if (MAP_FAILED == shm.pState) {
+    shm.pState = NULL ;
+    return false ;
+  } /* if */
+
+  shm.pName = strdup(pName) ;
+
+  /* readers of a segment left by another run see it being rewritten.
+   * a run killed part way through a write left the sequence odd, so it
+   * is set odd here rather than stepped, and write_end makes it even
+   */
+  __atomic_store_n(&shm.pState->ulSequence, shm.pState->ulSequence | 1U,
+                   __ATOMIC_RELAXED) ;
+  __atomic_thread_fence(__ATOMIC_RELEASE) ;
+  memset((char *)shm.pState + offsetof(cs10_shm_state_t, ucBank), 0,
+         sizeof(cs10_shm_state_t) - offsetof(cs10_shm_state_t, ucBank)) ;
+  shm.pState->ulMagic = CS10_SHM_MAGIC ;
+  shm.pState->ulVersion = CS10_SHM_VERSION ;
+  shm.pState->ulPid = getpid() ;
+  cs10_shm_write_end() ;
+
+  return true ;
+} /* cs10_shm_open */
+
+/*
+ * cs10_shm_close
+ *
+ * unmap and remove the shared segment
+ */
+void
+cs10_shm_close(void) {
+
+  if (NULL == shm.pState)
+    return ;
+
+  munmap(shm.pState, sizeof(cs10_shm_state_t)) ;
+  shm.pState = NULL ;
+
+  if (shm.pName)
+    shm_unlink(shm.pName) ;
+
+  free(shm.pName) ;
+  shm.pName = NULL ;
+} /* cs10_shm_close */
+
+/*
+ * cs10_shm_write_begin
+ *
+ * start rewriting the segment, NULL if there isn't one
+ * only one thread at a time may write
+ */
+cs10_shm_state_t *
+cs10_shm_write_begin(void) {
+
+  if (NULL == shm.pState)
+    return NULL ;
+
+  __atomic_store_n(&shm.pState->ulSequence, shm.pState->ulSequence + 1,
+                   __ATOMIC_RELAXED) ;
+  __atomic_thread_fence(__ATOMIC_RELEASE) ;
+
+  return shm.pState ;
+} /* cs10_shm_write_begin */
+
+/*
+ * cs10_shm_write_end
+ *
+ * the segment is consistent again
+ */
+void
+cs10_shm_write_end(void) {
+
+  if (NULL == shm.pState)
+    return ;
+
+  __atomic_store_n(&shm.pState->ulSequence, shm.pState->ulSequence + 1,
+                   __ATOMIC_RELEASE) ;
+} /* cs10_shm_write_end */
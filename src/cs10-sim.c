@@ -0,0 +1,769 @@
+/*****************************************************************************/
+
+/* cs10-sim
+ *
+ * a stand-in for the cs10 hardware, for soak and load testing cs10-linux
+ * without the desk. it registers a sequencer client, links itself to the
+ * daemon's cs10-io port and plays button, fader, knob and wheel moves at
+ * it, either from a script or as random moves at a fixed rate. the LED
+ * and seven segment sysex coming back is decoded into a copy of the
+ * panel that scripts can check.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <alsa/asoundlib.h>
+#include <getopt.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cs10.h"
+
+/*****************************************************************************/
+
+#define SIM_SEQUENCER_NAME  "default"
+#define SIM_CLIENT_NAME     "cs10-sim"
+#define SIM_PORT_NAME       "CS-10"
+#define SIM_DEFAULT_TARGET  "cs10-surface:0"
+
+#define SIM_CONTROL_CHANNEL 0
+#define SIM_NUM_LED_ADDRS   0x20
+#define SIM_NUM_FADERS      (LAST_FADER_ADDR - FIRST_FADER_ADDR + 1)
+#define SIM_NUM_KNOBS       (LAST_KNOB_ADDR - FIRST_KNOB_ADDR + 1)
+#define SIM_MAX_CONTROL     0x7f
+
+#define SIM_DEFAULT_RATE       1000   /* random moves a second */
+#define SIM_DEFAULT_EXPECT_MS  1000
+#define SIM_REPORT_MS          1000
+#define SIM_MAX_STEP           4      /* furthest a random move goes */
+
+static const unsigned int uiHexToSSDTable[] = HEX_TO_SSD_TABLE ;
+
+/*****************************************************************************/
+
+static struct CS10_SIM_S {
+  bool            debug ;
+
+  snd_seq_t      *pSeq ;
+  int             iPortID ;
+  char           *target ;
+
+  char           *script_filename ;
+  unsigned int    uiLoops ;
+  unsigned int    uiRate ;
+  unsigned int    uiSeconds ;
+  unsigned int    uiSeed ;
+  int             iDaemonPID ;
+
+  /* the panel as the daemon last lit it, plus one, 0 when never sent */
+  unsigned char   ucLED[SIM_NUM_LED_ADDRS] ;
+
+  /* where the random moves have left each control */
+  unsigned int    uiFader[SIM_NUM_FADERS] ;
+  unsigned int    uiKnob[SIM_NUM_KNOBS] ;
+
+  unsigned long   ulSent ;
+  unsigned long   ulLEDs ;
+  unsigned long   ulOtherInput ;
+  unsigned int    uiFailures ;
+
+  unsigned int    uiExpects ;
+  uint32_t        ulLatencyMin ;
+  uint32_t        ulLatencyMax ;
+  uint64_t        ullLatencyTotal ;
+
+  uint32_t        ulStart ;
+  unsigned long   ulDaemonTicks ;
+
+  volatile sig_atomic_t bStop ;
+} sim ;
+
+/*****************************************************************************/
+
+void
+sighandler(
+  int iSignal) {
+
+  sim.bStop = 1 ;
+} /* sighandler */
+
+/*
+ * sim_now_ms
+ *
+ * a monotonic millisecond clock
+ */
+uint32_t
+sim_now_ms(void) {
+
+  struct timespec tNow ;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow) ;
+
+  return (uint32_t)(tNow.tv_sec * 1000 + tNow.tv_nsec / 1000000) ;
+} /* sim_now_ms */
+
+/*
+ * sim_daemon_ticks
+ *
+ * user plus system clock ticks the daemon has used, 0 if it can't be read
+ */
+unsigned long
+sim_daemon_ticks(void) {
+
+  char          cPath[64] ;
+  char          cStat[1024] ;
+  char         *pFields ;
+  unsigned long ulUser = 0 ;
+  unsigned long ulSystem = 0 ;
+  FILE         *fp ;
+
+  if (0 >= sim.iDaemonPID)
+    return 0 ;
+
+  snprintf(cPath, sizeof(cPath), "/proc/%d/stat", sim.iDaemonPID) ;
+
+  fp = fopen(cPath, "r") ;
+
+  if (NULL == fp)
+    return 0 ;
+
+  if (NULL == fgets(cStat, sizeof(cStat), fp)) {
+    fclose(fp) ;
+    return 0 ;
+  } /* if */
+
+  fclose(fp) ;
+
+  /* the command name may hold spaces, the fields start after its ')' */
+  pFields = strrchr(cStat, ')') ;
+
+  if ((NULL == pFields) ||
+      (2 != sscanf(pFields + 2,
+                   "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                   &ulUser, &ulSystem)))
+    return 0 ;
+
+  return ulUser + ulSystem ;
+} /* sim_daemon_ticks */
+
+/*
+ * sim_init
+ *
+ * open the sequencer and link our port both ways with the daemon's
+ */
+bool
+sim_init(void) {
+
+  snd_seq_addr_t theTarget ;
+
+  if (0 != snd_seq_open(&sim.pSeq, SIM_SEQUENCER_NAME,
+                        SND_SEQ_OPEN_DUPLEX, 0)) {
+    fprintf(stderr, "can't open the sequencer\n") ;
+    return false ;
+  } /* if */
+
+  snd_seq_set_client_name(sim.pSeq, SIM_CLIENT_NAME) ;
+
+  sim.iPortID = snd_seq_create_simple_port(sim.pSeq, SIM_PORT_NAME,
+      SND_SEQ_PORT_CAP_READ |
+      SND_SEQ_PORT_CAP_WRITE |
+      SND_SEQ_PORT_CAP_SUBS_READ |
+      SND_SEQ_PORT_CAP_SUBS_WRITE,
+      SND_SEQ_PORT_TYPE_MIDI_GENERIC |
+      SND_SEQ_PORT_TYPE_HARDWARE) ;
+
+  if (0 > sim.iPortID) {
+    fprintf(stderr, "can't create port %s\n", SIM_PORT_NAME) ;
+    return false ;
+  } /* if */
+
+  if ((0 > snd_seq_parse_address(sim.pSeq, &theTarget, sim.target)) ||
+      (0 > snd_seq_connect_to(sim.pSeq, sim.iPortID,
+                              theTarget.client, theTarget.port)) ||
+      (0 > snd_seq_connect_from(sim.pSeq, sim.iPortID,
+                                theTarget.client, theTarget.port))) {
+    fprintf(stderr, "can't link with %s\n", sim.target) ;
+    return false ;
+  } /* if */
+
+  return true ;
+} /* sim_init */
+
+/*
+ * sim_send_control
+ *
+ * send a controller move from the panel
+ */
+void
+sim_send_control(
+  unsigned int uiAddr,
+  unsigned int uiValue) {
+
+  snd_seq_event_t theEvent ;
+
+  snd_seq_ev_clear(&theEvent) ;
+  snd_seq_ev_set_source(&theEvent, sim.iPortID) ;
+  snd_seq_ev_set_subs(&theEvent) ;
+  snd_seq_ev_set_direct(&theEvent) ;
+  snd_seq_ev_set_controller(&theEvent, SIM_CONTROL_CHANNEL, uiAddr, uiValue) ;
+
+  /* a full output buffer is drained on the way */
+  snd_seq_event_output(sim.pSeq, &theEvent) ;
+
+  sim.ulSent++ ;
+
+  if (sim.debug)
+    fprintf(stderr, "%s %02x %02x\n", __FUNCTION__, uiAddr, uiValue) ;
+} /* sim_send_control */
+
+/*
+ * sim_send_wheel
+ *
+ * turn the wheel iSteps clicks, a click at a time as the hardware does
+ */
+void
+sim_send_wheel(
+  int iSteps) {
+
+  for ( ; iSteps > 0 ; iSteps--)
+    sim_send_control(WHEEL_ADDR, 0x01) ;
+
+  for ( ; iSteps < 0 ; iSteps++)
+    sim_send_control(WHEEL_ADDR, 0x7f) ;
+} /* sim_send_wheel */
+
+/*
+ * sim_receive
+ *
+ * decode one event the daemon sent the panel
+ */
+void
+sim_receive(
+  snd_seq_event_t *pEvent) {
+
+  unsigned char *pData = pEvent->data.ext.ptr ;
+
+  if ((SND_SEQ_EVENT_SYSEX == pEvent->type) &&
+      (LED_SYSEX_PACKET_LENGTH == pEvent->data.ext.len) &&
+      (0xf0 == pData[0]) && (0x15 == pData[1]) && (0x15 == pData[2]) &&
+      (0x00 == pData[3]) && (0xf7 == pData[6]) &&
+      (SIM_NUM_LED_ADDRS > pData[4])) {
+    sim.ucLED[pData[4]] = pData[5] + 1 ;
+    sim.ulLEDs++ ;
+
+    if (sim.debug)
+      fprintf(stderr, "%s led %02x %02x\n", __FUNCTION__, pData[4], pData[5]) ;
+  } else
+    sim.ulOtherInput++ ;
+} /* sim_receive */
+
+/*
+ * sim_pump
+ *
+ * send what's queued, then take in whatever comes back for up to iTimeout
+ * ms, -1 waits for something
+ */
+void
+sim_pump(
+  int iTimeout) {
+
+  struct pollfd    theFDs[4] ;
+  int              iFDs ;
+  snd_seq_event_t *pEvent ;
+
+  snd_seq_drain_output(sim.pSeq) ;
+
+  iFDs = snd_seq_poll_descriptors(sim.pSeq, theFDs, 4, POLLIN) ;
+
+  if (0 >= poll(theFDs, iFDs, iTimeout))
+    return ;
+
+  do {
+    if (0 <= snd_seq_event_input(sim.pSeq, &pEvent))
+      sim_receive(pEvent) ;
+  } while (0 < snd_seq_event_input_pending(sim.pSeq, 0)) ;
+} /* sim_pump */
+
+/*
+ * sim_ssd_value
+ *
+ * the seven segment pattern for cDigit, -1 if it can't be shown
+ */
+int
+sim_ssd_value(
+  char cDigit) {
+
+  if ((cDigit >= '0') && (cDigit <= '9'))
+    return uiHexToSSDTable[cDigit - '0'] ;
+
+  if ((cDigit >= 'a') && (cDigit <= 'f'))
+    return uiHexToSSDTable[cDigit - 'a' + 10] ;
+
+  if ((cDigit >= 'A') && (cDigit <= 'F'))
+    return uiHexToSSDTable[cDigit - 'A' + 10] ;
+
+  if (' ' == cDigit || '_' == cDigit)
+    return uiHexToSSDTable[16] ;
+
+  return -1 ;
+} /* sim_ssd_value */
+
+/*
+ * sim_expect
+ *
+ * wait up to ulTimeout ms for uiAddr to show uiValue, and note how long
+ * it took
+ * return false if it never did
+ */
+bool
+sim_expect(
+  unsigned int uiAddr,
+  unsigned int uiValue,
+  uint32_t ulTimeout) {
+
+  uint32_t ulStart = sim_now_ms() ;
+  uint32_t ulTaken ;
+
+  while (sim.ucLED[uiAddr] != uiValue + 1) {
+    ulTaken = sim_now_ms() - ulStart ;
+
+    if ((ulTaken >= ulTimeout) || sim.bStop)
+      return false ;
+
+    sim_pump(ulTimeout - ulTaken) ;
+  } /* while */
+
+  ulTaken = sim_now_ms() - ulStart ;
+
+  if ((0 == sim.uiExpects) || (ulTaken < sim.ulLatencyMin))
+    sim.ulLatencyMin = ulTaken ;
+
+  if (ulTaken > sim.ulLatencyMax)
+    sim.ulLatencyMax = ulTaken ;
+
+  sim.ullLatencyTotal += ulTaken ;
+  sim.uiExpects++ ;
+
+  return true ;
+} /* sim_expect */
+
+/*
+ * sim_wait
+ *
+ * take in what the daemon sends for ulMs
+ */
+void
+sim_wait(
+  uint32_t ulMs) {
+
+  uint32_t ulStart = sim_now_ms() ;
+  uint32_t ulTaken ;
+
+  while (((ulTaken = sim_now_ms() - ulStart) < ulMs) && !sim.bStop)
+    sim_pump(ulMs - ulTaken) ;
+} /* sim_wait */
+
+/*
+ * sim_run_line
+ *
+ * carry out one script line:
+ *   press ADDR, down ADDR, up ADDR       a button by address
+ *   fader TRACK VALUE, knob INDEX VALUE  tracks and knobs count from 0
+ *   wheel CLICKS                         negative turns it back
+ *   wait MS
+ *   expect ADDR VALUE [MS]               an LED or segment shows VALUE
+ *   display XX [MS]                      the seven segments show XX
+ * numbers may be given in hex as 0x..
+ * return false for a line that makes no sense
+ */
+bool
+sim_run_line(
+  char *pLine,
+  const char *pWhere) {
+
+  char          cCommand[16] ;
+  char          cText[3] ;
+  unsigned long ulArg[3] = { 0, 0, SIM_DEFAULT_EXPECT_MS } ;
+  long          lClicks ;
+  int           iArgs ;
+  int           iTens ;
+  int           iOnes ;
+
+  iArgs = sscanf(pLine, "%15s %li %li %li",
+                 cCommand, (long *)&ulArg[0], (long *)&ulArg[1],
+                 (long *)&ulArg[2]) ;
+
+  if (0 >= iArgs)
+    return true ;
+
+  if ('#' == cCommand[0])
+    return true ;
+
+  if ((0 == strcmp(cCommand, "press")) && (2 == iArgs) &&
+      (LAST_BUTTON_ADDR >= ulArg[0])) {
+    sim_send_control(ulArg[0], BUTTON_DOWN_VALUE) ;
+    sim_send_control(ulArg[0], BUTTON_UP_VALUE) ;
+  } else
+  if ((0 == strcmp(cCommand, "down")) && (2 == iArgs) &&
+      (LAST_BUTTON_ADDR >= ulArg[0]))
+    sim_send_control(ulArg[0], BUTTON_DOWN_VALUE) ;
+  else
+  if ((0 == strcmp(cCommand, "up")) && (2 == iArgs) &&
+      (LAST_BUTTON_ADDR >= ulArg[0]))
+    sim_send_control(ulArg[0], BUTTON_UP_VALUE) ;
+  else
+  if ((0 == strcmp(cCommand, "fader")) && (3 == iArgs) &&
+      (SIM_NUM_FADERS > ulArg[0]) && (SIM_MAX_CONTROL >= ulArg[1]))
+    sim_send_control(FIRST_FADER_ADDR + ulArg[0], ulArg[1]) ;
+  else
+  if ((0 == strcmp(cCommand, "knob")) && (3 == iArgs) &&
+      (SIM_NUM_KNOBS > ulArg[0]) && (SIM_MAX_CONTROL >= ulArg[1]))
+    sim_send_control(FIRST_KNOB_ADDR + ulArg[0], ulArg[1]) ;
+  else
+  if ((0 == strcmp(cCommand, "wheel")) &&
+      (1 == sscanf(pLine, "%*s %li", &lClicks)))
+    sim_send_wheel(lClicks) ;
+  else
+  if ((0 == strcmp(cCommand, "wait")) && (2 == iArgs))
+    sim_wait(ulArg[0]) ;
+  else
+  if ((0 == strcmp(cCommand, "expect")) && (3 <= iArgs) &&
+      (SIM_NUM_LED_ADDRS > ulArg[0]) && (SIM_MAX_CONTROL >= ulArg[1])) {
+    snd_seq_drain_output(sim.pSeq) ;
+
+    if (!sim_expect(ulArg[0], ulArg[1], ulArg[2])) {
+      fprintf(stderr, "%s: led %02lx is %02x, not %02lx\n", pWhere,
+        ulArg[0], sim.ucLED[ulArg[0]] - 1, ulArg[1]) ;
+      sim.uiFailures++ ;
+    } /* if */
+  } else
+  if ((0 == strcmp(cCommand, "display")) &&
+      (1 <= sscanf(pLine, "%*s %2[0-9a-fA-F_] %lu", cText, &ulArg[2])) &&
+      (2 == strlen(cText))) {
+    iTens = sim_ssd_value(cText[0]) ;
+    iOnes = sim_ssd_value(cText[1]) ;
+
+    snd_seq_drain_output(sim.pSeq) ;
+
+    if (!sim_expect(TENS_SSD_ADDR, iTens, ulArg[2]) ||
+        !sim_expect(ONES_SSD_ADDR, iOnes, ulArg[2])) {
+      fprintf(stderr, "%s: display is %02x %02x, not %s\n", pWhere,
+        sim.ucLED[TENS_SSD_ADDR] - 1, sim.ucLED[ONES_SSD_ADDR] - 1, cText) ;
+      sim.uiFailures++ ;
+    } /* if */
+  } else
+    return false ;
+
+  return true ;
+} /* sim_run_line */
+
+/*
+ * sim_run_script
+ *
+ * play the script through, sim.uiLoops times, 0 until told to stop
+ */
+bool
+sim_run_script(void) {
+
+  unsigned int uiLoop ;
+
+  for (uiLoop = 0 ;
+       !sim.bStop && ((0 == sim.uiLoops) || (uiLoop < sim.uiLoops)) ;
+       uiLoop++) {
+    FILE        *fp ;
+    char         cLine[256] ;
+    char         cWhere[300] ;
+    unsigned int uiLine = 0 ;
+
+    fp = fopen(sim.script_filename, "r") ;
+
+    if (NULL == fp) {
+      fprintf(stderr, "can't read script %s\n", sim.script_filename) ;
+      return false ;
+    } /* if */
+
+    while (!sim.bStop && fgets(cLine, sizeof(cLine), fp)) {
+      uiLine++ ;
+
+      snprintf(cWhere, sizeof(cWhere), "%s:%u", sim.script_filename, uiLine) ;
+
+      if (!sim_run_line(cLine, cWhere)) {
+        fprintf(stderr, "%s: can't make sense of %s", cWhere, cLine) ;
+        fclose(fp) ;
+        return false ;
+      } /* if */
+
+      sim_pump(0) ;
+    } /* while */
+
+    fclose(fp) ;
+
+    if ((0 != sim.uiSeconds) &&
+        (sim_now_ms() - sim.ulStart >= sim.uiSeconds * 1000))
+      break ;
+  } /* for */
+
+  /* let the last of the feedback arrive */
+  sim_wait(100) ;
+
+  return true ;
+} /* sim_run_script */
+
+/*
+ * sim_random_move
+ *
+ * nudge a random fader or knob a few steps, or turn the wheel a click.
+ * buttons are left alone, they'd save over scenes and positions
+ */
+void
+sim_random_move(void) {
+
+  unsigned int uiPick = rand() % (SIM_NUM_FADERS + SIM_NUM_KNOBS + 1) ;
+  int          iStep = rand() % (2 * SIM_MAX_STEP + 1) - SIM_MAX_STEP ;
+  unsigned int *puValue ;
+  int          iValue ;
+
+  if (SIM_NUM_FADERS + SIM_NUM_KNOBS == uiPick) {
+    sim_send_wheel(iStep < 0 ? -1 : 1) ;
+    return ;
+  } /* if */
+
+  puValue = (uiPick < SIM_NUM_FADERS ?
+             &sim.uiFader[uiPick] : &sim.uiKnob[uiPick - SIM_NUM_FADERS]) ;
+
+  iValue = (int)*puValue + iStep ;
+
+  if (0 > iValue)
+    iValue = -iValue ;
+
+  if (SIM_MAX_CONTROL < iValue)
+    iValue = 2 * SIM_MAX_CONTROL - iValue ;
+
+  *puValue = iValue ;
+
+  sim_send_control(uiPick < SIM_NUM_FADERS ?
+                   FIRST_FADER_ADDR + uiPick :
+                   FIRST_KNOB_ADDR + uiPick - SIM_NUM_FADERS,
+                   iValue) ;
+} /* sim_random_move */
+
+/*
+ * sim_report
+ *
+ * print where the run has got to
+ */
+void
+sim_report(
+  FILE *fp) {
+
+  uint32_t ulElapsed = sim_now_ms() - sim.ulStart ;
+  long     lTicks = sysconf(_SC_CLK_TCK) ;
+
+  fprintf(fp, "%lu.%03lus sent %lu (%lu/s) leds %lu other %lu",
+    (unsigned long)ulElapsed / 1000, (unsigned long)ulElapsed % 1000,
+    sim.ulSent,
+    (ulElapsed ? (unsigned long)((uint64_t)sim.ulSent * 1000 / ulElapsed) : 0),
+    sim.ulLEDs, sim.ulOtherInput) ;
+
+  if (sim.uiExpects)
+    fprintf(fp, " latency %u/%u/%u ms",
+      sim.ulLatencyMin,
+      (unsigned int)(sim.ullLatencyTotal / sim.uiExpects),
+      sim.ulLatencyMax) ;
+
+  if ((0 < sim.iDaemonPID) && ulElapsed && (0 < lTicks))
+    fprintf(fp, " daemon cpu %.1f%%",
+      (double)(sim_daemon_ticks() - sim.ulDaemonTicks) * 100000.0 /
+      ((double)lTicks * ulElapsed)) ;
+
+  fprintf(fp, "\n") ;
+} /* sim_report */
+
+/*
+ * sim_run_random
+ *
+ * make random moves at sim.uiRate a second until the time is up
+ */
+void
+sim_run_random(void) {
+
+  uint32_t ulNextReport = SIM_REPORT_MS ;
+  uint64_t ullDue ;
+  uint32_t ulElapsed ;
+  unsigned int uiTrack ;
+
+  srand(sim.uiSeed) ;
+
+  for (uiTrack = 0 ; uiTrack < SIM_NUM_FADERS ; uiTrack++)
+    sim.uiFader[uiTrack] = rand() % (SIM_MAX_CONTROL + 1) ;
+
+  for (uiTrack = 0 ; uiTrack < SIM_NUM_KNOBS ; uiTrack++)
+    sim.uiKnob[uiTrack] = rand() % (SIM_MAX_CONTROL + 1) ;
+
+  while (!sim.bStop) {
+    ulElapsed = sim_now_ms() - sim.ulStart ;
+
+    if ((0 != sim.uiSeconds) && (ulElapsed >= sim.uiSeconds * 1000))
+      break ;
+
+    /* catch up with the rate, the wheel counts as a move too */
+    ullDue = (uint64_t)ulElapsed * sim.uiRate / 1000 ;
+
+    while (sim.ulSent < ullDue)
+      sim_random_move() ;
+
+    if (ulElapsed >= ulNextReport) {
+      sim_report(stderr) ;
+      ulNextReport += SIM_REPORT_MS ;
+    } /* if */
+
+    sim_pump(1) ;
+  } /* while */
+
+  sim_wait(100) ;
+} /* sim_run_random */
+
+/*
+ * sim_dump_panel
+ *
+ * print every LED and segment the daemon has lit
+ */
+void
+sim_dump_panel(
+  FILE *fp) {
+
+  unsigned int uiAddr ;
+
+  fprintf(fp, "panel:") ;
+
+  for (uiAddr = 0 ; uiAddr < SIM_NUM_LED_ADDRS ; uiAddr++) {
+    if (sim.ucLED[uiAddr])
+      fprintf(fp, " %02x=%02x", uiAddr, sim.ucLED[uiAddr] - 1) ;
+  } /* for */
+
+  fprintf(fp, "\n") ;
+} /* sim_dump_panel */
+
+static struct option long_opts[] = {
+  { "verbose", no_argument, NULL, 'v'},
+  { "connect", required_argument, NULL, 'c'},
+  { "script", required_argument, NULL, 's'},
+  { "loops", required_argument, NULL, 'l'},
+  { "rate", required_argument, NULL, 'r'},
+  { "time", required_argument, NULL, 't'},
+  { "seed", required_argument, NULL, 'S'},
+  { "pid", required_argument, NULL, 'P'},
+  { "help", no_argument, NULL, 'h'},
+  { NULL, 0, NULL, 0 }
+};
+
+void
+sim_help_exit(
+  int argc,
+  char** argv) {
+
+  fprintf(stderr, "%s options:\n", argv[0]);
+  fprintf(stderr, "  --connect, -c [client:port] of cs10-linux's cs10-io, %s by default\n",
+    SIM_DEFAULT_TARGET);
+  fprintf(stderr, "  --script, -s [path] play this script instead of random moves\n");
+  fprintf(stderr, "  --loops, -l [count] times to play the script, 0 for ever\n");
+  fprintf(stderr, "  --rate, -r [moves] random moves a second, %u by default\n",
+    SIM_DEFAULT_RATE);
+  fprintf(stderr, "  --time, -t [seconds] stop after this long, 0 for never\n");
+  fprintf(stderr, "  --seed, -S [number] for the random moves\n");
+  fprintf(stderr, "  --pid, -P [pid] of cs10-linux, to report the cpu it uses\n");
+  fprintf(stderr, "  --verbose, -v print every event\n");
+  fprintf(stderr, "  --help, -h show this help and exit\n");
+  exit(0);
+} /* sim_help_exit */
+
+int
+main(
+  int argc,
+  char** argv) {
+
+  int c;
+
+  memset(&sim, 0, sizeof(sim)) ;
+
+  sim.target = SIM_DEFAULT_TARGET ;
+  sim.uiLoops = 1 ;
+  sim.uiRate = SIM_DEFAULT_RATE ;
+  sim.uiSeed = time(NULL) ;
+
+  while ((c = getopt_long(argc, argv, "vc:s:l:r:t:S:P:h",
+                          long_opts, NULL)) != -1) {
+    switch (c) {
+      case 'v':
+        sim.debug = true;
+        break;
+
+      case 'c':
+        sim.target = optarg;
+        break;
+
+      case 's':
+        sim.script_filename = optarg;
+        break;
+
+      case 'l':
+        sim.uiLoops = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'r':
+        sim.uiRate = strtoul(optarg, NULL, 0);
+        break;
+
+      case 't':
+        sim.uiSeconds = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'S':
+        sim.uiSeed = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'P':
+        sim.iDaemonPID = strtol(optarg, NULL, 0);
+        break;
+
+      case 'h':
+      default:
+        sim_help_exit(argc, argv);
+        break;
+    } /* switch */
+  } /* while */
+
+  if (!sim_init())
+    return 1;
+
+  signal(SIGINT, sighandler) ;
+  signal(SIGTERM, sighandler) ;
+
+  sim.ulStart = sim_now_ms() ;
+  sim.ulDaemonTicks = sim_daemon_ticks() ;
+
+  if (sim.script_filename) {
+    if (!sim_run_script())
+      sim.uiFailures++ ;
+  } else {
+    if (sim.debug)
+      fprintf(stderr, "random moves, seed %u\n", sim.uiSeed) ;
+
+    sim_run_random() ;
+  } /* else */
+
+  sim_report(stdout) ;
+  sim_dump_panel(stdout) ;
+
+  if (sim.uiFailures)
+    printf("%u failed\n", sim.uiFailures) ;
+
+  snd_seq_close(sim.pSeq) ;
+
+  return (sim.uiFailures ? 1 : 0) ;
+} /* main */
@@ -0,0 +1,247 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "cs10-stats.h"
+
+/*****************************************************************************/
+
+#define STATS_TEMP_SUFFIX ".tmp"
+
+/* counters of one metric are kept together, its help goes out once */
+static const struct CS10_COUNTER_NAME_S {
+  const char *pMetric ;
+  const char *pLabels ;
+  const char *pHelp ;
+} counterName[NUM_COUNTERS] = {
+  { "cs10_events_in_total", "port=\"cs10-io\",type=\"controller\"",
+    "events read, by port and type" },
+  { "cs10_events_in_total", "port=\"cs10-io\",type=\"other\"", NULL },
+  { "cs10_events_in_total", "port=\"mmc-io\",type=\"controller\"", NULL },
+  { "cs10_events_in_total", "port=\"mmc-io\",type=\"sysex\"", NULL },
+  { "cs10_events_in_total", "port=\"mmc-io\",type=\"qframe\"", NULL },
+  { "cs10_events_in_total", "port=\"mmc-io\",type=\"other\"", NULL },
+  { "cs10_events_out_total", "type=\"controller\"",
+    "events sent, by type" },
+  { "cs10_events_out_total", "type=\"led_sysex\"", NULL },
+  { "cs10_events_out_total", "type=\"mmc\"", NULL },
+  { "cs10_events_out_total", "type=\"other\"", NULL },
+  { "cs10_surface_bytes_out_total", NULL,
+    "midi bytes sent to the surface" },
+  { "cs10_output_drains_total", NULL,
+    "output drained to the sequencer or rawmidi device" },
+  { "cs10_restore_steps_total", NULL,
+    "restore and morph steps taken" },
+  { "cs10_restores_aborted_total", NULL,
+    "restores and morphs taken over by another before they were done" },
+  { "cs10_saves_total", NULL,
+    "settings file writes" },
+  { "cs10_timecode_total", "source=\"qframe\"",
+    "times taken from the daw, by source" },
+  { "cs10_timecode_total", "source=\"full_frame\"", NULL },
+  { "cs10_timecode_total", "source=\"locate\"", NULL }
+} ;
+
+uint64_t cs10_counters[NUM_COUNTERS] ;
+
+static struct CS10_STATS_S {
+  clockid_t       threadClock[CS10_STATS_THREADS] ;
+  const char     *pThreadName[CS10_STATS_THREADS] ;
+  unsigned int    uiThreads ;
+
+  char           *pFilename ;
+  char           *pTempFilename ;
+
+  pthread_t       writerThread ;
+  pthread_mutex_t stopLock ;
+  pthread_cond_t  stopCond ;
+  bool            bRunning ;
+} stats = {
+  .stopLock = PTHREAD_MUTEX_INITIALIZER,
+  .stopCond = PTHREAD_COND_INITIALIZER
+} ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_stats_thread
+ *
+ * have the calling thread's cpu time written as pName
+ */
+void
+cs10_stats_thread(
+  const char *pName) {
+
+  unsigned int uiThread ;
+  clockid_t    threadClock ;
+
+  if (0 != pthread_getcpuclockid(pthread_self(), &threadClock))
+    return ;
+
+  pthread_mutex_lock(&stats.stopLock) ;
+
+  uiThread = stats.uiThreads ;
+
+  if (uiThread < CS10_STATS_THREADS) {
+    stats.threadClock[uiThread] = threadClock ;
+    stats.pThreadName[uiThread] = pName ;
+    stats.uiThreads++ ;
+  } /* if */
+
+  pthread_mutex_unlock(&stats.stopLock) ;
+} /* cs10_stats_thread */
+
+/*
+ * cs10_stats_write
+ *
+ * write every counter to the stats file, by way of a temporary one
+ */
+static void
+cs10_stats_write(void) {
+
+  FILE        *pFile = fopen(stats.pTempFilename, "w") ;
+  const char  *pMetric = NULL ;
+  unsigned int uiCounter ;
+  unsigned int uiThread ;
+
+  if (NULL == pFile)
+    return ;
+
+  for (uiCounter = 0 ; uiCounter < NUM_COUNTERS ; uiCounter++) {
+    const struct CS10_COUNTER_NAME_S *pName = &counterName[uiCounter] ;
+
+    if ((NULL == pMetric) || strcmp(pMetric, pName->pMetric)) {
+      pMetric = pName->pMetric ;
+      fprintf(pFile, "# HELP %s %s\n", pMetric, pName->pHelp) ;
+      fprintf(pFile, "# TYPE %s counter\n", pMetric) ;
+    } /* if */
+
+    fprintf(pFile, "%s%s%s%s %llu\n", pMetric,
+      pName->pLabels ? "{" : "",
+      pName->pLabels ? pName->pLabels : "",
+      pName->pLabels ? "}" : "",
+      (unsigned long long)__atomic_load_n(&cs10_counters[uiCounter],
+                                          __ATOMIC_RELAXED)) ;
+  } /* for */
+
+  fprintf(pFile, "# HELP cs10_thread_cpu_seconds_total cpu time, by thread\n") ;
+  fprintf(pFile, "# TYPE cs10_thread_cpu_seconds_total counter\n") ;
+
+  pthread_mutex_lock(&stats.stopLock) ;
+
+  for (uiThread = 0 ; uiThread < stats.uiThreads ; uiThread++) {
+    struct timespec tCPU ;
+
+    /* a thread that has gone takes its clock with it */
+    if (0 != clock_gettime(stats.threadClock[uiThread], &tCPU))
+      continue ;
+
+    fprintf(pFile, "cs10_thread_cpu_seconds_total{thread=\"%s\"} %ld.%09ld\n",
+      stats.pThreadName[uiThread], (long)tCPU.tv_sec, tCPU.tv_nsec) ;
+  } /* for */
+
+  pthread_mutex_unlock(&stats.stopLock) ;
+
+  if ((0 != fclose(pFile)) ||
+      (0 != rename(stats.pTempFilename, stats.pFilename)))
+    remove(stats.pTempFilename) ;
+} /* cs10_stats_write */
+
+/*
+ * cs10_stats_writer
+ *
+ * the writer thread, writes the file every CS10_STATS_INTERVAL_S until
+ * told to stop
+ */
+static void *
+cs10_stats_writer(
+  void *pArg) {
+
+  struct timespec tWake ;
+
+  (void) pArg ;
+
+  pthread_mutex_lock(&stats.stopLock) ;
+
+  while (stats.bRunning) {
+    pthread_mutex_unlock(&stats.stopLock) ;
+    cs10_stats_write() ;
+    pthread_mutex_lock(&stats.stopLock) ;
+
+    clock_gettime(CLOCK_REALTIME, &tWake) ;
+    tWake.tv_sec += CS10_STATS_INTERVAL_S ;
+
+    while (stats.bRunning &&
+           (ETIMEDOUT != pthread_cond_timedwait(&stats.stopCond,
+                                                &stats.stopLock, &tWake)))
+      ;
+  } /* while */
+
+  pthread_mutex_unlock(&stats.stopLock) ;
+
+  return NULL ;
+} /* cs10_stats_writer */
+
+/*
+ * cs10_stats_start
+ *
+ * write the counters to pFilename from now on
+ */
+bool
+cs10_stats_start(
+  const char *pFilename) {
+
+  if (stats.bRunning)
+    return true ;
+
+  free(stats.pFilename) ;
+  free(stats.pTempFilename) ;
+
+  stats.pFilename = strdup(pFilename) ;
+  stats.pTempFilename = malloc(strlen(pFilename) +
+                               strlen(STATS_TEMP_SUFFIX) + 1) ;
+
+  if ((NULL == stats.pFilename) || (NULL == stats.pTempFilename))
+    return false ;
+
+  strcpy(stats.pTempFilename, pFilename) ;
+  strcat(stats.pTempFilename, STATS_TEMP_SUFFIX) ;
+
+  stats.bRunning = true ;
+
+  if (0 != pthread_create(&stats.writerThread, NULL,
+                          cs10_stats_writer, NULL)) {
+    stats.bRunning = false ;
+    return false ;
+  } /* if */
+
+  return true ;
+} /* cs10_stats_start */
+
+/*
+ * cs10_stats_stop
+ *
+ * stop the writer thread, leaving the last counts in the file
+ */
+void
+cs10_stats_stop(void) {
+
+  if (!stats.bRunning)
+    return ;
+
+  pthread_mutex_lock(&stats.stopLock) ;
+  stats.bRunning = false ;
+  pthread_cond_signal(&stats.stopCond) ;
+  pthread_mutex_unlock(&stats.stopLock) ;
+
+  pthread_join(stats.writerThread, NULL) ;
+
+  cs10_stats_write() ;
+} /* cs10_stats_stop */
@@ -0,0 +1,304 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <alsa/asoundlib.h>
+
+#include "cs10-target.h"
+
+/*****************************************************************************/
+
+#define CS10_TARGET_ALL_TRACKS   0xffffffffU
+#define CS10_TARGET_ALL_CONTROLS ((1U << NUM_VIRTUAL_TRACK_CONTROLS) - 1)
+
+static struct CS10_TARGET_MODULE_S {
+  cs10_target_t target[CS10_MAX_TARGETS] ;
+  unsigned int  uiTargets ;
+  snd_seq_t    *pSeq ;
+} targets ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_target_forget
+ *
+ * drop every target, and any map of its own
+ */
+static void
+cs10_target_forget(void) {
+
+  unsigned int uiTarget ;
+
+  for (uiTarget = 0 ; uiTarget < targets.uiTargets ; uiTarget++)
+    free(targets.target[uiTarget].pMap) ;
+
+  memset(targets.target, 0, sizeof(targets.target)) ;
+  targets.uiTargets = 0 ;
+} /* cs10_target_forget */
+
+/*
+ * cs10_target_finish
+ *
+ * fill in whichever half of pTarget's filter was left out
+ */
+static void
+cs10_target_finish(
+  cs10_target_t *pTarget) {
+
+  if (pTarget->uiControlMask && (0 == pTarget->ulTrackMask))
+    pTarget->ulTrackMask = CS10_TARGET_ALL_TRACKS ;
+
+  if (pTarget->ulTrackMask && (0 == pTarget->uiControlMask))
+    pTarget->uiControlMask = CS10_TARGET_ALL_CONTROLS ;
+} /* cs10_target_finish */
+
+/*
+ * cs10_target_parse_controls
+ *
+ * add the controls named in pNames to pTarget's filter
+ * return false if one of them isn't a control
+ */
+static bool
+cs10_target_parse_controls(
+  char *pNames,
+  const char * const *ppControlNames,
+  cs10_target_t *pTarget) {
+
+  char         *pSave = NULL ;
+  char         *pName ;
+  unsigned int  uiControl ;
+  bool          bAny = false ;
+
+  for (pName = strtok_r(pNames, " \t\r\n", &pSave) ;
+       pName ;
+       pName = strtok_r(NULL, " \t\r\n", &pSave)) {
+    for (uiControl = 0 ; uiControl < NUM_VIRTUAL_TRACK_CONTROLS ; uiControl++) {
+      if (0 == strcmp(ppControlNames[uiControl], pName))
+        break ;
+    } /* for */
+
+    if (NUM_VIRTUAL_TRACK_CONTROLS == uiControl)
+      return false ;
+
+    pTarget->uiControlMask |= 1U << uiControl ;
+    bAny = true ;
+  } /* for */
+
+  return bAny ;
+} /* cs10_target_parse_controls */
+
+/*
+ * cs10_target_parse_setting
+ *
+ * apply one line of the targets file to pTarget
+ * return false if it makes no sense
+ */
+static bool
+cs10_target_parse_setting(
+  char *pLine,
+  const char * const *ppControlNames,
+  cs10_target_t *pTarget) {
+
+  unsigned int uiFirst ;
+  unsigned int uiLast ;
+  char         cPath[256] ;
+  char         cExtra ;
+
+  if ((0 == strncmp(pLine, "transport", 9)) &&
+      (1 > sscanf(pLine + 9, " %c", &cExtra))) {
+    pTarget->bTransport = true ;
+    return true ;
+  } /* if */
+
+  if (1 == sscanf(pLine, "tracks %u %c", &uiFirst, &cExtra))
+    uiLast = uiFirst ;
+  else
+  if (2 != sscanf(pLine, "tracks %u-%u %c", &uiFirst, &uiLast, &cExtra))
+    uiLast = 0 ;
+
+  if (uiLast) {
+    if ((1 > uiFirst) || (uiFirst > uiLast) ||
+        (CS10_MAP_MAX_STRIPS < uiLast))
+      return false ;
+
+    for ( ; uiFirst <= uiLast ; uiFirst++)
+      pTarget->ulTrackMask |= 1U << (uiFirst - 1) ;
+
+    return true ;
+  } /* if */
+
+  if ((0 == strncmp(pLine, "controls", 8)) &&
+      isspace((unsigned char)pLine[8]))
+    return cs10_target_parse_controls(pLine + 8, ppControlNames, pTarget) ;
+
+  if (1 == sscanf(pLine, "map %255s %c", cPath, &cExtra)) {
+    if (pTarget->pMap)
+      return false ;
+
+    pTarget->pMap = malloc(sizeof(cs10_map_t)) ;
+
+    if (pTarget->pMap && cs10_map_load(pTarget->pMap, cPath))
+      return true ;
+
+    free(pTarget->pMap) ;
+    pTarget->pMap = NULL ;
+    return false ;
+  } /* if */
+
+  return false ;
+} /* cs10_target_parse_setting */
+
+/*
+ * cs10_target_load
+ *
+ * replace every target with those in pFilename, ports aren't made yet
+ * return false if the file can't be read
+ */
+bool
+cs10_target_load(
+  const char *pFilename,
+  const char * const *ppControlNames) {
+
+  FILE          *fp ;
+  char           cLine[256] ;
+  unsigned int   uiLine = 0 ;
+  cs10_target_t *pTarget = NULL ;
+
+  fp = fopen(pFilename, "r") ;
+
+  if (NULL == fp)
+    return false ;
+
+  cs10_target_forget() ;
+
+  while (fgets(cLine, sizeof(cLine), fp)) {
+    char *pLine = cLine ;
+    char  cName[CS10_TARGET_NAME_LENGTH + 1] ;
+    char  cExtra ;
+
+    uiLine++ ;
+
+    while (isspace((unsigned char)*pLine))
+      pLine++ ;
+
+    if (('\0' == *pLine) || ('#' == *pLine))
+      continue ;
+
+    if (1 == sscanf(pLine, "target %32s %c", cName, &cExtra)) {
+      if (pTarget)
+        cs10_target_finish(pTarget) ;
+
+      pTarget = NULL ;
+
+      if (CS10_TARGET_NAME_LENGTH <= strlen(cName)) {
+        fprintf(stderr, "%s:%u: target name too long\n",
+          pFilename, uiLine) ;
+        continue ;
+      } /* if */
+
+      if (CS10_MAX_TARGETS == targets.uiTargets) {
+        fprintf(stderr, "%s:%u: too many targets\n", pFilename, uiLine) ;
+        continue ;
+      } /* if */
+
+      pTarget = &targets.target[targets.uiTargets++] ;
+      strcpy(pTarget->cName, cName) ;
+      pTarget->iPortID = -1 ;
+      continue ;
+    } /* if */
+
+    if (NULL == pTarget)
+      continue ;
+
+    if (!cs10_target_parse_setting(pLine, ppControlNames, pTarget))
+      fprintf(stderr, "%s:%u: ignoring %s", pFilename, uiLine, pLine) ;
+  } /* while */
+
+  if (pTarget)
+    cs10_target_finish(pTarget) ;
+
+  fclose(fp) ;
+
+  return true ;
+} /* cs10_target_load */
+
+/*
+ * cs10_target_open
+ *
+ * make a port on pSeq for every target
+ * return false, and keep none of them, if one can't be made
+ */
+bool
+cs10_target_open(
+  snd_seq_t *pSeq) {
+
+  unsigned int uiTarget ;
+
+  targets.pSeq = pSeq ;
+
+  for (uiTarget = 0 ; uiTarget < targets.uiTargets ; uiTarget++) {
+    cs10_target_t *pTarget = &targets.target[uiTarget] ;
+
+    pTarget->iPortID = snd_seq_create_simple_port(pSeq, pTarget->cName,
+        SND_SEQ_PORT_CAP_READ |
+        SND_SEQ_PORT_CAP_SUBS_READ,
+        SND_SEQ_PORT_TYPE_MIDI_GENERIC |
+        SND_SEQ_PORT_TYPE_APPLICATION) ;
+
+    if (pTarget->iPortID < 0) {
+      cs10_target_close() ;
+      return false ;
+    } /* if */
+  } /* for */
+
+  return true ;
+} /* cs10_target_open */
+
+/*
+ * cs10_target_close
+ *
+ * remove every target's port and forget the targets
+ */
+void
+cs10_target_close(void) {
+
+  unsigned int uiTarget ;
+
+  for (uiTarget = 0 ; uiTarget < targets.uiTargets ; uiTarget++) {
+    if (0 <= targets.target[uiTarget].iPortID)
+      snd_seq_delete_simple_port(targets.pSeq,
+                                 targets.target[uiTarget].iPortID) ;
+  } /* for */
+
+  cs10_target_forget() ;
+} /* cs10_target_close */
+
+/*
+ * cs10_target_count
+ *
+ * how many targets there are
+ */
+unsigned int
+cs10_target_count(void) {
+
+  return targets.uiTargets ;
+} /* cs10_target_count */
+
+/*
+ * cs10_target_get
+ *
+ * target number uiTarget, NULL past the last one
+ */
+const cs10_target_t *
+cs10_target_get(
+  unsigned int uiTarget) {
+
+  if (uiTarget >= targets.uiTargets)
+    return NULL ;
+
+  return &targets.target[uiTarget] ;
+} /* cs10_target_get */
@@ -0,0 +1,262 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "cs10-trace.h"
+
+/*****************************************************************************/
+
+#ifdef CS10_TRACE
+
+#define TRACE_MASK (CS10_TRACE_EVENTS - 1)
+
+typedef struct CS10_TRACE_EVENT_S {
+  uint64_t    ullTime ;  /* ns, monotonic */
+  const char *pName ;
+  int         iArg ;
+  char        cPhase ;   /* B, E or i as chrome has them */
+} cs10_trace_event_t ;
+
+/* only the owning thread writes a ring, it is read once tracing stops */
+typedef struct CS10_TRACE_RING_S {
+  const char         *pThreadName ;
+  uint32_t            ulHead ;
+  cs10_trace_event_t *pEvents ;
+} cs10_trace_ring_t ;
+
+bool cs10_trace_enabled ;
+
+static struct CS10_TRACE_S {
+  cs10_trace_ring_t rings[CS10_TRACE_THREADS] ;
+  unsigned int      uiRings ;      /* claimed so far, may overshoot */
+
+  char             *pFilename ;
+} trace ;
+
+/* the ring of the calling thread, claimed on its first event */
+static __thread cs10_trace_ring_t *pThreadRing ;
+static __thread bool               bNoRing ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_trace_ring
+ *
+ * the calling thread's ring, NULL once every ring is taken
+ */
+static cs10_trace_ring_t *
+cs10_trace_ring(void) {
+
+  unsigned int uiRing ;
+
+  if (pThreadRing || bNoRing)
+    return pThreadRing ;
+
+  uiRing = __atomic_fetch_add(&trace.uiRings, 1, __ATOMIC_ACQ_REL) ;
+
+  if (uiRing >= CS10_TRACE_THREADS) {
+    bNoRing = true ;
+    return NULL ;
+  } /* if */
+
+  pThreadRing = &trace.rings[uiRing] ;
+
+  return pThreadRing ;
+} /* cs10_trace_ring */
+
+/*
+ * cs10_trace_put
+ *
+ * note one event on the calling thread's ring, over the oldest if full
+ */
+void
+cs10_trace_put(
+  const char *pName,
+  char cPhase,
+  int iArg) {
+
+  cs10_trace_ring_t  *pRing = cs10_trace_ring() ;
+  cs10_trace_event_t *pEvent ;
+  struct timespec     tNow ;
+
+  if (NULL == pRing)
+    return ;
+
+  clock_gettime(CLOCK_MONOTONIC, &tNow) ;
+
+  pEvent = &pRing->pEvents[pRing->ulHead & TRACE_MASK] ;
+  pEvent->ullTime = (uint64_t)tNow.tv_sec * 1000000000ULL + tNow.tv_nsec ;
+  pEvent->pName = pName ;
+  pEvent->iArg = iArg ;
+  pEvent->cPhase = cPhase ;
+
+  __atomic_store_n(&pRing->ulHead, pRing->ulHead + 1, __ATOMIC_RELEASE) ;
+} /* cs10_trace_put */
+
+/*
+ * cs10_trace_thread
+ *
+ * name the calling thread in the trace
+ */
+void
+cs10_trace_thread(
+  const char *pName) {
+
+  cs10_trace_ring_t *pRing = cs10_trace_ring() ;
+
+  if (pRing)
+    pRing->pThreadName = pName ;
+} /* cs10_trace_thread */
+
+/*
+ * cs10_trace_open
+ *
+ * start tracing, to be written to pFilename by cs10_trace_close
+ */
+bool
+cs10_trace_open(
+  const char *pFilename) {
+
+  unsigned int uiRing ;
+
+  if (cs10_trace_enabled)
+    return true ;
+
+  for (uiRing = 0 ; uiRing < CS10_TRACE_THREADS ; uiRing++) {
+    if (NULL == trace.rings[uiRing].pEvents)
+      trace.rings[uiRing].pEvents = calloc(CS10_TRACE_EVENTS,
+                                           sizeof(cs10_trace_event_t)) ;
+
+    if (NULL == trace.rings[uiRing].pEvents)
+      return false ;
+  } /* for */
+
+  free(trace.pFilename) ;
+  trace.pFilename = strdup(pFilename) ;
+
+  if (NULL == trace.pFilename)
+    return false ;
+
+  __atomic_store_n(&cs10_trace_enabled, true, __ATOMIC_RELEASE) ;
+
+  return true ;
+} /* cs10_trace_open */
+
+/*
+ * cs10_trace_close
+ *
+ * stop tracing and write every ring out as chrome trace json, oldest
+ * event first
+ */
+void
+cs10_trace_close(void) {
+
+  FILE        *pFile ;
+  unsigned int uiRings ;
+  unsigned int uiRing ;
+  uint64_t     ullStart = UINT64_MAX ;
+  bool         bFirst = true ;
+  int          iPid = getpid() ;
+
+  if (!cs10_trace_enabled)
+    return ;
+
+  __atomic_store_n(&cs10_trace_enabled, false, __ATOMIC_RELEASE) ;
+
+  uiRings = __atomic_load_n(&trace.uiRings, __ATOMIC_ACQUIRE) ;
+
+  if (uiRings > CS10_TRACE_THREADS)
+    uiRings = CS10_TRACE_THREADS ;
+
+  /* time starts at the oldest event kept */
+  for (uiRing = 0 ; uiRing < uiRings ; uiRing++) {
+    cs10_trace_ring_t *pRing = &trace.rings[uiRing] ;
+    uint32_t           ulHead = __atomic_load_n(&pRing->ulHead,
+                                                __ATOMIC_ACQUIRE) ;
+    uint32_t           ulOldest = (ulHead > CS10_TRACE_EVENTS) ?
+                                    ulHead - CS10_TRACE_EVENTS : 0 ;
+
+    if ((ulHead != ulOldest) &&
+        (pRing->pEvents[ulOldest & TRACE_MASK].ullTime < ullStart))
+      ullStart = pRing->pEvents[ulOldest & TRACE_MASK].ullTime ;
+  } /* for */
+
+  pFile = fopen(trace.pFilename, "w") ;
+
+  if (NULL == pFile) {
+    fprintf(stderr, "can't write trace %s\n", trace.pFilename) ;
+    return ;
+  } /* if */
+
+  fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n") ;
+
+  for (uiRing = 0 ; uiRing < uiRings ; uiRing++) {
+    cs10_trace_ring_t *pRing = &trace.rings[uiRing] ;
+    uint32_t           ulHead = __atomic_load_n(&pRing->ulHead,
+                                                __ATOMIC_ACQUIRE) ;
+    uint32_t           ulEvent = (ulHead > CS10_TRACE_EVENTS) ?
+                                   ulHead - CS10_TRACE_EVENTS : 0 ;
+
+    if (pRing->pThreadName) {
+      fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\","
+                     "\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+        bFirst ? "" : ",\n", iPid, uiRing, pRing->pThreadName) ;
+      bFirst = false ;
+    } /* if */
+
+    for (; ulEvent != ulHead ; ulEvent++) {
+      const cs10_trace_event_t *pEvent = &pRing->pEvents[ulEvent & TRACE_MASK] ;
+      uint64_t                  ullTime = pEvent->ullTime - ullStart ;
+
+      fprintf(pFile, "%s{\"name\":\"%s\",\"ph\":\"%c\","
+                     "\"ts\":%lu.%03lu,\"pid\":%d,\"tid\":%u",
+        bFirst ? "" : ",\n",
+        pEvent->pName, pEvent->cPhase,
+        (unsigned long)(ullTime / 1000), (unsigned long)(ullTime % 1000),
+        iPid, uiRing) ;
+
+      if ('i' == pEvent->cPhase)
+        fprintf(pFile, ",\"s\":\"t\",\"args\":{\"value\":%d}", pEvent->iArg) ;
+
+      fprintf(pFile, "}") ;
+      bFirst = false ;
+    } /* for */
+  } /* for */
+
+  fprintf(pFile, "\n]}\n") ;
+  fclose(pFile) ;
+} /* cs10_trace_close */
+
+#else
+
+/*
+ * cs10_trace_open
+ *
+ * built without trace points, there is nothing to trace
+ */
+bool
+cs10_trace_open(
+  const char *pFilename) {
+
+  (void) pFilename ;
+
+  return false ;
+} /* cs10_trace_open */
+
+/*
+ * cs10_trace_close
+ *
+ * built without trace points
+ */
+void
+cs10_trace_close(void) {
+
+} /* cs10_trace_close */
+
+#endif /* CS10_TRACE */
@@ -0,0 +1,156 @@
+/*****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cs10-undo.h"
+
+/*****************************************************************************/
+
+#define UNDO_STEP_START   0x8000
+#define UNDO_INDEX(count) ((count) & (CS10_UNDO_ENTRIES - 1))
+
+#if CS10_UNDO_ENTRIES & (CS10_UNDO_ENTRIES - 1)
+#error CS10_UNDO_ENTRIES has to be a power of two
+#endif
+
+/* the first delta of a step has UNDO_STEP_START in its key */
+typedef struct CS10_UNDO_ENTRY_S {
+  uint16_t usKey ;
+  uint8_t  ucFrom ;
+  uint8_t  ucTo ;
+} cs10_undo_entry_t ;
+
+/* counts only ever go up, the entry for a count is UNDO_INDEX of it.
+ * ulOldest to ulCurrent can be undone, ulCurrent to ulNewest redone
+ */
+static struct CS10_UNDO_S {
+  cs10_undo_entry_t entry[CS10_UNDO_ENTRIES] ;
+  uint32_t          ulOldest ;
+  uint32_t          ulCurrent ;
+  uint32_t          ulNewest ;
+  uint32_t          ulStepStart ;
+  bool              bStepPending ;
+} undo ;
+
+/*****************************************************************************/
+
+/*
+ * cs10_undo_begin
+ *
+ * the next delta noted starts a step of its own
+ */
+void
+cs10_undo_begin(void) {
+
+  undo.bStepPending = true ;
+} /* cs10_undo_begin */
+
+/*
+ * cs10_undo_forget_oldest
+ *
+ * make room by dropping the oldest step
+ */
+static void
+cs10_undo_forget_oldest(void) {
+
+  do
+    undo.ulOldest++ ;
+  while ((undo.ulOldest != undo.ulNewest) &&
+         (0 == (undo.entry[UNDO_INDEX(undo.ulOldest)].usKey &
+                UNDO_STEP_START))) ;
+} /* cs10_undo_forget_oldest */
+
+/*
+ * cs10_undo_note
+ *
+ * add uiKey going from uiFrom to uiTo to the step being noted
+ * return false if the step has outgrown the ring
+ */
+bool
+cs10_undo_note(
+  unsigned int uiKey,
+  unsigned int uiFrom,
+  unsigned int uiTo) {
+
+  cs10_undo_entry_t *pEntry ;
+  bool               bStart ;
+
+  if (uiKey > CS10_UNDO_MAX_KEY)
+    return false ;
+
+  /* a step undone since can't be carried on with */
+  bStart = (undo.bStepPending || (undo.ulCurrent != undo.ulNewest)) ;
+
+  if (bStart) {
+    undo.ulNewest = undo.ulCurrent ;
+    undo.ulStepStart = undo.ulCurrent ;
+  } /* if */
+
+  if (CS10_UNDO_ENTRIES == undo.ulNewest - undo.ulOldest) {
+    if (undo.ulOldest == undo.ulStepStart)
+      return false ;
+
+    cs10_undo_forget_oldest() ;
+  } /* if */
+
+  pEntry = &undo.entry[UNDO_INDEX(undo.ulNewest)] ;
+  pEntry->usKey = uiKey | (bStart ? UNDO_STEP_START : 0) ;
+  pEntry->ucFrom = uiFrom ;
+  pEntry->ucTo = uiTo ;
+
+  undo.ulCurrent = ++undo.ulNewest ;
+  undo.bStepPending = false ;
+
+  return true ;
+} /* cs10_undo_note */
+
+/*
+ * cs10_undo
+ *
+ * hand pfnApply what the last step changed, as it was before
+ * return false if there's nothing to undo
+ */
+bool
+cs10_undo(
+  cs10_undo_apply_fn pfnApply,
+  void *pArg) {
+
+  cs10_undo_entry_t *pEntry ;
+
+  if (undo.ulCurrent == undo.ulOldest)
+    return false ;
+
+  do {
+    pEntry = &undo.entry[UNDO_INDEX(--undo.ulCurrent)] ;
+    pfnApply(pArg, pEntry->usKey & ~UNDO_STEP_START, pEntry->ucFrom) ;
+  } while (0 == (pEntry->usKey & UNDO_STEP_START)) ;
+
+  return true ;
+} /* cs10_undo */
+
+/*
+ * cs10_redo
+ *
+ * hand pfnApply what the last step undone changed, as it was after
+ * return false if there's nothing to redo
+ */
+bool
+cs10_redo(
+  cs10_undo_apply_fn pfnApply,
+  void *pArg) {
+
+  cs10_undo_entry_t *pEntry ;
+
+  if (undo.ulCurrent == undo.ulNewest)
+    return false ;
+
+  do {
+    pEntry = &undo.entry[UNDO_INDEX(undo.ulCurrent++)] ;
+    pfnApply(pArg, pEntry->usKey & ~UNDO_STEP_START, pEntry->ucTo) ;
+  } while ((undo.ulCurrent != undo.ulNewest) &&
+           (0 == (undo.entry[UNDO_INDEX(undo.ulCurrent)].usKey &
+                  UNDO_STEP_START))) ;
+
+  return true ;
+} /* cs10_redo */